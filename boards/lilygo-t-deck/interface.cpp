@@ -1,3 +1,4 @@
+#include "core/input_events.h"
 #include "core/powerSave.h"
 #include <Wire.h>
 #include <interface.h>
@@ -30,18 +31,22 @@ int8_t trackball_right_count = 0;
 void IRAM_ATTR ISR_up() {
     trackball_interrupted = true;
     trackball_up_count = 1;
+    inputWakeFromISR();
 }
 void IRAM_ATTR ISR_down() {
     trackball_interrupted = true;
     trackball_down_count = 1;
+    inputWakeFromISR();
 }
 void IRAM_ATTR ISR_left() {
     trackball_interrupted = true;
     trackball_left_count = 1;
+    inputWakeFromISR();
 }
 void IRAM_ATTR ISR_right() {
     trackball_interrupted = true;
     trackball_right_count = 1;
+    inputWakeFromISR();
 }
 
 void ISR_rst() {
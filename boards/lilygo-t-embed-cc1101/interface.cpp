@@ -162,6 +162,7 @@ void _setBrightness(uint8_t brightval) {
 RotaryEncoder *encoder = nullptr;
 IRAM_ATTR void checkPosition() {
     encoder->tick(); // just call tick() to check the state.
+    inputWakeFromISR();
 }
 
 /*********************************************************************
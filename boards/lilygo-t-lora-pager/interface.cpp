@@ -11,6 +11,7 @@ IRAM_ATTR void checkPosition();
 RotaryEncoder *encoder = nullptr;
 IRAM_ATTR void checkPosition() {
     encoder->tick(); // just call tick() to check the state.
+    inputWakeFromISR();
 }
 
 // GPIO expander
@@ -1,3 +1,4 @@
+#include "core/input_events.h"
 #include "core/powerSave.h"
 #include <Adafruit_TCA8418.h>
 #include <Keyboard.h>
@@ -86,7 +87,10 @@ void _setup_gpio() {
     digitalWrite(5, HIGH);
 }
 bool kb_interrupt = false;
-void IRAM_ATTR gpio_isr_handler(void *arg) { kb_interrupt = true; }
+void IRAM_ATTR gpio_isr_handler(void *arg) {
+    kb_interrupt = true;
+    inputWakeFromISR();
+}
 void _post_setup_gpio() {
     // Initialize TCA8418 I2C keyboard controller
     Serial.println("DEBUG: Cardputer ADV - Initializing TCA8418 keyboard");
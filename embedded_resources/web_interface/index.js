@@ -109,7 +109,8 @@ const Dialog = {
   }
 };
 
-async function requestGet (url, data) {
+// withStatus resolves { status, text }, for the calls that answer 202 while still working
+async function requestGet (url, data, withStatus = false) {
   return new Promise((resolve, reject) => {
     let req = new XMLHttpRequest();
     let realUrl = url;
@@ -121,7 +122,7 @@ async function requestGet (url, data) {
     req.open("GET", realUrl, true);
     req.onload = () => {
       if (req.status >= 200 && req.status < 300) {
-        resolve(req.responseText);
+        resolve(withStatus ? { status: req.status, text: req.responseText } : req.responseText);
       } else {
         reject(new Error(`Request failed with status ${req.status}`));
       }
@@ -395,7 +396,7 @@ function isModified(target) {
 
 async function openNavigator() {
   Dialog.show('navigator');
-  await reloadScreen();
+  await reloadScreen(true);
   autoReloadScreen();
 }
 
@@ -404,9 +405,10 @@ async function runNavigation(direction) {
   if (SCREEN_NAVIGATING) return;
   SCREEN_NAVIGATING = true;
   try {
-    drawCanvasLoading();
+    let live = SCREEN_WS && SCREEN_WS.readyState === WebSocket.OPEN;
+    if (!live) drawCanvasLoading();
     await requestPost("/cm", { cmnd: `nav ${direction.toLowerCase()}` });
-    await reloadScreen();
+    if (!live) await reloadScreen(); // the device pushes the changes when live
   } catch (error) {
     alert("Failed to run command: " + error.message);
     console.error(error)
@@ -417,12 +419,14 @@ async function runNavigation(direction) {
 
 const btnForceReload = $("#force-reload");
 let SCREEN_RELOAD = false;
-async function reloadScreen() {
+let SCREEN_SEQ = 0; // last draw received, the device only sends what was drawn after it
+async function reloadScreen(full = false) {
   if (SCREEN_RELOAD) return;
   SCREEN_RELOAD = true;
   btnForceReload.classList.add("reloading");
   try {
-    let binResponse = await fetch((IS_DEV ? "/bruce" : "") + "/getscreen");
+    let since = full ? 0 : SCREEN_SEQ;
+    let binResponse = await fetch((IS_DEV ? "/bruce" : "") + "/getscreen?since=" + since);
     let arrayBuffer = await binResponse.arrayBuffer();
     let screenData = new Uint8Array(arrayBuffer);
     await renderTFT(screenData);
@@ -462,9 +466,39 @@ async function autoReloadScreen() {
     AUTO_RELOAD_SCREEN = null;
   }
 
+  if (timer < 0) liveScreen();
+  else if (SCREEN_WS) SCREEN_WS.close();
   if (timer > 0) taskReloader();
 }
 
+// Live mode: the device pushes the new draws through a websocket, no polling
+let SCREEN_WS = null;
+let SCREEN_WS_RENDER = Promise.resolve();
+function liveScreen() {
+  if (SCREEN_WS) return;
+  let proto = window.location.protocol === "https:" ? "wss://" : "ws://";
+  SCREEN_WS = new WebSocket(proto + window.location.host + (IS_DEV ? "/bruce" : "") + "/screenws");
+  SCREEN_WS.binaryType = "arraybuffer";
+  SCREEN_WS.onmessage = (e) => {
+    if (!$(".dialog.navigator:not(.hidden)")) {
+      SCREEN_WS.close();
+      return;
+    }
+    let data = new Uint8Array(e.data);
+    SCREEN_WS_RENDER = SCREEN_WS_RENDER.then(() => renderTFT(data)).catch(console.error);
+  };
+  SCREEN_WS.onclose = () => {
+    SCREEN_WS = null;
+    // fall back to polling while live mode is still selected and the navigator is open
+    if (parseInt(eConfigAutoReload.value) < 0 && $(".dialog.navigator:not(.hidden)")) {
+      setTimeout(async () => {
+        await reloadScreen();
+        autoReloadScreen();
+      }, 1000);
+    }
+  };
+}
+
 /// TFT RENDER
 let loadingDrawn = false;
 const imageCache = {}; // global
@@ -557,6 +591,7 @@ async function renderTFT(data) {
       18: ["x", "y", "center", "ms", "fs", "file"],                // DRAWIMAGE
       20: ["x", "y", "h", "fg"],                                  // DRAWFASTVLINE
       21: ["x", "y", "w", "fg"],                                   // DRAWFASTHLINE
+      98: ["seq"],                                                // SCREEN_SEQ
       99: ["w", "h", "rotation"]                                  // SCREEN_INFO
     };
 
@@ -565,6 +600,9 @@ async function renderTFT(data) {
     for (let key of keysMap[fn]) {
       if (['txt', 'file'].includes(key)) {
         r[key] = getByteValue(`s${lengthLeft}`);
+      } else if (key === 'seq') {
+        lengthLeft -= 4;
+        r[key] = (getByteValue('int16') * 65536) + getByteValue('int16');
       } else if (['rotation', 'fs'].includes(key)) {
         lengthLeft -= 1;
         r[key] = getByteValue('int8');
@@ -579,8 +617,9 @@ async function renderTFT(data) {
     return r;
   }
 
+  // Only the whole screen comes with SCREEN_INFO, which resets the canvas.
+  // Otherwise the draws go on top of what is already there
   let offset = 0;
-  ctx.clearRect(0, 0, canvas.width, canvas.height);
   while (offset < data.length) {
     ctx.beginPath();
     if (data[offset] !== 0xAA) {
@@ -599,6 +638,10 @@ async function renderTFT(data) {
     ctx.fillStyle = "black";
     ctx.strokeStyle = "black";
     switch (fn) {
+      case 98: // SCREEN_SEQ
+        SCREEN_SEQ = input.seq;
+        break;
+
       case 99: // SCREEN_INFO
         canvas.width = input.w;
         canvas.height = input.h;
@@ -764,6 +807,7 @@ function drawCanvasLoading() {
   ctx.textBaseline = "middle";
   ctx.fillText("Navigating...", width / 2, height / 2);
   ctx.restore();
+  SCREEN_SEQ = 0; // the overlay covers everything, next reload must redraw the whole screen
 }
 
 let oldTimerSession = sessionStorage.getItem("autoReload") || "0";
@@ -777,7 +821,7 @@ eConfigAutoReload.addEventListener("change", async (e) => {
 btnForceReload.addEventListener("click", async (e) => {
   e.preventDefault();
   drawCanvasLoading();
-  await reloadScreen();
+  await reloadScreen(true);
 });
 
 window.ondragenter = () => $(".upload-area").classList.remove("hidden");
@@ -906,6 +950,32 @@ $(".container").addEventListener("click", async (e) => {
     return;
   }
 
+  let actHashFile = e.target.closest(".act-hash");
+  if (actHashFile) {
+    e.preventDefault();
+    let file = actHashFile.closest(".file-row").getAttribute("data-file");
+    if (!file) return;
+
+    Dialog.loading.show('Hashing...');
+    try {
+      // the device hashes in the background, ask until it's done
+      let params = { fs: currentDrive, action: 'hash', name: file };
+      let res = await requestGet("/file", params, true);
+      params.action = 'hashstatus';
+      while (res.status === 202) {
+        Dialog.loading.show(res.text);
+        await new Promise(r => setTimeout(r, 500));
+        res = await requestGet("/file", params, true);
+      }
+      Dialog.loading.hide();
+      alert(`${file}\n\n${res.text}`);
+    } catch (error) {
+      Dialog.loading.hide();
+      alert("Failed to hash file: " + error.message);
+    }
+    return;
+  }
+
   let actPlay = e.target.closest(".act-play");
   if (actPlay) {
     e.preventDefault();
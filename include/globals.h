@@ -8,6 +8,7 @@
 #define ALCOLOR TFT_RED
 
 #include "core/config.h"
+#include "core/input_events.h"
 #include "core/configPins.h"
 #include "core/serial_commands/cli.h"
 #include "core/startup_app.h"
@@ -214,13 +215,14 @@ extern inline bool check(volatile bool &btn) {
 
 #ifndef USE_TFT_eSPI_TOUCH
     if (!btn) return false;
-    vTaskSuspend(xHandle);
+    // test and clear under the input lock, so a press set meanwhile by the input task isn't lost
+    inputLock();
+    bool pressed = btn;
     btn = false;
     AnyKeyPress = false;
     SerialCmdPress = false;
-    delay(10);
-    vTaskResume(xHandle);
-    return true;
+    inputUnlock();
+    return pressed;
 #else
 
     InputHandler();
@@ -34,6 +34,7 @@ enum tftFuncs : uint8_t { // DO NOT CHANGE THE ORDER, ADD NEW FUNCTIONS TO THE E
     DRAWFASTHLINE,        // 21
     // Add new ones here
 
+    SCREEN_SEQ = 98, // 98
     SCREEN_INFO = 99 // 99
 };
 #define MAX_LOG_ENTRIES 64
@@ -41,17 +42,28 @@ enum tftFuncs : uint8_t { // DO NOT CHANGE THE ORDER, ADD NEW FUNCTIONS TO THE E
 #define MAX_LOG_IMAGES 3
 #define MAX_LOG_IMG_PATH 512
 #define LOG_PACKET_HEADER 0xAA
+#define LOG_GRID 8       // spatial index of the log entries, LOG_GRID x LOG_GRID cells
+#define LOG_CELL_SHIFT 6 // 64px cells, coordinates past the grid go to the last cell
 struct tftLog {
     uint8_t data[MAX_LOG_SIZE];
 };
 class tft_logger : public BRUCE_TFT_DRIVER {
 private:
     tftLog log[MAX_LOG_ENTRIES];
+    uint32_t logSeq[MAX_LOG_ENTRIES];  // sequence of each entry, entries are sent in this order
+    uint32_t logHash[MAX_LOG_ENTRIES]; // to find duplicated entries without comparing all of them
+    uint8_t logCell[MAX_LOG_ENTRIES];  // cell of the entry in cellEntries
+    uint64_t cellEntries[LOG_GRID * LOG_GRID]; // bitmask of the entries anchored in each cell
+    uint64_t freeEntries = ~0ULL;
+    uint32_t seq = 0;       // sequence of the last logged entry
+    uint32_t resyncSeq = 1; // clients that haven't seen up to here need the whole screen
     char images[MAX_LOG_IMAGES][MAX_LOG_IMG_PATH];
-    uint8_t logWriteIndex = 0;
+    // the entries above are written by the drawing task and read by the WebUI and serial tasks
+    portMUX_TYPE logLock = portMUX_INITIALIZER_UNLOCKED;
     bool logging = false;
     bool _logging = false;
     void clearLog();
+    void dropLogEntry(int i);
 
 public:
     tft_logger(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
@@ -59,7 +71,12 @@ public:
     void setLogging(bool _log = true);
     bool inline getLogging(void) { return logging; };
 
+    // Sequence of the last logged draw, changes every time the mirrored screen changes
+    uint32_t getLogSeq() const { return seq; }
     void getBinLog(uint8_t *outBuffer, size_t &outSize);
+    // Writes the draws logged after `since` (the lastSeq of a previous call), or the whole screen
+    // when since is 0 or some of those draws are no longer in the log. Returns the bytes written
+    size_t getBinLogSince(uint8_t *outBuffer, size_t maxSize, uint32_t since, uint32_t *lastSeq = nullptr);
     bool removeLogEntriesInsideRect(int rx, int ry, int rw, int rh);
     void removeOverlappedImages(int x, int y, int center, int ms);
 
@@ -119,12 +136,10 @@ public:
     size_t printf(const char *format, ...);
 
 protected:
-    bool isLogEqual(const tftLog &a, const tftLog &b);
     void pushLogIfUnique(const tftLog &l);
     void checkAndLog(tftFuncs f, std::initializer_list<int32_t> values);
 
     void restoreLogger();
-    void addLogEntry(const uint8_t *buffer, uint8_t size);
     void logWriteHeader(uint8_t *buffer, uint8_t &pos, tftFuncs fn);
     void writeUint16(uint8_t *buffer, uint8_t &pos, uint16_t value);
 };
@@ -0,0 +1,15 @@
+#include "bus_lock.h"
+
+static SemaphoreHandle_t lock = nullptr;
+
+void busLockBegin() {
+    if (!lock) lock = xSemaphoreCreateRecursiveMutex();
+}
+
+void busLock() {
+    if (lock) xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+}
+
+void busUnlock() {
+    if (lock) xSemaphoreGiveRecursive(lock);
+}
@@ -0,0 +1,15 @@
+#ifndef __BUS_LOCK_H__
+#define __BUS_LOCK_H__
+
+#include <Arduino.h>
+
+/**
+ * @brief Lock for the SPI bus that the display, the SD card and radios like the CC1101 share on many
+ *        boards. Only needed when a background task uses the bus: that task holds it around its SD
+ *        or radio transfers, and the loop task holds it while it draws meanwhile. Recursive.
+ */
+void busLockBegin(); // at boot, before any task that uses it
+void busLock();
+void busUnlock();
+
+#endif
@@ -365,6 +365,7 @@ void BruceConfig::fromFile(bool checkFS) {
         mifareKeys.clear();
         JsonArray _mifareKeys = setting["mifareKeys"].as<JsonArray>();
         for (JsonVariant key : _mifareKeys) mifareKeys.insert(key.as<String>());
+        mifareKeysVersion++;
     } else {
         count++;
         log_e("Fail");
@@ -430,29 +431,79 @@ void BruceConfig::fromFile(bool checkFS) {
     log_i("Using config from file");
 }
 
-void BruceConfig::saveFile() {
-    FS *fs = &LittleFS;
-    JsonDocument jsonDoc = toJson();
+void BruceConfig::saveFile(uint16_t sections) {
+    dirtySections |= sections;
+    lastChange = millis();
+    saveRequests++;
+}
 
-    // Open file for writing
-    File file = fs->open(filepath, FILE_WRITE);
-    if (!file) {
-        log_e("Failed to open config file");
-        file.close();
+void BruceConfig::saveIfIdle() {
+    if (dirtySections && millis() - lastChange >= CONFIG_SAVE_DELAY) flush();
+}
+
+static uint32_t configHash(const String &content) {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < content.length(); i++) h = (h ^ (uint8_t)content[i]) * 16777619u;
+    return h;
+}
+
+void BruceConfig::flush() {
+    if (!dirtySections) return;
+    static portMUX_TYPE createLock = portMUX_INITIALIZER_UNLOCKED;
+    portENTER_CRITICAL(&createLock);
+    if (!saveLock) saveLock = xSemaphoreCreateMutexStatic(&saveLockBuffer);
+    portEXIT_CRITICAL(&createLock);
+    xSemaphoreTake(saveLock, portMAX_DELAY);
+    if (!dirtySections) { // written by whoever held the lock
+        xSemaphoreGive(saveLock);
         return;
-    };
+    }
+    uint16_t sections = dirtySections;
+    dirtySections = 0; // anything changed while writing marks it dirty again
 
-    // Serialize JSON to file
-    serializeJsonPretty(jsonDoc, Serial);
-    if (serializeJsonPretty(jsonDoc, file) < 5) log_e("Failed to write config file");
-    else log_i("config file written successfully");
+    String content;
+    serializeJsonPretty(toJson(), content);
+    uint32_t hash = configHash(content);
+    if (hash == lastSavedHash) {
+        unchangedSkips++;
+        log_i("config unchanged (sections 0x%x), write skipped", sections);
+        xSemaphoreGive(saveLock);
+        return;
+    }
 
-    file.close();
+    // Write a temp file and rename it over the config, so a reset mid write keeps the old file
+    FS *fs = &LittleFS;
+    String tmpPath = String(filepath) + ".tmp";
+    File file = fs->open(tmpPath, FILE_WRITE);
+    size_t written = 0;
+    if (file) {
+        written = file.print(content);
+        file.close();
+    }
+    if (written != content.length() || !fs->rename(tmpPath, filepath)) {
+        log_e("Failed to write config file");
+        fs->remove(tmpPath);
+        dirtySections |= sections; // try again after the next delay
+        lastChange = millis();
+        xSemaphoreGive(saveLock);
+        return;
+    }
+    lastSavedHash = hash;
+    fileWrites++;
+    log_d("%s", content.c_str());
+    log_i(
+        "config file written (sections 0x%x), %u of %u save requests avoided",
+        sections,
+        (unsigned)(saveRequests - fileWrites),
+        (unsigned)saveRequests
+    );
 
     if (setupSdCard()) copyToFs(LittleFS, SD, filepath, false);
+    xSemaphoreGive(saveLock);
 }
 
 void BruceConfig::factoryReset() {
+    dirtySections = 0; // the restart must not write the current config back
     FS *fs = &LittleFS;
     fs->rename(String(filepath), "/bak." + String(filepath).substring(1));
     if (setupSdCard()) SD.rename(String(filepath), "/bak." + String(filepath).substring(1));
@@ -484,13 +535,13 @@ void BruceConfig::validateConfig() {
 
 void BruceConfig::setUiColor(uint16_t primary, uint16_t *secondary, uint16_t *background) {
     BruceTheme::_setUiColor(primary, secondary, background);
-    saveFile();
+    saveFile(CONFIG_SETTINGS);
 }
 
 void BruceConfig::setRotation(int value) {
     rotation = value;
     validateRotationValue();
-    saveFile();
+    saveFile(CONFIG_SETTINGS);
 }
 
 void BruceConfig::validateRotationValue() {
@@ -500,7 +551,7 @@ void BruceConfig::validateRotationValue() {
 void BruceConfig::setDimmer(int value) {
     dimmerSet = value;
     validateDimmerValue();
-    saveFile();
+    saveFile(CONFIG_SETTINGS);
 }
 
 void BruceConfig::validateDimmerValue() {
@@ -511,7 +562,7 @@ void BruceConfig::validateDimmerValue() {
 void BruceConfig::setBright(uint8_t value) {
     bright = value;
     validateBrightValue();
-    saveFile();
+    saveFile(CONFIG_SETTINGS);
 }
 
 void BruceConfig::validateBrightValue() {
@@ -521,7 +572,7 @@ void BruceConfig::validateBrightValue() {
 void BruceConfig::setTmz(int value) {
     tmz = value;
     validateTmzValue();
-    saveFile();
+    saveFile(CONFIG_SETTINGS);
 }
 
 void BruceConfig::validateTmzValue() {
@@ -531,13 +582,13 @@ void BruceConfig::validateTmzValue() {
 void BruceConfig::setSoundEnabled(int value) {
     soundEnabled = value;
     validateSoundEnabledValue();
-    saveFile();
+    saveFile(CONFIG_SETTINGS);
 }
 
 void BruceConfig::setSoundVolume(int value) {
     soundVolume = value;
     validateSoundVolumeValue();
-    saveFile();
+    saveFile(CONFIG_SETTINGS);
 }
 
 void BruceConfig::validateSoundEnabledValue() {
@@ -551,7 +602,7 @@ void BruceConfig::validateSoundVolumeValue() {
 void BruceConfig::setWifiAtStartup(int value) {
     wifiAtStartup = value;
     validateWifiAtStartupValue();
-    saveFile();
+    saveFile(CONFIG_SETTINGS);
 }
 
 void BruceConfig::validateWifiAtStartupValue() {
@@ -561,7 +612,7 @@ void BruceConfig::validateWifiAtStartupValue() {
 void BruceConfig::setLedBright(int value) {
     ledBright = value;
     validateLedBrightValue();
-    saveFile();
+    saveFile(CONFIG_LED);
 }
 
 void BruceConfig::validateLedBrightValue() { ledBright = max(0, min(100, ledBright)); }
@@ -569,7 +620,7 @@ void BruceConfig::validateLedBrightValue() { ledBright = max(0, min(100, ledBrig
 void BruceConfig::setLedColor(uint32_t value) {
     ledColor = value;
     validateLedColorValue();
-    saveFile();
+    saveFile(CONFIG_LED);
 }
 
 void BruceConfig::validateLedColorValue() {
@@ -579,7 +630,7 @@ void BruceConfig::validateLedColorValue() {
 void BruceConfig::setLedBlinkEnabled(int value) {
     ledBlinkEnabled = value;
     validateLedBlinkEnabledValue();
-    saveFile();
+    saveFile(CONFIG_LED);
 }
 
 void BruceConfig::validateLedBlinkEnabledValue() {
@@ -589,7 +640,7 @@ void BruceConfig::validateLedBlinkEnabledValue() {
 void BruceConfig::setLedEffect(int value) {
     ledEffect = value;
     validateLedEffectValue();
-    saveFile();
+    saveFile(CONFIG_LED);
 }
 
 void BruceConfig::validateLedEffectValue() {
@@ -599,7 +650,7 @@ void BruceConfig::validateLedEffectValue() {
 void BruceConfig::setLedEffectSpeed(int value) {
     ledEffectSpeed = value;
     validateLedEffectSpeedValue();
-    saveFile();
+    saveFile(CONFIG_LED);
 }
 
 void BruceConfig::validateLedEffectSpeedValue() {
@@ -614,7 +665,7 @@ void BruceConfig::validateLedEffectSpeedValue() {
 void BruceConfig::setLedEffectDirection(int value) {
     ledEffectDirection = value;
     validateLedEffectDirectionValue();
-    saveFile();
+    saveFile(CONFIG_LED);
 }
 
 void BruceConfig::validateLedEffectDirectionValue() {
@@ -625,18 +676,18 @@ void BruceConfig::validateLedEffectDirectionValue() {
 void BruceConfig::setWebUICreds(const String &usr, const String &pwd) {
     webUI.user = usr;
     webUI.pwd = pwd;
-    saveFile();
+    saveFile(CONFIG_WIFI);
 }
 
 void BruceConfig::setWifiApCreds(const String &ssid, const String &pwd) {
     wifiAp.ssid = ssid;
     wifiAp.pwd = pwd;
-    saveFile();
+    saveFile(CONFIG_WIFI);
 }
 
 void BruceConfig::addWifiCredential(const String &ssid, const String &pwd) {
     wifi[ssid] = pwd;
-    saveFile();
+    saveFile(CONFIG_WIFI);
 }
 
 String BruceConfig::getWifiPassword(const String &ssid) const {
@@ -647,48 +698,48 @@ String BruceConfig::getWifiPassword(const String &ssid) const {
 
 void BruceConfig::addEvilWifiName(String value) {
     evilWifiNames.insert(value);
-    saveFile();
+    saveFile(CONFIG_WIFI);
 }
 
 void BruceConfig::removeEvilWifiName(String value) {
     evilWifiNames.erase(value);
-    saveFile();
+    saveFile(CONFIG_WIFI);
 }
 
 void BruceConfig::setBleName(String value) {
     bleName = value;
-    saveFile();
+    saveFile(CONFIG_BLE);
 }
 
 void BruceConfig::setIrTxPin(int value) {
     irTx = value;
-    saveFile();
+    saveFile(CONFIG_IR);
 }
 
 void BruceConfig::setIrTxRepeats(uint8_t value) {
     irTxRepeats = value;
-    saveFile();
+    saveFile(CONFIG_IR);
 }
 
 void BruceConfig::setIrRxPin(int value) {
     irRx = value;
-    saveFile();
+    saveFile(CONFIG_IR);
 }
 
 void BruceConfig::setRfTxPin(int value) {
     rfTx = value;
-    saveFile();
+    saveFile(CONFIG_RF);
 }
 
 void BruceConfig::setRfRxPin(int value) {
     rfRx = value;
-    saveFile();
+    saveFile(CONFIG_RF);
 }
 
 void BruceConfig::setRfModule(RFModules value) {
     rfModule = value;
     validateRfModuleValue();
-    saveFile();
+    saveFile(CONFIG_RF);
 }
 
 void BruceConfig::validateRfModuleValue() {
@@ -698,19 +749,19 @@ void BruceConfig::validateRfModuleValue() {
 void BruceConfig::setRfFreq(float value, int fxdFreq) {
     rfFreq = value;
     if (fxdFreq > 1) rfFxdFreq = fxdFreq;
-    saveFile();
+    saveFile(CONFIG_RF);
 }
 
 void BruceConfig::setRfFxdFreq(float value) {
     rfFxdFreq = value;
-    saveFile();
+    saveFile(CONFIG_RF);
 }
 
 void BruceConfig::setRfScanRange(int value, int fxdFreq) {
     rfScanRange = value;
     rfFxdFreq = fxdFreq;
     validateRfScanRangeValue();
-    saveFile();
+    saveFile(CONFIG_RF);
 }
 
 void BruceConfig::validateRfScanRangeValue() {
@@ -720,7 +771,7 @@ void BruceConfig::validateRfScanRangeValue() {
 void BruceConfig::setRfidModule(RFIDModules value) {
     rfidModule = value;
     validateRfidModuleValue();
-    saveFile();
+    saveFile(CONFIG_RFID);
 }
 
 void BruceConfig::validateRfidModuleValue() {
@@ -733,28 +784,31 @@ void BruceConfig::validateRfidModuleValue() {
 void BruceConfig::setiButtonPin(int value) {
     if (value < GPIO_NUM_MAX) {
         iButton = value;
-        saveFile();
+        saveFile(CONFIG_MISC);
     } else log_e("iButton: Gpio pin not set, incompatible with this device\n");
 }
 
 void BruceConfig::addMifareKey(String value) {
     if (value.length() != 12) return;
     mifareKeys.insert(value);
+    mifareKeysVersion++;
     validateMifareKeysItems();
-    saveFile();
+    saveFile(CONFIG_RFID);
 }
 
 void BruceConfig::validateMifareKeysItems() {
     for (auto key = mifareKeys.begin(); key != mifareKeys.end();) {
-        if (key->length() != 12) key = mifareKeys.erase(key);
-        else ++key;
+        if (key->length() != 12) {
+            key = mifareKeys.erase(key);
+            mifareKeysVersion++;
+        } else ++key;
     }
 }
 
 void BruceConfig::setGpsBaudrate(int value) {
     gpsBaudrate = value;
     validateGpsBaudrateValue();
-    saveFile();
+    saveFile(CONFIG_GPS);
 }
 
 void BruceConfig::validateGpsBaudrateValue() {
@@ -765,18 +819,18 @@ void BruceConfig::validateGpsBaudrateValue() {
 
 void BruceConfig::setStartupApp(String value) {
     startupApp = value;
-    saveFile();
+    saveFile(CONFIG_MISC);
 }
 
 void BruceConfig::setWigleBasicToken(String value) {
     wigleBasicToken = value;
-    saveFile();
+    saveFile(CONFIG_MISC);
 }
 
 void BruceConfig::setDevMode(int value) {
     devMode = value;
     validateDevModeValue();
-    saveFile();
+    saveFile(CONFIG_MISC);
 }
 
 void BruceConfig::validateDevModeValue() {
@@ -786,7 +840,7 @@ void BruceConfig::validateDevModeValue() {
 void BruceConfig::setColorInverted(int value) {
     colorInverted = value;
     validateColorInverted();
-    saveFile();
+    saveFile(CONFIG_MISC);
 }
 
 void BruceConfig::validateColorInverted() {
@@ -796,12 +850,12 @@ void BruceConfig::validateColorInverted() {
 void BruceConfig::addDisabledMenu(String value) {
     // TODO: check if duplicate
     disabledMenus.push_back(value);
-    saveFile();
+    saveFile(CONFIG_MISC);
 }
 
 void BruceConfig::addQrCodeEntry(const String &menuName, const String &content) {
     qrCodes.push_back({menuName, content});
-    saveFile();
+    saveFile(CONFIG_MISC);
 }
 
 void BruceConfig::removeQrCodeEntry(const String &menuName) {
@@ -818,5 +872,5 @@ void BruceConfig::removeQrCodeEntry(const String &menuName) {
 
     if (writeIndex < qrCodes.size()) { qrCodes.erase(qrCodes.begin() + writeIndex, qrCodes.end()); }
 
-    saveFile();
+    saveFile(CONFIG_MISC);
 }
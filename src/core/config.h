@@ -22,6 +22,22 @@ enum RFModules {
     CC1101_SPI_MODULE = 1,
 };
 
+#define CONFIG_SAVE_DELAY 1500 // ms without changes before a pending config write happens
+
+// Dirty bits, tell which part of the config changed since the last write
+enum ConfigSection : uint16_t {
+    CONFIG_SETTINGS = 1 << 0,
+    CONFIG_LED = 1 << 1,
+    CONFIG_WIFI = 1 << 2,
+    CONFIG_BLE = 1 << 3,
+    CONFIG_IR = 1 << 4,
+    CONFIG_RF = 1 << 5,
+    CONFIG_RFID = 1 << 6,
+    CONFIG_GPS = 1 << 7,
+    CONFIG_MISC = 1 << 8,
+    CONFIG_ALL = 0xFFFF
+};
+
 class BruceConfig : public BruceTheme {
 public:
     struct WiFiCredential {
@@ -66,7 +82,7 @@ public:
 
     void setWifiMAC(const String &mac) {
         wifiMAC = mac;
-        saveFile(); // opcional, para salvar imediatamente
+        saveFile(CONFIG_WIFI);
     }
 
     // BLE
@@ -91,6 +107,7 @@ public:
     // RFID
     int rfidModule = M5_RFID2_MODULE;
     std::set<String> mifareKeys = {};
+    uint32_t mifareKeysVersion = 0; // bumped on every change of mifareKeys, caches compare it
 
     // GPS
     int gpsBaudrate = 9600;
@@ -119,7 +136,12 @@ public:
     /////////////////////////////////////////////////////////////////////////////////////
     // Operations
     /////////////////////////////////////////////////////////////////////////////////////
-    void saveFile();
+    // Only marks the sections dirty, the file is written by saveIfIdle() once changes stop
+    // for CONFIG_SAVE_DELAY, or right away by flush() (before power off and restart).
+    // saveIfIdle() runs in the loop task from loopOptions(), never call either from the input task
+    void saveFile(uint16_t sections = CONFIG_ALL);
+    void saveIfIdle();
+    void flush();
     void fromFile(bool checkFS = true);
     void factoryReset();
     void validateConfig();
@@ -208,6 +230,17 @@ public:
     void validateColorInverted();
     void addDisabledMenu(String value);
     // TODO: removeDisabledMenu(String value);
+
+private:
+    volatile uint16_t dirtySections = 0;
+    volatile unsigned long lastChange = 0;
+    SemaphoreHandle_t saveLock = NULL; // one flush() at a time, the CLI and WebUI can reboot too
+    StaticSemaphore_t saveLockBuffer;
+    uint32_t lastSavedHash = 0;
+    // save stats
+    uint32_t saveRequests = 0;
+    uint32_t fileWrites = 0;
+    uint32_t unchangedSkips = 0;
 };
 
 #endif
@@ -1,5 +1,6 @@
 #include "configPins.h"
 #include "sd_functions.h"
+#include <globals.h>
 String getMacAddress() {
     uint8_t mac[6];
     esp_read_mac(mac, ESP_MAC_WIFI_STA);
@@ -186,6 +187,7 @@ void BruceConfigPins::factoryReset() {
     FS *fs = &LittleFS;
     fs->rename(String(filepath), "/bak." + String(filepath).substring(1));
     if (setupSdCard()) SD.rename(String(filepath), "/bak." + String(filepath).substring(1));
+    bruceConfig.flush(); // pending BruceConfig changes, the restart would lose them
     ESP.restart();
 }
 
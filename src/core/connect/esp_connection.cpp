@@ -6,7 +6,7 @@
 EspConnection *EspConnection::instance = nullptr;
 std::vector<Option> peerOptions;
 
-EspConnection::EspConnection() { setInstance(this); }
+EspConnection::EspConnection() : recvQueue(8), transferQueue(32) { setInstance(this); }
 
 EspConnection::~EspConnection() {
     esp_now_unregister_send_cb();
@@ -69,19 +69,6 @@ EspConnection::Message EspConnection::createMessage(String text) {
     return message;
 }
 
-EspConnection::Message EspConnection::createFileMessage(File file) {
-    Message message;
-    String path = String(file.path());
-
-    message.isFile = true;
-    message.totalBytes = file.size();
-
-    strncpy(message.filename, file.name(), ESP_FILENAME_SIZE);
-    strncpy(message.filepath, path.substring(0, path.lastIndexOf("/")).c_str(), ESP_FILEPATH_SIZE);
-
-    return message;
-}
-
 EspConnection::Message EspConnection::createPingMessage() {
     Message message;
     message.ping = true;
@@ -131,8 +118,6 @@ bool EspConnection::setupPeer(const uint8_t *mac) {
 }
 
 void EspConnection::printMessage(Message message) {
-    delay(100);
-
     Serial.println("Message Details:");
     if (message.ping) {
         Serial.println("Ping: " + String(message.ping));
@@ -178,26 +163,55 @@ void EspConnection::appendPeerToList(const uint8_t *mac) {
 }
 
 void EspConnection::onDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
+    // log_d, a file transfer sends hundreds of packets per second
     if (status == ESP_NOW_SEND_SUCCESS) {
         sendStatus = SUCCESS;
-        Serial.println("ESPNOW send success");
+        log_d("ESPNOW send success");
     } else {
         sendStatus = FAILED;
-        Serial.println("ESPNOW send fail");
+        log_d("ESPNOW send fail");
     }
 }
 
 void EspConnection::onDataRecv(const uint8_t *mac, const uint8_t *incomingData, int len) {
-    Message recvMessage;
+    // Runs in the WiFi task: copy the packet to a queue and return, the loop does the rest
+    if (len >= ESPNOW_FT_HEADER && len <= ESPNOW_FT_MTU && incomingData[0] == ESPNOW_FT_MAGIC) {
+        EspNowPacket packet;
+        memcpy(packet.mac, mac, 6);
+        packet.len = len;
+        memcpy(packet.data, incomingData, len);
+        if (!transferQueue.push(packet)) log_d("ESPNOW transfer queue full");
+        return;
+    }
+    if (len != sizeof(Message)) return;
 
-    // Use reinterpret_cast and copy assignment
-    const Message *incomingMessage = reinterpret_cast<const Message *>(incomingData);
-    recvMessage = *incomingMessage; // Use copy assignment
+    Message recvMessage;
+    memcpy(&recvMessage, incomingData, sizeof(Message));
 
     printMessage(recvMessage);
 
     if (recvMessage.ping) return sendPong(mac);
     if (recvMessage.pong) return appendPeerToList(mac);
 
-    recvQueue.push_back(recvMessage);
+    if (!recvQueue.push(recvMessage)) Serial.println("ESPNOW message queue full");
+}
+
+bool EspConnection::TransferLink::send(const uint8_t *data, size_t len) {
+    // ESP_ERR_ESPNOW_NO_MEM while the radio queue is full, the protocol sends it again later
+    return esp_now_send(conn.dstAddress, data, len) == ESP_OK;
+}
+
+bool EspConnection::TransferLink::receive(EspNowPacket &packet) {
+    while (conn.transferQueue.pop(packet)) {
+        if (peerSet) {
+            bool broadcast = conn.dstAddress[0] & 1; // any receiver can answer
+            if (broadcast || memcmp(packet.mac, conn.dstAddress, 6) == 0) return true;
+            continue; // a device we aren't talking to
+        }
+        if (!conn.setupPeer(packet.mac)) continue;
+        conn.setDstAddress(packet.mac);
+        peerSet = true;
+        return true;
+    }
+    return false;
 }
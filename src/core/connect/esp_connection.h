@@ -1,9 +1,9 @@
 #ifndef __ESP_CONNECTION_H__
 #define __ESP_CONNECTION_H__
 
+#include "espnow_transfer.h"
 #include <esp_now.h>
 #include <globals.h>
-#include <vector>
 
 #define ESP_FILENAME_SIZE 30
 #define ESP_FILEPATH_SIZE 50
@@ -34,9 +34,23 @@ public:
         bool pong;
 
         // Constructor to initialize defaults
+        // Zeroed arrays, filename[0] tells it apart from a file transfer packet (ESPNOW_FT_MAGIC)
         Message()
-            : dataSize(0), totalBytes(0), bytesSent(0), isFile(false), done(false), ping(false), pong(false) {
-        }
+            : filename{}, filepath{}, data{}, dataSize(0), totalBytes(0), bytesSent(0), isFile(false),
+              done(false), ping(false), pong(false) {}
+    };
+
+    // File transfer packets go to dstAddress. Without a peer yet (receiving side), the sender of the
+    // first packet becomes the peer and packets from other devices are ignored
+    class TransferLink : public EspNowTransport {
+    public:
+        TransferLink(EspConnection &connection, bool hasPeer) : conn(connection), peerSet(hasPeer) {}
+        bool send(const uint8_t *data, size_t len) override;
+        bool receive(EspNowPacket &packet) override;
+
+    private:
+        EspConnection &conn;
+        bool peerSet;
     };
 
     EspConnection();
@@ -56,13 +70,14 @@ protected:
     Status sendStatus;
     uint8_t dstAddress[6];
     uint8_t broadcastAddress[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-    std::vector<Message> recvQueue;
+    // Filled by the receive callback (WiFi task), emptied by the loop
+    SpscRing<Message> recvQueue;
+    SpscRing<EspNowPacket> transferQueue;
 
     bool beginSend();
     bool beginEspnow();
 
     Message createMessage(String text);
-    Message createFileMessage(File file);
     Message createPingMessage();
     Message createPongMessage();
 
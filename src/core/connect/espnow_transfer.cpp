@@ -0,0 +1,321 @@
+#include "espnow_transfer.h"
+#include <cstring>
+
+/*
+ * Packets: magic, type, u16 session, u32 seq (little endian), then
+ *   META   seq = file size; u16 chunk size, u8 window, "path\0name\0"
+ *   DATA   seq = chunk index; u32 CRC32 of the data, data
+ *   ACK    seq = chunks received in order; u32 bitmap, bit i = chunk seq + 1 + i received out of order
+ *   NACK   seq = chunk index that failed the CRC
+ *   ABORT
+ * The receiver ACKs META and every DATA. The sender resends the chunks missing below the highest one
+ * acknowledged, or not acknowledged after ESPNOW_FT_RTO_MS.
+ */
+enum PacketType : uint8_t { META = 1, DATA, ACK, NACK, ABORT };
+
+static inline void putLe16(uint8_t *p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static inline void putLe32(uint8_t *p, uint32_t v) {
+    putLe16(p, v);
+    putLe16(p + 2, v >> 16);
+}
+
+static inline uint16_t getLe16(const uint8_t *p) { return p[0] | p[1] << 8; }
+
+static inline uint32_t getLe32(const uint8_t *p) { return getLe16(p) | (uint32_t)getLe16(p + 2) << 16; }
+
+static void putHeader(uint8_t *p, uint8_t type, uint16_t session, uint32_t seq) {
+    p[0] = ESPNOW_FT_MAGIC;
+    p[1] = type;
+    putLe16(p + 2, session);
+    putLe32(p + 4, seq);
+}
+
+static void sendControl(EspNowTransport &link, uint8_t type, uint16_t session, uint32_t seq) {
+    uint8_t p[ESPNOW_FT_HEADER];
+    putHeader(p, type, session, seq);
+    link.send(p, sizeof(p));
+}
+
+// Reflected CRC-32 (zlib), one table lookup per byte
+struct Crc32Table {
+    uint32_t t[256];
+    Crc32Table() {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t crc = n;
+            for (int i = 0; i < 8; i++) crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+            t[n] = crc;
+        }
+    }
+};
+
+uint32_t espnow_crc32(const uint8_t *data, size_t len) {
+    static const Crc32Table table;
+    uint32_t crc = 0xFFFFFFFF;
+    while (len--) crc = table.t[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+bool LoopbackTransport::send(const uint8_t *data, size_t len) {
+    if (!peer || len > ESPNOW_FT_MTU) return false;
+    if (dropEvery && ++sent % dropEvery == 0) return true; // lost on the air
+    EspNowPacket packet = {};
+    packet.len = len;
+    memcpy(packet.data, data, len);
+    return peer->inbox.push(packet);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Sender
+/////////////////////////////////////////////////////////////////////////////////////
+EspNowFileSender::EspNowFileSender(EspNowTransport &transport, Reader reader)
+    : link(transport), read(reader) {}
+
+void EspNowFileSender::begin(
+    const std::string &path, const std::string &name, uint32_t fileSize, uint32_t now
+) {
+    session = ((rand() ^ now) & 0xFFFF) | 1;
+    size = fileSize;
+    chunks = (size + ESPNOW_FT_CHUNK - 1) / ESPNOW_FT_CHUNK;
+    base = 0;
+    acked = 0;
+    retransmits = 0;
+    for (int i = 0; i < ESPNOW_FT_WINDOW; i++) sent[i] = false;
+
+    putHeader(meta, META, session, size);
+    putLe16(meta + ESPNOW_FT_HEADER, ESPNOW_FT_CHUNK);
+    meta[ESPNOW_FT_HEADER + 2] = ESPNOW_FT_WINDOW;
+    metaLen = ESPNOW_FT_HEADER + 3;
+    // Too long names are cut, the path leaves room for the name terminator
+    size_t n = std::min(path.size(), sizeof(meta) - metaLen - 2);
+    memcpy(meta + metaLen, path.data(), n);
+    metaLen += n;
+    meta[metaLen++] = '\0';
+    n = std::min(name.size(), sizeof(meta) - metaLen - 1);
+    memcpy(meta + metaLen, name.data(), n);
+    metaLen += n;
+    meta[metaLen++] = '\0';
+
+    state = META;
+    metaSent = false;
+    lastHeard = now;
+}
+
+uint32_t EspNowFileSender::bytesAcked() const {
+    uint64_t bytes = (uint64_t)base * ESPNOW_FT_CHUNK;
+    return bytes < size ? bytes : size;
+}
+
+void EspNowFileSender::abort() {
+    if (state == META || state == SENDING) sendControl(link, ABORT, session, 0);
+    state = FAILED;
+}
+
+bool EspNowFileSender::poll(uint32_t now) {
+    EspNowPacket packet;
+    while (link.receive(packet)) handle(packet, now);
+    if (state != META && state != SENDING) return false;
+
+    if (now - lastHeard > ESPNOW_FT_TIMEOUT_MS) {
+        abort();
+        return false;
+    }
+
+    if (state == META) {
+        if ((!metaSent || now - metaSentAt >= ESPNOW_FT_META_MS) && link.send(meta, metaLen)) {
+            metaSent = true;
+            metaSentAt = now;
+        }
+        return true;
+    }
+
+    for (uint32_t i = 0; i < ESPNOW_FT_WINDOW && base + i < chunks; i++) {
+        if (acked & (1u << i)) continue;
+        if (sent[i] && now - sentAt[i] < ESPNOW_FT_RTO_MS) continue;
+        if (sent[i]) retransmits++;
+        if (!sendChunk(base + i, now)) break; // the radio queue is full, next poll
+    }
+    return state == SENDING;
+}
+
+bool EspNowFileSender::sendChunk(uint32_t index, uint32_t now) {
+    uint8_t p[ESPNOW_FT_MTU];
+    uint32_t offset = index * ESPNOW_FT_CHUNK;
+    size_t len = std::min<uint32_t>(ESPNOW_FT_CHUNK, size - offset);
+    if (read(offset, p + ESPNOW_FT_HEADER + 4, len) != len) {
+        abort();
+        return false;
+    }
+    putHeader(p, DATA, session, index);
+    putLe32(p + ESPNOW_FT_HEADER, espnow_crc32(p + ESPNOW_FT_HEADER + 4, len));
+    if (!link.send(p, ESPNOW_FT_HEADER + 4 + len)) return false;
+
+    sent[index - base] = true;
+    sentAt[index - base] = now;
+    return true;
+}
+
+void EspNowFileSender::handle(const EspNowPacket &packet, uint32_t now) {
+    const uint8_t *p = packet.data;
+    if (packet.len < ESPNOW_FT_HEADER || p[0] != ESPNOW_FT_MAGIC || getLe16(p + 2) != session) return;
+    if (state != META && state != SENDING) return;
+    lastHeard = now;
+    uint32_t seq = getLe32(p + 4);
+
+    if (p[1] == ABORT) {
+        state = FAILED;
+        return;
+    }
+    if (p[1] == NACK) {
+        if (seq >= base && seq < base + ESPNOW_FT_WINDOW) sent[seq - base] = false;
+        return;
+    }
+    if (p[1] != ACK) return;
+    if (state == META) state = SENDING;
+
+    // Slide the window to the chunks received in order
+    if (seq > base && seq <= chunks) {
+        uint32_t n = seq - base;
+        for (uint32_t i = 0; i < ESPNOW_FT_WINDOW; i++) {
+            sent[i] = i + n < ESPNOW_FT_WINDOW && sent[i + n];
+            sentAt[i] = i + n < ESPNOW_FT_WINDOW ? sentAt[i + n] : 0;
+        }
+        acked = n < 32 ? acked >> n : 0;
+        base = seq;
+    }
+    if (base >= chunks) {
+        state = DONE;
+        return;
+    }
+
+    // Chunks received out of order, and the ones sent before them that didn't arrive
+    uint32_t bitmap = packet.len >= ESPNOW_FT_HEADER + 4 ? getLe32(p + ESPNOW_FT_HEADER) : 0;
+    int highest = -1;
+    for (int j = 0; j < 32; j++) {
+        if (!(bitmap & (1u << j))) continue;
+        uint32_t index = seq + 1 + j;
+        if (index < base || index >= base + ESPNOW_FT_WINDOW) continue;
+        acked |= 1u << (index - base);
+        highest = index - base;
+    }
+    for (int i = 0; i < highest; i++) {
+        if (!(acked & (1u << i)) && sent[i] && (int32_t)(sentAt[highest] - sentAt[i]) >= 0) sent[i] = false;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Receiver
+/////////////////////////////////////////////////////////////////////////////////////
+EspNowFileReceiver::EspNowFileReceiver(EspNowTransport &transport, Opener opener, Writer writer)
+    : link(transport), open(opener), write(writer) {
+    window = new uint8_t[ESPNOW_FT_WINDOW * ESPNOW_FT_CHUNK];
+}
+
+EspNowFileReceiver::~EspNowFileReceiver() { delete[] window; }
+
+uint32_t EspNowFileReceiver::bytesWritten() const {
+    uint64_t bytes = (uint64_t)base * ESPNOW_FT_CHUNK;
+    return bytes < fileSize ? bytes : fileSize;
+}
+
+void EspNowFileReceiver::abort() {
+    if (state == RECEIVING) sendControl(link, ABORT, session, 0);
+    state = FAILED;
+}
+
+bool EspNowFileReceiver::poll(uint32_t now) {
+    EspNowPacket packet;
+    while (link.receive(packet)) handle(packet, now);
+    if (state == RECEIVING && now - lastHeard > ESPNOW_FT_TIMEOUT_MS) state = FAILED;
+    return state == WAITING || state == RECEIVING;
+}
+
+void EspNowFileReceiver::sendAck() {
+    uint8_t p[ESPNOW_FT_HEADER + 4];
+    putHeader(p, ACK, session, base);
+    putLe32(p + ESPNOW_FT_HEADER, received);
+    link.send(p, sizeof(p));
+}
+
+void EspNowFileReceiver::handle(const EspNowPacket &packet, uint32_t now) {
+    const uint8_t *p = packet.data;
+    if (packet.len < ESPNOW_FT_HEADER || p[0] != ESPNOW_FT_MAGIC) return;
+    uint8_t type = p[1];
+    uint16_t sess = getLe16(p + 2);
+    uint32_t seq = getLe32(p + 4);
+
+    if (state == WAITING) {
+        if (type != META || packet.len < ESPNOW_FT_HEADER + 3) return;
+        session = sess;
+        if (getLe16(p + ESPNOW_FT_HEADER) != ESPNOW_FT_CHUNK) { // another protocol version
+            sendControl(link, ABORT, session, 0);
+            return;
+        }
+        const char *strings = (const char *)p + ESPNOW_FT_HEADER + 3;
+        size_t left = packet.len - ESPNOW_FT_HEADER - 3;
+        size_t pathLen = strnlen(strings, left);
+        std::string path(strings, pathLen);
+        std::string name;
+        if (pathLen < left) {
+            const char *rest = strings + pathLen + 1;
+            name.assign(rest, strnlen(rest, left - pathLen - 1));
+        }
+
+        fileSize = seq;
+        chunks = (fileSize + ESPNOW_FT_CHUNK - 1) / ESPNOW_FT_CHUNK;
+        base = 0;
+        received = 0;
+        if (!open(path, name, fileSize)) {
+            sendControl(link, ABORT, session, 0);
+            state = FAILED;
+            return;
+        }
+        lastHeard = now;
+        state = chunks ? RECEIVING : DONE;
+        sendAck();
+        return;
+    }
+    if (sess != session) return;
+    lastHeard = now;
+
+    if (type == ABORT && state == RECEIVING) state = FAILED;
+    if (state == FAILED) return;
+    if (type == META) return sendAck(); // our first ACK was lost
+    if (type != DATA) return;
+
+    if (state == DONE || seq < base) return sendAck(); // resent, we have it
+    if (seq >= base + ESPNOW_FT_WINDOW || seq >= chunks) return;
+
+    size_t len = packet.len - ESPNOW_FT_HEADER - 4;
+    size_t expected = seq == chunks - 1 ? fileSize - seq * ESPNOW_FT_CHUNK : ESPNOW_FT_CHUNK;
+    const uint8_t *data = p + ESPNOW_FT_HEADER + 4;
+    if (packet.len < ESPNOW_FT_HEADER + 4 || len != expected ||
+        espnow_crc32(data, len) != getLe32(p + ESPNOW_FT_HEADER)) {
+        sendControl(link, NACK, session, seq);
+        return;
+    }
+
+    if (seq == base) {
+        if (!write(data, len)) return abort();
+        base++;
+        // received bit 0 is now chunk base, write what was waiting behind it
+        while (received & 1) {
+            uint32_t slot = base % ESPNOW_FT_WINDOW;
+            if (!write(window + slot * ESPNOW_FT_CHUNK, windowLen[slot])) return abort();
+            received >>= 1;
+            base++;
+        }
+        received >>= 1;
+    } else if (!(received & (1u << (seq - base - 1)))) {
+        uint32_t slot = seq % ESPNOW_FT_WINDOW;
+        memcpy(window + slot * ESPNOW_FT_CHUNK, data, len);
+        windowLen[slot] = len;
+        received |= 1u << (seq - base - 1);
+    }
+
+    if (base == chunks) state = DONE;
+    sendAck();
+}
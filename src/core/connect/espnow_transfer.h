@@ -0,0 +1,172 @@
+#ifndef __ESPNOW_TRANSFER_H__
+#define __ESPNOW_TRANSFER_H__
+
+// File transfer protocol used by FileSharing. Only the standard library here, no Arduino or ESP-NOW
+// code, the radio is behind EspNowTransport, so both ends can run on a host with LoopbackTransport.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+
+#define ESPNOW_FT_MAGIC 0xB5 // never the first byte of an EspConnection::Message (a UTF-8 continuation)
+#define ESPNOW_FT_MTU 250    // ESP-NOW payload limit
+#define ESPNOW_FT_HEADER 8
+#define ESPNOW_FT_CHUNK (ESPNOW_FT_MTU - ESPNOW_FT_HEADER - 4) // data per packet, after the chunk CRC
+#define ESPNOW_FT_WINDOW 16                                    // chunks in flight, at most 32 (ACK bitmap)
+#define ESPNOW_FT_RTO_MS 80       // resend a chunk not acknowledged after this
+#define ESPNOW_FT_META_MS 250     // resend the file info until the receiver answers
+#define ESPNOW_FT_TIMEOUT_MS 5000 // nothing heard from the other side, give up
+
+/**
+ * @brief Lock free queue between one producer and one consumer, e.g. the ESP-NOW receive callback
+ *        (WiFi task) and the loop that handles the packets. Full means the new item is dropped.
+ *        The slots are allocated once, capacity is rounded up to a power of 2.
+ */
+template <typename T> class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size = 1;
+        while (size < capacity) size <<= 1;
+        slots = new T[size];
+    }
+    ~SpscRing() { delete[] slots; }
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    bool push(const T &item) { // producer
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == size) return false;
+        slots[h & (size - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    bool pop(T &item) { // consumer
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        item = slots[t & (size - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed);
+    }
+    void clear() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); } // consumer
+
+private:
+    T *slots;
+    size_t size;
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+};
+
+struct EspNowPacket {
+    uint8_t mac[6];
+    uint8_t len;
+    uint8_t data[ESPNOW_FT_MTU];
+};
+
+class EspNowTransport {
+public:
+    virtual ~EspNowTransport() {}
+    virtual bool send(const uint8_t *data, size_t len) = 0; // false if it couldn't be queued, try later
+    virtual bool receive(EspNowPacket &packet) = 0;         // next packet, without waiting
+};
+
+// Two of them connected to each other. dropEvery > 0 loses every n-th packet sent, to test the recovery
+class LoopbackTransport : public EspNowTransport {
+public:
+    explicit LoopbackTransport(size_t queue = 64) : inbox(queue) {}
+    void connect(LoopbackTransport &other) { peer = &other; }
+    bool send(const uint8_t *data, size_t len) override;
+    bool receive(EspNowPacket &packet) override { return inbox.pop(packet); }
+
+    unsigned dropEvery = 0;
+    unsigned sent = 0;
+
+private:
+    SpscRing<EspNowPacket> inbox;
+    LoopbackTransport *peer = nullptr;
+};
+
+class EspNowFileSender {
+public:
+    // read(offset, buf, len) returns the bytes read
+    using Reader = std::function<size_t(uint32_t offset, uint8_t *buf, size_t len)>;
+
+    EspNowFileSender(EspNowTransport &transport, Reader reader);
+
+    void begin(const std::string &path, const std::string &name, uint32_t fileSize, uint32_t now);
+    bool poll(uint32_t now); // false once finished, check done() or failed()
+    void abort();
+
+    bool done() const { return state == DONE; }
+    bool failed() const { return state == FAILED; }
+    uint32_t bytesAcked() const;
+    uint32_t retransmits = 0;
+
+private:
+    enum State { IDLE, META, SENDING, DONE, FAILED };
+    EspNowTransport &link;
+    Reader read;
+    State state = IDLE;
+    uint16_t session = 0;
+    uint32_t size = 0;
+    uint32_t chunks = 0;
+    uint32_t base = 0; // chunks before it are acknowledged
+    uint32_t acked = 0; // bit i: chunk base + i acknowledged
+    uint32_t sentAt[ESPNOW_FT_WINDOW];
+    bool sent[ESPNOW_FT_WINDOW];
+    uint32_t lastHeard = 0;
+    bool metaSent = false;
+    uint32_t metaSentAt = 0;
+    uint8_t meta[ESPNOW_FT_MTU];
+    size_t metaLen = 0;
+
+    void handle(const EspNowPacket &packet, uint32_t now);
+    bool sendChunk(uint32_t index, uint32_t now);
+};
+
+class EspNowFileReceiver {
+public:
+    // open(path, name, size) prepares the output, false refuses the file. write(buf, len) appends
+    using Opener = std::function<bool(const std::string &path, const std::string &name, uint32_t size)>;
+    using Writer = std::function<bool(const uint8_t *buf, size_t len)>;
+
+    EspNowFileReceiver(EspNowTransport &transport, Opener opener, Writer writer);
+    ~EspNowFileReceiver();
+
+    bool poll(uint32_t now); // false once finished, keep polling a bit after done() to repeat the last ACK
+    void abort();
+
+    bool started() const { return state != WAITING; }
+    bool done() const { return state == DONE; }
+    bool failed() const { return state == FAILED; }
+    uint32_t size() const { return fileSize; }
+    uint32_t bytesWritten() const;
+
+private:
+    enum State { WAITING, RECEIVING, DONE, FAILED };
+    EspNowTransport &link;
+    Opener open;
+    Writer write;
+    State state = WAITING;
+    uint16_t session = 0;
+    uint32_t fileSize = 0;
+    uint32_t chunks = 0;
+    uint32_t base = 0;     // chunks before it are written
+    uint32_t received = 0; // bit i: chunk base + 1 + i is buffered
+    uint8_t *window = nullptr;
+    uint8_t windowLen[ESPNOW_FT_WINDOW];
+    uint32_t lastHeard = 0;
+
+    void handle(const EspNowPacket &packet, uint32_t now);
+    void sendAck();
+};
+
+uint32_t espnow_crc32(const uint8_t *data, size_t len);
+
+#endif
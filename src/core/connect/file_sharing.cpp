@@ -15,44 +15,43 @@ void FileSharing::sendFile() {
         return;
     }
 
-    Message message = createFileMessage(file);
+    String path = String(file.path());
+    path = path.substring(0, path.lastIndexOf("/"));
 
-    esp_err_t response;
-    sendStatus = STARTED;
+    TransferLink link(*this, true);
+    EspNowFileSender sender(link, [&](uint32_t offset, uint8_t *buf, size_t len) -> size_t {
+        if (file.position() != offset) file.seek(offset);
+        return file.read(buf, len);
+    });
 
     drawMainBorderWithTitle("SEND FILE");
     padprintln("");
     padprintln("Sending...");
 
-    delay(100);
+    transferQueue.clear();
+    sender.begin(path.c_str(), file.name(), file.size(), millis());
 
-    while (file.available()) {
-        if (check(EscPress)) sendStatus = ABORTED;
-
-        if (sendStatus == ABORTED || sendStatus == FAILED) {
-            message.done = true;
-            message.dataSize = 0;
-            esp_now_send(dstAddress, (uint8_t *)&message, sizeof(message));
-            displayError("Error sending file");
+    uint32_t lastProgress = 0;
+    while (sender.poll(millis())) {
+        if (check(EscPress)) {
+            sender.abort();
             break;
         }
-
-        size_t bytesRead = file.readBytes(message.data, ESP_DATA_SIZE);
-        message.dataSize = bytesRead;
-        message.bytesSent = min(message.bytesSent + bytesRead, message.totalBytes);
-        message.done = message.bytesSent == message.totalBytes;
-
-        response = esp_now_send(dstAddress, (uint8_t *)&message, sizeof(message));
-        if (response != ESP_OK) {
-            Serial.printf("Send file response: %s\n", esp_err_to_name(response));
-            sendStatus = FAILED;
+        // the bar is slow to draw, the transfer isn't
+        if (file.size() && millis() - lastProgress > 200) {
+            progressHandler(sender.bytesAcked(), file.size(), "Sending...");
+            lastProgress = millis();
         }
-
-        progressHandler(file.position(), file.size(), "Sending...");
-        delay(100);
+        vTaskDelay(1);
     }
 
-    if (message.bytesSent == message.totalBytes) displaySuccess("File sent");
+    if (sender.done()) displaySuccess("File sent");
+    else displayError("Error sending file");
+    Serial.printf(
+        "ESPNOW file: %lu bytes acked, %lu resent\n",
+        (unsigned long)sender.bytesAcked(),
+        (unsigned long)sender.retransmits
+    );
 
     file.close();
     delay(1000);
@@ -64,43 +63,48 @@ void FileSharing::receiveFile() {
     padprintln("Waiting...");
 
     recvFileName = "";
-    recvQueue = {};
-    recvStatus = CONNECTING;
 
     if (!beginEspnow()) return;
 
-    delay(100);
-
-    while (1) {
-        if (check(EscPress)) recvStatus = ABORTED;
-
-        if (recvStatus == ABORTED || recvStatus == FAILED) {
-            displayError("Error receiving file");
+    File file;
+    TransferLink link(*this, false);
+    EspNowFileReceiver receiver(
+        link,
+        [&](const std::string &path, const std::string &name, uint32_t size) {
+            FS *fs;
+            if (!getFsStorage(fs)) return false;
+            createFilename(fs, path.c_str(), name.c_str());
+            file = fs->open(recvFileName, FILE_WRITE);
+            return (bool)file;
+        },
+        [&](const uint8_t *buf, size_t len) { return file.write(buf, len) == len; }
+    );
+
+    transferQueue.clear();
+
+    uint32_t lastProgress = 0;
+    while (receiver.poll(millis())) {
+        if (check(EscPress)) {
+            receiver.abort();
             break;
         }
-        if (recvStatus == SUCCESS) {
-            displaySuccess("File received");
-            break;
-        }
-
-        if (!recvQueue.empty()) {
-            Message recvFileMessage = recvQueue.front();
-            recvQueue.erase(recvQueue.begin());
-
-            progressHandler(recvFileMessage.bytesSent, recvFileMessage.totalBytes, "Receiving...");
-
-            if (!appendToFile(recvFileMessage)) {
-                recvStatus = FAILED;
-                Serial.println("Failed appending to file");
-            }
-            if (recvFileMessage.done) {
-                Serial.println("Recv done");
-                recvStatus = recvFileMessage.bytesSent == recvFileMessage.totalBytes ? SUCCESS : FAILED;
-            }
+        if (receiver.size() && millis() - lastProgress > 200) {
+            progressHandler(receiver.bytesWritten(), receiver.size(), "Receiving...");
+            lastProgress = millis();
         }
-
-        delay(100);
+        vTaskDelay(1);
+    }
+    // The sender may not have the last ACK yet, answer its retries for a moment
+    uint32_t doneAt = millis();
+    while (receiver.done() && millis() - doneAt < 500) {
+        receiver.poll(millis());
+        vTaskDelay(1);
     }
+    if (file) file.close();
+
+    recvStatus = receiver.done() ? SUCCESS : FAILED;
+    if (recvStatus == SUCCESS) displaySuccess("File received");
+    else displayError("Error receiving file");
 
     delay(1000);
 
@@ -133,25 +137,7 @@ File FileSharing::selectFile() {
     return file;
 }
 
-bool FileSharing::appendToFile(FileSharing::Message fileMessage) {
-    FS *fs;
-    if (!getFsStorage(fs)) return false;
-
-    if (recvFileName == "") createFilename(fs, fileMessage);
-
-    File file = (*fs).open(recvFileName, FILE_APPEND);
-    if (!file) return false;
-
-    file.write((const uint8_t *)fileMessage.data, fileMessage.dataSize);
-    file.close();
-
-    return true;
-}
-
-void FileSharing::createFilename(FS *fs, FileSharing::Message fileMessage) {
-    String messageFilename = String(fileMessage.filename);
-    String messageFilepath = String(fileMessage.filepath);
-
+void FileSharing::createFilename(FS *fs, String messageFilepath, String messageFilename) {
     String filename = messageFilename.substring(0, messageFilename.lastIndexOf("."));
     String ext = messageFilename.substring(messageFilename.lastIndexOf("."));
 
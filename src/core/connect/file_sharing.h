@@ -23,8 +23,7 @@ private:
     // Helpers
     /////////////////////////////////////////////////////////////////////////////////////
     File selectFile();
-    bool appendToFile(Message fileMessage);
-    void createFilename(FS *fs, Message fileMessage);
+    void createFilename(FS *fs, String filepath, String messageFilename);
 };
 
 #endif
@@ -85,10 +85,7 @@ void EspSerialCmd::receiveCommands() {
             recvStatus = WAITING;
         }
 
-        if (!recvQueue.empty()) {
-            recvMessage = recvQueue.front();
-            recvQueue.erase(recvQueue.begin());
-
+        if (recvQueue.pop(recvMessage)) {
             recvCommand = recvMessage.data;
             Serial.println(recvCommand);
 
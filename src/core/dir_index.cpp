@@ -0,0 +1,127 @@
+#include "dir_index.h"
+#include "sd_functions.h" // checkExt
+#include <algorithm>
+
+bool DirCursor::open(FS &fs, const String &folder, bool withSizes) {
+    close();
+    root = fs.open(folder);
+    if (!root || !root.isDirectory()) {
+        close();
+        return false;
+    }
+    sizes = withSizes;
+    return true;
+}
+
+bool DirCursor::next(String &name, bool &folder, size_t &size) {
+    if (!root) return false;
+    if (sizes) {
+        File file = root.openNextFile();
+        if (!file) return false;
+        name = file.name();
+        folder = file.isDirectory();
+        size = folder ? 0 : file.size();
+        file.close();
+    } else {
+        name = root.getNextFileName(&folder);
+        if (name.length() == 0) return false;
+        size = 0;
+    }
+    int slash = name.lastIndexOf('/');
+    if (slash >= 0) name.remove(0, slash + 1);
+    return true;
+}
+
+void DirCursor::close() {
+    if (root) root.close();
+    root = File();
+}
+
+static inline uint8_t foldChar(char c) { return toupper((unsigned char)c); }
+
+static int foldCompare(const char *a, const char *b) {
+    while (*a && foldChar(*a) == foldChar(*b)) {
+        a++;
+        b++;
+    }
+    return foldChar(*a) - foldChar(*b);
+}
+
+bool DirIndex::grow(void **buf, size_t &cap, size_t need, size_t itemSize) {
+    if (need <= cap) return true;
+    size_t newCap = cap ? cap + cap / 2 : 64;
+    if (newCap < need) newCap = need;
+    size_t bytes = newCap * itemSize;
+    void *p;
+    if (psramFound()) p = ps_realloc(*buf, bytes);
+    else {
+        if (ESP.getFreeHeap() < bytes - cap * itemSize + DIR_INDEX_HEAP_RESERVE) return false;
+        p = realloc(*buf, bytes);
+    }
+    if (!p) return false;
+    *buf = p;
+    cap = newCap;
+    return true;
+}
+
+bool DirIndex::add(const char *name, bool folder, size_t size, bool operation) {
+    size_t len = strlen(name) + 1;
+    if (!grow((void **)&entries, capacity, count + 1, sizeof(Entry)) ||
+        !grow((void **)&pool, poolCap, poolLen + len, 1)) {
+        truncated = true;
+        return false;
+    }
+
+    Entry &e = entries[count++];
+    e.name = poolLen;
+    e.size = size;
+    e.key = 0;
+    for (int i = 0; i < 4 && name[i]; i++) e.key |= (uint32_t)foldChar(name[i]) << (24 - 8 * i);
+    e.flags = (folder ? FOLDER : 0) | (operation ? OPERATION : 0);
+
+    memcpy(pool + poolLen, name, len);
+    poolLen += len;
+    return true;
+}
+
+bool DirIndex::load(FS &fs, const String &folder, const String &allowed_ext, bool withSizes) {
+    clear();
+    DirCursor dir;
+    if (!dir.open(fs, folder, withSizes)) return false;
+
+    String name;
+    bool isFolder;
+    size_t fileSize;
+    while (dir.next(name, isFolder, fileSize)) {
+        if (!isFolder && allowed_ext != "*" &&
+            !checkExt(name.substring(name.lastIndexOf('.') + 1), allowed_ext))
+            continue;
+        if (!add(name.c_str(), isFolder, fileSize)) break;
+    }
+    dir.close();
+
+    if (truncated) Serial.printf("DirIndex: out of memory, listing stopped at %u entries\n", count);
+    sort();
+    return true;
+}
+
+void DirIndex::sort() {
+    const char *names = pool;
+    std::sort(entries, entries + count, [names](const Entry &a, const Entry &b) {
+        // Operations stay at the bottom, then folders before files
+        if ((a.flags & OPERATION) != (b.flags & OPERATION)) return (b.flags & OPERATION) != 0;
+        if ((a.flags & FOLDER) != (b.flags & FOLDER)) return (a.flags & FOLDER) != 0;
+        if (a.key != b.key) return a.key < b.key;
+        if ((a.key & 0xFF) == 0) return false; // under 4 chars, the key was the whole name
+        return foldCompare(names + a.name + 4, names + b.name + 4) < 0;
+    });
+}
+
+void DirIndex::clear() {
+    free(entries);
+    free(pool);
+    entries = nullptr;
+    pool = nullptr;
+    count = capacity = poolLen = poolCap = 0;
+    truncated = false;
+}
@@ -0,0 +1,68 @@
+#ifndef __DIR_INDEX_H__
+#define __DIR_INDEX_H__
+
+#include <FS.h>
+
+// Keeps this much internal heap free when there is no PSRAM, the listing stops there
+#define DIR_INDEX_HEAP_RESERVE 40000
+
+/**
+ * @brief Walks a directory one entry at a time, without keeping the list.
+ *        Without sizes it reads only the names, FAT doesn't need to open every file for that.
+ */
+class DirCursor {
+public:
+    bool open(FS &fs, const String &folder, bool withSizes = false);
+    bool next(String &name, bool &folder, size_t &size); // name without the path
+    void close();
+
+private:
+    File root;
+    bool sizes = false;
+};
+
+/**
+ * @brief Sorted listing of a directory: folders first, then case insensitive by name.
+ *        Names go in one pool and each entry keeps the first 4 upper cased chars as an integer, so
+ *        most comparisons of the sort never touch the strings. Any entry is reached by index, the
+ *        file browser only draws the rows on screen.
+ */
+class DirIndex {
+public:
+    DirIndex() = default;
+    ~DirIndex() { clear(); }
+    DirIndex(const DirIndex &) = delete; // owns entries and pool
+    DirIndex &operator=(const DirIndex &) = delete;
+
+    bool load(FS &fs, const String &folder, const String &allowed_ext = "*", bool withSizes = false);
+    bool add(const char *name, bool folder, size_t size = 0, bool operation = false);
+    void sort();
+    void clear(); // frees the memory too
+
+    size_t size() const { return count; }
+    const char *name(size_t i) const { return pool + entries[i].name; }
+    bool isFolder(size_t i) const { return entries[i].flags & FOLDER; }
+    bool isOperation(size_t i) const { return entries[i].flags & OPERATION; }
+    size_t fileSize(size_t i) const { return entries[i].size; }
+    bool truncated = false; // ran out of memory while loading
+
+private:
+    enum { FOLDER = 1, OPERATION = 2 };
+    struct Entry {
+        uint32_t name; // offset in the pool
+        uint32_t size;
+        uint32_t key; // first 4 chars upper cased, big endian
+        uint8_t flags;
+    };
+
+    Entry *entries = nullptr;
+    size_t count = 0;
+    size_t capacity = 0;
+    char *pool = nullptr;
+    size_t poolLen = 0;
+    size_t poolCap = 0;
+
+    bool grow(void **buf, size_t &cap, size_t need, size_t itemSize);
+};
+
+#endif
@@ -465,6 +465,7 @@ int loopOptions(
     if (index >= options.size()) index = 0;
     bool firstRender = true;
     drawMainBorder();
+    inputFlush(); // presses from the previous screen
     while (1) {
         // Check for shutdown before drawing menu to avoid drawing a black bar on the screen
         if (exit) break;
@@ -501,6 +502,7 @@ int loopOptions(
             }
             firstRender = false;
             redraw = false;
+            inputRedrawn();
         }
 
         // handleSerialCommands(); // always use serial task for it
@@ -559,7 +561,6 @@ int loopOptions(
             if ((index + 1) > options.size()) index = 0;
             redraw = true;
         }
-        vTaskDelay(10 / portTICK_PERIOD_MS);
 
         /* Select and run function
         forceMenuOption is set by a SerialCommand to force a selection within the menu
@@ -601,6 +602,11 @@ int loopOptions(
 #elif defined(T_EMBED) || defined(HAS_TOUCH) || !defined(HAS_SCREEN)
         if (menuType != MENU_TYPE_MAIN && check(EscPress)) break;
 #endif
+        // sleep until the input task posts a press, instead of spinning
+        if (!redraw) {
+            bruceConfig.saveIfIdle(); // settings are changed from menus, write them from this task
+            inputWait(INPUT_IDLE_WAIT_MS);
+        }
     }
     return index;
 }
@@ -929,7 +935,7 @@ void drawWireguardStatus(int x, int y) {
 ** Description:   Função para desenhar e mostrar o menu principal
 ***************************************************************************************/
 #define MAX_ITEMS (int)(tftHeight - 20) / (LH * FM)
-Opt_Coord listFiles(int index, std::vector<FileList> fileList) {
+Opt_Coord listFiles(int index, const DirIndex &fileList) {
     Opt_Coord coord;
     if (index == 0) { tft.fillScreen(bruceConfig.bgColor); }
     tft.setCursor(10, 10);
@@ -941,14 +947,15 @@ Opt_Coord listFiles(int index, std::vector<FileList> fileList) {
         start = index - MAX_ITEMS + 1;
         if (start < 0) start = 0;
     }
+    i = start; // only the rows on screen are touched
     int nchars = (tftWidth - 20) / (6 * tft.textsize);
     String txt = ">";
     while (i < arraySize) {
         if (i >= start) {
             tft.setCursor(10, tft.getCursorY());
-            if (fileList[i].folder == true)
+            if (fileList.isFolder(i))
                 tft.setTextColor(getColorVariation(bruceConfig.priColor), bruceConfig.bgColor);
-            else if (fileList[i].operation == true) tft.setTextColor(ALCOLOR, bruceConfig.bgColor);
+            else if (fileList.isOperation(i)) tft.setTextColor(ALCOLOR, bruceConfig.bgColor);
             else { tft.setTextColor(bruceConfig.priColor, bruceConfig.bgColor); }
 
             if (index == i) {
@@ -957,10 +964,11 @@ Opt_Coord listFiles(int index, std::vector<FileList> fileList) {
                 coord.y = tft.getCursorY();
                 coord.size = nchars;
                 coord.fgcolor =
-                    fileList[i].folder ? getColorVariation(bruceConfig.priColor) : bruceConfig.priColor;
+                    fileList.isFolder(i) ? getColorVariation(bruceConfig.priColor) : bruceConfig.priColor;
                 coord.bgcolor = bruceConfig.bgColor;
             } else txt = " ";
-            txt += fileList[i].filename + "                 ";
+            txt += fileList.name(i);
+            txt += "                 ";
             tft.println(txt.substring(0, nchars));
         }
         i++;
@@ -1077,78 +1085,146 @@ void drawMfkey64Icon(int x, int y) {
 // ####################################################################################################
 //  from:
 //  https://github.com/Bodmer/TFT_eSPI/blob/master/examples/Generic/ESP32_SDcard_jpeg/ESP32_SDcard_jpeg.ino
-//  This function assumes xpos,ypos is a valid screen coordinate. For convenience images that do not
-//  fit totally on the screen are cropped to the nearest MCU size and may leave right/bottom borders.
-void jpegRender(int xpos, int ypos) {
+//  The file is read in JPEG_READ_BUFFER blocks and the MCUs are gathered in a buffer of one MCU row,
+//  pushed to the screen once complete, so memory use doesn't depend on the file size.
+//  Images small enough are decoded whole into PSRAM and kept in a small LRU cache for redraws.
+#define JPEG_READ_BUFFER 4096            // file reads are done in blocks of this size
+#define JPEG_CACHE_SIZE (128 * 1024)     // bytes of decoded RGB565 images kept in PSRAM
+#define JPEG_CACHE_MAX_IMAGE (64 * 1024) // bigger images are never cached
+#define JPEG_CACHE_ENTRIES 4
+
+struct JpegCacheEntry {
+    FS *fs;
+    String path;
+    size_t fileSize;
+    time_t lastWrite;
+    uint16_t w;
+    uint16_t h;
+    uint16_t *pixels;
+    uint32_t lastUse;
+};
+static JpegCacheEntry jpegCache[JPEG_CACHE_ENTRIES];
+static size_t jpegCacheUsed = 0;
+static uint32_t jpegCacheClock = 0;
+
+static JpegCacheEntry *jpegCacheFind(FS *fs, const String &path, size_t fileSize, time_t lastWrite) {
+    for (auto &e : jpegCache) {
+        if (e.pixels && e.fs == fs && e.fileSize == fileSize && e.lastWrite == lastWrite && e.path == path) {
+            e.lastUse = ++jpegCacheClock;
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+static void jpegCacheEvict(JpegCacheEntry &e) {
+    jpegCacheUsed -= (size_t)e.w * e.h * 2;
+    free(e.pixels);
+    e.pixels = nullptr;
+    e.path = "";
+}
+
+// Returns a PSRAM buffer for the whole image when it can be cached, evicting the least used ones
+static uint16_t *jpegCacheAlloc(uint32_t w, uint32_t h) {
+    size_t bytes = w * h * 2;
+    if (!psramFound() || bytes > JPEG_CACHE_MAX_IMAGE) return nullptr;
+    for (;;) {
+        JpegCacheEntry *lru = nullptr, *freeSlot = nullptr;
+        for (auto &e : jpegCache) {
+            if (!e.pixels) freeSlot = &e;
+            else if (!lru || e.lastUse < lru->lastUse) lru = &e;
+        }
+        if (freeSlot && jpegCacheUsed + bytes <= JPEG_CACHE_SIZE) break;
+        if (!lru) return nullptr;
+        jpegCacheEvict(*lru);
+    }
+    return (uint16_t *)ps_malloc(bytes);
+}
+
+static void jpegCacheInsert(FS *fs, const String &path, size_t fileSize, time_t lastWrite, uint16_t *pixels) {
+    for (auto &e : jpegCache) {
+        if (e.pixels) continue;
+        e = {fs,
+             path,
+             fileSize,
+             lastWrite,
+             (uint16_t)JpegDec.width,
+             (uint16_t)JpegDec.height,
+             pixels,
+             ++jpegCacheClock};
+        jpegCacheUsed += (size_t)e.w * e.h * 2;
+        return;
+    }
+    free(pixels);
+}
+
+// Decodes into `image` (whole picture) when given, otherwise into a buffer of one MCU row.
+// Returns the size of the buffer used
+size_t jpegRender(int xpos, int ypos, uint16_t *image) {
 
     // jpegInfo(); // Print information from the JPEG file (could comment this line out)
 
-    uint16_t *pImg;
     uint16_t mcu_w = JpegDec.MCUWidth;
     uint16_t mcu_h = JpegDec.MCUHeight;
-    uint32_t max_x = JpegDec.width;
-    uint32_t max_y = JpegDec.height;
+    uint32_t img_w = JpegDec.width;
+    uint32_t img_h = JpegDec.height;
+
+    size_t bufSize = image ? img_w * img_h * 2 : img_w * mcu_h * 2;
+    uint16_t *buf = image;
+    if (!buf) buf = (uint16_t *)(psramFound() ? ps_malloc(bufSize) : malloc(bufSize));
+    if (!buf) bufSize = 0; // no memory for a row, push each MCU on its own
 
     bool swapBytes = tft.getSwapBytes();
     tft.setSwapBytes(true);
 
+    if (!image) tft.fillRect(xpos, ypos, img_w, img_h, TFT_BLACK);
+    int rowY = -1;
     // Jpeg images are draw as a set of image block (tiles) called Minimum Coding Units (MCUs)
-    // Typically these MCUs are 16x16 pixel blocks
-    // Determine the width and height of the right and bottom edge image blocks
-    uint32_t min_w = jpg_min(mcu_w, max_x % mcu_w);
-    uint32_t min_h = jpg_min(mcu_h, max_y % mcu_h);
-
-    // save the current image block size
-    uint32_t win_w = mcu_w;
-    uint32_t win_h = mcu_h;
-
-    // save the coordinate of the right and bottom edges to assist image cropping
-    // to the screen size
-    max_x += xpos;
-    max_y += ypos;
-
-    // Fetch data from the file, decode and display
-    tft.fillRect(xpos, ypos, JpegDec.width, JpegDec.height, TFT_BLACK);
-    while (JpegDec.read()) {   // While there is more data in the file
-        pImg = JpegDec.pImage; // Decode a MCU (Minimum Coding Unit, typically a 8x8 or 16x16 pixel block)
-
-        // Calculate coordinates of top left corner of current MCU
-        int mcu_x = JpegDec.MCUx * mcu_w + xpos;
-        int mcu_y = JpegDec.MCUy * mcu_h + ypos;
-
-        // check if the image block size needs to be changed for the right edge
-        if (mcu_x + mcu_w <= max_x) win_w = mcu_w;
-        else win_w = min_w;
-
-        // check if the image block size needs to be changed for the bottom edge
-        if (mcu_y + mcu_h <= max_y) win_h = mcu_h;
-        else win_h = min_h;
-
-        // copy pixels into a contiguous block
-        if (win_w != mcu_w) {
-            uint16_t *cImg;
-            int p = 0;
-            cImg = pImg + win_w;
-            for (int h = 1; h < win_h; h++) {
-                p += mcu_w;
-                for (int w = 0; w < win_w; w++) {
-                    *cImg = *(pImg + w + p);
-                    cImg++;
-                }
-            }
+    // Typically these MCUs are 16x16 pixel blocks, decoded left to right, top to bottom
+    while (JpegDec.read()) {
+        uint16_t *pImg = JpegDec.pImage;
+        uint32_t mcu_x = JpegDec.MCUx * mcu_w;
+        uint32_t mcu_y = JpegDec.MCUy * mcu_h;
+        if (mcu_x >= img_w || mcu_y >= img_h) continue;
+
+        // right and bottom edge blocks may be smaller
+        uint32_t win_w = jpg_min(mcu_w, img_w - mcu_x);
+        uint32_t win_h = jpg_min(mcu_h, img_h - mcu_y);
+
+        if (!image && ypos + (int)mcu_y >= tft.height()) {
+            JpegDec.abort(); // Image has run off bottom of screen so abort decoding
+            break;
         }
 
-        // calculate how many pixels must be drawn
-        uint32_t mcu_pixels = win_w * win_h;
+        if (!buf) {
+            // copy pixels into a contiguous block
+            if (win_w != mcu_w) {
+                for (uint32_t h = 1; h < win_h; h++) memmove(pImg + h * win_w, pImg + h * mcu_w, win_w * 2);
+            }
+            tft.pushImage(xpos + mcu_x, ypos + mcu_y, win_w, win_h, pImg);
+            continue;
+        }
 
-        // draw image MCU block only if it will fit on the screen
-        if ((mcu_x + win_w) <= tft.width() && (mcu_y + win_h) <= tft.height())
-            tft.pushImage(mcu_x, mcu_y, win_w, win_h, pImg);
-        else if ((mcu_y + win_h) > tft.height())
-            JpegDec.abort(); // Image has run off bottom of screen so abort decoding
+        uint16_t *dest;
+        if (image) {
+            dest = image + mcu_y * img_w + mcu_x;
+        } else {
+            if ((int)mcu_y != rowY) {
+                if (rowY >= 0) tft.pushImage(xpos, ypos + rowY, img_w, jpg_min(mcu_h, img_h - rowY), buf);
+                rowY = mcu_y;
+            }
+            dest = buf + mcu_x;
+        }
+        for (uint32_t h = 0; h < win_h; h++) memcpy(dest + h * img_w, pImg + h * mcu_w, win_w * 2);
     }
 
+    // pushImage crops what doesn't fit on the screen
+    if (image) tft.pushImage(xpos, ypos, img_w, img_h, image);
+    else if (buf && rowY >= 0) tft.pushImage(xpos, ypos + rowY, img_w, jpg_min(mcu_h, img_h - rowY), buf);
+
     tft.setSwapBytes(swapBytes);
+    if (buf != image) free(buf);
+    return bufSize;
 }
 
 bool showJpeg(FS &fs, String filename, int x, int y, bool center) {
@@ -1158,72 +1234,55 @@ bool showJpeg(FS &fs, String filename, int x, int y, bool center) {
     if (fs.exists(filename)) picture = fs.open(filename, FILE_READ);
     else return false;
 
-    const size_t data_size = picture.size();
+    size_t fileSize = picture.size();
+    time_t lastWrite = picture.getLastWrite();
 
-    // Alloc memory into heap
-    uint8_t *data_array = new uint8_t[data_size];
-    if (data_array == nullptr) {
-        // Fail allocating memory
+    JpegCacheEntry *cached = jpegCacheFind(&fs, filename, fileSize, lastWrite);
+    if (cached) {
         picture.close();
-        delete[] data_array;
-        return false;
-    }
-
-    uint8_t data;
-    int i = 0;
-    byte line_len = 0;
-
-    while (picture.available()) {
-        data = picture.read();
-        data_array[i] = data;
-        i++;
-
-        // print array on Serial
-        /*
-        Serial.print("0x");
-        if (abs(data) < 16) {
-          Serial.print("0");
-        }
-
-        Serial.print(data, HEX);
-        Serial.print(","); // Add value and comma
-        line_len++;
-        if (line_len >= 32) {
-          line_len = 0;
-          Serial.println();
+        if (center) {
+            x = x + (tftWidth - cached->w) / 2;
+            y = y + (tftHeight - cached->h) / 2;
         }
-        */
+        bool swapBytes = tft.getSwapBytes();
+        tft.setSwapBytes(true);
+        tft.pushImage(x, y, cached->w, cached->h, cached->pixels);
+        tft.setSwapBytes(swapBytes);
+        Serial.printf(
+            "JPEG %s from cache in %lums\n", filename.c_str(), (unsigned long)(millis() - drawTime)
+        );
+        return true;
     }
 
-    picture.close();
-
-    bool decoded = false;
-    if (data_array) {
-        decoded = JpegDec.decodeArray(data_array, data_size);
-    } else {
-        displayError(filename + " Fail");
-        delay(2500);
-        delete[] data_array; // free heap before leaving
+    picture.setBufferSize(JPEG_READ_BUFFER);
+    if (!JpegDec.decodeFsFile(picture)) {
+        picture.close();
+        log_e("Fail decoding %s", filename.c_str());
         return false;
     }
 
-    if (decoded) {
-        if (center) {
-            x = x + (tftWidth - JpegDec.width) / 2;
-            y = y + (tftHeight - JpegDec.height) / 2;
-        }
-        jpegRender(x, y);
+    if (center) {
+        x = x + (tftWidth - JpegDec.width) / 2;
+        y = y + (tftHeight - JpegDec.height) / 2;
     }
+    uint16_t *image = jpegCacheAlloc(JpegDec.width, JpegDec.height);
+    size_t bufSize = jpegRender(x, y, image);
+    if (image) jpegCacheInsert(&fs, filename, fileSize, lastWrite, image);
+    picture.close();
+
     // calculate how long it took to draw the image
     drawTime = millis() - drawTime; // Calculate the time it took
 
     // print the results to the serial port
-    Serial.print("Total render time was    : ");
-    Serial.print(drawTime);
-    Serial.println(" ms");
-    Serial.println("=====================================");
-
-    delete[] data_array; // free heap before leaving
+    Serial.printf(
+        "JPEG %s %dx%d: %lums, %u bytes buffered%s\n",
+        filename.c_str(),
+        JpegDec.width,
+        JpegDec.height,
+        (unsigned long)drawTime,
+        (unsigned)(bufSize + JPEG_READ_BUFFER),
+        image ? ", cached" : ""
+    );
     return true;
 }
 #if !defined(LITE_VERSION)
@@ -1237,8 +1296,13 @@ bool showJpeg(FS &fs, String filename, int x, int y, bool center) {
 Gif::Gif() : gifPosition(0, 0) {}
 
 Gif::~Gif() {
-    gif->close();
-    delete gif;
+    if (gif) {
+        gif->close();
+        delete gif;
+    }
+    free(canvas);
+    free(strip);
+    dropCache();
 }
 
 FS *Gif::GifFs = NULL;
@@ -1252,14 +1316,11 @@ void *Gif::openFile(const char *fname, int32_t *pSize) {
         if (SD.exists(fname)) GifFile = SD.open(fname);
         else if (LittleFS.exists(fname)) GifFile = LittleFS.open(fname);
     }
+    if (!GifFile) return NULL;
 
     File *FSGifFile = new File(GifFile);
-
-    if (FSGifFile) {
-        *pSize = FSGifFile->size();
-        return (void *)FSGifFile;
-    }
-    return NULL;
+    *pSize = FSGifFile->size();
+    return (void *)FSGifFile;
 }
 
 void Gif::closeFile(void *pHandle) {
@@ -1269,12 +1330,9 @@ void Gif::closeFile(void *pHandle) {
 }
 
 int32_t Gif::readFile(GIFFILE *pFile, uint8_t *pBuf, int32_t iLen) {
-    int32_t iBytesRead;
-    iBytesRead = iLen;
     File *f = static_cast<File *>(pFile->fHandle);
-    // Note: If you read a file all the way to the last byte, seek() stops working
-    if ((pFile->iSize - pFile->iPos) < iLen)
-        iBytesRead = pFile->iSize - pFile->iPos - 1; // <-- ugly work-around
+    int32_t iBytesRead = pFile->iSize - pFile->iPos;
+    if (iBytesRead > iLen) iBytesRead = iLen;
     if (iBytesRead <= 0) return 0;
     iBytesRead = (int32_t)f->read(pBuf, iBytesRead);
     pFile->iPos = f->position();
@@ -1282,23 +1340,21 @@ int32_t Gif::readFile(GIFFILE *pFile, uint8_t *pBuf, int32_t iLen) {
 }
 
 int32_t Gif::seekFile(GIFFILE *pFile, int32_t iPosition) {
-    int i = micros();
     File *f = static_cast<File *>(pFile->fHandle);
     f->seek(iPosition);
     pFile->iPos = (int32_t)f->position();
-    i = micros() - i;
     return pFile->iPos;
 }
 
 void Gif::GIFDraw(GIFDRAW *pDraw) {
     uint8_t *s;
-    uint16_t *d, *usPalette, usTemp[tftWidth];
+    uint16_t *d, *usPalette;
     int x, y, iWidth;
 
-    GifPosition *position = (GifPosition *)(pDraw->pUser);
+    Gif *self = (Gif *)(pDraw->pUser);
+    GifPosition *position = &self->gifPosition;
 
     iWidth = pDraw->iWidth;
-    if (iWidth > tftWidth) iWidth = tftWidth;
     usPalette = pDraw->pPalette;
     y = pDraw->iY + pDraw->y; // current line
 
@@ -1309,6 +1365,45 @@ void Gif::GIFDraw(GIFDRAW *pDraw) {
         }
         pDraw->ucHasTransparency = 0;
     }
+
+    if (self->canvas) {
+        // Transparent pixels keep what the previous frames left in the canvas
+        if (y >= self->canvasH || pDraw->iX >= self->canvasW) return;
+        if (pDraw->iX + iWidth > self->canvasW) iWidth = self->canvasW - pDraw->iX;
+        d = self->canvas + y * self->canvasW + pDraw->iX;
+        if (pDraw->ucHasTransparency) {
+            uint8_t ucTransparent = pDraw->ucTransparent;
+            for (x = 0; x < iWidth; x++) {
+                if (s[x] != ucTransparent) d[x] = usPalette[s[x]];
+            }
+        } else {
+            for (x = 0; x < iWidth; x++) d[x] = usPalette[s[x]];
+        }
+        if (y < self->dirtyTop) self->dirtyTop = y;
+        if (y > self->dirtyBottom) self->dirtyBottom = y;
+        return;
+    }
+
+    if (iWidth > tftWidth) iWidth = tftWidth;
+    if (!pDraw->ucHasTransparency && self->strip) {
+        // Consecutive opaque lines go out GIF_STRIP_ROWS at a time
+        if (self->stripRows &&
+            (y != self->stripY + self->stripRows || pDraw->iX != self->stripX || iWidth != self->stripW))
+            self->flushStrip();
+        if (self->stripRows == 0) {
+            self->stripX = pDraw->iX;
+            self->stripY = y;
+            self->stripW = iWidth;
+        }
+        d = self->strip + self->stripRows * iWidth;
+        for (x = 0; x < iWidth; x++) d[x] = usPalette[s[x]];
+        if (++self->stripRows == GIF_STRIP_ROWS || pDraw->y == pDraw->iHeight - 1) self->flushStrip();
+        return;
+    }
+    self->flushStrip();
+
+    uint16_t usTemp[tftWidth];
+    tft.drawPixel(0, 0, 0);
     // Apply the new pixels to the main image
     if (pDraw->ucHasTransparency) { // if transparency used
         uint8_t *pEnd, c, ucTransparent = pDraw->ucTransparent;
@@ -1329,7 +1424,6 @@ void Gif::GIFDraw(GIFDRAW *pDraw) {
                 }
             } // while looking for opaque pixels
             if (iCount) { // any opaque pixels?
-                tft.drawPixel(0, 0, 0);
                 tft.pushImage(pDraw->iX + x + position->x, y + position->y, iCount, 1, (uint16_t *)usTemp);
                 x += iCount;
                 iCount = 0;
@@ -1350,11 +1444,22 @@ void Gif::GIFDraw(GIFDRAW *pDraw) {
         s = pDraw->pPixels;
         // Translate the 8-bit pixels through the RGB565 palette (already byte reversed)
         for (x = 0; x < iWidth; x++) usTemp[x] = usPalette[*s++];
-        tft.drawPixel(0, 0, 0);
         tft.pushImage(pDraw->iX + position->x, y + position->y, iWidth, 1, (uint16_t *)usTemp);
     }
 } /* GIFDraw() */
 
+void Gif::flushStrip() {
+    if (stripRows == 0) return;
+    tft.drawPixel(0, 0, 0);
+    tft.pushImage(stripX + gifPosition.x, stripY + gifPosition.y, stripW, stripRows, strip);
+    stripRows = 0;
+}
+
+void Gif::pushCanvas(uint16_t *pixels, int top, int rows) {
+    tft.drawPixel(0, 0, 0);
+    tft.pushImage(gifPosition.x, gifPosition.y + top, canvasW, rows, pixels);
+}
+
 bool Gif::openGIF(FS *fs, const char *filename) {
     if (fs != NULL) {
         GifFs = fs;
@@ -1365,10 +1470,82 @@ bool Gif::openGIF(FS *fs, const char *filename) {
 
     gif = new AnimatedGIF();
     gif->begin(BIG_ENDIAN_PIXELS);
-    if (gif->open(filename, openFile, closeFile, readFile, seekFile, GIFDraw)) { return true; }
+    if (!gif->open(filename, openFile, closeFile, readFile, seekFile, GIFDraw)) {
+        log_e("GIF opening error: %d\n", gif->getLastError());
+        return false;
+    }
 
-    log_e("GIF opening error: %d\n", gif->getLastError());
-    return false;
+    canvasW = gif->getCanvasWidth();
+    canvasH = gif->getCanvasHeight();
+    if (psramFound()) canvas = (uint16_t *)ps_malloc(canvasW * canvasH * sizeof(uint16_t));
+    if (canvas) {
+        // Same byte order as the palette
+        uint16_t bg = (bruceConfig.bgColor >> 8) | (bruceConfig.bgColor << 8);
+        for (int i = 0; i < canvasW * canvasH; i++) canvas[i] = bg;
+    } else {
+        strip = (uint16_t *)malloc(GIF_STRIP_ROWS * tftWidth * sizeof(uint16_t));
+    }
+    return true;
+}
+
+bool Gif::enableCache() {
+    if (!canvas || caching || cacheReady || frames) return false;
+
+    GIFINFO info;
+    if (!gif->getInfo(&info)) return false;
+    gif->reset(); // getInfo walks the file
+
+    size_t bytes = (size_t)canvasW * canvasH * sizeof(uint16_t) * info.iFrameCount;
+    if (info.iFrameCount < 2 || bytes > GIF_CACHE_MAX || bytes > ESP.getFreePsram() / 2) return false;
+
+    cache = (uint16_t *)ps_malloc(bytes);
+    cacheDelay = (int *)ps_malloc(info.iFrameCount * sizeof(int));
+    if (!cache || !cacheDelay) {
+        dropCache();
+        return false;
+    }
+    cacheFrames = info.iFrameCount;
+    cacheCount = 0;
+    caching = true;
+    return true;
+}
+
+void Gif::cacheFrame(int result) {
+    if (result < 0 || cacheCount == cacheFrames) { // decoding error or more frames than counted
+        dropCache();
+        return;
+    }
+    // 0 may come without a frame at the end of the file
+    if (result != 0 || gif->getLastError() == GIF_SUCCESS) {
+        memcpy(cache + cacheCount * canvasW * canvasH, canvas, canvasW * canvasH * sizeof(uint16_t));
+        cacheDelay[cacheCount++] = *delayMilliseconds;
+    }
+    if (result == 0) {
+        caching = false;
+        if (cacheCount == 0) dropCache();
+        else {
+            cacheReady = true;
+            cacheNext = 0;
+        }
+    }
+}
+
+void Gif::dropCache() {
+    free(cache);
+    free(cacheDelay);
+    cache = nullptr;
+    cacheDelay = nullptr;
+    cacheFrames = cacheCount = cacheNext = 0;
+    caching = cacheReady = false;
+}
+
+void Gif::reset() {
+    if (cacheReady) {
+        cacheNext = 0;
+        return;
+    }
+    if (caching) dropCache(); // restarted halfway
+    gif->reset();
 }
 
 // Play a single frame
@@ -1378,14 +1555,28 @@ bool Gif::openGIF(FS *fs, const char *filename) {
 // 0 = no more frames exist, a frame may or may not have been played: use getLastError() and look for
 // GIF_SUCCESS to know if a frame was played -1 = error
 int Gif::playFrame(int x, int y, bool bSync) {
-    if (bSync && ((millis() - lTime) >= *delayMilliseconds)) {
-        lTime = millis();
-        gifPosition.x = x;
-        gifPosition.y = y;
-        return gif->playFrame(false, delayMilliseconds, &gifPosition);
+    if (bSync && millis() - lTime < (unsigned long)*delayMilliseconds) return 2;
+
+    lTime = millis();
+    gifPosition.x = x;
+    gifPosition.y = y;
+    frames++;
+
+    if (cacheReady) {
+        pushCanvas(cache + cacheNext * canvasW * canvasH, 0, canvasH);
+        *delayMilliseconds = cacheDelay[cacheNext];
+        cacheNext = (cacheNext + 1) % cacheCount;
+        return cacheNext == 0 ? 0 : 1;
     }
 
-    return 2;
+    dirtyTop = canvasH;
+    dirtyBottom = -1;
+    int result = gif->playFrame(false, delayMilliseconds, this);
+    flushStrip();
+    if (canvas && dirtyBottom >= dirtyTop)
+        pushCanvas(canvas + dirtyTop * canvasW, dirtyTop, dirtyBottom - dirtyTop + 1);
+    if (caching) cacheFrame(result);
+    return result;
 }
 
 int Gif::getLastError() { return gif->getLastError(); }
@@ -1409,6 +1600,9 @@ bool showGif(FS *fs, const char *filename, int x, int y, bool center, int playDu
         y = y + (tftHeight - gif.getCanvasHeight()) / 2;
     }
 
+    // Loops replay the frames from PSRAM when the whole animation fits
+    if (playDurationMs != 0) gif.enableCache();
+
     int result = 0;
     long timeStart = millis();
     do {
@@ -1421,6 +1615,18 @@ bool showGif(FS *fs, const char *filename, int x, int y, bool center, int playDu
         if (playDurationMs == 0 && result == 0) break;
     } while (result >= 0);
 
+    unsigned long drawTime = millis() - timeStart;
+    Serial.printf(
+        "GIF %s %dx%d on %s: %lu frames in %lums, %.1f fps%s\n",
+        filename,
+        gif.getCanvasWidth(),
+        gif.getCanvasHeight(),
+        DEVICE_NAME,
+        (unsigned long)gif.framesPlayed(),
+        drawTime,
+        drawTime ? gif.framesPlayed() * 1000.0f / drawTime : 0.0f,
+        gif.isCached() ? ", cached" : ""
+    );
     return true;
 }
 #endif
@@ -2,7 +2,7 @@
 #define __DISPLAY_H__
 
 #include "core/serialcmds.h"
-#include "sd_functions.h" // to catch FileList Struct
+#include "sd_functions.h" // to catch DirIndex
 #include <FS.h>
 #include <LittleFS.h>
 #include <SD.h>
@@ -35,6 +35,9 @@ struct GifPosition {
     GifPosition(int xCoord, int yCoord) : x(xCoord), y(yCoord) {}
 };
 
+#define GIF_STRIP_ROWS 16               // lines pushed at once when there is no canvas
+#define GIF_CACHE_MAX (2 * 1024 * 1024) // PSRAM for pre-decoded frames
+
 class Gif {
 public:
     Gif();
@@ -43,11 +46,15 @@ public:
 
     bool openGIF(FS *fs, const char *filename);
 
+    // Keeps every frame decoded in PSRAM while the first loop plays, later loops are only blits.
+    // For short animations, false if it doesn't fit or the first frame was already played
+    bool enableCache();
+
     int playFrame(int x = 0, int y = 0, bool bSync = true);
 
     int getInfo(GIFINFO *pInfo) { return gif->getInfo(pInfo); }
 
-    void reset() { return gif->reset(); }
+    void reset();
 
     void close() { return gif->close(); }
 
@@ -57,7 +64,11 @@ public:
 
     int getLastError();
 
-    AnimatedGIF *gif;
+    uint32_t framesPlayed() { return frames; }
+
+    bool isCached() { return cacheReady; }
+
+    AnimatedGIF *gif = nullptr;
 
 private:
     unsigned long lTime = millis();
@@ -69,6 +80,38 @@ private:
 
     GifPosition gifPosition;
 
+    // With PSRAM frames are composed in a canvas and the changed rows go out in one push,
+    // otherwise opaque lines are batched in a strip
+    uint16_t *canvas = nullptr;
+    int canvasW = 0;
+    int canvasH = 0;
+    int dirtyTop = 0;
+    int dirtyBottom = -1;
+
+    uint16_t *strip = nullptr;
+    int stripX = 0;
+    int stripY = 0;
+    int stripW = 0;
+    int stripRows = 0;
+
+    uint16_t *cache = nullptr; // canvasW * canvasH per frame
+    int *cacheDelay = nullptr;
+    int cacheFrames = 0; // room for
+    int cacheCount = 0;  // decoded
+    int cacheNext = 0;
+    bool caching = false;
+    bool cacheReady = false;
+
+    uint32_t frames = 0;
+
+    void flushStrip();
+
+    void pushCanvas(uint16_t *pixels, int top, int rows);
+
+    void cacheFrame(int result);
+
+    void dropCache();
+
     static void *openFile(const char *fname, int32_t *pSize);
 
     static void closeFile(void *pHandle);
@@ -179,7 +222,7 @@ void printSubtitle(String subtitle, bool withLine = true);
 void printFootnote(String text);
 void printCenterFootnote(String text);
 
-Opt_Coord listFiles(int index, std::vector<FileList> fileList);
+Opt_Coord listFiles(int index, const DirIndex &fileList);
 
 void drawWireguardStatus(int x, int y);
 
@@ -0,0 +1,65 @@
+#include "file_hash.h"
+#include <MD5Builder.h>
+#include <esp32/rom/crc.h> // for CRC32
+#include <mbedtls/sha256.h>
+
+bool hashFile(FS &fs, const String &filepath, uint8_t types, FileHashResult &result, FileHashProgress progress) {
+    File file = fs.open(filepath, FILE_READ);
+    if (!file || file.isDirectory()) return false;
+
+    uint8_t *buf = (uint8_t *)malloc(FILE_HASH_CHUNK);
+    if (!buf) {
+        Serial.println("hashFile: no memory for the read buffer");
+        file.close();
+        return false;
+    }
+
+    MD5Builder md5;
+    uint32_t crc = 0;
+    mbedtls_sha256_context sha;
+
+    if (types & FILE_HASH_MD5) md5.begin();
+    if (types & FILE_HASH_SHA256) {
+        mbedtls_sha256_init(&sha);
+        mbedtls_sha256_starts_ret(&sha, 0);
+    }
+
+    size_t total = file.size();
+    size_t done = 0;
+    bool ok = true;
+    for (;;) {
+        int n = file.read(buf, FILE_HASH_CHUNK);
+        if (n <= 0) break;
+        if (types & FILE_HASH_MD5) md5.add(buf, n);
+        if (types & FILE_HASH_CRC32) crc = crc32_le(crc, buf, n);
+        if (types & FILE_HASH_SHA256) mbedtls_sha256_update_ret(&sha, buf, n);
+        done += n;
+        if (progress && !progress(done, total)) {
+            ok = false;
+            break;
+        }
+    }
+    if (done != total) ok = false; // read error or cancelled
+
+    free(buf);
+    file.close();
+
+    if (types & FILE_HASH_MD5) {
+        md5.calculate();
+        result.md5 = ok ? md5.toString() : "";
+    }
+    if (types & FILE_HASH_CRC32) {
+        char s[9];
+        snprintf(s, sizeof(s), "%08X", crc);
+        result.crc32 = ok ? s : "";
+    }
+    if (types & FILE_HASH_SHA256) {
+        uint8_t digest[32];
+        mbedtls_sha256_finish_ret(&sha, digest);
+        mbedtls_sha256_free(&sha);
+        char s[65];
+        for (int i = 0; i < 32; i++) snprintf(s + i * 2, 3, "%02x", digest[i]);
+        result.sha256 = ok ? s : "";
+    }
+    return ok;
+}
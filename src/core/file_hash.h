@@ -0,0 +1,29 @@
+#ifndef __FILE_HASH_H__
+#define __FILE_HASH_H__
+
+#include <FS.h>
+#include <functional>
+
+#define FILE_HASH_MD5 0x01
+#define FILE_HASH_CRC32 0x02
+#define FILE_HASH_SHA256 0x04
+#define FILE_HASH_ALL (FILE_HASH_MD5 | FILE_HASH_CRC32 | FILE_HASH_SHA256)
+
+#define FILE_HASH_CHUNK 4096 // bytes read at once, the only buffer used
+
+struct FileHashResult {
+    String md5;
+    String crc32;
+    String sha256;
+};
+
+// Called after every chunk, return false to cancel
+typedef std::function<bool(size_t done, size_t total)> FileHashProgress;
+
+// Hashes the file in a single pass with every algorithm in types, any size in constant memory.
+// SHA-256 goes through mbedtls, which uses the SHA peripheral of the chip.
+bool hashFile(
+    FS &fs, const String &filepath, uint8_t types, FileHashResult &result, FileHashProgress progress = nullptr
+);
+
+#endif
@@ -0,0 +1,72 @@
+#include "file_view.h"
+
+static char *pool = nullptr;
+static bool poolBusy = false;
+static portMUX_TYPE poolLock = portMUX_INITIALIZER_UNLOCKED;
+
+size_t readFully(File &file, void *dst, size_t len) {
+    uint8_t *p = (uint8_t *)dst;
+    size_t done = 0;
+    while (done < len) {
+        size_t toRead = len - done;
+        if (toRead > FILE_VIEW_CHUNK) toRead = FILE_VIEW_CHUNK;
+        size_t n = file.read(p + done, toRead);
+        if (n == 0) break; // EOF or read error
+        done += n;
+        if (done < len) yield();
+    }
+    return done;
+}
+
+bool FileView::open(FS &fs, const String &filepath, size_t before, size_t after) {
+    close();
+    File file = fs.open(filepath, FILE_READ);
+    if (!file || file.isDirectory()) {
+        Serial.printf("Could not open file: %s\n", filepath.c_str());
+        return false;
+    }
+
+    size_t fileLen = file.size();
+    size_t need = before + fileLen + after + 1;
+
+    if (psramFound() && need <= FILE_VIEW_POOL_SIZE) {
+        portENTER_CRITICAL(&poolLock);
+        pooled = !poolBusy;
+        poolBusy = true;
+        portEXIT_CRITICAL(&poolLock);
+        if (pooled && !pool) pool = (char *)ps_malloc(FILE_VIEW_POOL_SIZE);
+        if (pooled && pool) buf = pool;
+        else if (pooled) {
+            poolBusy = false;
+            pooled = false;
+        }
+    }
+    if (!buf) buf = (char *)(psramFound() ? ps_malloc(need) : malloc(need));
+    if (!buf) {
+        Serial.printf("Could not allocate memory for file: %s\n", filepath.c_str());
+        file.close();
+        return false;
+    }
+
+    head = before;
+    tail = after;
+    len = readFully(file, buf + head, fileLen);
+    file.close();
+    if (len < fileLen) Serial.printf("Short read on %s: %u of %u bytes\n", filepath.c_str(), len, fileLen);
+
+    buf[head + len] = '\0';
+    buf[head + len + tail] = '\0';
+    return true;
+}
+
+void FileView::close() {
+    if (!buf) return;
+    if (pooled) {
+        portENTER_CRITICAL(&poolLock);
+        poolBusy = false;
+        portEXIT_CRITICAL(&poolLock);
+    } else free(buf);
+    buf = nullptr;
+    pooled = false;
+    len = head = tail = 0;
+}
@@ -0,0 +1,42 @@
+#ifndef __FILE_VIEW_H__
+#define __FILE_VIEW_H__
+
+#include <FS.h>
+
+#define FILE_VIEW_CHUNK 16384     // bytes per read call, whole SD sectors and LittleFS blocks
+#define FILE_VIEW_POOL_SIZE 16384 // files up to this size reuse one buffer (PSRAM only)
+
+// Reads len bytes into dst with large reads straight into the destination.
+// Returns the bytes really read, less than len on a short read.
+size_t readFully(File &file, void *dst, size_t len);
+
+/**
+ * @brief Read only copy of a whole file, NUL terminated, for loaders that parse it and let it go.
+ *        Small files land in a pooled buffer kept in PSRAM, so loading many modules or assets doesn't
+ *        allocate for each one. before/after reserve room around the content, to wrap it without
+ *        another copy (see prefix()/suffix()).
+ */
+class FileView {
+public:
+    ~FileView() { close(); }
+
+    bool open(FS &fs, const String &filepath, size_t before = 0, size_t after = 0);
+    void close();
+
+    const char *data() const { return buf ? buf + head : nullptr; }
+    size_t size() const { return len; }
+
+    // The reserved room, content included: prefix + content + suffix
+    char *prefix() { return buf; }
+    char *suffix() { return buf + head + len; }
+    size_t total() const { return head + len + tail; }
+
+private:
+    char *buf = nullptr;
+    size_t len = 0;
+    size_t head = 0;
+    size_t tail = 0;
+    bool pooled = false;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "input_events.h"
+#include <globals.h>
+
+static QueueHandle_t queue = nullptr;
+static SemaphoreHandle_t lock = nullptr;
+static uint32_t pressTime = 0; // oldest event not redrawn yet, 0 if none
+static uint32_t lastLatency = 0;
+
+void inputEventsBegin() {
+    if (!queue) queue = xQueueCreate(INPUT_QUEUE_LEN, sizeof(InputEvent));
+    if (!lock) lock = xSemaphoreCreateRecursiveMutex();
+}
+
+void inputLock() {
+    if (lock) xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+}
+
+void inputUnlock() {
+    if (lock) xSemaphoreGiveRecursive(lock);
+}
+
+void inputPost(uint8_t key, uint32_t time) {
+    if (!queue) return;
+    InputEvent event = {time, key};
+    if (xQueueSend(queue, &event, 0) != pdTRUE) {
+        // Nobody is reading, drop the oldest one, the newest press is the one that matters
+        InputEvent old;
+        xQueueReceive(queue, &old, 0);
+        xQueueSend(queue, &event, 0);
+    }
+}
+
+void inputPostPressed(uint32_t time) {
+    bool posted = true;
+    if (NextPress) inputPost(INPUT_NEXT, time);
+    else if (PrevPress) inputPost(INPUT_PREV, time);
+    else if (UpPress) inputPost(INPUT_UP, time);
+    else if (DownPress) inputPost(INPUT_DOWN, time);
+    else if (SelPress) inputPost(INPUT_SEL, time);
+    else if (EscPress) inputPost(INPUT_ESC, time);
+    else if (NextPagePress) inputPost(INPUT_NEXT_PAGE, time);
+    else if (PrevPagePress) inputPost(INPUT_PREV_PAGE, time);
+    else if (KeyStroke.pressed) inputPost(INPUT_KEYSTROKE, time);
+    else if (touchPoint.pressed) inputPost(INPUT_TOUCH, time);
+    else posted = false;
+
+    if (SerialCmdPress) inputPost(INPUT_SERIAL_CMD, time);
+    else if (!posted && AnyKeyPress) inputPost(INPUT_ANY, time);
+}
+
+void inputFlush() {
+    if (queue) xQueueReset(queue);
+    pressTime = 0;
+}
+
+bool inputWait(uint32_t timeoutMs, InputEvent *event) {
+    if (!queue) {
+        vTaskDelay(pdMS_TO_TICKS(timeoutMs));
+        return false;
+    }
+    InputEvent ev;
+    pressTime = 0;
+    uint32_t start = millis();
+    for (;;) {
+        uint32_t waited = millis() - start;
+        if (waited > timeoutMs) return false;
+        if (xQueueReceive(queue, &ev, pdMS_TO_TICKS(timeoutMs - waited)) != pdTRUE) return false;
+        if (millis() - ev.time <= INPUT_PRESS_TTL_MS) break;
+        // posted while nobody waited (a redraw, an app without inputWait), its flag is gone
+    }
+    pressTime = ev.time ? ev.time : 1;
+    if (event) *event = ev;
+    return true;
+}
+
+void IRAM_ATTR inputWakeFromISR() {
+    if (!xHandle) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(xHandle, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+void inputRedrawn() {
+    if (!pressTime) return;
+    lastLatency = millis() - pressTime;
+    pressTime = 0;
+    log_d("input: %lums from press to redraw", (unsigned long)lastLatency);
+}
+
+uint32_t inputLastLatency() { return lastLatency; }
@@ -0,0 +1,68 @@
+#ifndef __INPUT_EVENTS_H__
+#define __INPUT_EVENTS_H__
+
+#include <Arduino.h>
+
+#define INPUT_QUEUE_LEN 16
+// The input task resets the press flags a press wasn't consumed within this long, an event older than it
+// has no flag left for check() to find
+#define INPUT_PRESS_TTL_MS 75
+
+// How long loopOptions sleeps without input, it still wakes for the scrolling label and the clock.
+// Touch boards with USE_TFT_eSPI_TOUCH read the panel inside check(), on the loop task, so they keep polling
+#ifdef USE_TFT_eSPI_TOUCH
+#define INPUT_IDLE_WAIT_MS 10
+#else
+#define INPUT_IDLE_WAIT_MS 50
+#endif
+
+enum InputKey : uint8_t {
+    INPUT_NEXT,
+    INPUT_PREV,
+    INPUT_UP,
+    INPUT_DOWN,
+    INPUT_SEL,
+    INPUT_ESC,
+    INPUT_NEXT_PAGE,
+    INPUT_PREV_PAGE,
+    INPUT_KEYSTROKE,
+    INPUT_TOUCH,
+    INPUT_SERIAL_CMD,
+    INPUT_ANY, // AnyKeyPress alone, without a specific key
+};
+
+struct InputEvent {
+    uint32_t time; // millis() when the input task read the press, latencies are measured from it
+    uint8_t key;   // InputKey
+};
+
+/**
+ * @brief Input events, filled by the input task after each InputHandler() run.
+ *        Boards keep setting the press flags; the task turns every new press into a timestamped
+ *        event, so the UI can sleep on the queue instead of polling the flags, and the flags are
+ *        read and cleared under a lock instead of suspending the input task.
+ */
+void inputEventsBegin(); // before the input task starts
+
+// Guards the press flags, KeyStroke and touchPoint. Recursive, InputHandler() may call check()
+void inputLock();
+void inputUnlock();
+
+void inputPost(uint8_t key, uint32_t time);
+void inputPostPressed(uint32_t time); // one event for the flags the InputHandler() run at time set
+
+// Drops the queued events, call when a wait loop starts: presses made on another screen were handled
+// (or dropped) there
+void inputFlush();
+// Waits up to timeoutMs for an event, skipping the ones older than INPUT_PRESS_TTL_MS. Returns false
+// on timeout
+bool inputWait(uint32_t timeoutMs, InputEvent *event = nullptr);
+
+// Boards with pin interrupts call it from the ISR, the input task runs now instead of on its next tick
+void IRAM_ATTR inputWakeFromISR();
+
+// Call after redrawing for a press, logs the time since the press woke inputWait()
+void inputRedrawn();
+uint32_t inputLastLatency();
+
+#endif
@@ -0,0 +1,125 @@
+#include "key_value_reader.h"
+
+void KeyValueReader::begin() {
+    bufStart = 0;
+    pos = 0;
+    len = 0;
+    file.seek(0);
+}
+
+bool KeyValueReader::seek(uint32_t offset) {
+    // still inside the buffer, no need to touch the file
+    if (len > 0 && offset >= bufStart && offset <= bufStart + len) {
+        pos = offset - bufStart;
+        return true;
+    }
+    bufStart = offset;
+    pos = 0;
+    len = 0;
+    return file.seek(offset);
+}
+
+bool KeyValueReader::fill() {
+    bufStart += len;
+    pos = 0;
+    int n = file.read(buf, sizeof(buf));
+    len = n > 0 ? n : 0;
+    return len > 0;
+}
+
+int KeyValueReader::peek() {
+    if (pos >= len && !fill()) return -1;
+    return buf[pos];
+}
+
+int KeyValueReader::read() {
+    int c = peek();
+    if (c >= 0) pos++;
+    return c;
+}
+
+void KeyValueReader::skipLine() {
+    for (;;) {
+        if (pos >= len && !fill()) return;
+        uint8_t *nl = (uint8_t *)memchr(buf + pos, '\n', len - pos);
+        if (nl) {
+            pos = nl - buf + 1;
+            return;
+        }
+        pos = len;
+    }
+}
+
+void KeyValueReader::skipSpaces() {
+    int c = peek();
+    while (c == ' ' || c == '\t' || c == '\r') {
+        pos++;
+        c = peek();
+    }
+}
+
+size_t KeyValueReader::readKey(char *key, size_t size) {
+    size_t n = 0;
+    for (;;) {
+        int c = read();
+        if (c < 0 || c == '\n') return 0;
+        if (c == ':') break;
+        if (n < size - 1) key[n++] = c;
+    }
+    key[n] = '\0';
+    return n;
+}
+
+void KeyValueReader::readValue(char *value, size_t size) {
+    size_t n = 0;
+    for (;;) {
+        int c = read();
+        if (c < 0 || c == '\n') break;
+        if (n < size - 1) value[n++] = c;
+    }
+    while (n > 0 && isspace((uint8_t)value[n - 1])) n--;
+    value[n] = '\0';
+}
+
+// Long values (raw data) are appended in chunks straight from the read buffer
+void KeyValueReader::readValue(String &value) {
+    value = "";
+    for (;;) {
+        if (pos >= len && !fill()) break;
+        uint8_t *nl = (uint8_t *)memchr(buf + pos, '\n', len - pos);
+        uint16_t end = nl ? nl - buf : len;
+        value.concat((const char *)buf + pos, end - pos);
+        pos = nl ? end + 1 : end;
+        if (nl) break;
+    }
+    value.trim();
+}
+
+bool KeyValueReader::readInt(int &value) {
+    for (;;) {
+        skipSpaces();
+        int c = peek();
+        if (c < 0) return false;
+        if (c == '\n') {
+            pos++;
+            return false;
+        }
+        bool neg = c == '-';
+        if (neg || c == '+') {
+            pos++;
+            c = peek();
+        }
+        if (c < '0' || c > '9') { // garbage, skip it
+            if (c >= 0 && c != '\n') pos++;
+            continue;
+        }
+        int v = 0;
+        while (c >= '0' && c <= '9') {
+            v = v * 10 + (c - '0');
+            pos++;
+            c = peek();
+        }
+        value = neg ? -v : v;
+        return true;
+    }
+}
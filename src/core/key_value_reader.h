@@ -0,0 +1,45 @@
+#ifndef __KEY_VALUE_READER_H__
+#define __KEY_VALUE_READER_H__
+
+#include <FS.h>
+
+#define KV_READ_BUFFER 512 // bytes read from the file at once
+
+/**
+ * @brief Buffered reader for the "Key: value" text files of the Flipper formats (.ir, .sub).
+ *        Keys and short values go into caller buffers, long values straight from the read buffer,
+ *        so going through a file doesn't allocate per line. '\r' counts as a space everywhere,
+ *        files saved on Windows read the same.
+ */
+class KeyValueReader {
+public:
+    KeyValueReader(File &file) : file(file) {}
+
+    void begin(); // from the start of the file, call it again after the file is reopened
+    bool seek(uint32_t offset);
+    uint32_t position() const { return bufStart + pos; }
+
+    int peek(); // next char without consuming it, -1 at the end of the file
+    int read();
+    void skipLine();   // up to and including the '\n'
+    void skipSpaces(); // ' ', '\t' and '\r', stops on '\n'
+
+    // Reads "key:" into key, returns its length or 0 if the line has no ':' (the line is consumed)
+    size_t readKey(char *key, size_t size);
+    // Rest of the line without trailing spaces, cut at size - 1
+    void readValue(char *value, size_t size);
+    void readValue(String &value);
+    // Next integer of the line, false at the end of the line (which is consumed). Garbage is skipped
+    bool readInt(int &value);
+
+private:
+    File &file;
+    uint8_t buf[KV_READ_BUFFER];
+    uint16_t pos = 0;
+    uint16_t len = 0;
+    uint32_t bufStart = 0;
+
+    bool fill();
+};
+
+#endif
@@ -50,11 +50,21 @@ void ConfigMenu::optionsMenu() {
         {"Clock", setClock},
         {"Sleep", setSleepMode},
         {"Factory Reset", [=]() { bruceConfig.factoryReset(); }},
-        {"Restart", [=]() { ESP.restart(); }},
+        {"Restart",
+         [=]() {
+             bruceConfig.flush();
+             ESP.restart();
+         }},
     };
 
-    options.push_back({"Turn-off", powerOff});
-    options.push_back({"Deep Sleep", goToDeepSleep});
+    options.push_back({"Turn-off", [=]() {
+                           bruceConfig.flush();
+                           powerOff();
+                       }});
+    options.push_back({"Deep Sleep", [=]() {
+                           bruceConfig.flush();
+                           goToDeepSleep();
+                       }});
 
     if (bruceConfig.devMode) options.push_back({"Device Pin setting", [=]() { devMenu(); }});
 
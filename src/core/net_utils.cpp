@@ -1,18 +1,79 @@
 #include "net_utils.h"
+#include "bus_lock.h"
+#include "oui_db.h"
 
 #include <ESPping.h>
 #include <HTTPClient.h>
+#include <LittleFS.h>
+#include <SD.h>
 #include <WiFi.h>
+#include <globals.h>
 #include <sstream>
 
+#define OUI_DB_FILE "/oui.bin"
+#define OUI_DB_RETRY_MS 10000 // without the file, look for it again after this
+
+// Everything below runs under busLock(): wardriving looks up from its scan task, and the file may be on
+// the SD card, which shares the bus with the display on many boards
+static File ouiFile;
+static OuiDatabase *ouiDb = nullptr;
+static bool ouiMissing = false;
+static uint32_t ouiMissingAt = 0;
+
+// Opens the database on first use and again after a read error (SD card removed). Call with busLock()
+static bool ouiOpen() {
+    if (ouiDb && ouiDb->ok()) return true;
+    if (ouiMissing && millis() - ouiMissingAt < OUI_DB_RETRY_MS) return false;
+
+    if (ouiFile) ouiFile.close();
+    if (sdcardMounted && SD.exists(OUI_DB_FILE)) ouiFile = SD.open(OUI_DB_FILE, FILE_READ);
+    else if (LittleFS.exists(OUI_DB_FILE)) ouiFile = LittleFS.open(OUI_DB_FILE, FILE_READ);
+
+    if (!ouiDb) {
+        ouiDb = new OuiDatabase([](uint32_t offset, uint8_t *buf, size_t len) -> size_t {
+            if (!ouiFile || !ouiFile.seek(offset)) return 0;
+            return ouiFile.read(buf, len);
+        });
+    }
+    ouiMissing = !ouiFile || !ouiDb->open();
+    if (ouiMissing) ouiMissingAt = millis();
+    return !ouiMissing;
+}
+
+bool hasVendorDatabase() {
+    busLock();
+    bool ok = ouiOpen();
+    busUnlock();
+    return ok;
+}
+
+String getVendor(const uint8_t *mac) {
+    if (mac[0] & 0x02) return "Private";
+
+    busLock();
+    std::string vendor;
+    if (ouiOpen()) ouiDb->lookup((uint32_t)mac[0] << 16 | mac[1] << 8 | mac[2], vendor);
+    busUnlock();
+    return vendor.c_str();
+}
+
+String getVendor(const String &mac) {
+    if (mac.length() < 17) return "";
+    uint8_t bytes[6];
+    stringToMAC(mac.c_str(), bytes);
+    return getVendor(bytes);
+}
+
 bool internetConnection() { return Ping.ping(IPAddress(8, 8, 8, 8)); }
 
 String getManufacturer(const String &mac) {
+    if (hasVendorDatabase()) {
+        String vendor = getVendor(mac);
+        return vendor.isEmpty() ? "UNKNOWN" : vendor;
+    }
     if (!internetConnection()) { return "NO_INTERNET_ACCESS"; }
 
-    // there is an official(IEEE) doc that contains all registered mac prefixes
-    // but it is around 700kb and i don't know a way to get specific part
-    // without downloading the whole txt
+    // without tools/oui_build.py's database on the device
     HTTPClient http;
     http.begin("http://api.maclookup.app/v2/macs/" + mac);
     int httpCode = http.GET(); // Send the request
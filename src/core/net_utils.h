@@ -4,8 +4,15 @@
 
 bool internetConnection();
 
+// Vendor from the offline database if there is one, else asks api.maclookup.app
 String getManufacturer(const String &mac);
 
+// Vendor from /oui.bin on the SD card or LittleFS (made by tools/oui_build.py), without network.
+// "" if it isn't registered or there is no database, "Private" for locally administered (random) MACs
+String getVendor(const uint8_t *mac);
+String getVendor(const String &mac);
+bool hasVendorDatabase();
+
 String MAC(uint8_t *data);
 
 void stringToMAC(const std::string &macStr, uint8_t MAC[6]);
@@ -0,0 +1,130 @@
+#include "oui_db.h"
+#include <algorithm>
+#include <cstring>
+
+static inline uint32_t getLe32(const uint8_t *p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// LEB128, false if it runs past end
+static bool getVarint(const uint8_t *&p, const uint8_t *end, uint32_t &value) {
+    value = 0;
+    for (int shift = 0; p < end && shift < 32; shift += 7) {
+        uint8_t b = *p++;
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool OuiDatabase::readAt(uint32_t offset, uint8_t *buf, size_t len) {
+    if (read(offset, buf, len) == len) return true;
+    broken = true;
+    return false;
+}
+
+bool OuiDatabase::open() {
+    broken = false;
+    firstOui.clear();
+    blockOffset.clear();
+    for (CacheSlot &slot : cache) slot = CacheSlot();
+
+    uint8_t head[OUI_DB_HEADER];
+    if (!readAt(0, head, sizeof(head))) return false;
+    if (memcmp(head, OUI_DB_MAGIC, 4) != 0) {
+        broken = true;
+        return false;
+    }
+    entryCount = getLe32(head + 4);
+    uint32_t blocks = getLe32(head + 8);
+    nameCount = getLe32(head + 12);
+    indexOffset = getLe32(head + 16);
+    namesOffset = getLe32(head + 20);
+    if (namesOffset < indexOffset || namesOffset - indexOffset != blocks * 8) {
+        broken = true;
+        return false;
+    }
+
+    firstOui.resize(blocks);
+    blockOffset.resize(blocks);
+    uint8_t entry[8 * 32];
+    for (uint32_t i = 0; i < blocks; i += 32) {
+        uint32_t n = std::min<uint32_t>(32, blocks - i);
+        if (!readAt(indexOffset + i * 8, entry, n * 8)) return false;
+        for (uint32_t j = 0; j < n; j++) {
+            firstOui[i + j] = getLe32(entry + j * 8);
+            blockOffset[i + j] = getLe32(entry + j * 8 + 4);
+        }
+    }
+    return true;
+}
+
+bool OuiDatabase::lookup(uint32_t oui, std::string &vendor) {
+    if (broken) return false;
+    useCounter++;
+
+    CacheSlot *oldest = &cache[0];
+    for (CacheSlot &slot : cache) {
+        if (slot.oui == oui) {
+            slot.used = useCounter;
+            cacheHits++;
+            if (slot.found) vendor = slot.vendor;
+            return slot.found;
+        }
+        if (slot.used < oldest->used) oldest = &slot;
+    }
+
+    std::string found;
+    bool ok = find(oui, found);
+    if (broken) return false; // don't cache a read error
+    oldest->oui = oui;
+    oldest->used = useCounter;
+    oldest->found = ok;
+    oldest->vendor = found;
+    if (ok) vendor = found;
+    return ok;
+}
+
+bool OuiDatabase::find(uint32_t oui, std::string &vendor) {
+    // last block starting at or before oui
+    auto it = std::upper_bound(firstOui.begin(), firstOui.end(), oui);
+    if (it == firstOui.begin()) return false;
+    size_t block = it - firstOui.begin() - 1;
+
+    uint32_t start = blockOffset[block];
+    uint32_t end = block + 1 < blockOffset.size() ? blockOffset[block + 1] : indexOffset;
+    if (end < start || end - start > OUI_DB_MAX_BLOCK) {
+        broken = true;
+        return false;
+    }
+    uint8_t buf[OUI_DB_MAX_BLOCK];
+    if (!readAt(start, buf, end - start)) return false;
+
+    const uint8_t *p = buf;
+    const uint8_t *stop = buf + (end - start);
+    uint32_t current = firstOui[block];
+    uint32_t id;
+    if (!getVarint(p, stop, id)) return false;
+    while (current < oui) {
+        uint32_t delta;
+        if (p == stop) return false; // after the last entry of the block
+        if (!getVarint(p, stop, delta) || !getVarint(p, stop, id)) return false;
+        current += delta;
+    }
+    return current == oui && readName(id, vendor);
+}
+
+bool OuiDatabase::readName(uint32_t id, std::string &vendor) {
+    if (id >= nameCount) return false;
+    uint8_t range[8];
+    if (!readAt(namesOffset + id * 4, range, sizeof(range))) return false;
+    uint32_t from = getLe32(range);
+    uint32_t to = getLe32(range + 4);
+    if (to < from) return false;
+
+    char name[OUI_DB_MAX_NAME];
+    size_t len = std::min<size_t>(to - from, sizeof(name));
+    if (!readAt(from, (uint8_t *)name, len)) return false;
+    vendor.assign(name, len);
+    return true;
+}
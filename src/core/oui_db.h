@@ -0,0 +1,69 @@
+#ifndef __OUI_DB_H__
+#define __OUI_DB_H__
+
+// MAC vendor lookup in the file made by tools/oui_build.py from the IEEE registry. Only the standard
+// library here, the file is read through a callback, so it runs on a host too.
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * File, little endian:
+ *   header   "OUI1", u32 entries, u32 blocks, u32 names, u32 index offset, u32 names offset
+ *   blocks   entries sorted by OUI, up to 64 per block. The first one is varint(name id), the others
+ *            varint(OUI - previous OUI), varint(name id)
+ *   index    per block: u32 first OUI, u32 block offset
+ *   names    (names + 1) u32 offsets, then the names without terminator. Ids go by number of
+ *            entries, the big vendors get one byte ids
+ * The index stays in RAM (8 bytes per block, ~4KB), a lookup is a binary search there, then one
+ * block and one name read.
+ */
+#define OUI_DB_MAGIC "OUI1"
+#define OUI_DB_HEADER 24
+#define OUI_DB_MAX_BLOCK 512 // bytes, the builder keeps the blocks below it
+#define OUI_DB_MAX_NAME 96
+#define OUI_DB_CACHE 16 // vendors remembered, lists look up the same few over and over
+
+class OuiDatabase {
+public:
+    // read(offset, buf, len) returns the bytes read
+    using Reader = std::function<size_t(uint32_t offset, uint8_t *buf, size_t len)>;
+
+    explicit OuiDatabase(Reader reader) : read(reader) {}
+
+    bool open(); // checks the header and loads the index
+    // vendor of the first 3 bytes of a MAC, false if it isn't registered or the file can't be read
+    bool lookup(uint32_t oui, std::string &vendor);
+
+    bool ok() const { return !broken; } // false after a read error, open it again
+    uint32_t entries() const { return entryCount; }
+    uint32_t cacheHits = 0;
+
+private:
+    struct CacheSlot {
+        uint32_t oui = UINT32_MAX;
+        uint32_t used = 0;
+        bool found = false;
+        std::string vendor;
+    };
+
+    Reader read;
+    bool broken = true;
+    uint32_t entryCount = 0;
+    uint32_t nameCount = 0;
+    uint32_t indexOffset = 0;
+    uint32_t namesOffset = 0;
+    std::vector<uint32_t> firstOui;
+    std::vector<uint32_t> blockOffset;
+    CacheSlot cache[OUI_DB_CACHE];
+    uint32_t useCounter = 0;
+
+    bool readAt(uint32_t offset, uint8_t *buf, size_t len);
+    bool find(uint32_t oui, std::string &vendor);
+    bool readName(uint32_t id, std::string &vendor);
+};
+
+#endif
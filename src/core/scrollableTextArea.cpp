@@ -27,6 +27,7 @@ ScrollableTextArea::ScrollableTextArea(
 
 ScrollableTextArea::~ScrollableTextArea() {
     // We don't use Sprites for big things, unfortunetly theres no much RAM in all devices
+    if (_file) _file.close();
 }
 
 void ScrollableTextArea::setup() {
@@ -47,7 +48,7 @@ void ScrollableTextArea::scrollUp() {
 }
 
 void ScrollableTextArea::scrollDown() {
-    if (firstVisibleLine + _maxVisibleLines <= linesBuffer.size()) {
+    if (firstVisibleLine + _maxVisibleLines <= lineCount(firstVisibleLine + _maxVisibleLines)) {
         if (firstVisibleLine == 0) firstVisibleLine++;
         firstVisibleLine++;
         _redraw = true;
@@ -55,21 +56,159 @@ void ScrollableTextArea::scrollDown() {
 }
 
 void ScrollableTextArea::scrollToLine(size_t lineNumber) {
-    if (linesBuffer.empty()) return; // Ensure there's content to scroll
+    size_t total = lineCount(lineNumber + _maxVisibleLines);
+    if (total == 0) return; // Ensure there's content to scroll
 
-    if (lineNumber > linesBuffer.size() - _maxVisibleLines) {
-        firstVisibleLine =
-            (linesBuffer.size() > _maxVisibleLines) ? linesBuffer.size() - _maxVisibleLines : 0;
+    if (total < _maxVisibleLines || lineNumber > total - _maxVisibleLines) {
+        firstVisibleLine = (total > _maxVisibleLines) ? total - _maxVisibleLines : 0;
     } else {
         firstVisibleLine = lineNumber;
     }
+    _redraw = true;
+}
+
+void ScrollableTextArea::scrollToEnd() { scrollToLine(lineCount(SIZE_MAX)); }
+
+bool ScrollableTextArea::find(const String &text) {
+    if (text.isEmpty()) return false;
+    String needle = text;
+    needle.toLowerCase();
+    size_t found = SIZE_MAX;
+    auto match = [&](size_t lineNumber, String &line) {
+        line.toLowerCase();
+        if (line.indexOf(needle) < 0) return true;
+        found = lineNumber;
+        return false;
+    };
+
+    // From the line after the first visible one to the end, then from the top
+    size_t start = firstVisibleLine + 1;
+    if (_fromFile) {
+        walkFile(start, true, match);
+        if (found == SIZE_MAX)
+            walkFile(0, true, [&](size_t n, String &line) { return n < start && match(n, line); });
+    } else {
+        for (size_t i = 0; i < linesBuffer.size() && found == SIZE_MAX; i++) {
+            String line = linesBuffer[(start + i) % linesBuffer.size()];
+            match((start + i) % linesBuffer.size(), line);
+        }
+    }
+    if (found == SIZE_MAX) return false;
+
+    firstVisibleLine = found;
+    _redraw = true;
+    return true;
 }
 
 String ScrollableTextArea::getLine(size_t lineNumber) {
-    return linesBuffer[(lineNumber >= linesBuffer.size()) ? linesBuffer.size() : lineNumber];
+    size_t total = lineCount(lineNumber + 1);
+    if (total == 0) return "";
+    return lineAt((lineNumber >= total) ? total - 1 : lineNumber);
+}
+
+size_t ScrollableTextArea::getMaxLines() { return lineCount(SIZE_MAX); }
+
+size_t ScrollableTextArea::lineCount(size_t needed) {
+    if (!_fromFile) return linesBuffer.size();
+    if (!_indexDone && _indexedLines <= needed) {
+        size_t from = _indexedLines ? _indexedLines - 1 : 0;
+        walkFile(from, false, [&](size_t n, String &) { return _indexedLines <= needed; });
+    }
+    return _indexedLines;
+}
+
+String ScrollableTextArea::lineAt(size_t lineNumber) {
+    if (!_fromFile) return lineNumber < linesBuffer.size() ? linesBuffer[lineNumber] : "";
+
+    if (lineNumber < _windowFirst || lineNumber >= _windowFirst + _window.size()) {
+        // Keeps one screen above and two below, so scrolling a line doesn't read the file again
+        _window.clear();
+        _windowFirst = lineNumber > _maxVisibleLines ? lineNumber - _maxVisibleLines : 0;
+        size_t windowSize = 3 * _maxVisibleLines;
+        walkFile(_windowFirst, true, [&](size_t n, String &line) {
+            _window.push_back(line);
+            return _window.size() < windowSize;
+        });
+    }
+    size_t i = lineNumber - _windowFirst;
+    return i < _window.size() ? _window[i] : "";
 }
 
-size_t ScrollableTextArea::getMaxLines() { return linesBuffer.size(); }
+// Reads the file from the start of fromLine, wrapping the lines like addLine() does, and calls visit for
+// each one until it returns false. Lines reached for the first time are indexed on the way
+void ScrollableTextArea::walkFile(
+    size_t fromLine, bool wantText, const std::function<bool(size_t, String &)> &visit
+) {
+    size_t lineNumber = 0;
+    uint32_t offset = 0;
+    bool wrapped = false;
+    if (fromLine >= _indexedLines) {
+        if (_indexDone) return;
+        if (_indexedLines) {
+            lineNumber = _indexedLines - 1;
+            offset = _resumeOffset;
+            wrapped = _resumeWrapped;
+        }
+    } else {
+        size_t entry = fromLine / TEXT_AREA_INDEX_STEP;
+        lineNumber = entry * TEXT_AREA_INDEX_STEP;
+        offset = _lineIndex[entry] & 0x7FFFFFFF;
+        wrapped = _lineIndex[entry] >> 31;
+    }
+    if (!_file.seek(offset)) return;
+
+    uint8_t buf[TEXT_AREA_READ_CHUNK];
+    String line;
+    bool open = false; // a line started and it's not over
+    uint16_t col = 0;
+    uint32_t pos = offset;
+
+    auto emit = [&]() {
+        open = false;
+        col = 0;
+        bool more = true;
+        if (lineNumber >= fromLine) {
+            if (line.endsWith("\r")) line.remove(line.length() - 1);
+            more = visit(lineNumber, line);
+        }
+        lineNumber++;
+        return more;
+    };
+
+    int n;
+    while ((n = _file.read(buf, sizeof(buf))) > 0) {
+        for (int i = 0; i < n; i++, pos++) {
+            char c = buf[i];
+            uint16_t limit = _maxCharactersPerLine - (wrapped && _indentWrappedLines ? 1 : 0);
+            if (open && c != '\n' && col >= limit && limit > 0) {
+                if (!emit()) return;
+                wrapped = true;
+            }
+            if (!open) {
+                open = true;
+                if (lineNumber == _indexedLines) {
+                    if (lineNumber % TEXT_AREA_INDEX_STEP == 0)
+                        _lineIndex.push_back(pos | (wrapped ? 0x80000000 : 0));
+                    _resumeOffset = pos;
+                    _resumeWrapped = wrapped;
+                    _indexedLines++;
+                }
+                line = "";
+                if (wantText && lineNumber >= fromLine && wrapped && _indentWrappedLines) line = " ";
+            }
+            if (c == '\n') {
+                if (!emit()) return;
+                wrapped = false;
+            } else {
+                col++;
+                if (wantText && lineNumber >= fromLine) line += c;
+            }
+        }
+        yield();
+    }
+    if (open && !emit()) return;
+    _indexDone = true;
+}
 
 void ScrollableTextArea::show(bool force) {
     draw(force);
@@ -89,13 +228,24 @@ uint32_t ScrollableTextArea::getMaxVisibleTextLength() { return _maxVisibleLines
 void ScrollableTextArea::update(bool force) {
     if (check(PrevPress) || check(UpPress)) scrollUp();
     else if (check(NextPress) || check(DownPress)) scrollDown();
+    else if (check(PrevPagePress))
+        scrollToLine(firstVisibleLine > _maxVisibleLines ? firstVisibleLine - _maxVisibleLines : 0);
+    else if (check(NextPagePress)) scrollToLine(firstVisibleLine + _maxVisibleLines);
 
     draw(force);
 }
 
+void ScrollableTextArea::redrawFrame() {
+    drawMainBorder();
+    if (!_title.isEmpty()) printTitle(_title);
+    draw(true);
+}
+
 void ScrollableTextArea::fromFile(File file) {
-    linesBuffer.clear();
-    while (file.available()) addLine(file.readStringUntil('\n'));
+    clear();
+    _file = file;
+    _fromFile = true;
+    _redraw = true;
 
     draw(true);
     delay(100);
@@ -105,6 +255,17 @@ void ScrollableTextArea::fromFile(File file) {
 void ScrollableTextArea::clear() {
     firstVisibleLine = 0;
     linesBuffer.clear();
+    if (_file) _file.close();
+    _file = File();
+    _fromFile = false;
+    _lineIndex.clear();
+    _lineIndex.shrink_to_fit();
+    _indexedLines = 0;
+    _indexDone = false;
+    _resumeOffset = 0;
+    _resumeWrapped = false;
+    _window.clear();
+    _windowFirst = 0;
 }
 
 void ScrollableTextArea::fromString(const String &text) {
@@ -175,16 +336,17 @@ void ScrollableTextArea::draw(bool force) {
     }
 
     int32_t tmpHeight = _height;
+    size_t total = lineCount(firstVisibleLine + _maxVisibleLines);
     // if there is text below
-    if (linesBuffer.size() - firstVisibleLine >= _maxVisibleLines) {
+    if (total - firstVisibleLine >= _maxVisibleLines) {
         _scrollBuffer.drawString("...", 0 + _startX, _startY + _height - _pixelsPerLine);
         tmpHeight -= _pixelsPerLine;
         lines++;
     }
 
     size_t idx{firstVisibleLine};
-    while (yOffset < tmpHeight && lines < _maxVisibleLines && idx < linesBuffer.size()) {
-        _scrollBuffer.drawString(linesBuffer[idx], 0 + _startX, _startY + yOffset);
+    while (yOffset < tmpHeight && lines < _maxVisibleLines && idx < total) {
+        _scrollBuffer.drawString(lineAt(idx), 0 + _startX, _startY + yOffset);
         yOffset += _pixelsPerLine;
         lines++;
         idx++;
@@ -1,5 +1,8 @@
 #include "display.h"
 
+#define TEXT_AREA_INDEX_STEP 32 // file mode: one index entry every this many wrapped lines
+#define TEXT_AREA_READ_CHUNK 512
+
 class ScrollableTextArea {
 public:
     ScrollableTextArea(const String &title = "");
@@ -17,6 +20,11 @@ public:
 
     void scrollToLine(size_t lineNumber);
 
+    void scrollToEnd();
+
+    // Scrolls to the next line containing text (case insensitive), from the top if needed
+    bool find(const String &text);
+
     String getLine(size_t lineNumber);
     size_t getMaxLines();
 
@@ -26,12 +34,16 @@ public:
 
     void fromString(const String &text);
 
+    // Keeps the file open and reads the lines as they are shown, the index of wrapped lines is built
+    // while scrolling. Only a window of lines around the screen stays in memory
     void fromFile(File file);
 
     void draw(bool force = false);
 
     void show(bool force = false);
 
+    void redrawFrame(); // border, title and text, after something else used the screen
+
     uint32_t getMaxVisibleTextLength();
 
     size_t firstVisibleLine;
@@ -50,7 +62,22 @@ private:
     uint16_t _maxCharactersPerLine;
     bool _indentWrappedLines;
 
+    // File mode
+    File _file;
+    bool _fromFile = false;
+    std::vector<uint32_t> _lineIndex; // offset of every TEXT_AREA_INDEX_STEP-th line, top bit: wrapped
+    size_t _indexedLines = 0;         // lines reached so far
+    bool _indexDone = false;          // reached the end, _indexedLines is the total
+    uint32_t _resumeOffset = 0;       // start of the last line reached, to index further
+    bool _resumeWrapped = false;
+    std::vector<String> _window;
+    size_t _windowFirst = 0;
+
     void setup();
 
     void update(bool force = false);
+
+    size_t lineCount(size_t needed);
+    String lineAt(size_t lineNumber);
+    void walkFile(size_t fromLine, bool wantText, const std::function<bool(size_t, String &)> &visit);
 };
@@ -1,5 +1,7 @@
 #include "sd_functions.h"
 #include "display.h" // using displayRedStripe as error msg
+#include "file_hash.h"
+#include "file_view.h"
 #include "modules/badusb_ble/ducky_typer.h"
 #include "modules/bjs_interpreter/interpreter.h"
 #include "modules/gps/wigle.h"
@@ -13,13 +15,11 @@
 #include "scrollableTextArea.h"
 #include <globals.h>
 
-#include <MD5Builder.h>
-#include <algorithm>       // for std::sort
-#include <esp32/rom/crc.h> // for CRC32
+#include <algorithm> // for std::sort
 
 // SPIClass sdcardSPI;
 String fileToCopy;
-std::vector<FileList> fileList;
+DirIndex fileList;
 
 /***************************************************************************************
 ** Function name: setupSdCard
@@ -375,29 +375,24 @@ String readSmallFile(FS &fs, String filepath) {
 ***************************************************************************************/
 char *readBigFile(FS &fs, String filepath, bool binary, size_t *fileSize) {
     File file = fs.open(filepath);
-    if (!file) {
+    if (!file || file.isDirectory()) {
         Serial.printf("Could not open file: %s\n", filepath.c_str());
         return NULL;
     }
 
     size_t fileLen = file.size();
     char *buf = (char *)(psramFound() ? ps_malloc(fileLen + 1) : malloc(fileLen + 1));
-    if (fileSize != NULL) { *fileSize = file.size(); }
-
     if (!buf) {
         Serial.printf("Could not allocate memory for file: %s\n", filepath.c_str());
+        file.close();
         return NULL;
     }
 
-    size_t bytesRead = 0;
-    while (bytesRead < fileLen && file.available()) {
-        size_t toRead = fileLen - bytesRead;
-        if (toRead > 512) { toRead = 512; }
-        file.read((uint8_t *)(buf + bytesRead), toRead);
-        bytesRead += toRead;
-    }
+    // counts what really came back, a short read doesn't leave garbage at the end
+    size_t bytesRead = readFully(file, buf, fileLen);
     buf[bytesRead] = '\0';
     file.close();
+    if (fileSize != NULL) { *fileSize = bytesRead; }
 
     return buf;
 }
@@ -414,44 +409,51 @@ size_t getFileSize(FS &fs, String filepath) {
     return fileSize;
 }
 
+/***************************************************************************************
+** Function name: md5File / crc32File / sha256File
+** Description:   hash a file of any size, streamed in chunks (see file_hash.h)
+***************************************************************************************/
 String md5File(FS &fs, String filepath) {
-    if (!fs.exists(filepath)) return "";
-    String txt = readSmallFile(fs, filepath);
-    MD5Builder md5;
-    md5.begin();
-    md5.add(txt);
-    md5.calculate();
-    return (md5.toString());
+    FileHashResult hash;
+    hashFile(fs, filepath, FILE_HASH_MD5, hash);
+    return hash.md5;
 }
 
 String crc32File(FS &fs, String filepath) {
-    if (!fs.exists(filepath)) return "";
-    String txt = readSmallFile(fs, filepath);
-    // derived from
-    // https://techoverflow.net/2022/08/05/how-to-compute-crc32-with-ethernet-polynomial-0x04c11db7-on-esp32-crc-h/
-    uint32_t romCRC =
-        (~crc32_le((uint32_t)~(0xffffffff), (const uint8_t *)txt.c_str(), txt.length())) ^ 0xffffffff;
-    char s[18] = {0};
-    char crcBytes[4] = {0};
-    memcpy(crcBytes, &romCRC, sizeof(uint32_t));
-    snprintf(s, sizeof(s), "%02X%02X%02X%02X\n", crcBytes[3], crcBytes[2], crcBytes[1], crcBytes[0]);
-    return (String(s));
+    FileHashResult hash;
+    hashFile(fs, filepath, FILE_HASH_CRC32, hash);
+    return hash.crc32;
+}
+
+String sha256File(FS &fs, String filepath) {
+    FileHashResult hash;
+    hashFile(fs, filepath, FILE_HASH_SHA256, hash);
+    return hash.sha256;
 }
 
 /***************************************************************************************
-** Function name: sortList
-** Description:   sort files for name
+** Function name: showFileHash
+** Description:   hash a file with a progress bar, Esc cancels
 ***************************************************************************************/
-bool sortList(const FileList &a, const FileList &b) {
-    if (a.folder != b.folder) {
-        return a.folder > b.folder; // true if a is a folder and b is not
-    }
-    // Order items alfabetically
-    String fa = a.filename.c_str();
-    fa.toUpperCase();
-    String fb = b.filename.c_str();
-    fb.toUpperCase();
-    return fa < fb;
+static void showFileHash(FS &fs, String filepath, uint8_t type) {
+    delay(200);
+    FileHashResult hash;
+    int lastPercent = -1;
+    bool ok = hashFile(fs, filepath, type, hash, [&](size_t done, size_t total) {
+        int percent = total ? (uint64_t)done * 100 / total : 100;
+        if (percent != lastPercent) {
+            progressHandler(percent, 100, "Hashing...");
+            lastPercent = percent;
+        }
+        return !check(EscPress);
+    });
+    if (!ok) {
+        displayError("Hash failed or cancelled", true);
+        return;
+    }
+    if (type == FILE_HASH_MD5) displaySuccess(hash.md5, true);
+    else if (type == FILE_HASH_CRC32) displaySuccess(hash.crc32, true);
+    else displaySuccess(hash.sha256, true);
 }
 
 /***************************************************************************************
@@ -479,49 +481,16 @@ bool checkExt(String ext, String pattern) {
 }
 
 /***************************************************************************************
-** Function name: sortList
-** Description:   sort files for name
+** Function name: readFs
+** Description:   list a folder into fileList, sorted, with the "> Back" operation at the end
 ***************************************************************************************/
 void readFs(FS fs, String folder, String allowed_ext) {
-    int allFilesCount = 0;
-    fileList.clear();
-    FileList object;
-
-    File root = fs.open(folder);
-    if (!root || !root.isDirectory()) { return; }
-    File file = root.openNextFile();
-    while (file && fileList.size() < 250) {
-        String fileName = file.name();
-        if (file.isDirectory()) {
-            object.filename = fileName.substring(fileName.lastIndexOf("/") + 1);
-            object.folder = true;
-            object.operation = false;
-            fileList.push_back(object);
-        } else {
-            String ext = fileName.substring(fileName.lastIndexOf(".") + 1);
-            if (allowed_ext == "*" || checkExt(ext, allowed_ext)) {
-                object.filename = fileName.substring(fileName.lastIndexOf("/") + 1);
-                object.folder = false;
-                object.operation = false;
-                fileList.push_back(object);
-            }
-        }
-        file = root.openNextFile();
-    }
-    file.close();
-    root.close();
-
-    // Sort folders/files
-    std::sort(fileList.begin(), fileList.end(), sortList);
+    fileList.load(fs, folder, allowed_ext);
 
     Serial.println("Files listed with: " + String(fileList.size()) + " files/folders found");
 
     // Adds Operational btn at the botton
-    object.filename = "> Back";
-    object.folder = false;
-    object.operation = true;
-
-    fileList.push_back(object);
+    fileList.add("> Back", false, 0, true);
 }
 
 /*********************************************************************
@@ -591,7 +560,7 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
 #endif
             redraw = false;
         }
-        displayScrollingText(fileList[index].filename, coord);
+        displayScrollingText(fileList.name(index), coord);
 
 #ifdef HAS_KEYBOARD
         char pressed_letter = checkLetterShortcutPress();
@@ -600,18 +569,18 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
         // check letter shortcuts
         if (pressed_letter > 0) {
             // Serial.println(pressed_letter);
-            if (tolower(fileList[index].filename.c_str()[0]) == pressed_letter) {
+            if (tolower(fileList.name(index)[0]) == pressed_letter) {
                 // already selected, go to the next
                 index += 1;
                 // check if index is still valid
-                if (index <= maxFiles && tolower(fileList[index].filename.c_str()[0]) == pressed_letter) {
+                if (index <= maxFiles && tolower(fileList.name(index)[0]) == pressed_letter) {
                     redraw = true;
                     continue;
                 }
             }
             // else look again from the start
             for (int i = 0; i < maxFiles; i++) {
-                if (tolower(fileList[i].filename.c_str()[0]) == pressed_letter) { // check if 1st char matches
+                if (tolower(fileList.name(i)[0]) == pressed_letter) { // check if 1st char matches
                     index = i;
                     redraw = true;
                     break; // quit on 1st match
@@ -655,22 +624,22 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
             LongPress = false;
 
             if (check(SelPress)) {
-                if (fileList[index].folder == true && fileList[index].operation == false) {
+                if (fileList.isFolder(index) && !fileList.isOperation(index)) {
                     options = {
-                        {"New Folder", [=]() { createFolder(fs, Folder); }                                 },
+                        {"New Folder", [=]() { createFolder(fs, Folder); }                             },
                         {"Rename",
                          [=]() {
-                             renameFile(fs, Folder + fileList[index].filename, fileList[index].filename);
-                         }                                                                                 },
-                        {"Delete",     [=]() { deleteFromSd(fs, Folder + "/" + fileList[index].filename); }},
-                        {"Close Menu", [&]() { yield(); }                                                  },
-                        {"Main Menu",  [&]() { exit = true; }                                              },
+                             renameFile(fs, Folder + fileList.name(index), fileList.name(index));
+                         }                                                                             },
+                        {"Delete",     [=]() { deleteFromSd(fs, Folder + "/" + fileList.name(index)); }},
+                        {"Close Menu", [&]() { yield(); }                                              },
+                        {"Main Menu",  [&]() { exit = true; }                                          },
                     };
                     loopOptions(options);
                     tft.drawRoundRect(5, 5, tftWidth - 10, tftHeight - 10, 5, bruceConfig.priColor);
                     reload = true;
                     redraw = true;
-                } else if (fileList[index].folder == false && fileList[index].operation == false) {
+                } else if (!fileList.isFolder(index) && !fileList.isOperation(index)) {
                     goto Files;
                 } else {
                     options = {
@@ -686,16 +655,15 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
                 }
             } else {
             Files:
-                if (fileList[index].folder == true && fileList[index].operation == false) {
-                    Folder = Folder + (Folder == "/" ? "" : "/") +
-                             fileList[index].filename; // Folder=="/"? "":"/" +
+                if (fileList.isFolder(index) && !fileList.isOperation(index)) {
+                    Folder = Folder + (Folder == "/" ? "" : "/") + fileList.name(index);
                     // Debug viewer
                     Serial.println(Folder);
                     redraw = true;
-                } else if (fileList[index].folder == false && fileList[index].operation == false) {
+                } else if (!fileList.isFolder(index) && !fileList.isOperation(index)) {
                     // Save the file/folder info to Clear memory to allow other functions to work better
-                    String filepath = Folder + (Folder == "/" ? "" : "/") + fileList[index].filename; //
-                    String filename = fileList[index].filename;
+                    String filepath = Folder + (Folder == "/" ? "" : "/") + fileList.name(index); //
+                    String filename = fileList.name(index);
                     // Debug viewer
                     Serial.println(filepath + " --> " + filename);
                     fileList.clear(); // Clear memory to allow other functions to work better
@@ -817,13 +785,12 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
                                                delay(200);
                                                qrcode_display(readSmallFile(fs, filepath));
                                            }});
-                        options.push_back({"CRC32", [&]() {
-                                               delay(200);
-                                               displaySuccess(crc32File(fs, filepath), true);
-                                           }});
-                        options.push_back({"MD5", [&]() {
-                                               delay(200);
-                                               displaySuccess(md5File(fs, filepath), true);
+                    }
+                    if (filesize > 0) {
+                        options.push_back({"CRC32", [&]() { showFileHash(fs, filepath, FILE_HASH_CRC32); }});
+                        options.push_back({"MD5", [&]() { showFileHash(fs, filepath, FILE_HASH_MD5); }});
+                        options.push_back({"SHA-256", [&]() {
+                                               showFileHash(fs, filepath, FILE_HASH_SHA256);
                                            }});
                     }
                     options.push_back({"Close Menu", [&]() { yield(); }});
@@ -864,11 +831,35 @@ void viewFile(FS fs, String filepath) {
     if (!file) return;
 
     ScrollableTextArea area = ScrollableTextArea("VIEW FILE");
-    area.fromFile(file);
-
-    file.close();
-
-    area.show();
+    area.fromFile(file); // the area keeps the file open and reads only what is shown
+
+    String search = "";
+    while (true) {
+        area.show();
+
+        // Sel opens the viewer menu
+        int action = -1;
+        std::vector<Option> viewOptions = {
+            {"Search",      [&]() { action = 0; }},
+            {"Go to start", [&]() { action = 2; }},
+            {"Go to end",   [&]() { action = 3; }},
+            {"Close file",  [&]() { action = 4; }},
+        };
+        if (!search.isEmpty())
+            viewOptions.insert(viewOptions.begin() + 1, {"Find next", [&]() { action = 1; }});
+        loopOptions(viewOptions);
+
+        if (action == 4) break;
+        if (action == 0) {
+            String text = keyboard(search, 76, "Search:");
+            if (text != "\x1B") search = text;
+        }
+        if ((action == 0 || action == 1) && !search.isEmpty() && !area.find(search))
+            displayInfo("Not found", true);
+        if (action == 2) area.scrollToLine(0);
+        if (action == 3) area.scrollToEnd();
+        area.redrawFrame();
+    }
 }
 
 /*********************************************************************
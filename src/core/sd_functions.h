@@ -1,17 +1,12 @@
 #ifndef __SD_FUNCTIONS_H__
 #define __SD_FUNCTIONS_H__
 
+#include "dir_index.h"
 #include <FS.h>
 #include <LittleFS.h>
 #include <SD.h>
 #include <SPI.h>
 
-struct FileList {
-    String filename;
-    bool folder;
-    bool operation;
-};
-
 // extern SPIClass sdcardSPI;
 
 bool setupSdCard();
@@ -42,9 +37,11 @@ String md5File(FS &fs, String filepath);
 
 String crc32File(FS &fs, String filepath);
 
-void readFs(FS fs, String folder, String allowed_ext = "*");
+String sha256File(FS &fs, String filepath);
 
-bool sortList(const FileList &a, const FileList &b);
+bool checkExt(String ext, String pattern);
+
+void readFs(FS fs, String folder, String allowed_ext = "*");
 
 String loopSD(FS &fs, bool filePicker = false, String allowed_ext = "*", String rootPath = "/");
 
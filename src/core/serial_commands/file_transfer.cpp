@@ -0,0 +1,213 @@
+#include "file_transfer.h"
+#include <esp32/rom/crc.h> // for CRC32
+
+struct FtFrame {
+    uint8_t type;
+    uint16_t len;
+    uint32_t offset;
+};
+
+static inline void putLe16(uint8_t *p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static inline void putLe32(uint8_t *p, uint32_t v) {
+    putLe16(p, v);
+    putLe16(p + 2, v >> 16);
+}
+
+static inline uint32_t getLe32(const uint8_t *p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void sendFrame(uint8_t type, uint32_t offset, const uint8_t *payload = nullptr, uint16_t len = 0) {
+    uint8_t head[FT_HEADER_SIZE] = {FT_MAGIC, type};
+    putLe16(head + 2, len);
+    putLe32(head + 4, offset);
+    uint32_t crc = crc32_le(0, head + 1, FT_HEADER_SIZE - 1);
+    if (len) crc = crc32_le(crc, payload, len);
+    uint8_t tail[4];
+    putLe32(tail, crc);
+
+    Serial.write(head, FT_HEADER_SIZE);
+    if (len) Serial.write(payload, len);
+    Serial.write(tail, sizeof(tail));
+}
+
+static void sendError(const char *msg) { sendFrame(FT_ERROR, 0, (const uint8_t *)msg, strlen(msg)); }
+
+void serialTransferError(const char *msg) { sendError(msg); }
+
+static void sendReady(uint32_t offset, uint32_t size, uint16_t chunk, uint16_t window) {
+    uint8_t info[8];
+    putLe32(info, size);
+    putLe16(info + 4, chunk);
+    putLe16(info + 6, window);
+    sendFrame(FT_READY, offset, info, sizeof(info));
+}
+
+// Waits up to timeoutMs for a frame, the payload goes in buf. False on timeout or a corrupted frame
+static bool readFrame(FtFrame &frame, uint8_t *buf, size_t maxLen, uint32_t timeoutMs) {
+    uint32_t start = millis();
+    uint8_t head[FT_HEADER_SIZE];
+    uint8_t tail[4];
+    while (millis() - start < timeoutMs) {
+        if (!Serial.available()) {
+            vTaskDelay(1);
+            continue;
+        }
+        if (Serial.read() != FT_MAGIC) continue; // text or garbage between frames
+
+        if (Serial.readBytes(head + 1, FT_HEADER_SIZE - 1) != FT_HEADER_SIZE - 1) return false;
+        frame.type = head[1];
+        frame.len = head[2] | head[3] << 8;
+        frame.offset = getLe32(head + 4);
+        if (frame.len > maxLen) continue; // the magic byte was only data
+
+        if (frame.len && Serial.readBytes(buf, frame.len) != frame.len) return false;
+        if (Serial.readBytes(tail, sizeof(tail)) != sizeof(tail)) return false;
+        uint32_t crc = crc32_le(0, head + 1, FT_HEADER_SIZE - 1);
+        if (frame.len) crc = crc32_le(crc, buf, frame.len);
+        return crc == getLe32(tail);
+    }
+    return false;
+}
+
+bool serialSendFile(FS &fs, const String &filepath, uint32_t offset) {
+    File file = fs.open(filepath, FILE_READ);
+    if (!file || file.isDirectory()) {
+        sendError("Cannot open file");
+        return false;
+    }
+    uint8_t *buf = (uint8_t *)malloc(FT_CHUNK);
+    if (!buf) {
+        file.close();
+        sendError("Out of memory");
+        return false;
+    }
+
+    uint32_t size = file.size();
+    if (offset > size) offset = size;
+    sendReady(offset, size, FT_CHUNK, FT_WINDOW);
+
+    uint32_t acked = offset; // the host has everything before it
+    uint32_t next = offset;  // next byte to send
+    int retries = 0;
+    bool ok = false;
+    while (true) {
+        while (next < size && next - acked < FT_CHUNK * FT_WINDOW) {
+            if (file.position() != next) file.seek(next);
+            size_t n = file.read(buf, min((uint32_t)FT_CHUNK, size - next));
+            if (n == 0) break;
+            sendFrame(FT_DATA, next, buf, n);
+            next += n;
+        }
+        if (acked >= size) {
+            ok = true;
+            break;
+        }
+
+        FtFrame frame;
+        uint8_t in[8];
+        if (!readFrame(frame, in, sizeof(in), FT_TIMEOUT_MS)) {
+            if (++retries > FT_RETRIES) break;
+            next = acked; // go back to what the host has
+            continue;
+        }
+        if (frame.type == FT_ABORT) break;
+        if ((frame.type != FT_ACK && frame.type != FT_NAK) || frame.offset > next) continue;
+        if (frame.offset > acked) {
+            acked = frame.offset;
+            retries = 0;
+        }
+        if (frame.type == FT_NAK && frame.offset == acked) next = acked;
+    }
+    file.close();
+    free(buf);
+
+    if (ok) sendFrame(FT_END, size);
+    else sendError("Transfer failed");
+    return ok;
+}
+
+bool serialReceiveFile(FS &fs, const String &filepath, uint32_t size, bool resume) {
+    uint32_t start = 0;
+    if (resume && fs.exists(filepath)) {
+        File old = fs.open(filepath, FILE_READ);
+        if (old && !old.isDirectory() && old.size() <= size) start = old.size();
+        old.close();
+    }
+    File file = fs.open(filepath, start ? FILE_APPEND : FILE_WRITE, true);
+    if (!file) {
+        sendError("Cannot create file");
+        return false;
+    }
+
+    // Frames in flight have to fit in the RX buffer. USB CDC grows it at runtime, a UART that is
+    // already running can't, it gets small frames one at a time
+    uint16_t chunk = FT_CHUNK;
+    uint16_t window = FT_RX_BUFFER / (FT_CHUNK + FT_HEADER_SIZE + 4);
+    bool grown = Serial.setRxBufferSize(FT_RX_BUFFER) >= FT_RX_BUFFER;
+    if (!grown) {
+        chunk = FT_SMALL_CHUNK;
+        window = 1;
+    }
+    uint8_t *buf = (uint8_t *)malloc(chunk);
+    if (!buf) {
+        file.close();
+        if (grown) Serial.setRxBufferSize(FT_RX_BUFFER_DEFAULT);
+        sendError("Out of memory");
+        return false;
+    }
+    sendReady(start, size, chunk, window);
+
+    uint32_t expected = start;
+    uint32_t nakSent = UINT32_MAX; // one NAK per gap, the frames already in flight don't repeat it
+    int retries = 0;
+    bool failed = false;
+    while (expected < size) {
+        FtFrame frame;
+        if (!readFrame(frame, buf, chunk, FT_TIMEOUT_MS)) {
+            if (++retries > FT_RETRIES) {
+                failed = true;
+                break;
+            }
+            sendFrame(FT_NAK, expected);
+            nakSent = expected;
+            continue;
+        }
+        if (frame.type == FT_ABORT) {
+            failed = true;
+            break;
+        }
+        if (frame.type != FT_DATA) continue;
+
+        if (frame.offset != expected || frame.len == 0 || frame.len > size - expected) {
+            if (frame.offset < expected) sendFrame(FT_ACK, expected); // resent, we have it
+            else if (nakSent != expected) {
+                sendFrame(FT_NAK, expected);
+                nakSent = expected;
+            }
+            continue;
+        }
+        if (file.write(buf, frame.len) != frame.len) {
+            failed = true;
+            break;
+        }
+        expected += frame.len;
+        retries = 0;
+        sendFrame(FT_ACK, expected);
+    }
+    file.close();
+    free(buf);
+    // before the last frame, the host sends the next command once it has it
+    if (grown) Serial.setRxBufferSize(FT_RX_BUFFER_DEFAULT);
+
+    if (failed) {
+        sendError("Transfer failed");
+        return false;
+    }
+    sendFrame(FT_END, expected);
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef __SERIAL_FILE_TRANSFER_H__
+#define __SERIAL_FILE_TRANSFER_H__
+
+#include <FS.h>
+
+/*
+ * Binary file transfer over the serial CLI ("storage get" / "storage put"), host side in
+ * tools/serial_transfer.py.
+ *
+ * Frame, little endian: magic 0xBF, type, u16 payload length, u32 offset, payload, u32 CRC32 of
+ * everything after the magic. Bytes that aren't a valid frame are skipped, so log lines printed
+ * meanwhile don't break the transfer.
+ *
+ * The device answers a command with READY: offset = where the data starts, payload = u32 file size,
+ * u16 chunk size, u16 window (frames). The sender keeps up to window frames not acknowledged;
+ * the receiver ACKs the offset it expects next, or NAKs it on a bad or missing frame and the sender
+ * goes back to it. END closes a transfer (offset = size), ABORT cancels it, ERROR carries a message.
+ */
+
+#define FT_MAGIC 0xBF
+#define FT_HEADER_SIZE 8
+#define FT_CHUNK 2048           // payload per frame
+#define FT_WINDOW 8             // frames in flight, device to host
+#define FT_RX_BUFFER 8192       // serial RX buffer asked for while receiving
+#define FT_RX_BUFFER_DEFAULT (SAFE_STACK_BUFFER_SIZE / 4) // the one setup() asks for, restored after
+#define FT_SMALL_CHUNK 224      // frames small enough for the default 256 bytes RX buffer
+#define FT_TIMEOUT_MS 1000      // without a frame, resend (sender) or NAK (receiver)
+#define FT_RETRIES 10           // timeouts in a row before giving up
+
+enum FtFrameType : uint8_t {
+    FT_READY = 'R',
+    FT_DATA = 'D',
+    FT_ACK = 'A',
+    FT_NAK = 'N',
+    FT_END = 'E',
+    FT_ABORT = 'X',
+    FT_ERROR = '!',
+};
+
+// ERROR frame, for a command that fails before the transfer starts. The host stops waiting on it
+void serialTransferError(const char *msg);
+
+// Sends filepath from offset on, for "storage get"
+bool serialSendFile(FS &fs, const String &filepath, uint32_t offset = 0);
+
+// Receives size bytes into filepath, for "storage put". With resume, a shorter existing file is
+// continued from its end instead of being replaced
+bool serialReceiveFile(FS &fs, const String &filepath, uint32_t size, bool resume = false);
+
+#endif
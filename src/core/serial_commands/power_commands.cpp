@@ -3,12 +3,14 @@
 #include <globals.h>
 
 uint32_t poweroffCallback(cmd *c) {
+    bruceConfig.flush();
     powerOff();
     esp_deep_sleep_start(); // only wake up via hardware reset
     return true;
 }
 
 uint32_t rebootCallback(cmd *c) {
+    bruceConfig.flush();
     ESP.restart();
     return true;
 }
@@ -1,5 +1,6 @@
 #include "storage_commands.h"
 #include "core/sd_functions.h"
+#include "file_transfer.h"
 #include "helpers.h"
 #include <globals.h>
 
@@ -51,10 +52,70 @@ uint32_t readCallback(cmd *c) {
     FS *fs;
     if (!getFsStorage(fs) || !(*fs).exists(filepath)) return false;
 
-    Serial.println(readSmallFile(*fs, filepath));
+    File file = fs->open(filepath, FILE_READ);
+    if (!file || file.isDirectory()) return false;
+
+    // streamed, so the file size isn't limited by a buffer
+    uint8_t buf[512];
+    size_t n;
+    while ((n = file.read(buf, sizeof(buf))) > 0) Serial.write(buf, n);
+    file.close();
+    Serial.println();
     return true;
 }
 
+uint32_t getCallback(cmd *c) {
+    Command cmd(c);
+
+    String filepath = cmd.getArgument("filepath").getValue();
+    filepath.trim();
+    uint32_t offset = cmd.getArgument("offset").getValue().toInt();
+
+    // tools/serial_transfer.py waits for a frame, every failure answers with one
+    if (filepath.length() == 0) {
+        serialTransferError("No file path");
+        return false;
+    }
+
+    if (!filepath.startsWith("/")) filepath = "/" + filepath;
+
+    FS *fs;
+    if (!getFsStorage(fs)) {
+        serialTransferError("No storage");
+        return false;
+    }
+    if (!(*fs).exists(filepath)) {
+        serialTransferError("File not found");
+        return false;
+    }
+
+    return serialSendFile(*fs, filepath, offset);
+}
+
+uint32_t putCallback(cmd *c) {
+    Command cmd(c);
+
+    String filepath = cmd.getArgument("filepath").getValue();
+    filepath.trim();
+    String sizeStr = cmd.getArgument("size").getValue();
+    bool resume = cmd.getArgument("resume").isSet();
+
+    if (filepath.length() == 0 || sizeStr.toInt() <= 0) {
+        serialTransferError("Bad file path or size");
+        return false;
+    }
+
+    if (!filepath.startsWith("/")) filepath = "/" + filepath;
+
+    FS *fs;
+    if (!getFsStorage(fs)) {
+        serialTransferError("No storage");
+        return false;
+    }
+
+    return serialReceiveFile(*fs, filepath, strtoul(sizeStr.c_str(), nullptr, 10), resume);
+}
+
 uint32_t md5Callback(cmd *c) {
     Command cmd(c);
 
@@ -91,6 +152,24 @@ uint32_t crc32Callback(cmd *c) {
     return true;
 }
 
+uint32_t sha256Callback(cmd *c) {
+    Command cmd(c);
+
+    Argument arg = cmd.getArgument("filepath");
+    String filepath = arg.getValue();
+    filepath.trim();
+
+    if (filepath.length() == 0) return false;
+
+    if (!filepath.startsWith("/")) filepath = "/" + filepath;
+
+    FS *fs;
+    if (!getFsStorage(fs) || !(*fs).exists(filepath)) return false;
+
+    Serial.println(sha256File(*fs, filepath));
+    return true;
+}
+
 uint32_t removeCallback(cmd *c) {
     Command cmd(c);
 
@@ -124,7 +203,7 @@ uint32_t writeCallback(cmd *c) {
     Argument arg = cmd.getArgument("filepath");
     Argument sizeArg = cmd.getArgument("size");
     String filepath = arg.getValue();
-    String sizeStr = arg.getValue();
+    String sizeStr = sizeArg.getValue();
     filepath.trim();
     int fileSize = sizeStr.toInt();
 
@@ -138,12 +217,20 @@ uint32_t writeCallback(cmd *c) {
     if (!getFsStorage(fs)) return false;
 
     char *txt = _readFileFromSerial(fileSize + 2);
-    if (strlen(txt) == 0) return false;
+    if (!txt) return false;
+    size_t len = strlen(txt); // text only, binary files go through "storage put"
+    if (len == 0) {
+        free(txt);
+        return false;
+    }
 
     File f = fs->open(filepath, FILE_WRITE, true);
-    if (!f) return false;
+    if (!f) {
+        free(txt);
+        return false;
+    }
 
-    f.write((const uint8_t *)txt, strlen(txt));
+    f.write((const uint8_t *)txt, len);
     f.close();
     free(txt);
 
@@ -360,6 +447,11 @@ void createCrc32Command(SimpleCLI *cli) {
     cmd.addPosArg("filepath");
 }
 
+void createSha256Command(SimpleCLI *cli) {
+    Command cmd = cli->addCommand("sha256", sha256Callback);
+    cmd.addPosArg("filepath");
+}
+
 void createRemoveCommand(SimpleCLI *cli) {
     Command cmd = cli->addCommand("rm,del", removeCallback);
     cmd.addPosArg("filepath");
@@ -391,6 +483,16 @@ void createStorageCommand(SimpleCLI *cli) {
     cmdWrite.addPosArg("filepath");
     cmdWrite.addPosArg("size", "0");
 
+    // binary transfers, see tools/serial_transfer.py
+    Command cmdGet = cmd.addCommand("get", getCallback);
+    cmdGet.addPosArg("filepath");
+    cmdGet.addPosArg("offset", "0");
+
+    Command cmdPut = cmd.addCommand("put", putCallback);
+    cmdPut.addPosArg("filepath");
+    cmdPut.addPosArg("size");
+    cmdPut.addFlagArg("resume");
+
     Command cmdRename = cmd.addCommand("rename", renameCallback);
     cmdRename.addPosArg("filepath");
     cmdRename.addPosArg("newName");
@@ -411,6 +513,9 @@ void createStorageCommand(SimpleCLI *cli) {
     Command cmdCrc32 = cmd.addCommand("crc32", crc32Callback);
     cmdCrc32.addPosArg("filepath");
 
+    Command cmdSha256 = cmd.addCommand("sha256", sha256Callback);
+    cmdSha256.addPosArg("filepath");
+
     Command cmdStat = cmd.addCommand("stat", statCallback);
     cmdStat.addPosArg("filepath");
 
@@ -428,6 +533,7 @@ void createStorageCommands(SimpleCLI *cli) {
 
     createMd5Command(cli);
     createCrc32Command(cli);
+    createSha256Command(cli);
 
     createStorageCommand(cli);
 }
@@ -5,18 +5,44 @@ AUXILIARY FUNCTIONS TO CREATE THE JSONS
 */
 
 /* TFT LOGGER FUNCTIONS */
-tft_logger::tft_logger(int16_t w, int16_t h) : BRUCE_TFT_DRIVER(w, h) {}
+tft_logger::tft_logger(int16_t w, int16_t h) : BRUCE_TFT_DRIVER(w, h) { clearLog(); }
 tft_logger::~tft_logger() { clearLog(); }
 
 void tft_logger::clearLog() {
+    portENTER_CRITICAL(&logLock);
     memset(log, 0, sizeof(log));
+    memset(logSeq, 0, sizeof(logSeq));
+    memset(cellEntries, 0, sizeof(cellEntries));
     memset(images, 0, sizeof(images));
-    logWriteIndex = 0;
+    freeEntries = ~0ULL;
+    resyncSeq = seq + 1;
+    portEXIT_CRITICAL(&logLock);
 }
 
-void tft_logger::addLogEntry(const uint8_t *buffer, uint8_t size) {
-    memcpy(log[logWriteIndex].data, buffer, size);
-    logWriteIndex = (logWriteIndex + 1) % MAX_LOG_ENTRIES;
+static inline int logCellCoord(int v) {
+    if (v < 0) return 0;
+    v >>= LOG_CELL_SHIFT;
+    return v < LOG_GRID ? v : LOG_GRID - 1;
+}
+
+// Every entry starts with AA SS FN XX XX YY YY, the position is used to place it in the grid
+static inline uint8_t logEntryCell(const uint8_t *data) {
+    int px = (data[3] << 8) | data[4];
+    int py = (data[5] << 8) | data[6];
+    return logCellCoord(py) * LOG_GRID + logCellCoord(px);
+}
+
+static uint32_t logEntryHash(const uint8_t *data) {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (uint8_t i = 0; i < data[1]; i++) h = (h ^ data[i]) * 16777619u;
+    return h;
+}
+
+void tft_logger::dropLogEntry(int i) {
+    log[i].data[0] = 0; // Mark as deleted
+    logSeq[i] = 0;
+    cellEntries[logCell[i]] &= ~(1ULL << i);
+    freeEntries |= 1ULL << i;
 }
 
 void tft_logger::logWriteHeader(uint8_t *buffer, uint8_t &pos, tftFuncs fn) {
@@ -32,27 +58,57 @@ void tft_logger::writeUint16(uint8_t *buffer, uint8_t &pos, uint16_t value) {
 
 void tft_logger::setLogging(bool _log) {
     logging = _logging = _log;
-    logWriteIndex = 0;
-    memset(log, 0, sizeof(log));
+    clearLog();
 };
 
 void tft_logger::getBinLog(uint8_t *outBuffer, size_t &outSize) {
-    outSize = 0;
-    // add Screen Info at the beginning of the Bin packet
+    outSize = getBinLogSince(outBuffer, MAX_LOG_ENTRIES * MAX_LOG_SIZE, 0);
+}
+
+size_t tft_logger::getBinLogSince(uint8_t *outBuffer, size_t maxSize, uint32_t since, uint32_t *lastSeq) {
+    size_t outSize = 0;
+    // the output is the snapshot, the drawing task can't change the log while it is written
+    portENTER_CRITICAL(&logLock);
+    uint32_t upTo = seq;
+    bool full = since == 0 || since < resyncSeq || since > upTo; // since > upTo: device restarted
+
+    // Sequence first, so the client knows what to ask next
     uint8_t buffer[16];
     uint8_t pos = 0;
-    logWriteHeader(buffer, pos, SCREEN_INFO);
-    writeUint16(buffer, pos, width());
-    writeUint16(buffer, pos, height());
-    buffer[pos++] = rotation;
-    buffer[1] = pos;
-
+    logWriteHeader(buffer, pos, SCREEN_SEQ);
+    writeUint16(buffer, pos, upTo >> 16);
+    writeUint16(buffer, pos, upTo & 0xFFFF);
+    // add Screen Info when sending the whole screen, the client clears the canvas on it
+    if (full) {
+        buffer[1] = pos;
+        uint8_t infoStart = pos;
+        logWriteHeader(buffer, pos, SCREEN_INFO);
+        writeUint16(buffer, pos, width());
+        writeUint16(buffer, pos, height());
+        buffer[pos++] = rotation;
+        buffer[infoStart + 1] = pos - infoStart;
+    } else {
+        buffer[1] = pos;
+    }
     memcpy(outBuffer + outSize, buffer, pos);
     outSize += pos;
 
+    // entries in the order they were drawn
+    uint8_t order[MAX_LOG_ENTRIES];
+    int count = 0;
     for (int i = 0; i < MAX_LOG_ENTRIES; i++) {
-        if (log[i].data[0] != LOG_PACKET_HEADER) continue;
-        uint8_t *entry = log[i].data;
+        if (log[i].data[0] != LOG_PACKET_HEADER || logSeq[i] > upTo) continue;
+        if (!full && logSeq[i] <= since) continue;
+        int j = count++;
+        while (j > 0 && logSeq[order[j - 1]] > logSeq[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    for (int k = 0; k < count; k++) {
+        uint8_t *entry = log[order[k]].data;
         uint8_t fn = entry[2];
 
         if (fn == DRAWIMAGE) {
@@ -61,7 +117,7 @@ void tft_logger::getBinLog(uint8_t *outBuffer, size_t &outSize) {
             const char *imgPath = images[imageSlot];
             size_t baseLen = 12; // AA SS FN XX XX YY YY Ce Ce Ms Ms FS + PATH
             size_t imgLen = strlen(imgPath);
-            if (outSize + baseLen + imgLen > MAX_LOG_SIZE * MAX_LOG_ENTRIES) continue;
+            if (outSize + baseLen + imgLen > maxSize) continue;
 
             memcpy(outBuffer + outSize, entry, baseLen);
             outSize += baseLen;
@@ -71,32 +127,58 @@ void tft_logger::getBinLog(uint8_t *outBuffer, size_t &outSize) {
             outBuffer[outSize - imgLen - baseLen + 1] = baseLen + imgLen; // update packet size
         } else {
             uint8_t size = entry[1];
-            if (outSize + size > MAX_LOG_SIZE * MAX_LOG_ENTRIES) continue;
+            if (outSize + size > maxSize) continue;
             memcpy(outBuffer + outSize, entry, size);
             outSize += size;
         }
     }
+    portEXIT_CRITICAL(&logLock);
+    if (lastSeq) *lastSeq = upTo;
+    return outSize;
 }
 
 void tft_logger::restoreLogger() {
     if (_logging) logging = true;
 }
 
-bool tft_logger::isLogEqual(const tftLog &a, const tftLog &b) {
-    uint8_t sizeA = a.data[1];
-    uint8_t sizeB = b.data[1];
-    if (sizeA != sizeB) return false;
-    return memcmp(a.data, b.data, sizeA) == 0;
-}
-
 void tft_logger::pushLogIfUnique(const tftLog &l) {
-    for (int i = 0; i < MAX_LOG_ENTRIES; i++) {
-        if (isLogEqual(log[i], l)) {
-            return; // Entry already exists
+    uint8_t size = l.data[1];
+    uint8_t cell = logEntryCell(l.data);
+    uint32_t hash = logEntryHash(l.data);
+    portENTER_CRITICAL(&logLock);
+
+    // a duplicate has the same position, so only the entries of the same cell are checked
+    uint64_t candidates = cellEntries[cell];
+    while (candidates) {
+        int i = __builtin_ctzll(candidates);
+        candidates &= candidates - 1;
+        if (logHash[i] == hash && log[i].data[1] == size && memcmp(log[i].data, l.data, size) == 0) {
+            logSeq[i] = ++seq; // Entry already exists, drawn again on top of what came after it
+            portEXIT_CRITICAL(&logLock);
+            return;
+        }
+    }
+
+    int slot;
+    if (freeEntries) {
+        slot = __builtin_ctzll(freeEntries);
+    } else {
+        // log is full, the oldest entry is lost and clients that didn't get it need the whole screen
+        slot = 0;
+        for (int i = 1; i < MAX_LOG_ENTRIES; i++) {
+            if (logSeq[i] < logSeq[slot]) slot = i;
         }
+        if (logSeq[slot] + 1 > resyncSeq) resyncSeq = logSeq[slot] + 1;
+        dropLogEntry(slot);
     }
-    memcpy(log[logWriteIndex].data, l.data, l.data[1]);
-    logWriteIndex = (logWriteIndex + 1) % MAX_LOG_ENTRIES;
+
+    memcpy(log[slot].data, l.data, size);
+    logSeq[slot] = ++seq;
+    logHash[slot] = hash;
+    logCell[slot] = cell;
+    cellEntries[cell] |= 1ULL << slot;
+    freeEntries &= ~(1ULL << slot);
+    portEXIT_CRITICAL(&logLock);
 }
 
 bool tft_logger::removeLogEntriesInsideRect(int rx, int ry, int rw, int rh) {
@@ -105,21 +187,34 @@ bool tft_logger::removeLogEntriesInsideRect(int rx, int ry, int rw, int rh) {
     int ry1 = ry;
     int rx2 = rx + rw;
     int ry2 = ry + rh;
+    if (rw <= 0 || rh <= 0) return false;
+
+    // only the entries anchored in the cells covered by the rect can be inside it
+    portENTER_CRITICAL(&logLock);
+    uint64_t candidates = 0;
+    for (int cy = logCellCoord(ry1); cy <= logCellCoord(ry2 - 1); cy++) {
+        for (int cx = logCellCoord(rx1); cx <= logCellCoord(rx2 - 1); cx++) {
+            candidates |= cellEntries[cy * LOG_GRID + cx];
+        }
+    }
 
-    for (int i = 0; i < MAX_LOG_ENTRIES; i++) {
+    while (candidates) {
+        int i = __builtin_ctzll(candidates);
+        candidates &= candidates - 1;
         uint8_t *data = log[i].data;
-        if (data[0] != LOG_PACKET_HEADER) continue;
         int px = (data[3] << 8) | data[4];
         int py = (data[5] << 8) | data[6];
         if (px >= rx1 && px < rx2 && py >= ry1 && py < ry2) {
-            data[0] = 0; // Mark as deleted
+            dropLogEntry(i);
             r = true;
         }
     }
+    portEXIT_CRITICAL(&logLock);
     return r;
 }
 
 void tft_logger::removeOverlappedImages(int x, int y, int center, int ms) {
+    portENTER_CRITICAL(&logLock);
     for (int i = 0; i < MAX_LOG_ENTRIES; i++) {
         uint8_t *data = log[i].data;
         if (data[0] != LOG_PACKET_HEADER) continue;
@@ -129,10 +224,9 @@ void tft_logger::removeOverlappedImages(int x, int y, int center, int ms) {
         int py = (data[5] << 8) | data[6];
         int pcenter = (data[7] << 8) | data[8];
         int pms = (data[9] << 8) | data[10];
-        if (px == x && py == y && pcenter == center && pms == ms) {
-            data[0] = 0; // Mark as deleted
-        }
+        if (px == x && py == y && pcenter == center && pms == ms) { dropLogEntry(i); }
     }
+    portEXIT_CRITICAL(&logLock);
 }
 
 void tft_logger::checkAndLog(tftFuncs f, std::initializer_list<int32_t> values) {
@@ -163,14 +257,15 @@ void tft_logger::imageToBin(uint8_t fs, String file, int x, int y, bool center,
 
     // Try to find or store in images[MAX_LOG_IMAGES][MAX_LOG_IMG_PATH];
     uint8_t imageSlot = 0xFF;
-    for (int i = 0; i < MAX_LOG_IMG_PATH; ++i) {
+    portENTER_CRITICAL(&logLock);
+    for (int i = 0; i < MAX_LOG_IMAGES; ++i) {
         if (strcmp(images[i], file.c_str()) == 0) {
             imageSlot = i;
             break;
         }
     }
     if (imageSlot == 0xFF) {
-        for (int i = 0; i < MAX_LOG_IMG_PATH; ++i) {
+        for (int i = 0; i < MAX_LOG_IMAGES; ++i) {
             if (images[i][0] == 0) {
                 strncpy(images[i], file.c_str(), sizeof(images[i]) - 1);
                 images[i][sizeof(images[i]) - 1] = 0;
@@ -179,6 +274,8 @@ void tft_logger::imageToBin(uint8_t fs, String file, int x, int y, bool center,
             }
         }
     }
+    portEXIT_CRITICAL(&logLock);
+    if (imageSlot == 0xFF) return; // no free slot for the path
 
     // Use image path as identifier in log.data
     uint8_t buffer[MAX_LOG_SIZE];
@@ -1,5 +1,6 @@
 #include "theme.h"
 #include "display.h"
+#include "file_view.h"
 
 struct ThemeEntry {
     const char *key;
@@ -20,9 +21,8 @@ bool BruceTheme::openThemeFile(FS *fs, String filepath) {
 
     if (fs == nullptr) return true;
     if (!fs->exists(filepath)) return false;
-    File file;
-    file = fs->open(filepath, FILE_READ);
-    if (!file) {
+    FileView file; // parsed from memory, not a char at a time from the file
+    if (!file.open(*fs, filepath)) {
         log_e("THEME: %s. Using default theme", "Theme file not found");
         removeTheme();
         return false;
@@ -30,7 +30,9 @@ bool BruceTheme::openThemeFile(FS *fs, String filepath) {
 
     // Deserialize the JSON document
     JsonDocument jsonDoc;
-    if (deserializeJson(jsonDoc, file)) {
+    DeserializationError err = deserializeJson(jsonDoc, file.data(), file.size());
+    file.close();
+    if (err) {
         displayError("5", true);
         log_e("THEME: %s. Using default theme", "Failed reading theme file");
         removeTheme();
@@ -1,5 +1,8 @@
 #include "webInterface.h"
+#include "core/bus_lock.h"
+#include "core/dir_index.h"
 #include "core/display.h"    // using displayRedStripe as error msg
+#include "core/file_hash.h"
 #include "core/mykeyboard.h" // using keyboard when calling rename
 #include "core/passwords.h"
 #include "core/sd_functions.h" // using sd functions called to rename and manage sd files
@@ -23,17 +26,86 @@ AsyncWebServer *server = nullptr; // initialise webserver
 const char *host = "bruce";
 String uploadFolder = "";
 
+// Screen mirroring pushed to the navigator through a websocket
+#define SCREEN_PUSH_INTERVAL 50 // ms between checks for new draws
+AsyncWebSocket *screenWs = nullptr;
+static TaskHandle_t screenPushHandle = NULL;
+static volatile bool screenPushRunning = false;
+static volatile bool screenPushFull = false;
+
+/**********************************************************************
+**  Function: screenPushTask
+**  Sends the draws logged since the last push to the websocket clients,
+**  the whole screen when a client connects or some draws were lost
+**********************************************************************/
+static void screenPushTask(void *pvParameters) {
+    const size_t bufSize = MAX_LOG_ENTRIES * MAX_LOG_SIZE + 16;
+    uint8_t *buf = (uint8_t *)(psramFound() ? ps_malloc(bufSize) : malloc(bufSize));
+    uint32_t pushedSeq = 0;
+
+    while (screenPushRunning && buf) {
+        screenWs->cleanupClients();
+        bool full = screenPushFull;
+        // wait for slow clients instead of queueing more, a dropped message would break the mirror
+        if (screenWs->count() > 0 && (full || tft.getLogSeq() != pushedSeq) &&
+            screenWs->availableForWriteAll()) {
+            screenPushFull = false;
+            size_t size = tft.getBinLogSince(buf, bufSize, full ? 0 : pushedSeq, &pushedSeq);
+            screenWs->binaryAll(buf, size);
+        }
+        vTaskDelay(pdMS_TO_TICKS(SCREEN_PUSH_INTERVAL));
+    }
+    free(buf);
+    screenPushHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+// /file?action=hash, big files take seconds so they are hashed here and not on the async_tcp task.
+// One file at a time, the page polls action=hashstatus until it's done.
+static struct {
+    volatile bool running = false;
+    bool finished = false; // result below is valid
+    bool ok = false;
+    FS *fs = nullptr;
+    String file;
+    FileHashResult hash;
+    volatile size_t done = 0;
+    volatile size_t total = 0;
+} webHash;
+
+static void webHashTask(void *pvParameters) {
+    FileHashResult hash;
+    bool ok = hashFile(*webHash.fs, webHash.file, FILE_HASH_ALL, hash, [](size_t done, size_t total) {
+        webHash.done = done;
+        webHash.total = total;
+        return true;
+    });
+    webHash.hash = hash;
+    webHash.ok = ok;
+    webHash.finished = true;
+    __atomic_store_n(&webHash.running, false, __ATOMIC_RELEASE);
+    vTaskDelete(NULL);
+}
+
+static String webHashProgress() {
+    size_t total = webHash.total;
+    return "Hashing " + webHash.file + ": " + String(total ? (uint64_t)webHash.done * 100 / total : 0) + "%";
+}
+
 /**********************************************************************
 **  Function: stopWebUi
 **  Turn off the WebUI
 **********************************************************************/
 void stopWebUi() {
+    screenPushRunning = false;
+    while (screenPushHandle) vTaskDelay(pdMS_TO_TICKS(5));
     tft.setLogging(false);
     isWebUIActive = false;
     server->end();
     server->~AsyncWebServer();
     free(server);
     server = nullptr;
+    screenWs = nullptr; // deleted with the server
     MDNS.end();
 }
 /**********************************************************************
@@ -74,51 +146,53 @@ String humanReadableSize(uint64_t bytes) {
 
 /**********************************************************************
 **  Function: listFiles
-**  list all of the files, if ishtml=true, return html rather than simple text
+**  stream the listing of a folder as a chunked response
 **********************************************************************/
-String listFiles(FS fs, String folder) {
+AsyncWebServerResponse *listFiles(AsyncWebServerRequest *request, FS fs, String folder) {
     // log_i("Listfiles Start");
-    String returnText = "pa:" + folder + ":0\n";
     Serial.println("Listing files stored on SD");
 
     _webFS = fs;
 
-    File root = fs.open(folder);
-    File foundfile = root.openNextFile();
+    struct Listing {
+        DirCursor dir;
+        String line; // entry that didn't fit in the last chunk
+        size_t pos = 0;
+        bool done = false;
+    };
+    std::shared_ptr<Listing> list = std::make_shared<Listing>();
+    list->line = "pa:" + folder + ":0\n";
+
     if (folder == "//") folder = "/";
     uploadFolder = folder;
-    String PreFolder = folder;
-    PreFolder = PreFolder.substring(0, PreFolder.lastIndexOf("/"));
-    if (PreFolder == "") PreFolder = "/";
-
-    if (folder == "/") folder = "";
-    while (foundfile) {
-        if (esp_get_free_heap_size() > (String("Fo:" + String(foundfile.name()) + ":0\n").length()) + 1024) {
-            if (foundfile.isDirectory()) returnText += "Fo:" + String(foundfile.name()) + ":0\n";
-        } else break;
-        foundfile = root.openNextFile();
-        esp_task_wdt_reset();
-    }
-    root.close();
-    foundfile.close();
-
-    if (folder == "") folder = "/";
-    root = fs.open(folder);
-    foundfile = root.openNextFile();
-    while (foundfile) {
-        if (esp_get_free_heap_size() > (String("Fo:" + String(foundfile.name()) + ":0\n").length()) + 1024) {
-            if (!(foundfile.isDirectory()))
-                returnText +=
-                    "Fi:" + String(foundfile.name()) + ":" + humanReadableSize(foundfile.size()) + "\n";
-        } else break;
-        foundfile = root.openNextFile();
-        esp_task_wdt_reset();
-    }
-    root.close();
-    foundfile.close();
-
-    // log_i("ListFiles End");
-    return returnText;
+    if (!list->dir.open(fs, folder, true)) list->done = true;
+
+    // One entry at a time straight from the directory, folders of any size and no big String
+    return request->beginChunkedResponse("text/plain", [list](uint8_t *buffer, size_t maxLen, size_t) {
+        size_t len = 0;
+        for (;;) {
+            size_t n = std::min((size_t)(list->line.length() - list->pos), maxLen - len);
+            memcpy(buffer + len, list->line.c_str() + list->pos, n);
+            len += n;
+            list->pos += n;
+            if (len == maxLen || list->done) break;
+
+            String name;
+            bool isFolder;
+            size_t size;
+            if (!list->dir.next(name, isFolder, size)) {
+                list->dir.close();
+                list->done = true;
+                break;
+            }
+            if (isFolder) list->line = "Fo:" + name + ":0\n";
+            else list->line = "Fi:" + name + ":" + humanReadableSize(size) + "\n";
+            list->pos = 0;
+            esp_task_wdt_reset();
+        }
+        // log_i("ListFiles End");
+        return len;
+    });
 }
 
 /**********************************************************************
@@ -394,13 +468,32 @@ void configureWebServer() {
         request->send(200, "application/json", response_body);
     });
 
+    // ?since=<seq> returns only what was drawn after it, see tft_logger::getBinLogSince
     server->on("/getscreen", HTTP_GET, [](AsyncWebServerRequest *request) {
-        uint8_t binData[MAX_LOG_ENTRIES * MAX_LOG_SIZE];
-        size_t binSize = 0;
+        const size_t bufSize = MAX_LOG_ENTRIES * MAX_LOG_SIZE + 16;
+        uint8_t *binData = (uint8_t *)(psramFound() ? ps_malloc(bufSize) : malloc(bufSize));
+        if (!binData) return request->send(500, "text/plain", "Not enough memory");
+
+        uint32_t since = request->hasArg("since") ? strtoul(request->arg("since").c_str(), NULL, 10) : 0;
+        size_t binSize = tft.getBinLogSince(binData, bufSize, since);
+        AsyncResponseStream *response = request->beginResponseStream("application/octet-stream");
+        response->write(binData, binSize);
+        free(binData);
+        request->send(response);
+    });
 
-        tft.getBinLog(binData, binSize);
-        request->send(200, "application/octet-stream", (const uint8_t *)binData, binSize);
+    screenWs = new AsyncWebSocket("/screenws");
+    screenWs->onEvent([](AsyncWebSocket *ws,
+                         AsyncWebSocketClient *client,
+                         AwsEventType type,
+                         void *arg,
+                         uint8_t *data,
+                         size_t len) {
+        if (type == WS_EVT_CONNECT) screenPushFull = true; // new client starts from the whole screen
     });
+    server->addHandler(screenWs);
+    screenPushRunning = true;
+    xTaskCreate(screenPushTask, "ScreenPush", 4096, NULL, 1, &screenPushHandle);
 
     // WIP: Serve a folder to a custom WEBUI..
     // if (bruceConfig.webUI_folder != "") {
@@ -469,6 +562,8 @@ void configureWebServer() {
     // Reinicia o ESP
     server->on("/reboot", HTTP_GET, [](AsyncWebServerRequest *request) {
         if (checkUserWebAuth(request)) {
+            busLock(); // async_tcp task, the config copy to SD shares the bus with the display
+            bruceConfig.flush();
             ESP.restart();
         } else {
             request->requestAuthentication();
@@ -482,9 +577,9 @@ void configureWebServer() {
             if (request->hasArg("folder")) { folder = request->arg("folder"); }
             bool useSD = false;
             if (strcmp(request->arg("fs").c_str(), "SD") == 0) {
-                request->send(200, "text/plain", listFiles(SD, folder));
+                request->send(listFiles(request, SD, folder));
             } else {
-                request->send(200, "text/plain", listFiles(LittleFS, folder));
+                request->send(listFiles(request, LittleFS, folder));
             }
 
         } else {
@@ -565,6 +660,45 @@ void configureWebServer() {
                             request->send(500, "text/plain", "Failed to open file for reading");
                         }
 
+                    } else if (strcmp(fileAction.c_str(), "hash") == 0) {
+                        // starts webHashTask, 202 until hashstatus has the result
+                        if (__atomic_load_n(&webHash.running, __ATOMIC_ACQUIRE)) {
+                            if (webHash.fs == fs && webHash.file == fileName) {
+                                request->send(202, "text/plain", webHashProgress());
+                            } else {
+                                request->send(409, "text/plain", "Busy hashing " + webHash.file);
+                            }
+                            return;
+                        }
+                        webHash.fs = fs;
+                        webHash.file = fileName;
+                        webHash.finished = false;
+                        webHash.done = 0;
+                        webHash.total = 0;
+                        webHash.running = true;
+                        if (xTaskCreate(webHashTask, "WebHash", 4096, NULL, 1, NULL) != pdPASS) {
+                            webHash.running = false;
+                            request->send(500, "text/plain", "Failed to start hashing");
+                            return;
+                        }
+                        request->send(202, "text/plain", webHashProgress());
+
+                    } else if (strcmp(fileAction.c_str(), "hashstatus") == 0) {
+                        if (__atomic_load_n(&webHash.running, __ATOMIC_ACQUIRE)) {
+                            request->send(202, "text/plain", webHashProgress());
+                        } else if (!webHash.finished || webHash.fs != fs || webHash.file != fileName) {
+                            request->send(404, "text/plain", "Not hashing " + fileName);
+                        } else if (webHash.ok) {
+                            request->send(
+                                200,
+                                "text/plain",
+                                "MD5: " + webHash.hash.md5 + "\nCRC32: " + webHash.hash.crc32 +
+                                    "\nSHA-256: " + webHash.hash.sha256
+                            );
+                        } else {
+                            request->send(500, "text/plain", "Failed to hash file");
+                        }
+
                     } else {
                         request->send(400, "text/plain", "ERROR: invalid action param supplied");
                     }
@@ -236,7 +236,7 @@ duk_ret_t native_dialogCreateTextViewerGetVisibleText(duk_context *ctx) {
     visibleText.reserve(area->getMaxVisibleTextLength());
 
     for (size_t i = area->firstVisibleLine; i < area->lastVisibleLine - 1; i++) {
-        visibleText += area->linesBuffer[i];
+        visibleText += area->getLine(i);
     }
     duk_push_string(ctx, visibleText.c_str());
     return 1;
@@ -1,5 +1,6 @@
 #include "interpreter.h"
 #include "core/mykeyboard.h"
+#include "core/file_view.h"
 #include "core/sd_functions.h"
 #include "core/serialcmds.h"
 #include "modules/badusb_ble/ducky_typer.h"
@@ -763,8 +764,6 @@ static duk_ret_t native_storageRead(duk_context *ctx) {
     // usage: storageRead(path: string | Path, binary: boolean): string |
     // Uint8Array returns: file contents as a string. Empty string on any error.
     bool binary = duk_get_boolean_default(ctx, 1, false);
-    size_t fileSize = 0;
-    char *fileContent = NULL;
     FileParamsJS fileParams = js_get_path_from_params(ctx, true);
     if (!fileParams.exist) {
         return duk_error(
@@ -773,24 +772,30 @@ static duk_ret_t native_storageRead(duk_context *ctx) {
     }
     if (!fileParams.path.startsWith("/")) fileParams.path = "/" + fileParams.path; // add "/" if missing
 
-    // TODO: Change to use duk_push_fixed_buffer
-    fileContent = readBigFile(*fileParams.fs, fileParams.path, binary, &fileSize);
+    if (binary) {
+        // Straight into the Duktape buffer, no copy in between
+        File file = (fileParams.fs)->open(fileParams.path, FILE_READ);
+        if (!file || file.isDirectory()) {
+            return duk_error(
+                ctx, DUK_ERR_ERROR, "%s: Could not read file: %s", "storageRead", fileParams.path.c_str()
+            );
+        }
+        size_t fileSize = file.size();
+        void *buf = duk_push_fixed_buffer(ctx, fileSize);
+        fileSize = readFully(file, buf, fileSize);
+        file.close();
+        // Convert buffer to Uint8Array
+        duk_push_buffer_object(ctx, -1, 0, fileSize, DUK_BUFOBJ_UINT8ARRAY);
+        return 1;
+    }
 
-    if (fileContent == NULL) {
+    FileView view;
+    if (!view.open(*fileParams.fs, fileParams.path)) {
         return duk_error(
             ctx, DUK_ERR_ERROR, "%s: Could not read file: %s", "storageRead", fileParams.path.c_str()
         );
     }
-
-    if (binary && fileSize != 0) {
-        void *buf = duk_push_fixed_buffer(ctx, fileSize);
-        memcpy(buf, fileContent, fileSize);
-        // Convert buffer to Uint8Array
-        duk_push_buffer_object(ctx, -1, 0, fileSize, DUK_BUFOBJ_UINT8ARRAY);
-    } else {
-        duk_push_string(ctx, fileContent);
-    }
-    free(fileContent);
+    duk_push_lstring(ctx, view.data(), view.size());
     return 1;
 }
 
@@ -829,23 +834,20 @@ static duk_ret_t native_storageWrite(duk_context *ctx) {
         }
     } else if (duk_is_string(ctx, 3)) {
         // Get position as string
-        size_t fileSize = 0;
-        char *fileContent = readBigFile(*fileParams.fs, fileParams.path, false, &fileSize);
-
-        if (fileContent == NULL) {
+        FileView view;
+        if (!view.open(*fileParams.fs, fileParams.path)) {
             return duk_error(
                 ctx, DUK_ERR_ERROR, "%s: Could not read file: %s", "storageWrite", fileParams.path.c_str()
             );
         }
 
-        char *foundPos = strstr(fileContent, duk_get_string(ctx, 3));
-        free(fileContent); // Free fileContent after usage
-
+        const char *foundPos = strstr(view.data(), duk_get_string(ctx, 3));
         if (foundPos) {
-            file.seek(foundPos - fileContent, SeekSet);
+            file.seek(foundPos - view.data(), SeekSet);
         } else {
             file.seek(0, SeekEnd); // Append if string is not found
         }
+        view.close();
     }
 
     // Write data
@@ -938,6 +940,32 @@ static duk_ret_t native_storageRmdir(duk_context *ctx) {
     return 1;
 }
 
+enum ModuleLoad { MODULE_NOT_FOUND, MODULE_COMPILED, MODULE_SYNTAX_ERROR };
+
+// Pushes the module wrapper function(exports, module) compiled from filepath. On MODULE_SYNTAX_ERROR
+// the error is pushed instead, nothing on MODULE_NOT_FOUND
+static ModuleLoad loadModule(duk_context *ctx, FS &fs, const String &filepath) {
+    uint32_t start = millis();
+
+    // The wrapper goes around the source in the same buffer, one string pushed instead of a concat
+    static const char wrapStart[] = "function(exports,module){\n";
+    static const char wrapEnd[] = "\n}";
+    FileView view;
+    if (!view.open(fs, filepath, sizeof(wrapStart) - 1, sizeof(wrapEnd) - 1)) { return MODULE_NOT_FOUND; }
+    memcpy(view.prefix(), wrapStart, sizeof(wrapStart) - 1);
+    memcpy(view.suffix(), wrapEnd, sizeof(wrapEnd) - 1);
+    duk_push_lstring(ctx, view.prefix(), view.total());
+    view.close();
+    duk_push_string(ctx, filepath.c_str());
+
+    if (duk_pcompile(ctx, DUK_COMPILE_FUNCTION) != DUK_EXEC_SUCCESS) {
+        Serial.printf("require(%s) failed: %s\n", filepath.c_str(), duk_safe_to_string(ctx, -1));
+        return MODULE_SYNTAX_ERROR;
+    }
+    Serial.printf("require(%s): compiled in %lums\n", filepath.c_str(), (unsigned long)(millis() - start));
+    return MODULE_COMPILED;
+}
+
 static duk_ret_t native_require(duk_context *ctx) {
     duk_idx_t obj_idx = duk_push_object(ctx);
 
@@ -1084,23 +1112,48 @@ static duk_ret_t native_require(duk_context *ctx) {
         if (SD.exists(filepath)) fs = &SD;
         else if (LittleFS.exists(filepath)) fs = &LittleFS;
         if (fs == NULL) { return 1; }
+        duk_pop(ctx); // obj_idx, modules return their own exports
+
+        // Modules are evaluated once per heap, next require() returns the same exports
+        String moduleKey = String(fs == &SD ? "sd:" : "littlefs:") + filepath;
+        duk_push_global_stash(ctx);
+        if (!duk_get_prop_string(ctx, -1, "modules")) {
+            duk_pop(ctx);
+            duk_push_object(ctx);
+            duk_dup(ctx, -1);
+            duk_put_prop_string(ctx, -3, "modules");
+        }
+        if (duk_get_prop_string(ctx, -1, moduleKey.c_str())) { return 1; }
+        duk_pop(ctx); // [ stash modules ]
+
+        switch (loadModule(ctx, *fs, filepath)) { // [ stash modules function|error ]
+            case MODULE_NOT_FOUND:
+                return duk_error(ctx, DUK_ERR_ERROR, "module not found: %s", filepath.c_str());
+            case MODULE_SYNTAX_ERROR: return duk_throw(ctx); // the script sees the SyntaxError
+            case MODULE_COMPILED: break;
+        }
 
-        const char *requiredScript = readBigFile(*fs, filepath);
-        if (requiredScript == NULL) { return 1; }
-
-        duk_push_string(ctx, "(function(){exports={};module={exports:exports};\n");
-        duk_push_string(ctx, requiredScript);
-        duk_push_string(ctx, "\n})");
-        duk_concat(ctx, 3);
-
-        duk_int_t pcall_rc = duk_pcompile(ctx, DUK_COMPILE_EVAL);
-        if (pcall_rc != DUK_EXEC_SUCCESS) { return 1; }
-
-        pcall_rc = duk_pcall(ctx, 1);
-        if (pcall_rc == DUK_EXEC_SUCCESS) {
-            duk_get_prop_string(ctx, -1, "exports");
-            duk_compact(ctx, -1);
+        duk_push_object(ctx); // module
+        duk_insert(ctx, -2);
+        duk_push_object(ctx); // exports
+        duk_dup(ctx, -1);
+        duk_put_prop_string(ctx, -4, "exports");
+        // Cached before the body runs, as CommonJS: a cycle A -> B -> A gets the exports of A so far
+        // instead of loading A again until the stack runs out
+        duk_dup(ctx, -1);
+        duk_put_prop_string(ctx, -5, moduleKey.c_str());
+        duk_dup(ctx, -3); // [ stash modules module function exports module ]
+
+        if (duk_pcall(ctx, 2) != DUK_EXEC_SUCCESS) {
+            Serial.printf("require(%s) failed: %s\n", filepath.c_str(), duk_safe_to_string(ctx, -1));
+            duk_del_prop_string(ctx, -3, moduleKey.c_str()); // the next require() runs it again
+            return duk_throw(ctx);
         }
+        duk_pop(ctx);
+        duk_get_prop_string(ctx, -1, "exports");
+        duk_compact(ctx, -1);
+        duk_dup(ctx, -1);
+        duk_put_prop_string(ctx, -4, moduleKey.c_str());
     }
 
     return 1;
@@ -2,6 +2,7 @@
 #include "core/display.h"
 #include "core/mykeyboard.h"
 #include "core/utils.h"
+#include <algorithm>
 
 // Known tracker device identifiers
 // Apple AirTag uses Apple's company ID (0x004C) and specific data patterns
@@ -9,98 +10,375 @@
 // Samsung SmartTag uses 0x0075
 // Chipolo uses 0x0349
 
-#define SCAN_TIME 30           // Scan for 30 seconds
-#define PERSISTENT_THRESHOLD 3 // Seen 3+ times = potential stalking
-#define TIME_THRESHOLD 300000  // 5 minutes in milliseconds
+#define SCAN_TIME 30 // Quick scan for 30 seconds
+
+// Background scan, passive and 10% duty so it can stay on for hours
+#define TRACKER_SCAN_INTERVAL 1000 // ms
+#define TRACKER_SCAN_WINDOW 100    // ms
+
+#define TRACKER_TABLE_PSRAM 256 // slots, power of two
+#define TRACKER_TABLE_RAM 128
+#define TRACKER_NAME_LEN 20
+
+// Sighting histogram, one bucket per 5 minutes, 2 hours of history
+#define TRACKER_BUCKET_MS 300000
+#define TRACKER_BUCKETS 24
+#define TRACKER_DECAY 0.85f       // weight lost by each bucket of age
+#define TRACKER_FOLLOW_SCORE 3.0f // ~4 recent buckets = following you for 15+ minutes
+#define TRACKER_STALE_MS (TRACKER_BUCKETS * TRACKER_BUCKET_MS)
+#define TRACKER_HOUSEKEEPING_MS 30000
+
+enum TrackerType : uint8_t {
+    TRACKER_NONE,
+    TRACKER_AIRTAG,
+    TRACKER_TILE,
+    TRACKER_SMARTTAG,
+    TRACKER_CHIPOLO,
+};
 
-static std::vector<TrackerDevice> globalTrackers;
+static const char *trackerTypeNames[] = {
+    "Unknown", "Apple AirTag/FindMy", "Tile Tracker", "Samsung SmartTag", "Chipolo Tracker"
+};
 
-class TrackerScanCallbacks : public NimBLEAdvertisedDeviceCallbacks {
-    void onResult(NimBLEAdvertisedDevice *advertisedDevice) {
-        // Check if this is a known tracker type
-        String address = advertisedDevice->getAddress().toString().c_str();
-        String name = advertisedDevice->getName().c_str();
-        int rssi = advertisedDevice->getRSSI();
-
-        // Check manufacturer data for tracker identification
-        if (advertisedDevice->haveManufacturerData()) {
-            std::string mfgData = advertisedDevice->getManufacturerData();
-            if (mfgData.length() >= 2) {
-                uint16_t companyId = (uint8_t)mfgData[1] << 8 | (uint8_t)mfgData[0];
-                String type = "Unknown";
-                bool isTracker = false;
-
-                // Apple devices (AirTag, AirPods, FindMy network)
-                if (companyId == 0x004C) {
-                    if (mfgData.length() >= 3) {
-                        uint8_t appleType = (uint8_t)mfgData[2];
-                        // AirTag and FindMy accessories use type 0x12 or 0x07
-                        if (appleType == 0x12 || appleType == 0x07) {
-                            type = "Apple AirTag/FindMy";
-                            isTracker = true;
-                        } else if (appleType == 0x01) {
-                            type = "Apple Device";
-                            isTracker = false; // iPhones, iPads - not trackers
-                        }
-                    }
-                }
-                // Tile trackers
-                else if (companyId == 0x0097) {
-                    type = "Tile Tracker";
-                    isTracker = true;
-                }
-                // Samsung SmartTag
-                else if (companyId == 0x0075) {
-                    type = "Samsung SmartTag";
-                    isTracker = true;
-                }
-                // Chipolo
-                else if (companyId == 0x0349) {
-                    type = "Chipolo Tracker";
-                    isTracker = true;
-                }
-
-                if (isTracker) {
-                    // Update or add to global tracker list
-                    bool found = false;
-                    unsigned long now = millis();
-
-                    for (auto &tracker : globalTrackers) {
-                        if (tracker.address == address) {
-                            tracker.lastSeen = now;
-                            tracker.seenCount++;
-                            tracker.rssi = rssi;
-                            if (!tracker.name.length() && name.length() > 0) { tracker.name = name; }
-                            found = true;
-                            break;
-                        }
-                    }
-
-                    if (!found && globalTrackers.size() < 50) {
-                        TrackerDevice newTracker;
-                        newTracker.address = address;
-                        newTracker.name = name.length() > 0 ? name : "Unknown";
-                        newTracker.type = type;
-                        newTracker.rssi = rssi;
-                        newTracker.firstSeen = now;
-                        newTracker.lastSeen = now;
-                        newTracker.seenCount = 1;
-                        newTracker.isPersistent = false;
-                        globalTrackers.push_back(newTracker);
-                    }
-                }
+struct TrackerEntry {
+    uint8_t addr[6];
+    bool used;
+    TrackerType type;
+    int8_t rssi;
+    uint8_t histHead;              // bucket lastBucket is hist[histHead], older ones before it
+    uint8_t hist[TRACKER_BUCKETS]; // sightings per bucket
+    uint32_t lastBucket;
+    uint32_t firstSeen;
+    uint32_t lastSeen;
+    uint32_t seenCount;
+    char name[TRACKER_NAME_LEN];
+};
+
+static TrackerEntry *table = nullptr;
+static uint32_t tableCap = 0;
+static uint32_t tableCount = 0;
+static uint32_t tableDropped = 0; // sightings lost with the table full
+static portMUX_TYPE tableLock = portMUX_INITIALIZER_UNLOCKED;
+static float decayLut[TRACKER_BUCKETS];
+
+static volatile bool serviceRunning = false;
+static volatile bool hkStop = false;
+static volatile bool hkDone = true;
+static bool bleOwned = false; // we initialized the stack, so we deinit it
+// The scan the service started. Another BLE tool that stops it, or deinits the stack, takes it over
+static NimBLEScan *ownedScan = nullptr;
+static volatile bool scanOwned = false;
+
+static uint32_t slotOf(const uint8_t *addr) {
+    uint64_t key = 0;
+    memcpy(&key, addr, 6);
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (tableCap - 1);
+}
+
+// Walks the AD structures of the raw advertisement, no copies
+static TrackerType identifyTracker(const uint8_t *p, size_t len, char *name) {
+    TrackerType type = TRACKER_NONE;
+    size_t i = 0;
+    while (i + 1 < len) {
+        uint8_t adLen = p[i];
+        if (adLen == 0 || i + 1 + adLen > len) break;
+        uint8_t adType = p[i + 1];
+        const uint8_t *d = p + i + 2;
+        size_t dLen = adLen - 1;
+
+        if (adType == 0xFF && dLen >= 2 && type == TRACKER_NONE) {
+            uint16_t companyId = d[1] << 8 | d[0];
+            // AirTag and FindMy accessories use type 0x12 or 0x07, 0x01 are iPhones, iPads
+            if (companyId == 0x004C) {
+                if (dLen >= 3 && (d[2] == 0x12 || d[2] == 0x07)) type = TRACKER_AIRTAG;
+            } else if (companyId == 0x0097) type = TRACKER_TILE;
+            else if (companyId == 0x0075) type = TRACKER_SMARTTAG;
+            else if (companyId == 0x0349) type = TRACKER_CHIPOLO;
+        } else if (adType == 0x09 || (adType == 0x08 && name[0] == '\0')) {
+            size_t n = dLen < TRACKER_NAME_LEN - 1 ? dLen : TRACKER_NAME_LEN - 1;
+            memcpy(name, d, n);
+            name[n] = '\0';
+        }
+        i += adLen + 1;
+    }
+    return type;
+}
+
+static float entryScore(const TrackerEntry &e, uint32_t nowBucket) {
+    uint32_t lag = nowBucket - e.lastBucket;
+    float score = 0;
+    for (uint32_t age = lag; age < TRACKER_BUCKETS; age++) {
+        if (e.hist[(e.histHead + TRACKER_BUCKETS - (age - lag)) % TRACKER_BUCKETS]) score += decayLut[age];
+    }
+    return score;
+}
+
+// Backward shift delete, keeps the probe chains intact without tombstones
+static void tableRemove(uint32_t i) {
+    uint32_t mask = tableCap - 1;
+    uint32_t j = i;
+    for (;;) {
+        table[i].used = false;
+        for (;;) {
+            j = (j + 1) & mask;
+            if (!table[j].used) {
+                tableCount--;
+                return;
             }
+            uint32_t k = slotOf(table[j].addr);
+            // entries whose home slot is in (i, j] stay where they are
+            if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) continue;
+            break;
+        }
+        table[i] = table[j];
+        i = j;
+    }
+}
+
+static void recordSighting(const uint8_t *addr, TrackerType type, int rssi, const char *name) {
+    uint32_t now = millis();
+    uint32_t bucket = now / TRACKER_BUCKET_MS;
+    uint32_t mask = tableCap - 1;
+
+    portENTER_CRITICAL(&tableLock);
+    if (!table) {
+        portEXIT_CRITICAL(&tableLock);
+        return;
+    }
+    uint32_t i = slotOf(addr);
+    while (table[i].used && memcmp(table[i].addr, addr, 6) != 0) i = (i + 1) & mask;
+
+    TrackerEntry &e = table[i];
+    if (!e.used) {
+        if (tableCount >= tableCap * 3 / 4) {
+            tableDropped++;
+            portEXIT_CRITICAL(&tableLock);
+            return;
         }
+        memset(&e, 0, sizeof(e));
+        memcpy(e.addr, addr, 6);
+        e.used = true;
+        e.type = type;
+        e.firstSeen = now;
+        e.lastBucket = bucket;
+        tableCount++;
+    }
+    // Move the ring forward, clearing the buckets with no sightings
+    uint32_t shift = bucket - e.lastBucket;
+    if (shift > TRACKER_BUCKETS) shift = TRACKER_BUCKETS;
+    while (shift--) {
+        e.histHead = (e.histHead + 1) % TRACKER_BUCKETS;
+        e.hist[e.histHead] = 0;
+    }
+    e.lastBucket = bucket;
+    if (e.hist[e.histHead] < 255) e.hist[e.histHead]++;
+    e.lastSeen = now;
+    e.seenCount++;
+    e.rssi = rssi;
+    if (e.name[0] == '\0' && name[0] != '\0') strcpy(e.name, name);
+    portEXIT_CRITICAL(&tableLock);
+}
+
+class TrackerScanCallbacks : public NimBLEAdvertisedDeviceCallbacks {
+    void onResult(NimBLEAdvertisedDevice *advertisedDevice) {
+        char name[TRACKER_NAME_LEN] = "";
+        TrackerType type =
+            identifyTracker(advertisedDevice->getPayload(), advertisedDevice->getPayloadLength(), name);
+        if (type == TRACKER_NONE) return;
+        recordSighting(advertisedDevice->getAddress().getNative(), type, advertisedDevice->getRSSI(), name);
     }
 };
 
-TrackerDetector::TrackerDetector() : pBLEScan(nullptr), isScanning(false) { scanStartTime = millis(); }
+static TrackerScanCallbacks scanCallbacks;
+
+// NimBLE calls it when the scan ends, stop() from anywhere included
+static void trackerScanEnded(NimBLEScanResults) { scanOwned = false; }
+
+static bool ownsScan() {
+    return scanOwned && NimBLEDevice::getInitialized() && NimBLEDevice::getScan() == ownedScan;
+}
+
+// Drops the devices not seen for the whole histogram
+static void pruneTable() {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&tableLock);
+    for (uint32_t i = 0; table && i < tableCap;) {
+        // the shift may move another entry into i, check it again
+        if (table[i].used && now - table[i].lastSeen > TRACKER_STALE_MS) tableRemove(i);
+        else i++;
+    }
+    portEXIT_CRITICAL(&tableLock);
+}
+
+static void trackerHousekeepingTask(void *) {
+    uint32_t last = millis();
+    while (!hkStop) {
+        vTaskDelay(pdMS_TO_TICKS(200));
+        if (millis() - last < TRACKER_HOUSEKEEPING_MS) continue;
+        last = millis();
+        // Other BLE tools deinit the stack when they are done, which ends the scan
+        if (!ownsScan() || !NimBLEDevice::getScan()->isScanning()) {
+            Serial.println("Tracker service: scan ended by another BLE tool");
+            serviceRunning = false;
+            scanOwned = false;
+            bleOwned = false;
+            break;
+        }
+        pruneTable();
+        if (tableDropped) Serial.printf("Tracker service: table full, %u sightings dropped\n", tableDropped);
+    }
+    hkDone = true;
+    vTaskDelete(NULL);
+}
 
-TrackerDetector::~TrackerDetector() {
-    if (isScanning) { stop(); }
+static void freeTable() {
+    portENTER_CRITICAL(&tableLock);
+    TrackerEntry *t = table;
+    table = nullptr;
+    tableCap = 0;
+    tableCount = 0;
+    portEXIT_CRITICAL(&tableLock);
+    free(t);
+}
+
+bool trackerServiceStart(bool quick) {
+    trackerServiceStop();
+
+    uint32_t cap = psramFound() ? TRACKER_TABLE_PSRAM : TRACKER_TABLE_RAM;
+    size_t size = cap * sizeof(TrackerEntry);
+    TrackerEntry *t = (TrackerEntry *)(psramFound() ? ps_malloc(size) : malloc(size));
+    if (!t) {
+        Serial.println("Tracker service: no memory for the device table");
+        return false;
+    }
+    memset(t, 0, size);
+    for (int i = 0; i < TRACKER_BUCKETS; i++) decayLut[i] = powf(TRACKER_DECAY, i);
+    portENTER_CRITICAL(&tableLock);
+    table = t;
+    tableCap = cap;
+    tableCount = 0;
+    tableDropped = 0;
+    portEXIT_CRITICAL(&tableLock);
+
+    bleOwned = !NimBLEDevice::getInitialized();
+    if (bleOwned) NimBLEDevice::init("");
+    NimBLEScan *pBLEScan = NimBLEDevice::getScan();
+    pBLEScan->setAdvertisedDeviceCallbacks(&scanCallbacks, false);
+    pBLEScan->setDuplicateFilter(false); // every advertisement counts as a sighting
+    pBLEScan->setMaxResults(0);          // nothing kept by NimBLE, the table is the only storage
+    if (quick) {
+        pBLEScan->setActiveScan(true);
+        pBLEScan->setInterval(100);
+        pBLEScan->setWindow(99);
+    } else {
+        pBLEScan->setActiveScan(false);
+        pBLEScan->setInterval(TRACKER_SCAN_INTERVAL);
+        pBLEScan->setWindow(TRACKER_SCAN_WINDOW);
+    }
+    scanOwned = true;
+    ownedScan = pBLEScan;
+    if (!pBLEScan->start(0, trackerScanEnded, false)) {
+        Serial.println("Tracker service: failed to start the scan");
+        pBLEScan->setAdvertisedDeviceCallbacks(nullptr, false);
+        if (bleOwned) NimBLEDevice::deinit(true);
+        bleOwned = false;
+        scanOwned = false;
+        ownedScan = nullptr;
+        freeTable();
+        return false;
+    }
+
+    serviceRunning = true;
+    hkStop = false;
+    hkDone = false;
+    if (xTaskCreate(trackerHousekeepingTask, "TrackerHk", 3072, NULL, 1, NULL) != pdPASS) hkDone = true;
+    return true;
+}
+
+void trackerServiceStop() {
+    hkStop = true;
+    while (!hkDone) vTaskDelay(5);
+
+    // a scan or a stack another tool took over since then isn't ours to stop
+    if (serviceRunning && ownsScan()) {
+        ownedScan->setAdvertisedDeviceCallbacks(nullptr, false);
+        ownedScan->stop();
+        if (bleOwned) NimBLEDevice::deinit(true);
+    }
+    serviceRunning = false;
+    scanOwned = false;
+    ownedScan = nullptr;
+    bleOwned = false;
+    freeTable();
+}
+
+bool trackerServiceRunning() { return serviceRunning; }
+
+void trackerServiceSnapshot(std::vector<TrackerDevice> &out) {
+    out.clear();
+    if (!table) return;
+
+    // Copy out under the lock, Strings are built after it
+    std::vector<TrackerEntry> entries;
+    entries.reserve(tableCap * 3 / 4);
+    portENTER_CRITICAL(&tableLock);
+    for (uint32_t i = 0; table && i < tableCap; i++) {
+        if (table[i].used && entries.size() < entries.capacity()) entries.push_back(table[i]);
+    }
+    portEXIT_CRITICAL(&tableLock);
+
+    uint32_t nowBucket = millis() / TRACKER_BUCKET_MS;
+    for (const auto &e : entries) {
+        char address[18];
+        snprintf(
+            address,
+            sizeof(address),
+            "%02x:%02x:%02x:%02x:%02x:%02x",
+            e.addr[5],
+            e.addr[4],
+            e.addr[3],
+            e.addr[2],
+            e.addr[1],
+            e.addr[0]
+        );
+        TrackerDevice d;
+        d.address = address;
+        d.name = e.name[0] ? e.name : "Unknown";
+        d.type = trackerTypeNames[e.type];
+        d.rssi = e.rssi;
+        d.firstSeen = e.firstSeen;
+        d.lastSeen = e.lastSeen;
+        d.seenCount = e.seenCount;
+        d.score = entryScore(e, nowBucket);
+        d.isPersistent = d.score >= TRACKER_FOLLOW_SCORE;
+        out.push_back(d);
+    }
+    // Most suspicious first
+    std::sort(out.begin(), out.end(), [](const TrackerDevice &a, const TrackerDevice &b) {
+        return a.score > b.score;
+    });
 }
 
 void TrackerDetector::start() {
+    options.clear();
+    if (trackerServiceRunning()) {
+        options.push_back({"Results", [this]() {
+                               trackerServiceSnapshot(detectedTrackers);
+                               displayResults();
+                           }});
+        options.push_back({"Stop background", trackerServiceStop});
+    } else {
+        options.push_back({"Quick scan", [this]() { quickScan(); }});
+        options.push_back({"Background scan", [=]() {
+                               if (trackerServiceStart()) displaySuccess("Scanning in background", true);
+                               else displayError("BLE scan failed", true);
+                           }});
+    }
+    options.push_back({"Back", [=]() {}});
+    loopOptions(options, MENU_TYPE_SUBMENU, "Tracker Detect");
+}
+
+void TrackerDetector::quickScan() {
     drawMainBorderWithTitle("Tracker Detection");
     padprintln("Scanning for BLE trackers...");
     padprintln("");
@@ -114,59 +392,23 @@ void TrackerDetector::start() {
     padprintln("Scanning for " + String(SCAN_TIME) + " seconds...");
     tft.setTextColor(bruceConfig.priColor, bruceConfig.bgColor);
 
-    delay(1000);
-
-    // Clear previous results
-    globalTrackers.clear();
-
-    // Initialize BLE
-    NimBLEDevice::init("");
-    pBLEScan = NimBLEDevice::getScan();
-    pBLEScan->setAdvertisedDeviceCallbacks(new TrackerScanCallbacks(), false);
-    pBLEScan->setActiveScan(true);
-    pBLEScan->setInterval(100);
-    pBLEScan->setWindow(99);
-
-    isScanning = true;
-    scanStartTime = millis();
-
-    // Scan for specified time
-    pBLEScan->start(SCAN_TIME, false);
-
-    isScanning = false;
-
-    // Analyze results
-    checkForStalking();
-    displayResults();
-
-    // Cleanup
-    pBLEScan->clearResults();
-    NimBLEDevice::deinit(true);
-}
-
-void TrackerDetector::stop() {
-    if (pBLEScan && isScanning) {
-        pBLEScan->stop();
-        isScanning = false;
+    if (!trackerServiceStart(true)) {
+        displayError("BLE scan failed", true);
+        return;
     }
-}
-
-void TrackerDetector::checkForStalking() {
-    // Check if any trackers have been seen persistently
-    unsigned long now = millis();
-
-    for (auto &tracker : globalTrackers) {
-        unsigned long timeSeen = tracker.lastSeen - tracker.firstSeen;
-
-        // If seen multiple times over several minutes, mark as persistent
-        if (tracker.seenCount >= PERSISTENT_THRESHOLD || timeSeen > TIME_THRESHOLD) {
-            tracker.isPersistent = true;
-        }
+    unsigned long scanStart = millis();
+    while (millis() - scanStart < SCAN_TIME * 1000) {
+        if (check(EscPress)) break;
+        delay(50);
     }
+    trackerServiceSnapshot(detectedTrackers);
+    trackerServiceStop();
+
+    displayResults();
 }
 
 void TrackerDetector::displayResults() {
-    if (globalTrackers.empty()) {
+    if (detectedTrackers.empty()) {
         drawMainBorderWithTitle("Tracker Detection");
         padprintln("");
         padprintln("No trackers detected!");
@@ -188,7 +430,7 @@ void TrackerDetector::displayResults() {
     options.clear();
 
     bool hasWarning = false;
-    for (const auto &tracker : globalTrackers) {
+    for (const auto &tracker : detectedTrackers) {
         if (tracker.isPersistent) hasWarning = true;
 
         String label = tracker.type;
@@ -205,6 +447,11 @@ void TrackerDetector::displayResults() {
                                padprintln("Address: " + tracker.address);
                                padprintln("Signal: " + String(tracker.rssi) + " dBm");
                                padprintln("Seen: " + String(tracker.seenCount) + " times");
+                               padprintln(
+                                   "Around for: " + String((tracker.lastSeen - tracker.firstSeen) / 60000) +
+                                   " min"
+                               );
+                               padprintln("Score: " + String(tracker.score, 1));
                                padprintln("");
 
                                if (tracker.isPersistent) {
@@ -231,7 +478,7 @@ void TrackerDetector::displayResults() {
     // Show summary screen first
     drawMainBorderWithTitle("Tracker Detection");
     padprintln("");
-    padprintln("Found " + String(globalTrackers.size()) + " tracker(s):");
+    padprintln("Found " + String(detectedTrackers.size()) + " tracker(s):");
     padprintln("");
 
     if (hasWarning) {
@@ -242,7 +489,7 @@ void TrackerDetector::displayResults() {
         tft.setTextColor(bruceConfig.priColor, bruceConfig.bgColor);
     }
 
-    for (const auto &tracker : globalTrackers) {
+    for (const auto &tracker : detectedTrackers) {
         String line = "• " + tracker.type;
         if (tracker.isPersistent) {
             tft.setTextColor(TFT_RED, bruceConfig.bgColor);
@@ -18,28 +18,26 @@ struct TrackerDevice {
     unsigned long firstSeen;
     unsigned long lastSeen;
     int seenCount;
+    float score; // sightings over the last hours, older ones weigh less
     bool isPersistent;
 };
 
+// Background service, keeps a passive low duty scan running while the user is in other menus.
+// quick = full duty active scan, for the one shot scan
+bool trackerServiceStart(bool quick = false);
+void trackerServiceStop();
+bool trackerServiceRunning();
+void trackerServiceSnapshot(std::vector<TrackerDevice> &out);
+
 class TrackerDetector {
 public:
-    TrackerDetector();
-    ~TrackerDetector();
-
     void start();
-    void stop();
 
 private:
-    NimBLEScan *pBLEScan;
     std::vector<TrackerDevice> detectedTrackers;
-    unsigned long scanStartTime;
-    bool isScanning;
 
+    void quickScan();
     void displayResults();
-    void checkForStalking();
-    bool isKnownTracker(NimBLEAdvertisedDevice *device);
-    String identifyTrackerType(NimBLEAdvertisedDevice *device);
-    void updateOrAddTracker(String address, String name, String type, int rssi);
 };
 
 // Main entry point
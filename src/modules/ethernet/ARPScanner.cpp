@@ -208,6 +208,8 @@ ScanHostMenu:
     for (auto host : hostslist_eth) {
         String result = host.ip.toString();
         if (host.ip == gateway) result += "(GTW)";
+        String vendor = getVendor(host.mac);
+        if (!vendor.isEmpty()) result += " " + vendor;
         options.push_back({result.c_str(), [=]() { afterScanOptions(host); }});
     }
     addOptionToMainMenu();
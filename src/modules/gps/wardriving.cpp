@@ -2,18 +2,23 @@
  * @file wardriving.cpp
  * @author IncursioHack - https://github.com/IncursioHack
  * @brief WiFi Wardriving
- * @version 0.2
+ * @version 0.3
  * @note Updated: 2024-08-28 by Rennan Cockles (https://github.com/rennancockles)
  */
 
 #include "wardriving.h"
+#include "core/bus_lock.h"
 #include "core/display.h"
 #include "core/mykeyboard.h"
+#include "core/net_utils.h"
 #include "core/sd_functions.h"
 #include "core/wifi/wifi_common.h"
 #include "current_year.h"
 
 #define MAX_WAIT 5000
+#define GPS_LOST_TIMEOUT 30000  // ms without GPS data before giving up
+#define SCAN_MS_PER_CHANNEL 120 // active scan time per channel, a full sweep takes ~1.6s
+#define FIX_WAIT_TIMEOUT 1500   // ms a scan waits for the next fix to be placed between two fixes
 
 Wardriving::Wardriving() { setup(); }
 
@@ -35,6 +40,10 @@ void Wardriving::setup() {
 
     begin_wifi();
     if (!begin_gps()) return;
+    if (!begin_tasks()) {
+        displayError("Failed to start tasks");
+        return end();
+    }
 
     vTaskDelay(500 / portTICK_PERIOD_MS);
     return loop();
@@ -66,7 +75,36 @@ bool Wardriving::begin_gps() {
     return true;
 }
 
+bool Wardriving::begin_tasks() {
+    state.lastData = millis();
+    wifiConnected = true;
+    tasksStop = false;
+
+    gpsDone = false;
+    if (xTaskCreate(gps_task, "WardrivingGPS", 4096, this, 2, &gpsTask) != pdPASS) {
+        gpsTask = NULL;
+        gpsDone = true;
+        return false;
+    }
+    scanDone = false;
+    if (xTaskCreate(scan_task, "WardrivingScan", 8192, this, 1, &scanTask) != pdPASS) {
+        scanTask = NULL;
+        scanDone = true;
+        return false;
+    }
+    return true;
+}
+
+void Wardriving::end_tasks() {
+    tasksStop = true;
+    while (!gpsDone || !scanDone) vTaskDelay(5 / portTICK_PERIOD_MS);
+    gpsTask = NULL;
+    scanTask = NULL;
+}
+
 void Wardriving::end() {
+    end_tasks();
+    csv.end();
     wifiDisconnect();
 
     GPSserial.end();
@@ -75,79 +113,257 @@ void Wardriving::end() {
     gpsConnected = false;
 }
 
+// UI only, GPS and scans keep running in their tasks while the screen is redrawn
 void Wardriving::loop() {
-    int count = 0;
+    uint32_t lastDraw = 0;
     returnToMenu = false;
     while (1) {
-        display_banner();
-
         if (check(EscPress) || returnToMenu) return end();
 
-        if (GPSserial.available() > 0) {
-            count = 0;
-            while (GPSserial.available() > 0) gps.encode(GPSserial.read());
-
-            if (gps.location.isUpdated()) {
-                padprintln("GPS location updated");
-                set_position();
-                scan_networks();
-            } else {
-                padprintln("GPS location not updated");
-                dump_gps_data();
-
-                if (filename == "" && gps.date.year() >= CURRENT_YEAR && gps.date.year() < CURRENT_YEAR + 5)
-                    create_filename();
-            }
-        } else {
-            if (count > 5) {
-                displayError("GPS not Found!");
-                return end();
-            }
-            padprintln("No GPS data available");
-            count++;
+        if (millis() - lastDraw < 1000) {
+            vTaskDelay(50 / portTICK_PERIOD_MS);
+            continue;
         }
-
-        int tmp = millis();
-        while (millis() - tmp < MAX_WAIT && !gps.location.isUpdated()) {
-            if (check(EscPress) || returnToMenu) return end();
+        lastDraw = millis();
+
+        GpsState st;
+        portENTER_CRITICAL(&lock);
+        st = state;
+        portEXIT_CRITICAL(&lock);
+
+        if (millis() - st.lastData > GPS_LOST_TIMEOUT) {
+            busLock();
+            displayError("GPS not Found!");
+            busUnlock();
+            return end();
         }
+        // Opened here rather than in the scan task, so only this task touches filename
+        if (!fileReady && st.fix && st.dateValid && !open_file(st)) return end();
+
+        // the scan task writes to the SD card meanwhile, and it may share the bus with the display
+        busLock();
+        display_banner();
+        if (millis() - st.lastData > MAX_WAIT) padprintln("No GPS data available");
+        else if (!st.fix) padprintln("Waiting for GPS fix");
+        dump_gps_data(st);
+        busUnlock();
+    }
+}
+
+bool Wardriving::open_file(const GpsState &st) {
+    busLock();
+    FS *fs;
+    bool ok = getFsStorage(fs);
+    if (ok) {
+        create_filename(st);
+        if (!(*fs).exists("/BruceWardriving")) (*fs).mkdir("/BruceWardriving");
+        ok = csv.begin(fs, "/BruceWardriving/" + filename);
+        if (!ok) csv.end();
     }
+    if (!ok) displayError("Failed to open the file");
+    busUnlock();
+    if (ok) __atomic_store_n(&fileReady, true, __ATOMIC_RELEASE); // the scan task may write now
+    return ok;
 }
 
-void Wardriving::set_position() {
-    double lat = gps.location.lat();
-    double lng = gps.location.lng();
+/////////////////////////////////////////////////////////////////////////////////////
+// GPS task
+/////////////////////////////////////////////////////////////////////////////////////
 
-    if (initial_position_set) distance += gps.distanceBetween(cur_lat, cur_lng, lat, lng);
+void Wardriving::gps_task(void *pvParameters) {
+    Wardriving *self = (Wardriving *)pvParameters;
+    while (!self->tasksStop) {
+        self->read_gps();
+        vTaskDelay(10 / portTICK_PERIOD_MS); // ~10 bytes at 9600 baud, far from filling the UART buffer
+    }
+    self->gpsDone = true;
+    vTaskDelete(NULL);
+}
+
+void Wardriving::read_gps() {
+    if (GPSserial.available() <= 0) return;
+    while (GPSserial.available() > 0) gps.encode(GPSserial.read());
+
+    uint32_t now = millis();
+    bool updated = gps.location.isUpdated();
+    GpsFix fix = {
+        now,
+        gps.location.lat(),
+        gps.location.lng(),
+        (float)gps.altitude.meters(),
+        (float)gps.hdop.hdop(),
+    };
+    double moved = updated ? set_position(fix) : 0;
+    bool dateValid = gps.date.year() >= CURRENT_YEAR && gps.date.year() < CURRENT_YEAR + 5;
+
+    portENTER_CRITICAL(&lock);
+    state.lastData = now;
+    if (updated) {
+        fixes[fixHead] = fix;
+        fixHead = (fixHead + 1) % WARDRIVING_FIX_HISTORY;
+        if (fixCount < WARDRIVING_FIX_HISTORY) fixCount++;
+        state.fix = true;
+        state.distance += moved;
+    }
+    if (dateValid) {
+        state.dateValid = true;
+        state.year = gps.date.year();
+        state.month = gps.date.month();
+        state.day = gps.date.day();
+        state.hour = gps.time.hour();
+        state.minute = gps.time.minute();
+        state.second = gps.time.second();
+    }
+    state.satellites = gps.satellites.value();
+    state.hdop = fix.hdop;
+    portEXIT_CRITICAL(&lock);
+}
+
+// Returns the distance from the previous fix
+double Wardriving::set_position(const GpsFix &fix) {
+    double moved = 0;
+    if (initial_position_set) moved = gps.distanceBetween(cur_lat, cur_lng, fix.lat, fix.lng);
     else initial_position_set = true;
 
-    cur_lat = lat;
-    cur_lng = lng;
+    cur_lat = fix.lat;
+    cur_lng = fix.lng;
+    return moved;
 }
 
+// Position at ms, interpolated between the fixes around it.
+// Scans end between fixes, so it waits a bit for the next one instead of using a stale position
+bool Wardriving::position_at(uint32_t ms, GpsFix &pos, uint32_t &lag) {
+    GpsFix hist[WARDRIVING_FIX_HISTORY];
+    uint8_t count;
+    uint32_t waitStart = millis();
+    for (;;) {
+        portENTER_CRITICAL(&lock);
+        count = fixCount;
+        for (uint8_t i = 0; i < count; i++) {
+            hist[i] = fixes[(fixHead + WARDRIVING_FIX_HISTORY - count + i) % WARDRIVING_FIX_HISTORY];
+        }
+        portEXIT_CRITICAL(&lock);
+
+        if (count == 0) return false;
+        if ((int32_t)(hist[count - 1].ms - ms) >= 0) break;
+        if (tasksStop || millis() - waitStart > FIX_WAIT_TIMEOUT) {
+            pos = hist[count - 1];
+            lag = ms - pos.ms;
+            return true;
+        }
+        vTaskDelay(50 / portTICK_PERIOD_MS);
+    }
+
+    uint8_t b = 0;
+    while ((int32_t)(hist[b].ms - ms) < 0) b++;
+    if (b == 0) { // scan is older than the history
+        pos = hist[0];
+        lag = pos.ms - ms;
+        return true;
+    }
+
+    const GpsFix &before = hist[b - 1];
+    const GpsFix &after = hist[b];
+    double f = (double)(ms - before.ms) / (after.ms - before.ms);
+    pos.ms = ms;
+    pos.lat = before.lat + f * (after.lat - before.lat);
+    pos.lng = before.lng + f * (after.lng - before.lng);
+    pos.altitude = before.altitude + f * (after.altitude - before.altitude);
+    pos.hdop = max(before.hdop, after.hdop);
+    lag = min(ms - before.ms, after.ms - ms);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Scan task
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Wardriving::scan_task(void *pvParameters) {
+    Wardriving *self = (Wardriving *)pvParameters;
+    while (!self->tasksStop) self->scan_networks();
+    WiFi.scanDelete();
+    busLock();
+    if (self->fileReady) self->csv.flush();
+    busUnlock();
+    self->scanDone = true;
+    vTaskDelete(NULL);
+}
+
+void Wardriving::scan_networks() {
+    portENTER_CRITICAL(&lock);
+    bool fix = state.fix;
+    portEXIT_CRITICAL(&lock);
+    if (!fix || !__atomic_load_n(&fileReady, __ATOMIC_ACQUIRE)) {
+        vTaskDelay(200 / portTICK_PERIOD_MS);
+        return;
+    }
+
+    uint32_t start = millis();
+    if (WiFi.scanNetworks(true, false, false, SCAN_MS_PER_CHANNEL) == WIFI_SCAN_FAILED) {
+        vTaskDelay(500 / portTICK_PERIOD_MS);
+        return;
+    }
+    int network_amount;
+    while ((network_amount = WiFi.scanComplete()) == WIFI_SCAN_RUNNING) {
+        if (tasksStop) return;
+        vTaskDelay(20 / portTICK_PERIOD_MS);
+    }
+    uint32_t finish = millis();
+
+    GpsFix pos;
+    uint32_t lag;
+    if (network_amount > 0 && position_at(start + (finish - start) / 2, pos, lag)) {
+        append_to_file(network_amount, pos);
+        positionLag = lag;
+    }
+    WiFi.scanDelete();
+
+    if (lastScanEnd) {
+        float rate = 60000.0f / max(finish - lastScanEnd, (uint32_t)1);
+        scansPerMin = scanCount > 1 ? scansPerMin * 0.8f + rate * 0.2f : rate;
+    }
+    lastScanEnd = finish;
+    scanCount++;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Display
+/////////////////////////////////////////////////////////////////////////////////////
+
 void Wardriving::display_banner() {
     drawMainBorderWithTitle("Wardriving");
     padprintln("");
 
     if (wifiNetworkCount > 0) {
+        double distance;
+        char last[sizeof(lastNetwork)];
+        portENTER_CRITICAL(&lock);
+        distance = state.distance;
+        memcpy(last, lastNetwork, sizeof(last));
+        portEXIT_CRITICAL(&lock);
+
         padprintln("File: " + filename.substring(0, filename.length() - 4), 2);
         padprintln("Unique Networks Found: " + String(wifiNetworkCount), 2);
+        padprintln("Last: " + String(last), 2);
         padprintf(2, "Distance: %.2fkm\n", distance / 1000);
     }
+    if (scanCount > 0) {
+        padprintf(2, "Scans/min: %.1f\n", (float)scansPerMin);
+        padprintf(2, "Position lag: %lums\n", (unsigned long)positionLag);
+    }
 
     padprintln("");
 }
 
-void Wardriving::dump_gps_data() {
-    if (!date_time_updated && (!gps.date.isUpdated() || !gps.time.isUpdated())) {
+void Wardriving::dump_gps_data(const GpsState &st) {
+    if (!st.dateValid) {
         padprintln("Waiting for valid GPS data");
         return;
     }
-    date_time_updated = true;
-    padprintf(2, "Date: %02d-%02d-%02d\n", gps.date.year(), gps.date.month(), gps.date.day());
-    padprintf(2, "Time: %02d:%02d:%02d\n", gps.time.hour(), gps.time.minute(), gps.time.second());
-    padprintf(2, "Sat:  %d\n", gps.satellites.value());
-    padprintf(2, "HDOP: %.2f\n", gps.hdop.hdop());
+    padprintf(2, "Date: %02d-%02d-%02d\n", st.year, st.month, st.day);
+    padprintf(2, "Time: %02d:%02d:%02d\n", st.hour, st.minute, st.second);
+    padprintf(2, "Sat:  %lu\n", (unsigned long)st.satellites);
+    padprintf(2, "HDOP: %.2f\n", st.hdop);
 }
 
 String Wardriving::auth_mode_to_string(wifi_auth_mode_t authMode) {
@@ -165,105 +381,66 @@ String Wardriving::auth_mode_to_string(wifi_auth_mode_t authMode) {
     }
 }
 
-void Wardriving::scan_networks() {
-    wifiConnected = true;
-
-    int network_amount = WiFi.scanNetworks();
-    if (network_amount == 0) {
-        padprintln("No Wi-Fi networks found", 2);
-        return;
-    }
-
-    padprintf(2, "Coord: %.6f, %.6f\n", gps.location.lat(), gps.location.lng());
-    padprintln("Networks Found: " + String(network_amount), 2);
-
-    return append_to_file(network_amount);
-}
-
-void Wardriving::create_filename() {
+void Wardriving::create_filename(const GpsState &st) {
     char timestamp[20];
     sprintf(
         timestamp,
         "%02d%02d%02d_%02d%02d%02d",
-        gps.date.year() % 100,
-        gps.date.month() % 100,
-        gps.date.day() % 100,
-        gps.time.hour() % 100,
-        gps.time.minute() % 100,
-        gps.time.second() % 100
+        st.year % 100,
+        st.month % 100,
+        st.day % 100,
+        st.hour % 100,
+        st.minute % 100,
+        st.second % 100
     );
     filename = String(timestamp) + "_wardriving.csv";
 }
 
-void Wardriving::append_to_file(int network_amount) {
-    FS *fs;
-    if (!getFsStorage(fs)) {
-        padprintln("Storage setup error");
-        returnToMenu = true;
-        return;
-    }
-
-    if (filename == "") create_filename();
-
-    if (!(*fs).exists("/BruceWardriving")) (*fs).mkdir("/BruceWardriving");
-
-    bool is_new_file = false;
-    if (!(*fs).exists("/BruceWardriving/" + filename)) is_new_file = true;
-    File file = (*fs).open("/BruceWardriving/" + filename, is_new_file ? FILE_WRITE : FILE_APPEND);
-
-    if (!file) {
-        padprintln("Failed to open file for writing");
-        returnToMenu = true;
-        return;
-    }
-
-    if (is_new_file) {
-        file.println(
-            "WigleWifi-1.6,appRelease=v" + String(BRUCE_VERSION) + ",model=M5Stack GPS Unit,release=v" +
-            String(BRUCE_VERSION) +
-            ",device=ESP32 M5Stack,display=SPI TFT,board=ESP32 M5Stack,brand=Bruce,star=Sol,body=4,subBody=1"
-        );
-        file.println(
-            "MAC,SSID,AuthMode,FirstSeen,Channel,Frequency,RSSI,CurrentLatitude,CurrentLongitude,"
-            "AltitudeMeters,AccuracyMeters,RCOIs,MfgrId,Type"
-        );
-    }
+void Wardriving::append_to_file(int network_amount, const GpsFix &pos) {
+    GpsState st;
+    portENTER_CRITICAL(&lock);
+    st = state;
+    portEXIT_CRITICAL(&lock);
+
+    WigleObservation obs;
+    snprintf(
+        obs.firstSeen,
+        sizeof(obs.firstSeen),
+        "%04d-%02d-%02d %02d:%02d:%02d",
+        st.year,
+        st.month,
+        st.day,
+        st.hour,
+        st.minute,
+        st.second
+    );
+    obs.lat = pos.lat;
+    obs.lng = pos.lng;
+    obs.altitude = pos.altitude;
+    obs.accuracy = pos.hdop;
 
+    busLock(); // the CSV and the vendor lookup read and write the SD card
     for (int i = 0; i < network_amount; i++) {
-        String macAddress = WiFi.BSSIDstr(i);
-
-        // Check if MAC was already found in this session
-        if (registeredMACs.find(macAddress) == registeredMACs.end()) {
-            registeredMACs.insert(macAddress); // Adds MAC to file
-            int32_t channel = WiFi.channel(i);
-
-            char buffer[512];
-            snprintf(
-                buffer,
-                sizeof(buffer),
-                "%s,\"%s\",[%s],%04d-%02d-%02d %02d:%02d:%02d,%d,%d,%d,%f,%f,%f,%f,,,WIFI\n",
-                macAddress.c_str(),
-                WiFi.SSID(i).c_str(),
-                auth_mode_to_string(WiFi.encryptionType(i)).c_str(),
-                gps.date.year(),
-                gps.date.month(),
-                gps.date.day(),
-                gps.time.hour(),
-                gps.time.minute(),
-                gps.time.second(),
-                channel,
-                channel != 14 ? 2407 + (channel * 5) : 2484,
-                WiFi.RSSI(i),
-                gps.location.lat(),
-                gps.location.lng(),
-                gps.altitude.meters(),
-                gps.hdop.hdop() * 1.0
-            );
-            file.print(buffer);
-
+        uint8_t *bssid = WiFi.BSSID(i);
+        if (!bssid) continue;
+        memcpy(obs.bssid, bssid, 6);
+
+        // SSID and auth mode are kept alive until add() has formatted the line
+        String ssid = WiFi.SSID(i);
+        String authMode = auth_mode_to_string(WiFi.encryptionType(i));
+        obs.ssid = ssid.c_str();
+        obs.authMode = authMode.c_str();
+        obs.channel = WiFi.channel(i);
+        obs.rssi = WiFi.RSSI(i);
+
+        if (csv.add(obs)) {
             wifiNetworkCount++;
+            String vendor = getVendor(bssid);
+            String last = vendor.isEmpty() ? ssid : ssid + " (" + vendor + ")";
+            portENTER_CRITICAL(&lock);
+            strlcpy(lastNetwork, last.c_str(), sizeof(lastNetwork));
+            portEXIT_CRITICAL(&lock);
         }
     }
-
-    file.close();
+    busUnlock();
 }
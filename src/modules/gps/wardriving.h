@@ -2,17 +2,46 @@
  * @file wardriving.h
  * @author IncursioHack - https://github.com/IncursioHack
  * @brief WiFi Wardriving
- * @version 0.2
+ * @version 0.3
  * @note Updated: 2024-08-28 by Rennan Cockles (https://github.com/rennancockles)
+ * @note GPS parsing and WiFi scans run in their own tasks, each scan is stamped with the position
+ *       interpolated between the fixes around the middle of the scan
  */
 
 #ifndef __WAR_DRIVING_H__
 #define __WAR_DRIVING_H__
 
+#include "wigle_csv.h"
 #include <TinyGPS++.h>
 #include <esp_wifi_types.h>
 #include <globals.h>
-#include <set>
+
+#define WARDRIVING_FIX_HISTORY 8 // recent fixes kept to interpolate the scan positions
+
+// Position reported by the GPS, ms is the millis() when the sentence finished
+struct GpsFix {
+    uint32_t ms;
+    double lat;
+    double lng;
+    float altitude;
+    float hdop;
+};
+
+// Copy of the GPS data shared with the display and scan tasks
+struct GpsState {
+    bool fix;
+    bool dateValid;
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+    uint32_t satellites;
+    float hdop;
+    double distance;
+    uint32_t lastData; // millis() of the last byte received
+};
 
 class Wardriving {
 public:
@@ -29,38 +58,64 @@ public:
     void loop();
 
 private:
-    bool date_time_updated = false;
     bool initial_position_set = false;
     double cur_lat;
     double cur_lng;
-    double distance = 0;
-    String filename = "";
-    TinyGPSPlus gps;
+    String filename = ""; // only used by the UI task
+    bool fileReady = false; // csv is open, set once by the UI task, then the scan task writes
+    TinyGPSPlus gps;                              // only used by the GPS task
     HardwareSerial GPSserial = HardwareSerial(2); // Uses UART2 for GPS
-    std::set<String> registeredMACs;              // Store and track registered MAC
-    int wifiNetworkCount = 0;                     // Counter fo wifi networks
+    WigleCsvWriter csv;                           // only used by the scan task
+    volatile int wifiNetworkCount = 0;            // Counter fo wifi networks
+
+    // shared between tasks, guarded by lock
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    GpsState state = {};
+    GpsFix fixes[WARDRIVING_FIX_HISTORY];
+    uint8_t fixCount = 0;
+    uint8_t fixHead = 0;
+    char lastNetwork[48] = ""; // "SSID (vendor)" of the last new network
+
+    TaskHandle_t gpsTask = NULL;
+    TaskHandle_t scanTask = NULL;
+    volatile bool tasksStop = false;
+    volatile bool gpsDone = true;
+    volatile bool scanDone = true;
+
+    // pipeline stats, written by the scan task
+    volatile uint32_t scanCount = 0;
+    volatile float scansPerMin = 0;
+    volatile uint32_t positionLag = 0; // ms between the scan and the closest fix used for it
+    uint32_t lastScanEnd = 0;
 
     /////////////////////////////////////////////////////////////////////////////////////
     // Setup
     /////////////////////////////////////////////////////////////////////////////////////
     void begin_wifi(void);
     bool begin_gps(void);
+    bool begin_tasks(void);
+    void end_tasks(void);
     void end(void);
 
     /////////////////////////////////////////////////////////////////////////////////////
     // Display functions
     /////////////////////////////////////////////////////////////////////////////////////
     void display_banner(void);
-    void dump_gps_data(void);
+    void dump_gps_data(const GpsState &st);
 
     /////////////////////////////////////////////////////////////////////////////////////
     // Operations
     /////////////////////////////////////////////////////////////////////////////////////
-    void set_position(void);
+    static void gps_task(void *pvParameters);
+    static void scan_task(void *pvParameters);
+    void read_gps(void);
+    double set_position(const GpsFix &fix);
+    bool position_at(uint32_t ms, GpsFix &pos, uint32_t &lag);
     void scan_networks(void);
     String auth_mode_to_string(wifi_auth_mode_t authMode);
-    void append_to_file(int network_amount);
-    void create_filename(void);
+    void append_to_file(int network_amount, const GpsFix &pos);
+    void create_filename(const GpsState &st);
+    bool open_file(const GpsState &st);
 };
 
 #endif // WAR_DRIVING_H
@@ -0,0 +1,324 @@
+/**
+ * @file wigle_csv.cpp
+ * @brief Append only Wigle CSV writer with a bounded session dedupe index
+ * @version 0.1
+ */
+
+#include "wigle_csv.h"
+
+/////////////////////////////////////////////////////////////////////////////////////
+// MAC table
+/////////////////////////////////////////////////////////////////////////////////////
+
+static inline uint64_t macKey(const uint8_t *mac) {
+    uint64_t k = 0;
+    for (int i = 0; i < 6; i++) k = (k << 8) | mac[i];
+    return k;
+}
+
+static inline uint32_t macHash(uint64_t key, uint32_t seed) {
+    key = (key ^ seed) * 0x9E3779B97F4A7C15ULL;
+    return key >> 32;
+}
+
+bool WigleMacTable::begin() {
+    end();
+    capacity = psramFound() ? WIGLE_TABLE_SIZE_PSRAM : WIGLE_TABLE_SIZE_RAM;
+    size_t bytes = capacity * sizeof(Slot);
+    slots = (Slot *)(psramFound() ? ps_calloc(1, bytes) : calloc(1, bytes));
+    if (!slots) return false;
+    bloomBits = psramFound() ? WIGLE_BLOOM_BITS_PSRAM : WIGLE_BLOOM_BITS_RAM;
+    bloom = (uint8_t *)(psramFound() ? ps_calloc(1, bloomBits / 8) : calloc(1, bloomBits / 8));
+    return true;
+}
+
+void WigleMacTable::end() {
+    free(slots);
+    slots = nullptr;
+    free(bloom);
+    bloom = nullptr;
+    capacity = 0;
+    count = 0;
+    bloomCount = 0;
+}
+
+WigleMacTable::Slot *WigleMacTable::find(const uint8_t *mac) {
+    if (!slots) return nullptr;
+    uint32_t i = macHash(macKey(mac), 0) & (capacity - 1);
+    for (uint32_t probe = 0; probe < capacity; probe++, i = (i + 1) & (capacity - 1)) {
+        if (!slots[i].used) return nullptr;
+        if (memcmp(slots[i].mac, mac, 6) == 0) return &slots[i];
+    }
+    return nullptr;
+}
+
+WigleMacTable::Slot *WigleMacTable::insert(const uint8_t *mac, bool *isNew) {
+    *isNew = false;
+    if (!slots) return nullptr;
+
+    uint32_t i = macHash(macKey(mac), 0) & (capacity - 1);
+    for (uint32_t probe = 0; probe < capacity; probe++, i = (i + 1) & (capacity - 1)) {
+        Slot &s = slots[i];
+        if (s.used) {
+            if (memcmp(s.mac, mac, 6) == 0) return &s;
+            continue;
+        }
+        if (count >= capacity * 3 / 4) break; // full, keep probes short
+        memcpy(s.mac, mac, 6);
+        s.rssi = -128;
+        s.used = 1;
+        s.best = WIGLE_NO_BEST;
+        count++;
+        *isNew = true;
+        return &s;
+    }
+
+    // table is full, the Bloom filter tells if the MAC was probably seen already
+    if (!bloom) return nullptr;
+    uint64_t key = macKey(mac);
+    bool seen = true;
+    for (uint32_t k = 1; k <= 3; k++) {
+        uint32_t bit = macHash(key, k * 0x5bd1e995) & (bloomBits - 1);
+        if (!(bloom[bit >> 3] & (1 << (bit & 7)))) {
+            seen = false;
+            bloom[bit >> 3] |= 1 << (bit & 7);
+        }
+    }
+    if (!seen) {
+        bloomCount++;
+        *isNew = true;
+    }
+    return nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// CSV writer
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool WigleCsvWriter::begin(FS *_fs, const String &_path, bool _keepStrongest) {
+    end();
+    fs = _fs;
+    path = _path;
+    keepStrongest = _keepStrongest;
+
+    if (!table.begin()) return false;
+    buffer = (char *)malloc(WIGLE_WRITE_BUFFER);
+    if (!buffer) return false;
+    bufferFill = 0;
+    bestCount = 0;
+
+    bool isNewFile = !fs->exists(path);
+    file = fs->open(path, isNewFile ? FILE_WRITE : FILE_APPEND);
+    if (!file) return false;
+    sessionStart = file.size();
+
+    if (isNewFile) {
+        String header = "WigleWifi-1.6,appRelease=v" + String(BRUCE_VERSION) +
+                        ",model=M5Stack GPS Unit,release=v" + String(BRUCE_VERSION) +
+                        ",device=ESP32 M5Stack,display=SPI TFT,board=ESP32 M5Stack,brand=Bruce,star=Sol,"
+                        "body=4,subBody=1\n"
+                        "MAC,SSID,AuthMode,FirstSeen,Channel,Frequency,RSSI,CurrentLatitude,CurrentLongitude,"
+                        "AltitudeMeters,AccuracyMeters,RCOIs,MfgrId,Type\n";
+        write(header.c_str(), header.length());
+    }
+
+    if (keepStrongest) {
+        bestFile = fs->open(path + ".best", FILE_WRITE);
+        if (!bestFile) keepStrongest = false;
+    }
+
+    lastSync = millis();
+    opened = true;
+    return true;
+}
+
+void WigleCsvWriter::write(const char *data, size_t len) {
+    if (bufferFill + len > WIGLE_WRITE_BUFFER) {
+        file.write((uint8_t *)buffer, bufferFill);
+        bufferFill = 0;
+    }
+    memcpy(buffer + bufferFill, data, len);
+    bufferFill += len;
+}
+
+bool WigleCsvWriter::add(const WigleObservation &obs) {
+    if (!opened) return false;
+
+    bool isNew;
+    WigleMacTable::Slot *slot = table.insert(obs.bssid, &isNew);
+
+    if (isNew) {
+        // SSIDs may have quotes, CSV escapes them doubling
+        char ssid[2 * 32 + 1];
+        size_t n = 0;
+        for (const char *c = obs.ssid; *c && n < sizeof(ssid) - 2; c++) {
+            if (*c == '"') ssid[n++] = '"';
+            ssid[n++] = *c;
+        }
+        ssid[n] = '\0';
+
+        char line[WIGLE_LINE_MAX];
+        int len = snprintf(
+            line,
+            sizeof(line),
+            "%02X:%02X:%02X:%02X:%02X:%02X,\"%s\",[%s],%s,%d,%d,%d,%f,%f,%f,%f,,,WIFI\n",
+            obs.bssid[0],
+            obs.bssid[1],
+            obs.bssid[2],
+            obs.bssid[3],
+            obs.bssid[4],
+            obs.bssid[5],
+            ssid,
+            obs.authMode,
+            obs.firstSeen,
+            (int)obs.channel,
+            obs.channel != 14 ? 2407 + ((int)obs.channel * 5) : 2484,
+            obs.rssi,
+            obs.lat,
+            obs.lng,
+            obs.altitude,
+            obs.accuracy
+        );
+        if (len > 0) write(line, len < (int)sizeof(line) ? len : sizeof(line) - 1);
+        if (slot) slot->rssi = obs.rssi;
+    } else if (slot && keepStrongest && obs.rssi > slot->rssi) {
+        WigleBestRecord rec;
+        memcpy(rec.bssid, obs.bssid, 6);
+        rec.rssi = obs.rssi;
+        rec.reserved = 0;
+        rec.lat = obs.lat;
+        rec.lng = obs.lng;
+        rec.altitude = obs.altitude;
+        rec.accuracy = obs.accuracy;
+        if (bestFile.write((uint8_t *)&rec, sizeof(rec)) == sizeof(rec)) {
+            slot->rssi = obs.rssi;
+            slot->best = bestCount++;
+        }
+    }
+
+    if (millis() - lastSync > WIGLE_SYNC_INTERVAL) flush();
+    return isNew;
+}
+
+void WigleCsvWriter::flush() {
+    if (!opened) return;
+    if (bufferFill) file.write((uint8_t *)buffer, bufferFill);
+    bufferFill = 0;
+    file.flush();
+    if (bestFile) bestFile.flush();
+    lastSync = millis();
+}
+
+// Lines end with RSSI,Lat,Lng,Alt,Accuracy,RCOIs,MfgrId,Type, counting the commas from the end
+// finds the RSSI even when the SSID has commas.
+// FS has no truncate, so the lines of previous sessions are copied to the .tmp too, in blocks of
+// WIGLE_WRITE_BUFFER: ending a session costs one sequential copy of the whole file.
+// The original is only replaced when every write went through and the .tmp has the expected size,
+// a full or failing card keeps the log as it was.
+void WigleCsvWriter::rewriteStrongest() {
+    File in = fs->open(path, FILE_READ);
+    File out = fs->open(path + ".tmp", FILE_WRITE);
+    File best = fs->open(path + ".best", FILE_READ);
+    if (!in || !out || !best) {
+        if (out) {
+            out.close();
+            fs->remove(path + ".tmp");
+        }
+        return;
+    }
+
+    bool ok = true;
+    size_t expected = 0;
+    auto put = [&](const uint8_t *data, size_t len) {
+        expected += len;
+        if (out.write(data, len) != len) ok = false;
+    };
+
+    char line[WIGLE_LINE_MAX];
+    char tail[96];
+    uint8_t mac[6];
+    WigleBestRecord rec;
+
+    // lines from previous sessions are copied as they are
+    size_t copied = 0;
+    while (ok && copied < sessionStart) {
+        size_t n = sessionStart - copied < WIGLE_WRITE_BUFFER ? sessionStart - copied : WIGLE_WRITE_BUFFER;
+        n = in.read((uint8_t *)buffer, n);
+        if (n == 0) ok = false;
+        put((uint8_t *)buffer, n);
+        copied += n;
+    }
+
+    while (ok && in.available()) {
+        size_t len = in.readBytesUntil('\n', line, sizeof(line) - 1);
+        line[len] = '\0';
+
+        WigleMacTable::Slot *slot = nullptr;
+        if (sscanf(
+                line,
+                "%2hhx:%2hhx:%2hhx:%2hhx:%2hhx:%2hhx,",
+                &mac[0],
+                &mac[1],
+                &mac[2],
+                &mac[3],
+                &mac[4],
+                &mac[5]
+            ) == 6)
+            slot = table.find(mac);
+
+        int commas = 0;
+        size_t rssiPos = len;
+        while (slot && slot->best != WIGLE_NO_BEST && rssiPos > 0) {
+            if (line[--rssiPos] == ',' && ++commas == 8) break;
+        }
+
+        if (commas == 8 && best.seek(slot->best * sizeof(rec)) &&
+            best.read((uint8_t *)&rec, sizeof(rec)) == sizeof(rec)) {
+            put((uint8_t *)line, rssiPos + 1);
+            int n = snprintf(
+                tail,
+                sizeof(tail),
+                "%d,%f,%f,%f,%f,,,WIFI\n",
+                rec.rssi,
+                rec.lat,
+                rec.lng,
+                rec.altitude,
+                rec.accuracy
+            );
+            put((uint8_t *)tail, n);
+        } else {
+            line[len] = '\n';
+            put((uint8_t *)line, len + 1);
+        }
+    }
+    in.close();
+    out.close();
+    best.close();
+
+    if (ok) {
+        File check = fs->open(path + ".tmp", FILE_READ);
+        ok = check && check.size() == expected;
+        check.close();
+    }
+    if (!ok) {
+        Serial.println("Wigle: could not rewrite the strongest observations, log kept as it was");
+        fs->remove(path + ".tmp");
+        return;
+    }
+    fs->remove(path);
+    fs->rename(path + ".tmp", path);
+}
+
+void WigleCsvWriter::end() {
+    if (opened) {
+        flush();
+        file.close();
+        if (bestFile) bestFile.close();
+        if (keepStrongest && bestCount > 0) rewriteStrongest();
+        if (keepStrongest) fs->remove(path + ".best");
+    }
+    opened = false;
+    free(buffer);
+    buffer = nullptr;
+    table.end();
+}
@@ -0,0 +1,118 @@
+/**
+ * @file wigle_csv.h
+ * @brief Append only Wigle CSV writer with a bounded session dedupe index
+ * @version 0.1
+ */
+
+#ifndef __WIGLE_CSV_H__
+#define __WIGLE_CSV_H__
+
+#include <Arduino.h>
+#include <FS.h>
+
+#define WIGLE_LINE_MAX 256                  // longest CSV line, a 32 chars SSID fits with room to spare
+#define WIGLE_WRITE_BUFFER 4096             // lines are written to the file in blocks of this size
+#define WIGLE_SYNC_INTERVAL 10000           // ms between forced flushes of the open file
+#define WIGLE_TABLE_SIZE_PSRAM 8192         // dedupe table slots, must be a power of two
+#define WIGLE_TABLE_SIZE_RAM 1024           // dedupe table slots, must be a power of two
+#define WIGLE_BLOOM_BITS_PSRAM (512 * 1024) // overflow filter once the table is full, must be a power of two
+#define WIGLE_BLOOM_BITS_RAM (64 * 1024)    // overflow filter once the table is full, must be a power of two
+#define WIGLE_NO_BEST 0xFFFFFFFF
+
+struct WigleObservation {
+    uint8_t bssid[6];
+    const char *ssid;
+    const char *authMode;
+    char firstSeen[20]; // YYYY-MM-DD HH:MM:SS
+    int32_t channel;
+    int8_t rssi;
+    double lat;
+    double lng;
+    float altitude;
+    float accuracy;
+};
+
+// Stronger observation of a network already written, kept in the <file>.best sidecar
+struct WigleBestRecord {
+    uint8_t bssid[6];
+    int8_t rssi;
+    uint8_t reserved;
+    double lat;
+    double lng;
+    float altitude;
+    float accuracy;
+};
+
+/**
+ * @brief Hash table of the BSSIDs seen in the session, keyed by the 48 bit MAC.
+ *        The size is fixed when it is created, once 3/4 of the slots are used new MACs go to a
+ *        Bloom filter, so memory stays flat on long drives (at the cost of a few false duplicates).
+ */
+class WigleMacTable {
+public:
+    struct Slot {
+        uint8_t mac[6];
+        int8_t rssi;
+        uint8_t used;
+        uint32_t best; // index in the sidecar of the strongest observation, WIGLE_NO_BEST if none
+    };
+
+    ~WigleMacTable() { end(); }
+    bool begin();
+    void end();
+
+    // Returns the slot of the MAC, inserting it when new (*isNew = true).
+    // Returns nullptr when the table is full, *isNew then tells what the Bloom filter thinks
+    Slot *insert(const uint8_t *mac, bool *isNew);
+    Slot *find(const uint8_t *mac);
+    uint32_t size() const { return count; }
+    uint32_t overflow() const { return bloomCount; }
+
+private:
+    Slot *slots = nullptr;
+    uint32_t capacity = 0;
+    uint32_t count = 0;
+    uint8_t *bloom = nullptr;
+    uint32_t bloomBits = 0;
+    uint32_t bloomCount = 0;
+};
+
+/**
+ * @brief Keeps the wardriving CSV open and appends the new networks through a write buffer,
+ *        flushing it every WIGLE_SYNC_INTERVAL instead of reopening the file on every scan.
+ *        With keepStrongest, stronger observations of networks already written go to a binary
+ *        sidecar and end() rewrites those lines with the strongest RSSI and position.
+ */
+class WigleCsvWriter {
+public:
+    ~WigleCsvWriter() { end(); }
+
+    bool begin(FS *fs, const String &path, bool keepStrongest = true);
+    // Returns true when the network was not seen before in this session
+    bool add(const WigleObservation &obs);
+    void flush();
+    void end();
+
+    bool isOpen() const { return opened; }
+    uint32_t networks() const { return table.size() + table.overflow(); }
+    uint32_t strongerUpdates() const { return bestCount; }
+
+private:
+    FS *fs = nullptr;
+    String path;
+    File file;
+    File bestFile;
+    bool opened = false;
+    bool keepStrongest = false;
+    WigleMacTable table;
+    char *buffer = nullptr;
+    size_t bufferFill = 0;
+    uint32_t lastSync = 0;
+    uint32_t bestCount = 0;
+    size_t sessionStart = 0; // file size when it was opened, only lines after it are rewritten
+
+    void write(const char *data, size_t len);
+    void rewriteStrongest();
+};
+
+#endif
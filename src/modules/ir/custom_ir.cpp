@@ -5,8 +5,11 @@
 #include "core/sd_functions.h"
 #include "core/settings.h"
 #include "core/type_convertion.h"
+#include "ir_file.h"
 #include <IRutils.h>
 
+#define IR_MAX_MENU_CODES 250
+
 uint32_t swap32(uint32_t value) {
     return ((value & 0x000000FF) << 24) | ((value & 0x0000FF00) << 8) | ((value & 0x00FF0000) >> 8) |
            ((value & 0xFF000000) >> 24);
@@ -15,13 +18,6 @@ uint32_t swap32(uint32_t value) {
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Custom IR
 
-static std::vector<IRCode *> codes;
-
-void resetCodesArray() {
-    for (auto code : codes) { delete code; }
-    codes.clear();
-}
-
 static std::vector<IRCode *> recent_ircodes;
 
 void addToRecentCodes(IRCode *ircode) {
@@ -70,10 +66,7 @@ void selectRecentIrMenu() {
 }
 
 bool txIrFile(FS *fs, String filepath) {
-    // SPAM all codes of the file
-
-    int total_codes = 0;
-    String line;
+    // SPAM all codes of the file, in a single pass
 
     File databaseFile = fs->open(filepath, FILE_READ);
 
@@ -90,105 +83,25 @@ bool txIrFile(FS *fs, String filepath) {
 
     bool endingEarly = false;
     int codes_sent = 0;
-    uint16_t frequency = 0;
-    String rawData = "";
-    String protocol = "";
-    String address = "";
-    String command = "";
-    String value = "";
-    uint8_t bits = 32;
-
-    databaseFile.seek(0); // comes back to first position
-
-    // count the number of codes to replay
-    while (databaseFile.available()) {
-        line = databaseFile.readStringUntil('\n');
-        if (line.startsWith("type:")) total_codes++;
-    }
-
-    Serial.printf("\nStarted SPAM all codes with: %d codes", total_codes);
-    // comes back to first position, beggining of the file
-    databaseFile.seek(0);
-    while (databaseFile.available()) {
-        progressHandler(codes_sent, total_codes);
-        line = databaseFile.readStringUntil('\n');
-        if (line.endsWith("\r")) line.remove(line.length() - 1);
-
-        if (line.startsWith("type:")) {
+    size_t fileSize = databaseFile.size();
+    IRFileReader reader(databaseFile);
+    IRCode code;
+
+    Serial.printf("\nStarted SPAM all codes of %s\n", filepath.c_str());
+    while (reader.next(code)) {
+        // progress by bytes, so the file doesn't need to be read twice to count the codes
+        progressHandler(reader.position(), fileSize);
+
+        if (code.type.equalsIgnoreCase("raw") && code.frequency != 0 && code.data != "") {
+            Serial.println("RAW code: " + code.name);
+            sendIRCommand(&code);
+            codes_sent++;
+        } else if (code.type.equalsIgnoreCase("parsed")) {
+            Serial.println("PARSED: " + code.name + " " + code.protocol);
+            sendIRCommand(&code);
             codes_sent++;
-            String type = line.substring(5);
-            type.trim();
-            Serial.println("Type: " + type);
-            if (type == "raw") {
-                Serial.println("RAW code");
-                while (databaseFile.available()) {
-                    line = databaseFile.readStringUntil('\n');
-                    if (line.endsWith("\r")) line.remove(line.length() - 1);
-
-                    if (line.startsWith("frequency:")) {
-                        line = line.substring(10);
-                        line.trim();
-                        frequency = line.toInt();
-                        Serial.printf("Frequency: %d\n", frequency);
-                    } else if (line.startsWith("data:")) {
-                        rawData = line.substring(5);
-                        rawData.trim();
-                        Serial.println("RawData: " + rawData);
-                    } else if ((frequency != 0 && rawData != "") || line.startsWith("#")) {
-                        IRCode code;
-                        code.type = "raw";
-                        code.data = rawData;
-                        code.frequency = frequency;
-                        sendIRCommand(&code);
-
-                        rawData = "";
-                        frequency = 0;
-                        type = "";
-                        line = "";
-                        break;
-                    }
-                }
-            } else if (type == "parsed") {
-                Serial.println("PARSED");
-                while (databaseFile.available()) {
-                    line = databaseFile.readStringUntil('\n');
-                    if (line.endsWith("\r")) line.remove(line.length() - 1);
-
-                    if (line.startsWith("protocol:")) {
-                        protocol = line.substring(9);
-                        protocol.trim();
-                        Serial.println("Protocol: " + protocol);
-                    } else if (line.startsWith("address:")) {
-                        address = line.substring(8);
-                        address.trim();
-                        Serial.println("Address: " + address);
-                    } else if (line.startsWith("command:")) {
-                        command = line.substring(8);
-                        command.trim();
-                        Serial.println("Command: " + command);
-                    } else if (line.startsWith("value:") || line.startsWith("state:")) {
-                        value = line.substring(6);
-                        value.trim();
-                        Serial.println("Value: " + value);
-                    } else if (line.startsWith("bits:")) {
-                        bits = line.substring(strlen("bits:")).toInt();
-                        Serial.println("bits: " + bits);
-                    } else if (line.indexOf("#") != -1) { // TODO: also detect EOF
-                        IRCode code(protocol, address, command, value, bits);
-                        sendIRCommand(&code);
-
-                        protocol = "";
-                        address = "";
-                        command = "";
-                        value = "";
-                        bits = 32;
-                        type = "";
-                        line = "";
-                        break;
-                    }
-                }
-            }
         }
+
         // if user is pushing (holding down) TRIGGER button, stop transmission early
         if (check(SelPress)) // Pause TV-B-Gone
         {
@@ -205,22 +118,18 @@ bool txIrFile(FS *fs, String filepath) {
             if (endingEarly) break; // Cancels  custom IR Spam
             displayTextLine("Running, Wait");
         }
-    } // end while file has lines to process
+    } // end while file has codes to process
     databaseFile.close();
-    Serial.println("closed");
+    Serial.printf("closed, %d codes sent\n", codes_sent);
     Serial.println("EXTRA finished");
 
-    resetCodesArray();
     digitalWrite(bruceConfig.irTx, LED_OFF);
     return true;
 }
 
 void otherIRcodes() {
     checkIrTxPin();
-    resetCodesArray();
-    int total_codes = 0;
     String filepath;
-    File databaseFile;
     FS *fs = NULL;
 
     returnToMenu = true; // make sure menu is redrawn when quitting in any point
@@ -265,10 +174,11 @@ void otherIRcodes() {
 
     // else continue and try to parse the file
 
-    databaseFile = fs->open(filepath, FILE_READ);
+    // names and offsets come from the .idx sidecar, codes are only parsed when sent
+    IRFileIndex index;
     drawMainBorder();
 
-    if (!databaseFile) {
+    if (!index.begin(fs, filepath)) {
         Serial.println("Failed to open database file.");
         // displayError("Fail to open file");
         // delay(2000);
@@ -279,52 +189,21 @@ void otherIRcodes() {
     pinMode(bruceConfig.irTx, OUTPUT);
     // digitalWrite(bruceConfig.irTx, LED_ON);
 
-    // Mode to choose and send command by command limitted to 100 commands
-    String line;
-    String txt;
-    codes.push_back(new IRCode());
-    while (databaseFile.available() && total_codes < 100) {
-        line = databaseFile.readStringUntil('\n');
-        txt = line.substring(line.indexOf(":") + 1);
-        txt.trim();
-        if (line.startsWith("name:")) {
-            // in case that the separation between codes are not made by "#" line
-            if (codes[total_codes]->name != "") {
-                total_codes++;
-                codes.push_back(new IRCode());
-            }
-            // save signal name
-            codes[total_codes]->name = txt;
-            codes[total_codes]->filepath = txt + " " + filepath.substring(1 + filepath.lastIndexOf("/"));
-        }
-        if (line.startsWith("type:")) codes[total_codes]->type = txt;
-        if (line.startsWith("protocol:")) codes[total_codes]->protocol = txt;
-        if (line.startsWith("address:")) codes[total_codes]->address = txt;
-        if (line.startsWith("frequency:")) codes[total_codes]->frequency = txt.toInt();
-        if (line.startsWith("bits:")) codes[total_codes]->bits = txt.toInt();
-        if (line.startsWith("command:")) codes[total_codes]->command = txt;
-        if (line.startsWith("data:") || line.startsWith("value:") || line.startsWith("state:")) {
-            codes[total_codes]->data = txt;
-        }
-        // if there are a line with "#", and the code name isnt't "" (there are a signal saved), go to next
-        // signal
-        if (line.startsWith("#") && total_codes < codes.size() && codes[total_codes]->name != "") {
-            total_codes++;
-            codes.push_back(new IRCode());
-        }
-        // if(line.startsWith("duty_cycle:")) codes[total_codes]->duty_cycle = txt.toFloat();
-    }
+    // Mode to choose and send command by command limitted to IR_MAX_MENU_CODES commands
+    String fileName = filepath.substring(1 + filepath.lastIndexOf("/"));
+    IRIndexEntry entry;
     options = {};
-    for (auto code : codes) {
-        if (code->name != "") {
-            options.push_back({code->name.c_str(), [code]() {
-                                   sendIRCommand(code);
-                                   addToRecentCodes(code);
-                               }});
-        }
+    for (uint32_t i = 0; i < index.count() && i < IR_MAX_MENU_CODES; i++) {
+        if (!index.entry(i, entry) || entry.name[0] == '\0') continue;
+        options.push_back({entry.name, [&index, i, &fileName]() {
+                               IRCode code;
+                               if (!index.load(i, code)) return;
+                               code.filepath = code.name + " " + fileName;
+                               sendIRCommand(&code);
+                               addToRecentCodes(&code);
+                           }});
     }
     options.push_back({"Main Menu", [&]() { exit = true; }});
-    databaseFile.close();
 
  #ifdef USE_BOOST  ///DISABLE 5V OUTPUT
   PPM.disableOTG();
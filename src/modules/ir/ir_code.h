@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+
+struct IRCode {
+    IRCode(
+        String protocol = "", String address = "", String command = "", String data = "", uint8_t bits = 32
+    )
+        : protocol(protocol), address(address), command(command), data(data), bits(bits) {}
+
+    IRCode(IRCode *code) {
+        name = String(code->name);
+        type = String(code->type);
+        protocol = String(code->protocol);
+        address = String(code->address);
+        command = String(code->command);
+        frequency = code->frequency;
+        bits = code->bits;
+        // duty_cycle = code->duty_cycle;
+        data = String(code->data);
+        filepath = String(code->filepath);
+    }
+
+    String protocol = "";
+    String address = "";
+    String command = "";
+    String data = "";
+    uint8_t bits = 32;
+    String name = "";
+    String type = "";
+    uint16_t frequency = 0;
+    // float duty_cycle;
+    String filepath = "";
+};
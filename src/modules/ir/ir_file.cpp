@@ -0,0 +1,152 @@
+#include "ir_file.h"
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Reader
+
+static void clearCode(IRCode &code) {
+    // assigning "" keeps the String buffers, so reading the next signal doesn't allocate again
+    code.name = "";
+    code.type = "";
+    code.protocol = "";
+    code.address = "";
+    code.command = "";
+    code.data = "";
+    code.frequency = 0;
+    code.bits = 32;
+}
+
+bool IRFileReader::next(IRCode &code, uint32_t *offset) {
+    char key[16];
+    char value[IR_FIELD_LEN];
+    bool started = false;
+
+    clearCode(code);
+    for (;;) {
+        uint32_t lineStart = position();
+        int c = in.peek();
+        if (c < 0) return started;
+        if (c == '#') {
+            in.skipLine();
+            if (started) return true;
+            continue;
+        }
+        if (isspace(c)) {
+            in.read();
+            continue;
+        }
+        if (in.readKey(key, sizeof(key)) == 0) continue;
+
+        if (strcmp(key, "name") == 0 && started) {
+            seek(lineStart); // belongs to the next signal
+            return true;
+        }
+
+        in.skipSpaces();
+        if (strcmp(key, "data") == 0 || strcmp(key, "value") == 0 || strcmp(key, "state") == 0) {
+            in.readValue(code.data);
+        } else if (strcmp(key, "name") == 0 || strcmp(key, "type") == 0 || strcmp(key, "protocol") == 0 ||
+                   strcmp(key, "address") == 0 || strcmp(key, "command") == 0 ||
+                   strcmp(key, "frequency") == 0 || strcmp(key, "bits") == 0) {
+            in.readValue(value, sizeof(value));
+            if (key[0] == 'n') code.name = value;
+            else if (key[0] == 't') code.type = value;
+            else if (key[0] == 'p') code.protocol = value;
+            else if (key[0] == 'a') code.address = value;
+            else if (key[0] == 'c') code.command = value;
+            else if (key[0] == 'f') code.frequency = atoi(value);
+            else if (key[0] == 'b') code.bits = atoi(value);
+        } else {
+            in.skipLine(); // file header (Filetype, Version) or keys we don't use (duty_cycle)
+            continue;
+        }
+
+        if (!started && offset) *offset = lineStart;
+        started = true;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Index
+
+bool IRFileIndex::begin(FS *fs, const String &filepath) {
+    end();
+    db = fs->open(filepath, FILE_READ);
+    if (!db) return false;
+
+    String idxPath = filepath + IR_INDEX_EXT;
+    idx = fs->open(idxPath, FILE_READ);
+    if (idx && idx.read((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+        header.magic == IR_INDEX_MAGIC && header.version == IR_INDEX_VERSION &&
+        header.entrySize == sizeof(IRIndexEntry) && header.srcSize == db.size() &&
+        header.srcMtime == (uint32_t)db.getLastWrite() &&
+        idx.size() == sizeof(header) + header.count * sizeof(IRIndexEntry)) {
+        return true;
+    }
+    if (idx) idx.close();
+    return build(fs, idxPath);
+}
+
+bool IRFileIndex::build(FS *fs, const String &idxPath) {
+    uint32_t start = millis();
+    header = {
+        IR_INDEX_MAGIC,
+        IR_INDEX_VERSION,
+        (uint16_t)sizeof(IRIndexEntry),
+        0,
+        (uint32_t)db.size(),
+        (uint32_t)db.getLastWrite()
+    };
+
+    File out = fs->open(idxPath, FILE_WRITE);
+    if (out) out.write((uint8_t *)&header, sizeof(header)); // count is rewritten at the end
+
+    IRFileReader reader(db);
+    IRCode code;
+    IRIndexEntry e;
+    uint32_t offset;
+    while (reader.next(code, &offset)) {
+        memset(&e, 0, sizeof(e));
+        e.offset = offset;
+        e.raw = code.type.equalsIgnoreCase("raw");
+        strncpy(e.protocol, code.protocol.c_str(), sizeof(e.protocol) - 1);
+        strncpy(e.name, code.name.c_str(), sizeof(e.name) - 1);
+        if (out) out.write((uint8_t *)&e, sizeof(e));
+        else ramEntries.push_back(e);
+        header.count++;
+    }
+
+    if (out) {
+        out.seek(0);
+        out.write((uint8_t *)&header, sizeof(header));
+        out.close();
+        idx = fs->open(idxPath, FILE_READ);
+        if (!idx) return false;
+    }
+    Serial.printf("IR index: %u signals in %lums\n", (unsigned)header.count, (unsigned long)(millis() - start));
+    return true;
+}
+
+void IRFileIndex::end() {
+    if (db) db.close();
+    if (idx) idx.close();
+    ramEntries.clear();
+    header = {};
+}
+
+bool IRFileIndex::entry(uint32_t n, IRIndexEntry &e) {
+    if (n >= header.count) return false;
+    if (!idx) {
+        e = ramEntries[n];
+        return true;
+    }
+    if (!idx.seek(sizeof(header) + n * sizeof(IRIndexEntry))) return false;
+    return idx.read((uint8_t *)&e, sizeof(e)) == sizeof(e);
+}
+
+bool IRFileIndex::load(uint32_t n, IRCode &code) {
+    IRIndexEntry e;
+    if (!entry(n, e)) return false;
+    IRFileReader reader(db);
+    reader.seek(e.offset);
+    return reader.next(code);
+}
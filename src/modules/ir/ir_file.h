@@ -0,0 +1,74 @@
+#pragma once
+#include "core/key_value_reader.h"
+#include "ir_code.h"
+#include <FS.h>
+#include <vector>
+
+#define IR_FIELD_LEN 64 // max length of the short fields (name, protocol, address...)
+#define IR_INDEX_EXT ".idx"
+#define IR_INDEX_MAGIC 0x58524942 // "BIRX"
+#define IR_INDEX_VERSION 1
+
+/**
+ * @brief Streaming reader for Flipper .ir files.
+ *        Reads the file through a KeyValueReader and fills an IRCode per signal, reusing its
+ *        Strings, so going through a file doesn't allocate per line.
+ *        A signal starts at a "name:" (or any signal key) and ends on a "#" line, the next
+ *        "name:" or the end of the file.
+ */
+class IRFileReader {
+public:
+    IRFileReader(File &file) : in(file) { in.begin(); }
+
+    // Reads the next signal, returns false when there are no more signals.
+    // offset receives the position of the first line of the signal
+    bool next(IRCode &code, uint32_t *offset = nullptr);
+
+    bool seek(uint32_t offset) { return in.seek(offset); }
+    uint32_t position() const { return in.position(); }
+
+private:
+    KeyValueReader in;
+};
+
+struct IRIndexHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entrySize;
+    uint32_t count;
+    uint32_t srcSize;  // .ir file size when the index was built
+    uint32_t srcMtime; // .ir file last write when the index was built
+};
+
+struct IRIndexEntry {
+    uint32_t offset; // first line of the signal in the .ir file
+    uint8_t raw;
+    char protocol[11];
+    char name[48];
+};
+
+/**
+ * @brief Index of the signals of an .ir file, kept in a <file>.idx sidecar.
+ *        The sidecar is rebuilt in a single pass when the .ir file size or last write changes,
+ *        after that counting and seeking to the Nth signal don't need to parse the file.
+ *        If the sidecar can't be written (read only FS), the index is kept in RAM.
+ */
+class IRFileIndex {
+public:
+    ~IRFileIndex() { end(); }
+
+    bool begin(FS *fs, const String &filepath);
+    void end();
+
+    uint32_t count() const { return header.count; }
+    bool entry(uint32_t n, IRIndexEntry &e);
+    bool load(uint32_t n, IRCode &code);
+
+private:
+    File db;
+    File idx;
+    IRIndexHeader header = {};
+    std::vector<IRIndexEntry> ramEntries;
+
+    bool build(FS *fs, const String &idxPath);
+};
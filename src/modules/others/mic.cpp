@@ -4,16 +4,12 @@
 #include "driver/gpio.h"
 #include "soc/gpio_struct.h"
 #include "soc/io_mux_reg.h"
-#include <esp_heap_caps.h>
+#include "spectrum.h"
 
-#define FFT_SIZE 1024
 #define SPECTRUM_WIDTH 200
-#define SPECTRUM_HEIGHT 124
-#define HISTORY_LEN (SPECTRUM_WIDTH + 1)
 
 static int8_t *i2s_buffer = nullptr;
-static uint8_t *fftHistory = nullptr; // Linear buffer [WIDTH + 1][HEIGHT]
-static uint16_t posData = 0;
+static Spectrum spectrum;
 
 #ifndef PIN_CLK
 #define PIN_CLK I2S_PIN_NO_CHANGE
@@ -71,11 +67,6 @@ const unsigned char ImageData[768] = {
     0xFF, 0xFF, 0xFD,
 };
 
-static inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
-    return (r << (5 + 6)) | (g << 5) | b;
-    // return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-}
-
 bool deinitMicroPhone() {
     esp_err_t err = ESP_OK;
     err |= i2s_driver_uninstall(I2S_NUM_0);
@@ -92,7 +83,7 @@ bool InitI2SMicroPhone() {
         .communication_format = I2S_COMM_FORMAT_STAND_I2S,
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
         .dma_buf_count = 8,
-        .dma_buf_len = SPECTRUM_HEIGHT,
+        .dma_buf_len = SPECTRUM_HOP / 2, // 8 x 256 samples, ~40ms of audio to absorb slow frames
     };
 
     i2s_pin_config_t pin_config = {
@@ -118,14 +109,9 @@ bool InitI2SMicroPhone() {
 void mic_test_one_task() {
     tft.fillScreen(TFT_BLACK);
 
-    // Alloc framebuffer
-    uint16_t *frameBuffer;
-    if (psramFound())
-        frameBuffer = (uint16_t *)ps_malloc(SPECTRUM_WIDTH * SPECTRUM_HEIGHT * sizeof(uint16_t));
-    else frameBuffer = (uint16_t *)malloc(SPECTRUM_WIDTH * SPECTRUM_HEIGHT * sizeof(uint16_t));
-
-    if (!frameBuffer) {
-        Serial.println("Error alloc drawing frameBuffer, exiting");
+    if (!spectrum.begin(ImageData)) {
+        Serial.println("Error alloc FFT buffers, exiting");
+        spectrum.end();
         return;
     }
     tft.drawRect(
@@ -136,52 +122,46 @@ void mic_test_one_task() {
         bruceConfig.priColor
     );
 
+    int x0 = tftWidth / 2 - SPECTRUM_WIDTH / 2;
+    int y0 = tftHeight / 2 - SPECTRUM_HEIGHT / 2;
+    uint16_t column[SPECTRUM_HEIGHT];
+    int16_t *samples = (int16_t *)i2s_buffer;
+    memset(samples, 0, SPECTRUM_FFT_SIZE * sizeof(int16_t));
+    uint16_t posData = 0;
+    uint32_t frames = 0;
+    uint32_t lastReport = millis();
+
     while (1) {
-        fft_config_t *plan = fft_init(FFT_SIZE, FFT_REAL, FFT_FORWARD, NULL, NULL);
+        // keep the newest half of the window, read the other half
+        memmove(samples, samples + SPECTRUM_HOP, SPECTRUM_HOP * sizeof(int16_t));
         size_t bytesread;
-        i2s_read(I2S_NUM_0, (char *)i2s_buffer, FFT_SIZE * sizeof(int16_t), &bytesread, portMAX_DELAY);
-        int16_t *samples = (int16_t *)i2s_buffer;
-
-        for (int i = 0; i < FFT_SIZE; i++) { plan->input[i] = (float)samples[i] / 32768.0f; }
-
-        fft_execute(plan);
-
-        for (int i = 1; i < FFT_SIZE / 4 && i < SPECTRUM_HEIGHT; i++) {
-            float re = plan->output[2 * i];
-            float im = plan->output[2 * i + 1];
-            float mag = re * re + im * im;
-            if (mag > 1.0f) mag = 1.0f;
-            uint8_t value = map(mag * 2000, 0, 2000, 0, 255);
-            fftHistory[posData * SPECTRUM_HEIGHT + (SPECTRUM_HEIGHT - i)] = value;
-        }
+        i2s_read(
+            I2S_NUM_0,
+            (char *)(samples + SPECTRUM_HOP),
+            SPECTRUM_HOP * sizeof(int16_t),
+            &bytesread,
+            portMAX_DELAY
+        );
 
-        posData = (posData + 1) % HISTORY_LEN;
+        spectrum.column(samples, column);
 
-        fft_destroy(plan);
+        // only the new column goes to the screen, sweeping from left to right with a cursor ahead of it
+        tft.pushImage(x0 + posData, y0, 1, SPECTRUM_HEIGHT, column);
+        posData = (posData + 1) % SPECTRUM_WIDTH;
+        tft.drawFastVLine(x0 + posData, y0, SPECTRUM_HEIGHT, bruceConfig.priColor);
 
-        // Render
-        for (int y = 0; y < SPECTRUM_HEIGHT; y++) {
-            for (int x = 0; x < SPECTRUM_WIDTH; x++) {
-                int index = (x + posData) % HISTORY_LEN;
-                uint8_t val = fftHistory[index * SPECTRUM_HEIGHT + y];
-                uint16_t color =
-                    rgb565(ImageData[val * 3 + 0], ImageData[val * 3 + 1], ImageData[val * 3 + 2]);
-                frameBuffer[y * SPECTRUM_WIDTH + x] = color;
-            }
+        frames++;
+        if (millis() - lastReport > 5000) {
+            Serial.printf("Spectrum: %.1f columns/s\n", frames * 1000.0f / (millis() - lastReport));
+            frames = 0;
+            lastReport = millis();
         }
 
-        tft.pushImage(
-            tftWidth / 2 - SPECTRUM_WIDTH / 2,
-            tftHeight / 2 - SPECTRUM_HEIGHT / 2,
-            SPECTRUM_WIDTH,
-            SPECTRUM_HEIGHT,
-            frameBuffer
-        );
         wakeUpScreen();
         if (check(SelPress) || check(EscPress)) break;
     }
     i2s_stop(I2S_NUM_0);
-    free(frameBuffer);
+    spectrum.end();
 }
 
 bool isGPIOOutput(gpio_num_t gpio) {
@@ -206,25 +186,16 @@ void mic_test() {
     }
     Serial.println("Mic Spectrum start");
     InitI2SMicroPhone();
-    // Alloc buffers in PSRAM if available
-    if (psramFound()) {
-        i2s_buffer = (int8_t *)ps_malloc(FFT_SIZE * sizeof(int16_t));
-        fftHistory = (uint8_t *)ps_malloc(HISTORY_LEN * SPECTRUM_HEIGHT);
-    } else {
-        i2s_buffer = (int8_t *)malloc(FFT_SIZE * sizeof(int16_t));
-        fftHistory = (uint8_t *)malloc(HISTORY_LEN * SPECTRUM_HEIGHT);
-    }
-    if (!i2s_buffer || !fftHistory) {
+    // samples are read every frame, internal RAM is faster than PSRAM for it
+    i2s_buffer = (int8_t *)malloc(SPECTRUM_FFT_SIZE * sizeof(int16_t));
+    if (!i2s_buffer) {
         displayError("Fail to alloc buffers, exiting", true);
         return;
     }
 
-    memset(fftHistory, 0, HISTORY_LEN * SPECTRUM_HEIGHT);
-
     mic_test_one_task();
 
     free(i2s_buffer);
-    free(fftHistory);
 
     delay(10);
     if (deinitMicroPhone()) Serial.println("Fail disabling I2S Driver");
@@ -300,8 +271,8 @@ void mic_record() {
     InitI2SMicroPhone();
 
     // Alloc buffers in PSRAM if available
-    if (psramFound()) i2s_buffer = (int8_t *)ps_malloc(FFT_SIZE * sizeof(int16_t));
-    else i2s_buffer = (int8_t *)malloc(FFT_SIZE * sizeof(int16_t));
+    if (psramFound()) i2s_buffer = (int8_t *)ps_malloc(SPECTRUM_FFT_SIZE * sizeof(int16_t));
+    else i2s_buffer = (int8_t *)malloc(SPECTRUM_FFT_SIZE * sizeof(int16_t));
     if (!i2s_buffer) {
         displayError("Fail to alloc buffers, exiting", true);
         return;
@@ -366,7 +337,7 @@ void mic_record() {
 
     unsigned long dataSize = 0;
 
-    int bytesPerRead = FFT_SIZE * sizeof(int16_t);
+    int bytesPerRead = SPECTRUM_FFT_SIZE * sizeof(int16_t);
     unsigned long startMillis = millis();
     if (record_time != 0) {
         displayRedStripe("Recording...", 0xffff, 0x5db9);
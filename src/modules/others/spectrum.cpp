@@ -0,0 +1,78 @@
+#include "spectrum.h"
+#include <esp_heap_caps.h>
+#if __has_include(<esp_dsp.h>)
+#include <esp_dsp.h>
+#define SPECTRUM_USE_ESP_DSP
+#else
+#include <fft.h>
+#endif
+
+static inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return (r << (5 + 6)) | (g << 5) | b;
+    // return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+bool Spectrum::begin(const uint8_t *paletteRgb) {
+    end();
+    fftWindow =
+        (float *)heap_caps_malloc(SPECTRUM_FFT_SIZE * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!fftWindow) return false;
+    // x2 restores the amplitude the window takes out (coherent gain of 0.5)
+    for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+        fftWindow[i] = 2.0f * (0.5f - 0.5f * cosf(2.0f * PI * i / (SPECTRUM_FFT_SIZE - 1))) / 32768.0f;
+    }
+    for (int i = 0; i < 256; i++) {
+        palette[i] = rgb565(paletteRgb[i * 3], paletteRgb[i * 3 + 1], paletteRgb[i * 3 + 2]);
+    }
+
+#ifdef SPECTRUM_USE_ESP_DSP
+    fftBuf = (float *)heap_caps_aligned_alloc(16, 2 * SPECTRUM_FFT_SIZE * sizeof(float), MALLOC_CAP_INTERNAL);
+    if (!fftBuf || dsps_fft2r_init_fc32(NULL, SPECTRUM_FFT_SIZE) != ESP_OK) return false;
+#else
+    fftPlan = fft_init(SPECTRUM_FFT_SIZE, FFT_REAL, FFT_FORWARD, NULL, NULL);
+    if (!fftPlan) return false;
+#endif
+    return true;
+}
+
+void Spectrum::end() {
+#ifdef SPECTRUM_USE_ESP_DSP
+    if (fftBuf) dsps_fft2r_deinit_fc32();
+    heap_caps_free(fftBuf);
+    fftBuf = nullptr;
+#else
+    if (fftPlan) fft_destroy((fft_config_t *)fftPlan);
+    fftPlan = nullptr;
+#endif
+    heap_caps_free(fftWindow);
+    fftWindow = nullptr;
+}
+
+const float *Spectrum::transform(const int16_t *samples) {
+#ifdef SPECTRUM_USE_ESP_DSP
+    for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+        fftBuf[2 * i] = samples[i] * fftWindow[i];
+        fftBuf[2 * i + 1] = 0;
+    }
+    dsps_fft2r_fc32(fftBuf, SPECTRUM_FFT_SIZE);
+    dsps_bit_rev_fc32(fftBuf, SPECTRUM_FFT_SIZE);
+    return fftBuf;
+#else
+    fft_config_t *plan = (fft_config_t *)fftPlan;
+    for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) plan->input[i] = samples[i] * fftWindow[i];
+    fft_execute(plan);
+    return plan->output;
+#endif
+}
+
+void Spectrum::column(const int16_t *samples, uint16_t *column) {
+    const float *out = transform(samples);
+    column[0] = palette[0];
+    for (int i = 1; i < SPECTRUM_FFT_SIZE / 4 && i < SPECTRUM_HEIGHT; i++) {
+        float re = out[2 * i];
+        float im = out[2 * i + 1];
+        float mag = re * re + im * im;
+        if (mag > 1.0f) mag = 1.0f;
+        column[SPECTRUM_HEIGHT - i] = palette[(uint8_t)(mag * 255)];
+    }
+}
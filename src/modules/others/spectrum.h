@@ -0,0 +1,36 @@
+#pragma once
+#include <Arduino.h>
+
+// Spectrogram columns of the mic screen. No I2S or display here, so it also builds on a host
+// ([env:native]: test_spectrum and the benchmarks)
+
+#define SPECTRUM_FFT_SIZE 1024
+#define SPECTRUM_HOP (SPECTRUM_FFT_SIZE / 2) // 50% overlap, each frame reads half a window
+#define SPECTRUM_HEIGHT 124
+
+/**
+ * @brief FFT plan, Hann window and RGB565 palette, built once per session instead of on every frame.
+ *        The FFT runs on esp-dsp's fft2r kernels when esp_dsp.h is available (assembly on ESP32, SIMD
+ *        on S3), on a persistent tinyu-zhao FFT plan otherwise.
+ */
+class Spectrum {
+public:
+    ~Spectrum() { end(); }
+    bool begin(const uint8_t *paletteRgb); // 256 r,g,b triplets
+    void end();
+
+    // Windowed FFT of SPECTRUM_FFT_SIZE samples. Bin k, 1 <= k < SPECTRUM_FFT_SIZE / 2, is
+    // out[2k] + i out[2k + 1]
+    const float *transform(const int16_t *samples);
+    // SPECTRUM_HEIGHT pixels, low frequencies at the bottom
+    void column(const int16_t *samples, uint16_t *column);
+
+    float window(int i) const { return fftWindow[i]; }
+    uint16_t color(uint8_t level) const { return palette[level]; }
+
+private:
+    float *fftWindow = nullptr; // Hann window, with the int16 -> float scale folded in
+    float *fftBuf = nullptr;    // esp-dsp: complex, re/im interleaved
+    void *fftPlan = nullptr;    // tinyu-zhao: fft_config_t
+    uint16_t palette[256];
+};
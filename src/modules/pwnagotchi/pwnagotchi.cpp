@@ -7,6 +7,7 @@ Thanks to thoses developers for their projects:
 Thanks to @bmorcelli for his help doing a better code.
 */
 
+#include "../wifi/pcap_writer.h"
 #include "../wifi/sniffer.h"
 #include "../wifi/wifi_atks.h"
 #include "core/mykeyboard.h"
@@ -102,7 +103,8 @@ void brucegotchi_start() {
     tft.fillScreen(bruceConfig.bgColor);
     num_HS = 0; // restart pwnagotchi counting
     SavedHS.clear();
-    registeredBeacons.clear();          // Clear the registeredBeacon array in case it has something
+    SavedHSBeacons.clear();
+    clearRegisteredBeacons();           // Clear the registeredBeacon array in case it has something
     vTaskDelay(300 / portTICK_RATE_MS); // Due to select button pressed to enter / quit this feature*
 
     brucegotchi_setup(); // Starts the thing
@@ -127,6 +129,7 @@ void brucegotchi_start() {
         if (!LittleFS.exists("/BrucePCAP/handshakes")) LittleFS.mkdir("/BrucePCAP/handshakes");
         isLittleFS = true;
     }
+    pcapWriterBegin(isLittleFS ? (FS *)&LittleFS : (FS *)&SD, nullptr); // handshakes are written by its task
     tmp = millis();
     // LET'S GOOOOO!!!
     while (true) {
@@ -137,9 +140,12 @@ void brucegotchi_start() {
         if (millis() - tmp > (2000 + 1000 * _times) && Deauth_done && !pwgrid_done) {
 
             if (registeredBeacons.size() > 30)
-                registeredBeacons.clear(); // Clear registered beacons to restart search and avoir restarts
+                clearRegisteredBeacons(); // Clear registered beacons to restart search and avoir restarts
             // Serial.println("<<---- Starting Deauthentication Process ---->>");
-            for (auto registeredBeacon : registeredBeacons) {
+            const BeaconList *targets;
+            size_t count = registeredBeaconsOn(ch, targets);
+            for (size_t i = 0; i < count; i++) {
+                const BeaconList &registeredBeacon = targets[i];
                 char _MAC[20];
                 sprintf(
                     _MAC,
@@ -155,13 +161,11 @@ void brucegotchi_start() {
                 //     String(_MAC) + " on ch" + String(registeredBeacon.channel) + " -> we are now on ch " +
                 //     String(ch)
                 // );
-                if (registeredBeacon.channel == ch) {
-                    memcpy(&ap_record.bssid, registeredBeacon.MAC, 6);
-                    wsl_bypasser_send_raw_frame(
-                        &ap_record, registeredBeacon.channel
-                    ); // writes the buffer with the information
-                    send_raw_frame(deauth_frame, 26);
-                }
+                memcpy(&ap_record.bssid, registeredBeacon.MAC, 6);
+                wsl_bypasser_send_raw_frame(
+                    &ap_record, registeredBeacon.channel
+                ); // writes the buffer with the information
+                send_raw_frame(deauth_frame, 26);
                 if (SelPress) break; // stops deauthing if select button is pressed
             }
             // Serial.println("<<---- Stopping Deauthentication Process ---->>");
@@ -206,5 +210,6 @@ void brucegotchi_start() {
     // Turn off WiFi
     esp_wifi_set_promiscuous(false);
     esp_wifi_set_promiscuous_rx_cb(nullptr);
+    pcapWriterEnd(true);
     wifiDisconnect();
 }
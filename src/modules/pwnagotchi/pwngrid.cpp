@@ -252,12 +252,7 @@ void pwnSnifferCallback(void *buf, wifi_promiscuous_pkt_type_t type) {
         } else {
             apAddr = addr2;
         }
-        BeaconList Beacon;
-        memcpy(Beacon.MAC, apAddr, 6);
-        Beacon.channel = ch;
-        if (registeredBeacons.find(Beacon) == registeredBeacons.end()) {
-            registeredBeacons.insert(Beacon); // Save a new MAC to Deauth
-        }
+        registerBeacon(apAddr, ch); // Save a new MAC to Deauth
     }
 
     String src = "";
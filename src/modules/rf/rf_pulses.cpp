@@ -0,0 +1,54 @@
+#include "rf_pulses.h"
+#include <cstdlib>
+
+// CRC-64-ECMA constants
+const uint64_t CRC64_ECMA_POLY = 0x42F0E1EBA9EA3693; // Polynomial for CRC-64-ECMA
+const uint64_t CRC64_ECMA_INIT = 0xFFFFFFFFFFFFFFFF; // Initial value
+
+int find_pulse_index(const std::vector<int> &indexed_durations, int duration) {
+    int abs_duration = abs(duration);
+    int closest_index = -1;
+    int closest_diff = 999999; // Large number to find minimum difference
+
+    for (size_t i = 0; i < indexed_durations.size(); i++) {
+        int diff = abs(indexed_durations[i] - abs_duration);
+        if (diff <= 50) { // ±50µs tolerance
+            return i;     // Found a close match, return its index
+        }
+        if (diff < closest_diff) {
+            closest_diff = diff;
+            closest_index = i; // Store closest match
+        }
+    }
+
+    // If there's space for a new duration, return -1 to signal adding it
+    if (indexed_durations.size() < 4) { return -1; }
+
+    return closest_index; // Otherwise, return the closest match
+}
+
+// The 8 shifts of each byte precomputed once (2 KB), one lookup per pulse instead of a bit loop
+struct Crc64Table {
+    uint64_t t[256];
+    Crc64Table() {
+        for (int n = 0; n < 256; n++) {
+            uint64_t crc = (uint64_t)n << 56;
+            for (int i = 0; i < 8; i++) {
+                if (crc & 0x8000000000000000) crc = (crc << 1) ^ CRC64_ECMA_POLY;
+                else crc <<= 1;
+            }
+            t[n] = crc;
+        }
+    }
+};
+
+// Function to compute CRC-64-ECMA
+uint64_t crc64_ecma(const std::vector<int> &data) {
+    static const Crc64Table table;
+    uint64_t crc = CRC64_ECMA_INIT;
+
+    // Each value is used as the high byte, only its low 8 bits count
+    for (int value : data) crc = table.t[((crc >> 56) ^ (uint8_t)value) & 0xFF] ^ (crc << 8);
+
+    return crc;
+}
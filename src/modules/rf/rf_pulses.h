@@ -0,0 +1,13 @@
+#ifndef __RF_PULSES_H__
+#define __RF_PULSES_H__
+
+// Pulse bookkeeping for the RF scanner. Only the standard library here, no Arduino or radio code,
+// so it builds and can be timed on any host compiler as well.
+
+#include <cstdint>
+#include <vector>
+
+int find_pulse_index(const std::vector<int> &indexed_durations, int duration);
+uint64_t crc64_ecma(const std::vector<int> &data);
+
+#endif
@@ -1,8 +1,14 @@
 #include "rf_send.h"
 #include "core/type_convertion.h"
 #include "rf_utils.h"
+#include "sub_file.h"
 #include <RCSwitch.h>
 
+static bool beginRfTx(const RfCodes &rfcode, int &rcswitch_protocol_no);
+static void sendRfSignal(RfCodes &rfcode, int rcswitch_protocol_no);
+static void rcswitchTransmit(uint64_t data, unsigned int bits, int pulse, int protocol, int repeat);
+static void sendRawPulses(const int *pulses, size_t count);
+
 void sendCustomRF() {
     // interactive menu part only
     FS *fs = NULL;
@@ -37,87 +43,81 @@ void sendCustomRF() {
 
 bool txSubFile(FS *fs, String filepath) {
     struct RfCodes selected_code;
-    File databaseFile;
-    String line;
-    String txt;
+    SubFile sub;
     int sent = 0;
 
     if (!fs) return false;
 
-    databaseFile = fs->open(filepath, FILE_READ);
     drawMainBorder();
 
-    if (!databaseFile) {
+    uint32_t start = millis();
+    if (!sub.load(fs, filepath)) {
         Serial.println("Failed to open database file.");
         displayError("Fail to open file", true);
         return false;
     }
     Serial.println("Opened sub file.");
     selected_code.filepath = filepath.substring(1 + filepath.lastIndexOf("/"));
-
-    std::vector<int> bitList;
-    std::vector<int> bitRawList;
-    std::vector<uint64_t> keyList;
-    std::vector<String> rawDataList;
-
-    if (!databaseFile) Serial.println("Fail opening file");
-    // Store the code(s) in the signal
-    while (databaseFile.available()) {
-        line = databaseFile.readStringUntil('\n');
-        txt = line.substring(line.indexOf(":") + 1);
-        if (txt.endsWith("\r")) txt.remove(txt.length() - 1);
-        txt.trim();
-        if (line.startsWith("Protocol:")) selected_code.protocol = txt;
-        if (line.startsWith("Preset:")) selected_code.preset = txt;
-        if (line.startsWith("Frequency:")) selected_code.frequency = txt.toInt();
-        if (line.startsWith("TE:")) selected_code.te = txt.toInt();
-        if (line.startsWith("Bit:")) bitList.push_back(txt.toInt()); // selected_code.Bit = txt.toInt();
-        if (line.startsWith("Bit_RAW:"))
-            bitRawList.push_back(txt.toInt()); // selected_code.BitRAW = txt.toInt();
-        if (line.startsWith("Key:"))
-            keyList.push_back(hexStringToDecimal(txt.c_str())
-            ); // selected_code.key = hexStringToDecimal(txt.c_str());
-        if (line.startsWith("RAW_Data:") || line.startsWith("Data_RAW:"))
-            rawDataList.push_back(txt); // selected_code.data = txt;
-        if (check(EscPress)) break;
-    }
-    int total = bitList.size() + bitRawList.size() + keyList.size() + rawDataList.size() > 0 ? 1 : 0;
-    Serial.printf("Total signals found: %d\n", total);
-    databaseFile.close();
+    selected_code.protocol = sub.protocol;
+    selected_code.preset = sub.preset;
+    selected_code.frequency = sub.frequency;
+    selected_code.te = sub.te;
+
+    int total = sub.signals.size();
+    Serial.printf(
+        "Total signals found: %d, %lu pulses parsed in %lums\n",
+        total,
+        (unsigned long)sub.pulseCount(),
+        (unsigned long)(millis() - start)
+    );
 
     // If the signal is complete, send all of the code(s) that were found in it.
-    // TODO: try to minimize the overhead between codes.
-    if (selected_code.protocol != "" && selected_code.preset != "" && selected_code.frequency > 0) {
-        for (int bit : bitList) {
-            selected_code.Bit = bit;
-            sendRfCommand(selected_code);
-            sent++;
-            if (check(EscPress)) break;
-            displayTextLine("Sent " + String(sent) + "/" + String(total));
-        }
-        for (int bitRaw : bitRawList) {
-            selected_code.Bit = bitRaw;
-            sendRfCommand(selected_code);
-            sent++;
-            if (check(EscPress)) break;
-            displayTextLine("Sent " + String(sent) + "/" + String(total));
-        }
-        for (uint64_t key : keyList) {
-            selected_code.key = key;
-            sendRfCommand(selected_code);
+    // The module is set up once for the whole file, so there's no init between codes
+    int rcswitch_protocol_no;
+    if (selected_code.protocol != "" && selected_code.preset != "" && selected_code.frequency > 0 &&
+        total > 0 && beginRfTx(selected_code, rcswitch_protocol_no)) {
+        Serial.printf("First transmission after %lums\n", (unsigned long)(millis() - start));
+        for (const SubSignal &signal : sub.signals) {
+            const int *pulses = sub.pulses(signal);
+            if (signal.type == SUB_SIGNAL_KEY) {
+                selected_code.key = signal.key;
+                selected_code.Bit = signal.bits;
+                sendRfSignal(selected_code, rcswitch_protocol_no);
+            } else if (signal.type == SUB_SIGNAL_RAW) {
+                displayTextLine("Sending..");
+                sendRawPulses(pulses, signal.count);
+            } else {
+                selected_code.data = "";
+                selected_code.data.reserve(signal.count * 8);
+                for (uint32_t i = 0; i < signal.count; i++) {
+                    for (int j = 7; j >= 0; j--) selected_code.data += (pulses[i] & (1 << j)) ? '1' : '0';
+                }
+                selected_code.Bit = signal.bits;
+                RCSwitch_RAW_Bit_send(selected_code);
+            }
             sent++;
             if (check(EscPress)) break;
             displayTextLine("Sent " + String(sent) + "/" + String(total));
         }
-
-        // RAS_Data is considered one long signal, doesn't matter the number of lines it has
-        if (rawDataList.size() > 0) sent++;
-        for (String rawData : rawDataList) {
-            selected_code.data = rawData;
-            sendRfCommand(selected_code);
-            // sent++;
-            if (check(EscPress)) break;
-            // displayTextLine("Sent " + String(sent) + "/" + String(total));
+        deinitRfModule();
+
+        // recent codes replay through sendRfCommand, which takes RAW signals as text
+        const SubSignal &last = sub.signals.back();
+        if (last.type == SUB_SIGNAL_RAW) {
+            const int *pulses = sub.pulses(last);
+            selected_code.data = "";
+            selected_code.data.reserve(last.count * 6);
+            for (uint32_t i = 0; i < last.count; i++) {
+                if (i) selected_code.data += ' ';
+                selected_code.data += pulses[i];
+            }
+        } else if (last.type == SUB_SIGNAL_BINRAW) {
+            selected_code.data = "";
+            for (uint32_t i = 0; i < last.count; i++) {
+                char hex[4];
+                snprintf(hex, sizeof(hex), i ? " %02X" : "%02X", sub.pulses(last)[i]);
+                selected_code.data += hex;
+            }
         }
         addToRecentCodes(selected_code);
     }
@@ -125,27 +125,16 @@ bool txSubFile(FS *fs, String filepath) {
     Serial.printf("\nSent %d of %d signals\n", sent, total);
     displayTextLine("Sent " + String(sent) + "/" + String(total), true);
 
-    // Clear the vectors from memory
-    bitList.clear();
-    bitRawList.clear();
-    keyList.clear();
-    rawDataList.clear();
-    bitList.shrink_to_fit();
-    bitRawList.shrink_to_fit();
-    keyList.shrink_to_fit();
-    rawDataList.shrink_to_fit();
-
+    sub.end();
     delay(1000);
     deinitRfModule();
     return true;
 }
 
-void sendRfCommand(struct RfCodes rfcode) {
+// Sets the module up for the preset of the code, returns false if it's not supported
+static bool beginRfTx(const RfCodes &rfcode, int &rcswitch_protocol_no) {
     uint32_t frequency = rfcode.frequency;
-    String protocol = rfcode.protocol;
-    String preset = rfcode.preset;
-    String data = rfcode.data;
-    uint64_t key = rfcode.key;
+    const String &preset = rfcode.preset;
     byte modulation = 2; // possible values for CC1101: 0 = 2-FSK, 1 =GFSK, 2=ASK, 3 = 4-FSK, 4 = MSK
     float deviation = 1.58;
     float rxBW = 270.83; // Receive bandwidth
@@ -170,7 +159,7 @@ void sendRfCommand(struct RfCodes rfcode) {
         FuriHalSubGhzPresetCustom, //Custom Preset
     */
     // struct Protocol rcswitch_protocol;
-    int rcswitch_protocol_no = 1;
+    rcswitch_protocol_no = 1;
     if (preset == "FuriHalSubGhzPresetOok270Async") {
         rcswitch_protocol_no = 1;
         //  pulseLength , syncFactor , zero , one, invertedSignal
@@ -209,12 +198,12 @@ void sendRfCommand(struct RfCodes rfcode) {
         if (!found) {
             Serial.print("unsupported preset: ");
             Serial.println(preset);
-            return;
+            return false;
         }
     }
 
     // init transmitter
-    if (!initRfModule("", frequency / 1000000.0)) return;
+    if (!initRfModule("", frequency / 1000000.0)) return false;
     if (bruceConfig.rfModule == CC1101_SPI_MODULE) { // CC1101 in use
         // derived from
         // https://github.com/LSatan/SmartRC-CC1101-Driver-Lib/blob/master/examples/Rc-Switch%20examples%20cc1101/SendDemo_cc1101/SendDemo_cc1101.ino
@@ -238,41 +227,37 @@ void sendRfCommand(struct RfCodes rfcode) {
         if (modulation != 2) {
             Serial.print("unsupported modulation: ");
             Serial.println(modulation);
-            return;
+            return false;
         }
         initRfModule("tx", frequency / 1000000.0);
     }
+    return true;
+}
 
+// Sends a code through a module already set up by beginRfTx
+static void sendRfSignal(RfCodes &rfcode, int rcswitch_protocol_no) {
+    const String &protocol = rfcode.protocol;
     if (protocol == "RAW") {
         // count the number of elements of RAW_Data
-        int buff_size = 0;
-        int index = 0;
-        while (index >= 0) {
-            index = data.indexOf(' ', index + 1);
-            buff_size++;
-        }
-        // alloc buffer for transmittimings
-        int *transmittimings =
-            (int *)calloc(sizeof(int), buff_size + 1); // should be smaller the data.length()
-        size_t transmittimings_idx = 0;
-
-        // split data into words, convert to int, and store them in transmittimings
-        int startIndex = 0;
-        index = 0;
-        for (transmittimings_idx = 0; transmittimings_idx < buff_size; transmittimings_idx++) {
-            index = data.indexOf(' ', startIndex);
-            if (index == -1) {
-                transmittimings[transmittimings_idx] = data.substring(startIndex).toInt();
-            } else {
-                transmittimings[transmittimings_idx] = data.substring(startIndex, index).toInt();
-            }
-            startIndex = index + 1;
+        const char *p = rfcode.data.c_str();
+        size_t buff_size = 1;
+        for (const char *c = p; *c; c++) buff_size += *c == ' ';
+        int *transmittimings = (int *)malloc(sizeof(int) * buff_size);
+        if (!transmittimings) return;
+
+        // convert the words straight from the string, no substrings
+        size_t count = 0;
+        char *next;
+        while (count < buff_size) {
+            long v = strtol(p, &next, 10);
+            if (next == p) break;
+            if (v) transmittimings[count++] = v;
+            p = next;
         }
-        transmittimings[transmittimings_idx] = 0; // termination
 
         // send rf command
         displayTextLine("Sending..");
-        RCSwitch_RAW_send(transmittimings);
+        sendRawPulses(transmittimings, count);
         free(transmittimings);
     } else if (protocol == "BinRAW") {
         // transform from "00 01 02 ... FF" into "00000000 00000001 00000010 .... 11111111"
@@ -283,7 +268,6 @@ void sendRfCommand(struct RfCodes rfcode) {
     }
 
     else if (protocol == "RcSwitch") {
-        data.replace(" ", ""); // remove spaces
         // uint64_t data_val = strtoul(data.c_str(), nullptr, 16);
         uint64_t data_val = rfcode.key;
         int bits = rfcode.Bit;
@@ -297,25 +281,30 @@ void sendRfCommand(struct RfCodes rfcode) {
         Serial.println(rcswitch_protocol_no);
         */
         displayTextLine("Sending..");
-        RCSwitch_send(data_val, bits, pulse, rcswitch_protocol_no, repeat);
+        rcswitchTransmit(data_val, bits, pulse, rcswitch_protocol_no, repeat);
     } else if (protocol.startsWith("Princeton")) {
-        RCSwitch_send(rfcode.key, rfcode.Bit, 350, 1, 10);
+        rcswitchTransmit(rfcode.key, rfcode.Bit, 350, 1, 10);
     } else {
         Serial.print("unsupported protocol: ");
         Serial.println(protocol);
         Serial.println("Sending RcSwitch 11 protocol");
         // if(protocol.startsWith("CAME") || protocol.startsWith("HOLTEC" || NICE)) {
-        RCSwitch_send(rfcode.key, rfcode.Bit, 270, 11, 10);
+        rcswitchTransmit(rfcode.key, rfcode.Bit, 270, 11, 10);
         //}
-
-        return;
     }
+}
+
+void sendRfCommand(struct RfCodes rfcode) {
+    int rcswitch_protocol_no;
+    if (!beginRfTx(rfcode, rcswitch_protocol_no)) return;
+    sendRfSignal(rfcode, rcswitch_protocol_no);
 
     // digitalWrite(bruceConfig.rfTx, LED_OFF);
     deinitRfModule();
 }
 
-void RCSwitch_send(uint64_t data, unsigned int bits, int pulse, int protocol, int repeat) {
+// Same as RCSwitch_send, but leaves the module on for the next code
+static void rcswitchTransmit(uint64_t data, unsigned int bits, int pulse, int protocol, int repeat) {
     // derived from
     // https://github.com/LSatan/SmartRC-CC1101-Driver-Lib/blob/master/examples/Rc-Switch%20examples%20cc1101/SendDemo_cc1101/SendDemo_cc1101.ino
 
@@ -341,7 +330,10 @@ void RCSwitch_send(uint64_t data, unsigned int bits, int pulse, int protocol, in
     */
 
     mySwitch.disableTransmit();
+}
 
+void RCSwitch_send(uint64_t data, unsigned int bits, int pulse, int protocol, int repeat) {
+    rcswitchTransmit(data, bits, pulse, protocol, repeat);
     deinitRfModule();
 }
 
@@ -381,38 +373,24 @@ void RCSwitch_RAW_Bit_send(RfCodes data) {
     }
 }
 
-void RCSwitch_RAW_send(int *ptrtransmittimings) {
+// Pulses in us, positive = high, negative = low
+static void sendRawPulses(const int *pulses, size_t count) {
     int nTransmitterPin = bruceConfig.rfTx;
     if (bruceConfig.rfModule == CC1101_SPI_MODULE) { nTransmitterPin = bruceConfigPins.CC1101_bus.io0; }
 
-    if (!ptrtransmittimings) return;
-
-    bool currentlogiclevel = true;
-    int nRepeatTransmit = 1; // repeats RAW signal twice!
-    // HighLow pulses ;
-
-    for (int nRepeat = 0; nRepeat < nRepeatTransmit; nRepeat++) {
-        unsigned int currenttiming = 0;
-        while (ptrtransmittimings[currenttiming]) { // && currenttiming < RCSWITCH_MAX_CHANGES
-            if (ptrtransmittimings[currenttiming] >= 0) {
-                currentlogiclevel = true;
-            } else {
-                // negative value
-                currentlogiclevel = false;
-                ptrtransmittimings[currenttiming] = (-1) * ptrtransmittimings[currenttiming]; // invert sign
-            }
+    if (!pulses) return;
 
-            digitalWrite(nTransmitterPin, currentlogiclevel ? HIGH : LOW);
-            delayMicroseconds(ptrtransmittimings[currenttiming]);
+    for (size_t i = 0; i < count; i++) {
+        digitalWrite(nTransmitterPin, pulses[i] >= 0 ? HIGH : LOW);
+        delayMicroseconds(abs(pulses[i]));
+    }
+    digitalWrite(nTransmitterPin, LOW);
+}
 
-            /*
-            Serial.print(ptrtransmittimings[currenttiming]);
-            Serial.print("=");
-            Serial.println(currentlogiclevel);
-            */
+void RCSwitch_RAW_send(int *ptrtransmittimings) {
+    if (!ptrtransmittimings) return;
 
-            currenttiming++;
-        }
-        digitalWrite(nTransmitterPin, LOW);
-    } // end for
+    size_t count = 0;
+    while (ptrtransmittimings[count]) count++; // 0 terminated
+    sendRawPulses(ptrtransmittimings, count);
 }
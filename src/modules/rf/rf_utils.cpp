@@ -1,10 +1,6 @@
 #include "rf_utils.h"
 #include "core/settings.h"
 
-// CRC-64-ECMA constants
-const uint64_t CRC64_ECMA_POLY = 0x42F0E1EBA9EA3693; // Polynomial for CRC-64-ECMA
-const uint64_t CRC64_ECMA_INIT = 0xFFFFFFFFFFFFFFFF; // Initial value
-
 const int range_limits[4][2] = {
     {0,  23}, // 300-348 MHz
     {24, 47}, // 387-464 MHz
@@ -308,46 +304,6 @@ void setMHZ(float frequency) {
     ELECHOUSE_cc1101.setMHZ(frequency);
 }
 
-int find_pulse_index(const std::vector<int> &indexed_durations, int duration) {
-    int abs_duration = abs(duration);
-    int closest_index = -1;
-    int closest_diff = 999999; // Large number to find minimum difference
-
-    for (size_t i = 0; i < indexed_durations.size(); i++) {
-        int diff = abs(indexed_durations[i] - abs_duration);
-        if (diff <= 50) { // ±50µs tolerance
-            return i;     // Found a close match, return its index
-        }
-        if (diff < closest_diff) {
-            closest_diff = diff;
-            closest_index = i; // Store closest match
-        }
-    }
-
-    // If there's space for a new duration, return -1 to signal adding it
-    if (indexed_durations.size() < 4) { return -1; }
-
-    return closest_index; // Otherwise, return the closest match
-}
-
-// Function to compute CRC-64-ECMA
-uint64_t crc64_ecma(const std::vector<int> &data) {
-    uint64_t crc = CRC64_ECMA_INIT;
-
-    for (int value : data) {
-        crc ^= (uint64_t)value << 56; // Use the value as the high byte
-        for (int i = 0; i < 8; i++) {
-            if (crc & 0x8000000000000000) {
-                crc = (crc << 1) ^ CRC64_ECMA_POLY;
-            } else {
-                crc <<= 1;
-            }
-        }
-    }
-
-    return crc;
-}
-
 void addToRecentCodes(struct RfCodes rfcode) {
     // copy rfcode -> recent_rfcodes[recent_rfcodes_last_used]
     recent_rfcodes[recent_rfcodes_last_used] = rfcode;
@@ -1,6 +1,7 @@
 #ifndef __RF_UTILS_H__
 #define __RF_UTILS_H__
 
+#include "rf_pulses.h"
 #include "structs.h"
 #include <ELECHOUSE_CC1101_SRC_DRV.h>
 
@@ -24,8 +25,6 @@ void initRMT();
 void deinitRMT();
 
 void setMHZ(float frequency);
-int find_pulse_index(const std::vector<int> &indexed_durations, int duration);
-uint64_t crc64_ecma(const std::vector<int> &data);
 
 void addToRecentCodes(struct RfCodes rfcode);
 struct RfCodes selectRecentRfMenu();
@@ -1,9 +1,34 @@
 #include "rf_waterfall.h"
+#include "core/bus_lock.h"
 #ifndef TFT_MOSI
 #define TFT_MOSI -1
 #endif
+#define WATERFALL_RING_ROWS 8 // must be a power of two
+
 float m_rf_waterfall_start_freq = 433.0;
 float m_rf_waterfall_end_freq = 435.0;
+WaterfallSettings m_rf_waterfall_settings = {0, 100, 2, false, false};
+
+struct WaterfallRow {
+    uint32_t ms;
+    float fStart;
+    float fEnd;
+    uint16_t bins;
+    int8_t rssi[WATERFALL_MAX_BINS];
+};
+
+// Sweep task -> UI ring, single producer / single consumer
+static WaterfallRow *rows = nullptr;
+static uint32_t rowHead = 0; // free running, written by the sweep task only
+static uint32_t rowTail = 0; // free running, written by the UI only
+static TaskHandle_t sweepTask = NULL;
+static volatile bool sweepStop = false;
+static volatile bool sweepDone = true;
+static volatile float sweepFrom;
+static volatile float sweepTo;
+static volatile uint16_t sweepBins;
+static volatile uint32_t sweepCount = 0;
+static volatile uint32_t sweepStalls = 0;
 
 void rf_waterfall() {
     if (bruceConfig.rfModule != CC1101_SPI_MODULE) {
@@ -23,6 +48,7 @@ select:
     options = {
         {"Start Freq.", [&]() { option = 1; }},
         {"End Freq.",   [&]() { option = 2; }},
+        {"Settings",    [&]() { option = 5; }},
         {"Start",       [&]() { option = 3; }},
         {"Main Menu",   [&]() { option = 4; }},
     };
@@ -41,6 +67,9 @@ select:
     } else if (option == 2) {
         rf_waterfall_end_freq();
         goto select;
+    } else if (option == 5) {
+        rf_waterfall_settings();
+        goto select;
     }
 }
 
@@ -68,15 +97,176 @@ void rf_waterfall_end_freq() {
     options.clear();
 }
 
+void rf_waterfall_settings() {
+    WaterfallSettings &st = m_rf_waterfall_settings;
+    for (;;) {
+        int option = 0;
+        options = {
+            {"Bins: " + (st.bins ? String(st.bins) : String("screen")), [&]() { option = 1; }},
+            {"Dwell: " + String(st.dwellUs) + "us",                     [&]() { option = 2; }},
+            {"Samples: " + String(st.samples),                          [&]() { option = 3; }},
+            {st.maxHold ? "Mode: Max hold" : "Mode: Average",           [&]() { option = 4; }},
+            {st.record ? "Record: ON" : "Record: OFF",                  [&]() { option = 5; }},
+            {"Back",                                                    [&]() { option = 0; }},
+        };
+        loopOptions(options);
+        options.clear();
+
+        // each option cycles through its values
+        if (option == 1) st.bins = st.bins == 0 ? 64 : st.bins == 64 ? 128 : 0;
+        else if (option == 2) st.dwellUs = st.dwellUs >= 500 ? 50 : st.dwellUs * 2;
+        else if (option == 3) st.samples = st.samples >= 8 ? 1 : st.samples * 2;
+        else if (option == 4) st.maxHold = !st.maxHold;
+        else if (option == 5) st.record = !st.record;
+        else return;
+    }
+}
+
 uint16_t swapBytes(uint16_t c) { return (c >> 8) | (c << 8); }
 
+/////////////////////////////////////////////////////////////////////////////////////
+// Sweep engine
+/////////////////////////////////////////////////////////////////////////////////////
+
+static void sweepTaskLoop(void *pvParameters) {
+    WaterfallSettings st = m_rf_waterfall_settings;
+    bool sharedBus = bruceConfigPins.CC1101_bus.mosi == TFT_MOSI;
+    uint16_t dwell = st.dwellUs + (sharedBus ? 50 : 0); // T-Embed case, need more time to process
+    uint8_t samples = st.samples ? st.samples : 1;
+
+    while (!sweepStop) {
+        uint32_t head = rowHead;
+        if (head - __atomic_load_n(&rowTail, __ATOMIC_ACQUIRE) >= WATERFALL_RING_ROWS) {
+            sweepStalls++; // UI is behind, wait instead of overwriting rows it may be reading
+            vTaskDelay(1);
+            continue;
+        }
+
+        WaterfallRow &row = rows[head & (WATERFALL_RING_ROWS - 1)];
+        row.fStart = sweepFrom;
+        row.fEnd = sweepTo;
+        row.bins = sweepBins;
+        float step = (row.fEnd - row.fStart) / row.bins;
+
+        for (int i = 0; i < row.bins && !sweepStop; i++) {
+            busLock();
+            setMHZ(row.fStart + i * step);
+            int acc = st.maxHold ? -128 : 0;
+            // first read waits for the PLL to settle, the next ones only for a new RSSI
+            for (int n = 0; n < samples; n++) {
+                delayMicroseconds(n == 0 ? dwell : 20);
+                int r = ELECHOUSE_cc1101.getRssi();
+                if (st.maxHold) acc = max(acc, r);
+                else acc += r;
+            }
+            // The lock only keeps the UI off the bus. A TFT call after the CC1101 is still needed
+            // to put the bus back in the display's settings (T-Embed)
+            if (sharedBus) tft.drawPixel(0, 0, 0);
+            busUnlock();
+            row.rssi[i] = constrain(st.maxHold ? acc : acc / samples, -128, 0);
+        }
+        row.ms = millis();
+
+        __atomic_store_n(&rowHead, head + 1, __ATOMIC_RELEASE);
+        sweepCount++;
+        vTaskDelay(1); // let the UI and the idle task run
+    }
+    sweepDone = true;
+    vTaskDelete(NULL);
+}
+
+static bool sweepBegin(float f_start, float f_end, uint16_t bins) {
+    if (!rows) rows = (WaterfallRow *)malloc(WATERFALL_RING_ROWS * sizeof(WaterfallRow));
+    if (!rows) return false;
+
+    rowHead = 0;
+    rowTail = 0;
+    sweepFrom = f_start;
+    sweepTo = f_end;
+    sweepBins = bins;
+    sweepCount = 0;
+    sweepStalls = 0;
+    sweepStop = false;
+    sweepDone = false;
+    if (xTaskCreate(sweepTaskLoop, "RfWaterfall", 4096, NULL, 1, &sweepTask) != pdPASS) {
+        sweepTask = NULL;
+        sweepDone = true;
+        return false;
+    }
+    return true;
+}
+
+static void sweepEnd() {
+    sweepStop = true;
+    while (!sweepDone) vTaskDelay(5 / portTICK_PERIOD_MS);
+    sweepTask = NULL;
+    free(rows);
+    rows = nullptr;
+}
+
+static bool sweepPop(WaterfallRow *&row) {
+    uint32_t tail = rowTail;
+    if (tail == __atomic_load_n(&rowHead, __ATOMIC_ACQUIRE)) return false;
+    row = &rows[tail & (WATERFALL_RING_ROWS - 1)];
+    return true;
+}
+
+static void sweepRelease() { __atomic_store_n(&rowTail, rowTail + 1, __ATOMIC_RELEASE); }
+
+static File openRecording() {
+    FS *fs;
+    if (!getFsStorage(fs)) return File();
+    if (!fs->exists("/BruceRF")) fs->mkdir("/BruceRF");
+
+    char filename[40];
+    int index = 0;
+    do {
+        snprintf(filename, sizeof(filename), "/BruceRF/waterfall_%d.bin", index++);
+    } while (fs->exists(filename));
+
+    File file = fs->open(filename, FILE_WRITE);
+    if (file) {
+        uint32_t magic = WATERFALL_REC_MAGIC;
+        file.write((uint8_t *)&magic, sizeof(magic));
+        Serial.printf("Waterfall recording to %s\n", filename);
+    }
+    return file;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// UI
+/////////////////////////////////////////////////////////////////////////////////////
+
 void rf_waterfall_run() {
     float f_start = m_rf_waterfall_start_freq;
     float f_end = m_rf_waterfall_end_freq;
     const int screen_width = tft.width();
     const int screen_height = tft.height();
     const int display_top = screen_height / 5;
-    float f_freq_step;
+    uint16_t bins = m_rf_waterfall_settings.bins ? m_rf_waterfall_settings.bins : screen_width;
+    if (bins > WATERFALL_MAX_BINS) bins = WATERFALL_MAX_BINS;
+
+    // rssi -> color, built once, same scale as before (-100 blue .. -30 red)
+    uint16_t palette[129];
+    for (int rssi = -128; rssi <= 0; rssi++) {
+        int rawLevel = map(rssi, -100, -30, 0, 255);
+        int level = 255 - constrain(rawLevel, 0, 255);
+
+        uint8_t r = 0, g = 0, b = 0;
+        if (level <= 63) {
+            b = map(level, 0, 63, 64, 255);
+        } else if (level <= 127) {
+            g = map(level, 64, 127, 0, 255);
+            b = map(level, 64, 127, 255, 0);
+        } else if (level <= 191) {
+            r = map(level, 128, 191, 0, 255);
+            g = 255;
+        } else {
+            r = 255;
+            g = map(level, 192, 255, 255, 0);
+        }
+        palette[rssi + 128] = swapBytes(tft.color565(r, g, b));
+    }
 
     // Alloc framebuffer
     uint16_t frameBuffer[screen_width] = {0};
@@ -84,40 +274,26 @@ void rf_waterfall_run() {
     int current_line = display_top;
     initRfModule("rx", f_start);
 
+    if (!sweepBegin(f_start, f_end, bins)) {
+        displayError("Fail starting the sweep", true);
+        deinitRfModule();
+        return;
+    }
+    File recording;
+    if (m_rf_waterfall_settings.record) recording = openRecording();
+
     float max_freq = f_start;
-    int max_rssi = -100;
+    int max_rssi = -128;
     unsigned long lastMaxUpdate = millis();
+    unsigned long lastRateUpdate = millis();
+    uint32_t lastSweepCount = 0;
 
     tft.fillRect(0, 0, screen_width, display_top, TFT_BLACK);
 
     int selected_item = 0;
-    bool exitting = false;
-    unsigned long exit_time = 0;
+    bool redrawHeader = true;
 
     while (1) {
-        for (int i = 0; i < 4; i++) {
-            int x = i * (screen_width / 4);
-            float f_freq = f_start + (f_end - f_start) * i / 4.0;
-            tft.setCursor(x, 0);
-            tft.setTextSize(1);
-
-            if (i == 0 && selected_item == 0) {
-                tft.setTextColor(TFT_PINK, TFT_BLACK);
-            } else if (i == 3 && selected_item == 1) {
-                tft.setTextColor(TFT_PINK, TFT_BLACK);
-            } else {
-                tft.setTextColor(TFT_WHITE, TFT_BLACK);
-            }
-
-            tft.drawFastVLine(x, 0, tft.height(), TFT_DARKGREY);
-            tft.print(String(f_freq, 1));
-        }
-
-        f_freq_step = (f_end - f_start) / screen_width;
-
-        float temp_max_freq = f_start;
-        int temp_max_rssi = -100;
-
         float range = abs(f_end - f_start);
         float step;
 
@@ -127,96 +303,130 @@ void rf_waterfall_run() {
         else if (range > 0.1) step = 0.01;
         else step = 0.001;
 
-        for (int i = 0; i < screen_width; ++i) {
-            float f_freq = f_start + i * f_freq_step;
-            setMHZ(f_freq);
-            // To make sure CC1101 shared with TFT works properly on T-Embed
-            if (bruceConfigPins.CC1101_bus.mosi == TFT_MOSI) {
-                tft.drawPixel(0, 0, 0);
-                delayMicroseconds(150); // T-Embed case, need more time to process
-            } else delayMicroseconds(100);
-
-            int i_rssi = ELECHOUSE_cc1101.getRssi();
-            // To make sure CC1101 shared with TFT works properly on T-Embed
-            if (bruceConfigPins.CC1101_bus.mosi == TFT_MOSI) tft.drawPixel(0, 0, 0);
-            if (i_rssi > temp_max_rssi) {
-                temp_max_rssi = i_rssi;
-                temp_max_freq = f_freq;
-            }
+        if (check(SelPress)) {
+            selected_item++;
+            if (selected_item > 2) selected_item = 0;
+            redrawHeader = true;
+        }
 
-            int rawLevel = map(i_rssi, -100, -30, 0, 255);
-            int level = 255 - constrain(rawLevel, 0, 255);
-
-            uint8_t r = 0, g = 0, b = 0;
-            if (level <= 63) {
-                b = map(level, 0, 63, 64, 255);
-            } else if (level <= 127) {
-                g = map(level, 64, 127, 0, 255);
-                b = map(level, 64, 127, 255, 0);
-            } else if (level <= 191) {
-                r = map(level, 128, 191, 0, 255);
-                g = 255;
-            } else {
-                r = 255;
-                g = map(level, 192, 255, 255, 0);
+        if (check(UpPress) || check(NextPress)) {
+            switch (selected_item) {
+                case 0: f_start += step; break;
+                case 1: f_end += step; break;
+                case 2: goto finish;
             }
-
-            uint16_t color = tft.color565(r, g, b);
-            frameBuffer[i] = swapBytes(color);
-            if (check(SelPress)) {
-                selected_item++;
-                if (selected_item > 2) selected_item = 0;
+            redrawHeader = true;
+        } else if (check(DownPress) || check(PrevPress)) {
+            switch (selected_item) {
+                case 0: f_start -= step; break;
+                case 1: f_end -= step; break;
+                case 2: goto finish;
             }
+            if (EscPress) EscPress = false; // Reset for StickCs
+            redrawHeader = true;
+        }
+        if (check(EscPress)) break;
 
-            if (check(UpPress) || check(NextPress)) {
-                switch (selected_item) {
-                    case 0: f_start += step; break;
-                    case 1: f_end += step; break;
-                    case 2: return;
+        // labels only change with the range or the selection, no need to draw them every sweep
+        if (redrawHeader) {
+            sweepFrom = f_start;
+            sweepTo = f_end;
+            busLock();
+            tft.fillRect(0, 0, screen_width, 10, TFT_BLACK);
+            for (int i = 0; i < 4; i++) {
+                int x = i * (screen_width / 4);
+                float f_freq = f_start + (f_end - f_start) * i / 4.0;
+                tft.setCursor(x, 0);
+                tft.setTextSize(1);
+
+                if (i == 0 && selected_item == 0) {
+                    tft.setTextColor(TFT_PINK, TFT_BLACK);
+                } else if (i == 3 && selected_item == 1) {
+                    tft.setTextColor(TFT_PINK, TFT_BLACK);
+                } else {
+                    tft.setTextColor(TFT_WHITE, TFT_BLACK);
                 }
-                delay(100);
-            } else if (check(DownPress) || check(PrevPress)) {
-                switch (selected_item) {
-                    case 0: f_start -= step; break;
-                    case 1: f_end -= step; break;
-                    case 2: return;
+
+                tft.drawFastVLine(x, 0, display_top, TFT_DARKGREY);
+                tft.print(String(f_freq, 1));
+            }
+
+            tft.setCursor(3, 20);
+            tft.setTextColor(TFT_DARKCYAN, TFT_BLACK);
+            tft.print("[OK] Item [PREV/NEXT] Value ");
+            tft.setTextColor(selected_item == 2 ? TFT_RED : TFT_WHITE, TFT_BLACK);
+            tft.print("EXIT");
+            busUnlock();
+            redrawHeader = false;
+        }
+
+        WaterfallRow *row;
+        while (sweepPop(row)) {
+            // bins are stretched to the screen width
+            for (int x = 0; x < screen_width; x++) {
+                int i = x * row->bins / screen_width;
+                frameBuffer[x] = palette[row->rssi[i] + 128];
+                if (row->rssi[i] > max_rssi) {
+                    max_rssi = row->rssi[i];
+                    max_freq = row->fStart + (row->fEnd - row->fStart) * i / row->bins;
                 }
-                if (EscPress) EscPress = false; // Reset for StickCs
-                delay(100);
             }
+            for (int i = 0; i < 4; i++) frameBuffer[i * (screen_width / 4)] = swapBytes(TFT_DARKGREY);
+
+            busLock();
+            tft.drawPixel(0, 0, 0); // Cardputer: resets the bus settings after the CC1101, as above
+            tft.pushImage(0, current_line, screen_width, 1, frameBuffer);
+            tft.drawFastHLine(0, current_line + 1, screen_width, TFT_DARKGREY);
+            if (recording) {
+                WaterfallRecRow rec = {row->ms, row->fStart, row->fEnd, row->bins};
+                recording.write((uint8_t *)&rec, sizeof(rec));
+                recording.write((uint8_t *)row->rssi, row->bins);
+            }
+            busUnlock();
+            sweepRelease();
+
+            current_line++;
+            if (current_line >= screen_height) current_line = display_top;
         }
-        tft.drawPixel(0, 0, 0); // Cardputer Case, need to call something to the tft.
-        tft.pushImage(0, current_line, screen_width, 1, frameBuffer);
-        tft.drawFastHLine(0, current_line + 1, screen_width, TFT_DARKGREY);
 
+        // peak held for 5s
         if (millis() - lastMaxUpdate >= 5000) {
-            max_rssi = temp_max_rssi;
-            max_freq = temp_max_freq;
+            busLock();
             tft.fillRect(0, 10, screen_width, 10, TFT_BLACK);
             tft.setCursor(3, 10);
             tft.setTextSize(1);
             tft.setTextColor(TFT_YELLOW, TFT_BLACK);
             tft.printf("%d dBm @ %.3f", max_rssi, max_freq);
+            busUnlock();
 
+            max_rssi = -128;
             lastMaxUpdate = millis();
         }
 
-        tft.setCursor(3, 20);
-        tft.setTextColor(TFT_DARKCYAN);
-        tft.print("[OK] Item [PREV/NEXT] Value ");
-
-        if (selected_item == 2) {
-            tft.setTextColor(TFT_RED);
-            tft.print("EXIT");
-        } else {
-            tft.setTextColor(TFT_WHITE);
-            tft.print("EXIT");
+        if (millis() - lastRateUpdate >= 1000) {
+            uint32_t count = sweepCount;
+            float rate = (count - lastSweepCount) * 1000.0f / (millis() - lastRateUpdate);
+            busLock();
+            tft.setCursor(screen_width - 60, 10);
+            tft.setTextSize(1);
+            tft.setTextColor(TFT_GREEN, TFT_BLACK);
+            tft.printf("%5.1f sw/s", rate);
+            busUnlock();
+            lastSweepCount = count;
+            lastRateUpdate = millis();
         }
 
-        if (check(EscPress)) break;
+        vTaskDelay(10 / portTICK_PERIOD_MS);
+    }
 
-        current_line++;
-        if (current_line >= screen_height) current_line = display_top;
+finish:
+    sweepEnd();
+    if (recording) {
+        Serial.printf("Waterfall recorded %lu bytes\n", (unsigned long)recording.size());
+        recording.close();
+    }
+    if (sweepStalls) {
+        Serial.printf("Waterfall: sweep waited %lu times for the UI\n", (unsigned long)sweepStalls);
     }
 
     returnToMenu = true;
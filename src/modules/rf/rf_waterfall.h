@@ -2,11 +2,33 @@
 
 #include "rf_utils.h"
 
+#define WATERFALL_MAX_BINS 320
+#define WATERFALL_REC_MAGIC 0x31465742 // "BWF1", recordings start with it, rows follow
+
+// Sweep engine settings, bins = 0 uses the screen width
+struct WaterfallSettings {
+    uint16_t bins;
+    uint16_t dwellUs; // wait after each retune before reading the RSSI
+    uint8_t samples;  // RSSI reads per bin
+    bool maxHold;     // keeps the max of the reads instead of the average
+    bool record;      // streams the rows to /BruceRF/waterfall_N.bin
+};
+
+// Row as written to the recording, rssi[bins] follows it
+struct __attribute__((packed)) WaterfallRecRow {
+    uint32_t ms;
+    float fStart;
+    float fEnd;
+    uint16_t bins;
+};
+
 void rf_waterfall_start_freq();
 void rf_waterfall_end_freq();
+void rf_waterfall_settings();
 void rf_waterfall_run();
 
 extern float m_rf_waterfall_start_freq;
 extern float m_rf_waterfall_end_freq;
+extern WaterfallSettings m_rf_waterfall_settings;
 
 void rf_waterfall();
@@ -0,0 +1,116 @@
+#include "sub_file.h"
+
+// "00 00 12 AB" as a number, or as bytes appended to the pulse buffer
+uint64_t SubFile::readHex(bool toPulses) {
+    uint64_t v = 0;
+    int byte = 0;
+    int digits = 0;
+    for (;;) {
+        int c = in.read();
+        if (c < 0 || c == '\n') break;
+        int d;
+        if (c >= '0' && c <= '9') d = c - '0';
+        else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+        else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+        else continue;
+        v = (v << 4) | d;
+        byte = (byte << 4) | d;
+        if (++digits == 2) {
+            if (toPulses) pushPulse(byte);
+            byte = 0;
+            digits = 0;
+        }
+    }
+    return v;
+}
+
+bool SubFile::pushPulse(int value) {
+    if (pulseLen == pulseCap) {
+        uint32_t cap = pulseCap ? pulseCap + pulseCap / 2 : 256;
+        int *p = (int *)(psramFound() ? ps_realloc(pulseBuf, cap * sizeof(int))
+                                      : realloc(pulseBuf, cap * sizeof(int)));
+        if (!p) return false;
+        pulseBuf = p;
+        pulseCap = cap;
+    }
+    pulseBuf[pulseLen++] = value;
+    return true;
+}
+
+bool SubFile::load(FS *fs, const String &filepath) {
+    end();
+    file = fs->open(filepath, FILE_READ);
+    if (!file) return false;
+
+    // RAW files are ~5 chars per pulse, reserving it upfront avoids growing the buffer while reading
+    uint32_t reserve = file.size() / 5 + 16;
+    pulseBuf = (int *)(psramFound() ? ps_malloc(reserve * sizeof(int)) : malloc(reserve * sizeof(int)));
+    pulseCap = pulseBuf ? reserve : 0;
+
+    char key[24];
+    char value[SUB_FIELD_LEN];
+    int bits = 0;
+    int rawSignal = -1;
+    in.begin();
+
+    for (;;) {
+        int c = in.peek();
+        if (c < 0) break;
+        if (c == '#' || isspace(c)) {
+            in.skipLine();
+            continue;
+        }
+        if (in.readKey(key, sizeof(key)) == 0) continue;
+        in.skipSpaces();
+
+        if (strcmp(key, "RAW_Data") == 0) {
+            if (rawSignal < 0) {
+                rawSignal = signals.size();
+                signals.push_back({SUB_SIGNAL_RAW, 0, 0, pulseLen, 0});
+            }
+            int v;
+            while (in.readInt(v)) {
+                if (v == 0) continue; // a 0 would end the transmission early
+                if (!pushPulse(v)) {
+                    Serial.println("Sub file: no memory for the pulses");
+                    in.skipLine();
+                    break;
+                }
+                signals[rawSignal].count++;
+            }
+        } else if (strcmp(key, "Data_RAW") == 0) {
+            uint32_t start = pulseLen;
+            readHex(true);
+            signals.push_back({SUB_SIGNAL_BINRAW, bits, 0, start, pulseLen - start});
+        } else if (strcmp(key, "Key") == 0) {
+            signals.push_back({SUB_SIGNAL_KEY, bits, readHex(false), 0, 0});
+        } else {
+            in.readValue(value, sizeof(value));
+            if (strcmp(key, "Protocol") == 0) protocol = value;
+            else if (strcmp(key, "Preset") == 0) preset = value;
+            else if (strcmp(key, "Frequency") == 0) frequency = strtoul(value, nullptr, 10);
+            else if (strcmp(key, "TE") == 0) te = atoi(value);
+            else if (strcmp(key, "Bit") == 0 || strcmp(key, "Bit_RAW") == 0) {
+                bits = atoi(value);
+                // some files have the Key before the Bit
+                if (!signals.empty() && signals.back().type == SUB_SIGNAL_KEY && signals.back().bits == 0)
+                    signals.back().bits = bits;
+            }
+        }
+    }
+    file.close();
+    return true;
+}
+
+void SubFile::end() {
+    if (file) file.close();
+    free(pulseBuf);
+    pulseBuf = nullptr;
+    pulseLen = 0;
+    pulseCap = 0;
+    signals.clear();
+    protocol = "";
+    preset = "";
+    frequency = 0;
+    te = 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "core/key_value_reader.h"
+#include <FS.h>
+#include <vector>
+
+#define SUB_FIELD_LEN 64 // max length of the text fields (protocol, preset)
+
+enum SubSignalType : uint8_t {
+    SUB_SIGNAL_KEY,    // Key + Bit, sent with RCSwitch
+    SUB_SIGNAL_RAW,    // RAW_Data pulses in us, positive = high, negative = low
+    SUB_SIGNAL_BINRAW, // Data_RAW bytes, one per pulse buffer entry, sent bit by bit at TE
+};
+
+struct SubSignal {
+    SubSignalType type;
+    int bits;
+    uint64_t key;
+    uint32_t start; // first entry in the pulse buffer
+    uint32_t count;
+};
+
+/**
+ * @brief Flipper .sub file read in a single pass into a playback plan.
+ *        RAW_Data values are converted straight from the read buffer into one pulse buffer,
+ *        so long captures don't go through a String per line. All RAW_Data lines of the file
+ *        are one signal, every Key and every Data_RAW line is a signal of its own.
+ */
+class SubFile {
+public:
+    ~SubFile() { end(); }
+
+    bool load(FS *fs, const String &filepath);
+    void end();
+
+    String protocol;
+    String preset;
+    uint32_t frequency = 0;
+    int te = 0;
+    std::vector<SubSignal> signals;
+
+    const int *pulses(const SubSignal &s) const { return pulseBuf + s.start; }
+    uint32_t pulseCount() const { return pulseLen; }
+
+private:
+    File file;
+    KeyValueReader in{file};
+
+    int *pulseBuf = nullptr;
+    uint32_t pulseLen = 0;
+    uint32_t pulseCap = 0;
+
+    uint64_t readHex(bool toPulses);
+    bool pushPulse(int value);
+};
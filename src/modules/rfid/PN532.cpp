@@ -160,7 +160,7 @@ int PN532::load() {
 
     String line;
     String strData;
-    strAllPages = "";
+    dump.clear();
     pageReadSuccess = true;
 
     while (file.available()) {
@@ -173,7 +173,7 @@ int PN532::load() {
         if (line.startsWith("ATQA:")) printableUID.atqa = strData;
         if (line.startsWith("Pages total:")) dataPages = strData.toInt();
         if (line.startsWith("Pages read:")) pageReadSuccess = false;
-        if (line.startsWith("Page ")) strAllPages += line + "\n";
+        dump.parseLine(line);
     }
 
     file.close();
@@ -207,7 +207,7 @@ int PN532::save(String filename) {
         file.println("Blocks total: " + String(totalPages));
         file.println("Blocks read: " + String(dataPages));
     }
-    file.print(strAllPages);
+    dump.print(file);
 
     file.close();
     delay(100);
@@ -295,7 +295,7 @@ int PN532::read_data_blocks() {
     totalPages = 0;
     int readStatus = FAILURE;
 
-    strAllPages = "";
+    dump.clear(printableUID.picc_type == "FeliCa");
 
     if (printableUID.picc_type != "FeliCa") {
         switch (uid.sak) {
@@ -342,10 +342,21 @@ int PN532::read_mifare_classic_data_blocks() {
     }
 
     if (no_of_sectors) {
-        for (int8_t i = 0; i < no_of_sectors; i++) {
+        uint32_t start = millis();
+        int8_t i;
+        keyCache.resetStats();
+        for (i = 0; i < no_of_sectors; i++) {
             sectorReadStatus = read_mifare_classic_data_sector(i);
             if (sectorReadStatus != SUCCESS) break;
         }
+        Serial.printf(
+            "MIFARE dump: %d/%d sectors, %lu auth attempts, %lu reselects, %lu ms/sector\n",
+            i,
+            no_of_sectors,
+            (unsigned long)keyCache.attempts,
+            (unsigned long)keyCache.reselects,
+            (millis() - start) / (i > 0 ? i : 1)
+        );
     }
     return sectorReadStatus;
 }
@@ -366,20 +377,16 @@ int PN532::read_mifare_classic_data_sector(byte sector) {
 
     byte buffer[18];
     byte blockAddr;
-    String strPage;
 
     int authStatus = authenticate_mifare_classic(firstBlock);
     if (authStatus != SUCCESS) return authStatus;
 
     for (int8_t blockOffset = 0; blockOffset < no_of_blocks; blockOffset++) {
-        strPage = "";
         blockAddr = firstBlock + blockOffset;
 
         if (!nfc.mifareclassic_ReadDataBlock(blockAddr, buffer)) return FAILURE;
 
-        strPage = hexToStr(buffer, 16);
-
-        strAllPages += "Page " + String(dataPages) + ": " + strPage + "\n";
+        dump.setPage(blockAddr, buffer, 16);
         dataPages++;
     }
 
@@ -387,69 +394,46 @@ int PN532::read_mifare_classic_data_sector(byte sector) {
 }
 
 int PN532::authenticate_mifare_classic(byte block) {
-    uint8_t successA = 0;
-    uint8_t successB = 0;
-
-    for (auto key : keys) {
-        successA = nfc.mifareclassic_AuthenticateBlock(uid.uidByte, uid.size, block, 0, key);
-        if (successA) break;
-
-        if (!nfc.startPassiveTargetIDDetection() || !nfc.readDetectedPassiveTargetID()) {
-            return TAG_NOT_PRESENT;
-        }
-    }
-
-    if (!successA) {
-        uint8_t keyA[6];
-
-        for (const auto &mifKey : bruceConfig.mifareKeys) {
-            for (size_t i = 0; i < mifKey.length(); i += 2) {
-                keyA[i / 2] = strtoul(mifKey.substring(i, i + 2).c_str(), NULL, 16);
+    uint8_t sector = CardDump::sectorOf(block);
+    uint8_t key[6];
+    bool reselect = false;
+
+    keyCache.begin(keys, sizeof(keys) / sizeof(keys[0]));
+    keyCache.selectCard(uid.uidByte, uid.size);
+
+    for (uint8_t keyType = 0; keyType < 2; keyType++) {
+        bool success = false;
+
+        for (uint16_t n = 0; n < keyCache.size() && !success; n++) {
+            // A failed authentication halts the card, select it again only when there is another try
+            if (reselect) {
+                keyCache.reselects++;
+                if (!nfc.startPassiveTargetIDDetection() || !nfc.readDetectedPassiveTargetID()) {
+                    return TAG_NOT_PRESENT;
+                }
+                reselect = false;
             }
 
-            successA = nfc.mifareclassic_AuthenticateBlock(uid.uidByte, uid.size, block, 0, keyA);
-            if (successA) break;
-
-            if (!nfc.startPassiveTargetIDDetection() || !nfc.readDetectedPassiveTargetID()) {
-                return TAG_NOT_PRESENT;
+            memcpy(key, keyCache.key(keyType, n), 6);
+            keyCache.attempts++;
+            success = nfc.mifareclassic_AuthenticateBlock(uid.uidByte, uid.size, block, keyType, key);
+            if (success) {
+                keyCache.hit(keyType, n);
+                dump.setKey(sector, keyType, key);
+            } else {
+                reselect = true;
             }
         }
-    }
 
-    for (auto key : keys) {
-        successB = nfc.mifareclassic_AuthenticateBlock(uid.uidByte, uid.size, block, 1, key);
-        if (successB) break;
-
-        if (!nfc.startPassiveTargetIDDetection() || !nfc.readDetectedPassiveTargetID()) {
-            return TAG_NOT_PRESENT;
-        }
+        if (!success) return TAG_AUTH_ERROR;
     }
 
-    if (!successB) {
-        uint8_t keyB[6];
-
-        for (const auto &mifKey : bruceConfig.mifareKeys) {
-            for (size_t i = 0; i < mifKey.length(); i += 2) {
-                keyB[i / 2] = strtoul(mifKey.substring(i, i + 2).c_str(), NULL, 16);
-            }
-
-            successB = nfc.mifareclassic_AuthenticateBlock(uid.uidByte, uid.size, block, 1, keyB);
-            if (successB) break;
-
-            if (!nfc.startPassiveTargetIDDetection() || !nfc.readDetectedPassiveTargetID()) {
-                return TAG_NOT_PRESENT;
-            }
-        }
-    }
-
-    return (successA && successB) ? SUCCESS : TAG_AUTH_ERROR;
+    return SUCCESS;
 }
 
 int PN532::read_mifare_ultralight_data_blocks() {
     uint8_t success;
     byte buffer[18];
-    byte i;
-    String strPage = "";
 
     uint8_t buf[4];
     nfc.mifareultralight_ReadPage(3, buf);
@@ -469,16 +453,7 @@ int PN532::read_mifare_ultralight_data_blocks() {
         if (!success) return FAILURE;
 
         for (byte offset = 0; offset < 4; offset++) {
-            strPage = "";
-            for (byte index = 0; index < 4; index++) {
-                i = 4 * offset + index;
-                strPage += buffer[i] < 0x10 ? F(" 0") : F(" ");
-                strPage += String(buffer[i], HEX);
-            }
-            strPage.trim();
-            strPage.toUpperCase();
-
-            strAllPages += "Page " + String(dataPages) + ": " + strPage + "\n";
+            dump.setPage(dataPages, buffer + 4 * offset, 4);
             dataPages++;
             if (dataPages >= totalPages) break;
         }
@@ -488,7 +463,6 @@ int PN532::read_mifare_ultralight_data_blocks() {
 }
 
 int PN532::read_felica_data() {
-    String strPage = "";
     totalPages = 14;
 
     for (uint16_t i = 0x8000; i < 0x8000 + totalPages; i++) {
@@ -499,109 +473,73 @@ int PN532::read_felica_data() {
         }; // Default service code for reading. Should works for every card
         int res = nfc.felica_ReadWithoutEncryption(1, default_service_code, 1, block_list, block_data);
 
-        for (size_t i = 0; i < 16; i++) {
-            if (res) { // If card block read successfully, copy data to string
-                strPage = hexToStr(block_data[0], 16);
-            }
-        }
         if (res) { // If PN532 can't read the FeliCa tag, don't write the block to file
-            strAllPages += "Block " + String(dataPages++) + ": " + strPage + "\n";
+            dump.setPage(dataPages++, block_data[0], 16);
         }
-        strPage = ""; // Reset for the next block
     }
 
     return SUCCESS;
 }
 
 int PN532::write_data_blocks() {
-    String pageLine = "";
-    String strBytes = "";
-    int lineBreakIndex;
-    int pageIndex;
     bool blockWriteSuccess;
-    int totalSize = strAllPages.length();
+    int totalSize = dump.pages();
 
-    Serial.println(strAllPages);
-    while (strAllPages.length() > 0) {
-        lineBreakIndex = strAllPages.indexOf("\n");
-        pageLine = strAllPages.substring(0, lineBreakIndex);
-        strAllPages = strAllPages.substring(lineBreakIndex + 1);
+    // Classic and FeliCa blocks are 16 bytes, Ultralight pages 4
+    byte pageSize = (printableUID.picc_type != "FeliCa" && uid.sak == PICC_TYPE_MIFARE_UL) ? 4 : 16;
+    if (totalSize > 0 && dump.pageSize() != pageSize) return FAILURE;
 
-        pageIndex = pageLine.substring(5, pageLine.indexOf(":")).toInt();
-        strBytes = pageLine.substring(pageLine.indexOf(":") + 1);
-        strBytes.trim();
-
-        if (pageIndex == 0) continue;
+    for (int pageIndex = 1; pageIndex < totalSize; pageIndex++) {
+        if (!dump.isRead(pageIndex)) continue;
+        const byte *data = dump.page(pageIndex);
 
         if (printableUID.picc_type != "FeliCa") {
             switch (uid.sak) {
                 case PICC_TYPE_MIFARE_MINI:
                 case PICC_TYPE_MIFARE_1K:
                 case PICC_TYPE_MIFARE_4K:
-                    if (pageIndex == 0 || (pageIndex + 1) % 4 == 0)
-                        continue; // Data blocks for MIFARE Classic
-                    blockWriteSuccess = write_mifare_classic_data_block(pageIndex, strBytes);
+                    if ((pageIndex + 1) % 4 == 0) continue; // Data blocks for MIFARE Classic
+                    blockWriteSuccess = write_mifare_classic_data_block(pageIndex, data);
                     break;
 
                 case PICC_TYPE_MIFARE_UL:
                     if (pageIndex < 4 || pageIndex >= dataPages - 5) continue; // Data blocks for NTAG21X
-                    blockWriteSuccess = write_mifare_ultralight_data_block(pageIndex, strBytes);
+                    blockWriteSuccess = write_mifare_ultralight_data_block(pageIndex, data);
                     break;
 
                 default: blockWriteSuccess = false; break;
             }
         } else {
-            blockWriteSuccess = write_felica_data_block(pageIndex, strBytes);
+            blockWriteSuccess = write_felica_data_block(pageIndex, data);
         }
 
         if (!blockWriteSuccess) return FAILURE;
 
-        progressHandler(totalSize - strAllPages.length(), totalSize, "Writing data blocks...");
+        progressHandler(pageIndex + 1, totalSize, "Writing data blocks...");
     }
 
     return SUCCESS;
 }
 
-bool PN532::write_mifare_classic_data_block(int block, String data) {
-    data.replace(" ", "");
-    byte size = data.length() / 2;
-    byte buffer[size];
-
-    if (size != 16) return false;
-
-    for (size_t i = 0; i < data.length(); i += 2) {
-        buffer[i / 2] = strtoul(data.substring(i, i + 2).c_str(), NULL, 16);
-    }
+bool PN532::write_mifare_classic_data_block(int block, const byte *data) {
+    byte buffer[16];
+    memcpy(buffer, data, 16);
 
     if (authenticate_mifare_classic(block) != SUCCESS) return false;
 
     return nfc.mifareclassic_WriteDataBlock(block, buffer);
 }
 
-bool PN532::write_mifare_ultralight_data_block(int block, String data) {
-    data.replace(" ", "");
-    byte size = data.length() / 2;
-    byte buffer[size];
-
-    if (size != 4) return false;
-
-    for (size_t i = 0; i < data.length(); i += 2) {
-        buffer[i / 2] = strtoul(data.substring(i, i + 2).c_str(), NULL, 16);
-    }
+bool PN532::write_mifare_ultralight_data_block(int block, const byte *data) {
+    byte buffer[4];
+    memcpy(buffer, data, 4);
 
     return nfc.ntag2xx_WritePage(block, buffer);
 }
 
-int PN532::write_felica_data_block(int block, String data) {
-    data.replace(" ", "");
-    byte size = data.length() / 2;
+int PN532::write_felica_data_block(int block, const byte *data) {
     uint8_t block_data[1][16] = {0};
-
-    if (size != 16) { return false; }
-
-    for (size_t i = 0; i < data.length(); i += 2) {
-        block_data[0][i / 2] = strtoul(data.substring(i, i + 2).c_str(), NULL, 16);
-    }
+    memcpy(block_data[0], data, 16);
 
     uint16_t block_list[1] = {(uint16_t)(block +
                                          0x8000)}; // Write the block i. Block in FeliCa start from 0x8000
@@ -614,6 +552,8 @@ int PN532::write_felica_data_block(int block, String data) {
 }
 
 int PN532::erase_data_blocks() {
+    const byte empty[16] = {0};
+    const byte ndef[4] = {0x03, 0x00, 0xFE, 0x00};
     bool blockWriteSuccess;
 
     switch (uid.sak) {
@@ -622,19 +562,18 @@ int PN532::erase_data_blocks() {
         case PICC_TYPE_MIFARE_4K:
             for (byte i = 1; i < 64; i++) {
                 if ((i + 1) % 4 == 0) continue;
-                blockWriteSuccess =
-                    write_mifare_classic_data_block(i, "00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00");
+                blockWriteSuccess = write_mifare_classic_data_block(i, empty);
                 if (!blockWriteSuccess) return FAILURE;
             }
             break;
 
         case PICC_TYPE_MIFARE_UL:
             // NDEF stardard
-            blockWriteSuccess = write_mifare_ultralight_data_block(4, "03 00 FE 00");
+            blockWriteSuccess = write_mifare_ultralight_data_block(4, ndef);
             if (!blockWriteSuccess) return FAILURE;
 
             for (byte i = 5; i < 130; i++) {
-                blockWriteSuccess = write_mifare_ultralight_data_block(i, "00 00 00 00");
+                blockWriteSuccess = write_mifare_ultralight_data_block(i, empty);
                 if (!blockWriteSuccess) return FAILURE;
             }
             break;
@@ -124,7 +124,7 @@ int RFID2::load() {
 
     String line;
     String strData;
-    strAllPages = "";
+    dump.clear();
     pageReadSuccess = true;
 
     while (file.available()) {
@@ -137,7 +137,7 @@ int RFID2::load() {
         if (line.startsWith("ATQA:")) printableUID.atqa = strData;
         if (line.startsWith("Pages total:")) dataPages = strData.toInt();
         if (line.startsWith("Pages read:")) pageReadSuccess = false;
-        if (line.startsWith("Page ")) strAllPages += line + "\n";
+        dump.parseLine(line);
     }
 
     file.close();
@@ -172,7 +172,7 @@ int RFID2::save(String filename) {
     file.println("# Memory dump");
     file.println("Pages total: " + String(dataPages));
     if (!pageReadSuccess) file.println("Pages read: " + String(dataPages));
-    file.print(strAllPages);
+    dump.print(file);
 
     file.close();
     delay(100);
@@ -250,7 +250,7 @@ int RFID2::read_data_blocks() {
     totalPages = 0;
     int readStatus = FAILURE;
     byte piccType = mfrc522.PICC_GetType(mfrc522.uid.sak);
-    strAllPages = "";
+    dump.clear();
 
     switch (piccType) {
         case MFRC522::PICC_Type::PICC_TYPE_MIFARE_MINI:
@@ -297,10 +297,21 @@ int RFID2::read_mifare_classic_data_blocks(byte piccType) {
     }
 
     if (no_of_sectors) {
-        for (int8_t i = 0; i < no_of_sectors; i++) {
+        uint32_t start = millis();
+        int8_t i;
+        keyCache.resetStats();
+        for (i = 0; i < no_of_sectors; i++) {
             sectorReadStatus = read_mifare_classic_data_sector(i);
             if (sectorReadStatus != SUCCESS) break;
         }
+        Serial.printf(
+            "MIFARE dump: %d/%d sectors, %lu auth attempts, %lu reselects, %lu ms/sector\n",
+            i,
+            no_of_sectors,
+            (unsigned long)keyCache.attempts,
+            (unsigned long)keyCache.reselects,
+            (millis() - start) / (i > 0 ? i : 1)
+        );
     }
     mfrc522.PICC_HaltA();
     mfrc522.PCD_StopCrypto1();
@@ -325,28 +336,18 @@ int RFID2::read_mifare_classic_data_sector(byte sector) {
     byte byteCount;
     byte buffer[18];
     byte blockAddr;
-    String strPage;
 
     int authStatus = authenticate_mifare_classic(firstBlock);
     if (authStatus != SUCCESS) return authStatus;
 
     for (int8_t blockOffset = 0; blockOffset < no_of_blocks; blockOffset++) {
-        strPage = "";
         blockAddr = firstBlock + blockOffset;
         byteCount = sizeof(buffer);
 
         status = mfrc522.MIFARE_Read(blockAddr, buffer, &byteCount);
         if (status != MFRC522::StatusCode::STATUS_OK) { return FAILURE; }
 
-        for (byte index = 0; index < 16; index++) {
-            strPage += buffer[index] < 0x10 ? F(" 0") : F(" ");
-            strPage += String(buffer[index], HEX);
-        }
-
-        strPage.trim();
-        strPage.toUpperCase();
-
-        strAllPages += "Page " + String(dataPages) + ": " + strPage + "\n";
+        dump.setPage(blockAddr, buffer, 16);
         dataPages++;
     }
 
@@ -354,76 +355,49 @@ int RFID2::read_mifare_classic_data_sector(byte sector) {
 }
 
 int RFID2::authenticate_mifare_classic(byte block) {
-    byte statusA = 0;
-    byte statusB = 0;
-
-    MFRC522::MIFARE_Key keyA;
-    MFRC522::MIFARE_Key keyB;
-
-    for (auto key : keys) {
-        memcpy(keyA.keyByte, key, 6);
-
-        statusA = mfrc522.PCD_Authenticate(
-            MFRC522::PICC_Command::PICC_CMD_MF_AUTH_KEY_A, block, &keyA, &mfrc522.uid
-        );
-        if (statusA == MFRC522::StatusCode::STATUS_OK) break;
-
-        if (!PICC_IsNewCardPresent() || !mfrc522.PICC_ReadCardSerial()) { return TAG_NOT_PRESENT; }
-    }
-
-    if (statusA != MFRC522::StatusCode::STATUS_OK) {
-        for (const auto &mifKey : bruceConfig.mifareKeys) {
-            for (size_t i = 0; i < mifKey.length(); i += 2) {
-                keyA.keyByte[i / 2] = strtoul(mifKey.substring(i, i + 2).c_str(), NULL, 16);
+    uint8_t sector = CardDump::sectorOf(block);
+    MFRC522::MIFARE_Key key;
+    bool reselect = false;
+
+    keyCache.begin(keys, sizeof(keys) / sizeof(keys[0]));
+    keyCache.selectCard(mfrc522.uid.uidByte, mfrc522.uid.size);
+
+    for (uint8_t keyType = 0; keyType < 2; keyType++) {
+        MFRC522::PICC_Command cmd = keyType ? MFRC522::PICC_Command::PICC_CMD_MF_AUTH_KEY_B
+                                            : MFRC522::PICC_Command::PICC_CMD_MF_AUTH_KEY_A;
+        bool success = false;
+
+        for (uint16_t n = 0; n < keyCache.size() && !success; n++) {
+            // A failed authentication halts the card, select it again only when there is another try
+            if (reselect) {
+                keyCache.reselects++;
+                if (!PICC_IsNewCardPresent() || !mfrc522.PICC_ReadCardSerial()) { return TAG_NOT_PRESENT; }
+                reselect = false;
             }
 
-            statusA = mfrc522.PCD_Authenticate(
-                MFRC522::PICC_Command::PICC_CMD_MF_AUTH_KEY_A, block, &keyA, &mfrc522.uid
-            );
-            if (statusA == MFRC522::StatusCode::STATUS_OK) break;
-
-            if (!PICC_IsNewCardPresent() || !mfrc522.PICC_ReadCardSerial()) { return TAG_NOT_PRESENT; }
-        }
-    }
-
-    for (auto key : keys) {
-        memcpy(keyB.keyByte, key, 6);
-
-        statusB = mfrc522.PCD_Authenticate(
-            MFRC522::PICC_Command::PICC_CMD_MF_AUTH_KEY_B, block, &keyB, &mfrc522.uid
-        );
-        if (statusB == MFRC522::StatusCode::STATUS_OK) break;
-
-        if (!PICC_IsNewCardPresent() || !mfrc522.PICC_ReadCardSerial()) { return TAG_NOT_PRESENT; }
-    }
-
-    if (statusB != MFRC522::StatusCode::STATUS_OK) {
-        for (const auto &mifKey : bruceConfig.mifareKeys) {
-            for (size_t i = 0; i < mifKey.length(); i += 2) {
-                keyB.keyByte[i / 2] = strtoul(mifKey.substring(i, i + 2).c_str(), NULL, 16);
+            memcpy(key.keyByte, keyCache.key(keyType, n), 6);
+            keyCache.attempts++;
+            success = mfrc522.PCD_Authenticate(cmd, block, &key, &mfrc522.uid) ==
+                      MFRC522::StatusCode::STATUS_OK;
+            if (success) {
+                keyCache.hit(keyType, n);
+                dump.setKey(sector, keyType, key.keyByte);
+            } else {
+                reselect = true;
             }
-
-            statusB = mfrc522.PCD_Authenticate(
-                MFRC522::PICC_Command::PICC_CMD_MF_AUTH_KEY_A, block, &keyB, &mfrc522.uid
-            );
-            if (statusB == MFRC522::StatusCode::STATUS_OK) break;
-
-            if (!PICC_IsNewCardPresent() || !mfrc522.PICC_ReadCardSerial()) { return TAG_NOT_PRESENT; }
         }
+
+        if (!success) return TAG_AUTH_ERROR;
     }
 
-    return (statusA == MFRC522::StatusCode::STATUS_OK && statusB == MFRC522::StatusCode::STATUS_OK)
-               ? SUCCESS
-               : TAG_AUTH_ERROR;
+    return SUCCESS;
 }
 
 int RFID2::read_mifare_ultralight_data_blocks() {
     byte status;
     byte byteCount;
     byte buffer[18];
-    byte i;
     byte cc;
-    String strPage = "";
 
     for (byte page = 0; page <= 252; page += 4) {
         byteCount = sizeof(buffer);
@@ -432,7 +406,6 @@ int RFID2::read_mifare_ultralight_data_blocks() {
             return status == MFRC522::StatusCode::STATUS_MIFARE_NACK ? SUCCESS : FAILURE;
         }
         for (byte offset = 0; offset < 4; offset++) {
-            strPage = "";
             if (page + offset == 3) {
                 cc = buffer[4 * offset + 2];
                 switch (cc) {
@@ -445,15 +418,7 @@ int RFID2::read_mifare_ultralight_data_blocks() {
                     default: break;
                 }
             }
-            for (byte index = 0; index < 4; index++) {
-                i = 4 * offset + index;
-                strPage += buffer[i] < 0x10 ? F(" 0") : F(" ");
-                strPage += String(buffer[i], HEX);
-            }
-            strPage.trim();
-            strPage.toUpperCase();
-
-            strAllPages += "Page " + String(dataPages) + ": " + strPage + "\n";
+            dump.setPage(dataPages, buffer + 4 * offset, 4);
             dataPages++;
         }
     }
@@ -463,35 +428,28 @@ int RFID2::read_mifare_ultralight_data_blocks() {
 
 int RFID2::write_data_blocks() {
     byte piccType = mfrc522.PICC_GetType(mfrc522.uid.sak);
-    String pageLine = "";
-    String strBytes = "";
-    int lineBreakIndex;
-    int pageIndex;
     bool blockWriteSuccess;
-    int totalSize = strAllPages.length();
-
-    while (strAllPages.length() > 0) {
-        lineBreakIndex = strAllPages.indexOf("\n");
-        pageLine = strAllPages.substring(0, lineBreakIndex);
-        strAllPages = strAllPages.substring(lineBreakIndex + 1);
+    int totalSize = dump.pages();
 
-        pageIndex = pageLine.substring(5, pageLine.indexOf(":")).toInt();
-        strBytes = pageLine.substring(pageLine.indexOf(":") + 1);
-        strBytes.trim();
+    // Classic blocks are 16 bytes, Ultralight pages 4
+    byte pageSize = piccType == MFRC522::PICC_Type::PICC_TYPE_MIFARE_UL ? 4 : 16;
+    if (totalSize > 0 && dump.pageSize() != pageSize) return FAILURE;
 
-        if (pageIndex == 0) continue;
+    for (int pageIndex = 1; pageIndex < totalSize; pageIndex++) {
+        if (!dump.isRead(pageIndex)) continue;
+        const byte *data = dump.page(pageIndex);
 
         switch (piccType) {
             case MFRC522::PICC_Type::PICC_TYPE_MIFARE_MINI:
             case MFRC522::PICC_Type::PICC_TYPE_MIFARE_1K:
             case MFRC522::PICC_Type::PICC_TYPE_MIFARE_4K:
-                if (pageIndex == 0 || (pageIndex + 1) % 4 == 0) continue; // Data blocks for MIFARE Classic
-                blockWriteSuccess = write_mifare_classic_data_block(pageIndex, strBytes);
+                if ((pageIndex + 1) % 4 == 0) continue; // Data blocks for MIFARE Classic
+                blockWriteSuccess = write_mifare_classic_data_block(pageIndex, data);
                 break;
 
             case MFRC522::PICC_Type::PICC_TYPE_MIFARE_UL:
                 if (pageIndex < 4 || pageIndex >= dataPages - 5) continue; // Data blocks for NTAG21X
-                blockWriteSuccess = write_mifare_ultralight_data_block(pageIndex, strBytes);
+                blockWriteSuccess = write_mifare_ultralight_data_block(pageIndex, data);
                 break;
 
             default: blockWriteSuccess = false; break;
@@ -499,39 +457,29 @@ int RFID2::write_data_blocks() {
 
         if (!blockWriteSuccess) return FAILURE;
 
-        progressHandler(totalSize - strAllPages.length(), totalSize, "Writing data blocks...");
+        progressHandler(pageIndex + 1, totalSize, "Writing data blocks...");
     }
 
     return SUCCESS;
 }
 
-bool RFID2::write_mifare_classic_data_block(int block, String data) {
-    data.replace(" ", "");
-    byte size = data.length() / 2;
-    byte buffer[size];
-
-    for (size_t i = 0; i < data.length(); i += 2) {
-        buffer[i / 2] = strtoul(data.substring(i, i + 2).c_str(), NULL, 16);
-    }
+bool RFID2::write_mifare_classic_data_block(int block, const byte *data) {
+    byte buffer[16];
+    memcpy(buffer, data, 16);
 
     if (authenticate_mifare_classic(block) != SUCCESS) return false;
 
-    byte status = mfrc522.MIFARE_Write((byte)block, buffer, size);
+    byte status = mfrc522.MIFARE_Write((byte)block, buffer, 16);
     if (status != MFRC522::StatusCode::STATUS_OK) return false;
 
     return true;
 }
 
-bool RFID2::write_mifare_ultralight_data_block(int block, String data) {
-    data.replace(" ", "");
-    byte size = data.length() / 2;
-    byte buffer[size];
-
-    for (size_t i = 0; i < data.length(); i += 2) {
-        buffer[i / 2] = strtoul(data.substring(i, i + 2).c_str(), NULL, 16);
-    }
+bool RFID2::write_mifare_ultralight_data_block(int block, const byte *data) {
+    byte buffer[4];
+    memcpy(buffer, data, 4);
 
-    byte status = mfrc522.MIFARE_Ultralight_Write((byte)block, buffer, size);
+    byte status = mfrc522.MIFARE_Ultralight_Write((byte)block, buffer, 4);
     if (status != MFRC522::StatusCode::STATUS_OK) return false;
 
     return true;
@@ -539,6 +487,8 @@ bool RFID2::write_mifare_ultralight_data_block(int block, String data) {
 
 int RFID2::erase_data_blocks() {
     byte piccType = mfrc522.PICC_GetType(mfrc522.uid.sak);
+    const byte empty[16] = {0};
+    const byte ndef[4] = {0x03, 0x00, 0xFE, 0x00};
     bool blockWriteSuccess;
 
     switch (piccType) {
@@ -547,19 +497,18 @@ int RFID2::erase_data_blocks() {
         case MFRC522::PICC_Type::PICC_TYPE_MIFARE_4K:
             for (byte i = 1; i < 64; i++) {
                 if ((i + 1) % 4 == 0) continue;
-                blockWriteSuccess =
-                    write_mifare_classic_data_block(i, "00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00");
+                blockWriteSuccess = write_mifare_classic_data_block(i, empty);
                 if (!blockWriteSuccess) return FAILURE;
             }
             break;
 
         case MFRC522::PICC_Type::PICC_TYPE_MIFARE_UL:
             // NDEF stardard
-            blockWriteSuccess = write_mifare_ultralight_data_block(4, "03 00 FE 00");
+            blockWriteSuccess = write_mifare_ultralight_data_block(4, ndef);
             if (!blockWriteSuccess) return FAILURE;
 
             for (byte i = 5; i < 130; i++) {
-                blockWriteSuccess = write_mifare_ultralight_data_block(i, "00 00 00 00");
+                blockWriteSuccess = write_mifare_ultralight_data_block(i, empty);
                 if (!blockWriteSuccess) return FAILURE;
             }
             break;
@@ -62,8 +62,8 @@ private:
     int read_mifare_ultralight_data_blocks();
 
     int write_data_blocks();
-    bool write_mifare_classic_data_block(int block, String data);
-    bool write_mifare_ultralight_data_block(int block, String data);
+    bool write_mifare_classic_data_block(int block, const byte *data);
+    bool write_mifare_ultralight_data_block(int block, const byte *data);
 
     int erase_data_blocks();
     int write_ndef_blocks();
@@ -9,6 +9,8 @@
 #ifndef __RFID_INTERFACE_H__
 #define __RFID_INTERFACE_H__
 
+#include "card_dump.h"
+#include "mifare_keys.h"
 #include <globals.h>
 
 class RFIDInterface {
@@ -71,7 +73,8 @@ public:
     Uid uid;
     PrintableUID printableUID;
     NdefMessage ndefMessage;
-    String strAllPages = "";
+    CardDump dump;
+    MifareKeyCache keyCache;
     int totalPages = 0;
     int dataPages = 0;
     bool pageReadSuccess = false;
@@ -0,0 +1,135 @@
+/**
+ * @file card_dump.cpp
+ * @brief Memory dump of a tag kept as raw bytes, shared by the RFID backends
+ * @version 0.1
+ */
+
+#include "card_dump.h"
+
+bool CardDump::alloc(uint8_t pageSize) {
+    if (data) return size == pageSize;
+    if (pageSize == 0 || pageSize > CARD_DUMP_MAX_PAGE_SIZE) return false;
+
+    size_t bytes = CARD_DUMP_MAX_PAGES * pageSize;
+    data = (uint8_t *)(psramFound() ? ps_malloc(bytes) : malloc(bytes));
+    if (!data) return false;
+    size = pageSize;
+    return true;
+}
+
+void CardDump::clear(bool felica) {
+    free(data);
+    data = nullptr;
+    size = 0;
+    count = 0;
+    blocks = felica;
+    memset(readMap, 0, sizeof(readMap));
+    memset(keyMap, 0, sizeof(keyMap));
+}
+
+CardDump &CardDump::operator=(const CardDump &other) {
+    if (this == &other) return *this;
+    clear(other.blocks);
+    if (other.data && alloc(other.size)) {
+        memcpy(data, other.data, other.count * other.size);
+        count = other.count;
+        memcpy(readMap, other.readMap, sizeof(readMap));
+    }
+    memcpy(keyMap, other.keyMap, sizeof(keyMap));
+    memcpy(keys, other.keys, sizeof(keys));
+    return *this;
+}
+
+bool CardDump::operator==(const CardDump &other) const {
+    if (count != other.count) return false;
+    if (count == 0) return true;
+    if (size != other.size || memcmp(readMap, other.readMap, (count + 7) / 8) != 0) return false;
+    for (uint16_t i = 0; i < count; i++) {
+        if (isRead(i) && memcmp(page(i), other.page(i), size) != 0) return false;
+    }
+    return true;
+}
+
+bool CardDump::setPage(uint16_t index, const uint8_t *bytes, uint8_t pageSize) {
+    if (index >= CARD_DUMP_MAX_PAGES || !alloc(pageSize)) return false;
+
+    memcpy(data + index * size, bytes, size);
+    readMap[index / 8] |= 1 << (index % 8);
+    if (index >= count) count = index + 1;
+    return true;
+}
+
+uint16_t CardDump::readPages() const {
+    uint16_t n = 0;
+    for (uint16_t i = 0; i < count; i++) n += isRead(i);
+    return n;
+}
+
+void CardDump::setKey(uint8_t sector, bool keyB, const uint8_t *key) {
+    if (sector >= CARD_DUMP_MAX_SECTORS) return;
+    uint8_t slot = sector * 2 + keyB;
+    memcpy(keys[sector][keyB], key, 6);
+    keyMap[slot / 8] |= 1 << (slot % 8);
+}
+
+const uint8_t *CardDump::key(uint8_t sector, bool keyB) const {
+    if (sector >= CARD_DUMP_MAX_SECTORS) return nullptr;
+    uint8_t slot = sector * 2 + keyB;
+    return (keyMap[slot / 8] & (1 << (slot % 8))) ? keys[sector][keyB] : nullptr;
+}
+
+void CardDump::print(Print &out) const {
+    // "Block 255:" + " XX" per byte + '\n'
+    char line[12 + 3 * CARD_DUMP_MAX_PAGE_SIZE + 1];
+
+    for (uint16_t i = 0; i < count; i++) {
+        if (!isRead(i)) continue;
+        int n = snprintf(line, sizeof(line), "%s %u:", blocks ? "Block" : "Page", i);
+        const uint8_t *p = page(i);
+        for (uint8_t b = 0; b < size; b++) n += snprintf(line + n, sizeof(line) - n, " %02X", p[b]);
+        line[n++] = '\n';
+        out.write((const uint8_t *)line, n);
+    }
+}
+
+// "Page N: XX XX ..." or "Block N: XX XX ...", false for any other line
+bool CardDump::parseLine(const String &line) {
+    const char *p = line.c_str();
+    bool block = strncmp(p, "Block ", 6) == 0;
+    if (!block && strncmp(p, "Page ", 5) != 0) return false;
+
+    char *end;
+    unsigned long index = strtoul(p + (block ? 6 : 5), &end, 10);
+    if (*end != ':') return false;
+    if (count == 0) blocks = block;
+
+    uint8_t bytes[CARD_DUMP_MAX_PAGE_SIZE];
+    uint8_t n = 0;
+    p = end + 1;
+    while (*p && n < CARD_DUMP_MAX_PAGE_SIZE) {
+        if (!isxdigit((uint8_t)*p)) {
+            p++;
+            continue;
+        }
+        if (!isxdigit((uint8_t)p[1])) break;
+        char hex[3] = {p[0], p[1], '\0'};
+        bytes[n++] = strtoul(hex, nullptr, 16);
+        p += 2;
+    }
+    return setPage(index, bytes, n);
+}
+
+String CardDump::hex() const {
+    static const char digits[] = "0123456789ABCDEF";
+    String str;
+    str.reserve(count * size * 2);
+    for (uint16_t i = 0; i < count; i++) {
+        if (!isRead(i)) continue;
+        const uint8_t *p = page(i);
+        for (uint8_t b = 0; b < size; b++) {
+            str += digits[p[b] >> 4];
+            str += digits[p[b] & 0x0F];
+        }
+    }
+    return str;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file card_dump.h
+ * @brief Memory dump of a tag kept as raw bytes, shared by the RFID backends
+ * @version 0.1
+ */
+
+#ifndef __CARD_DUMP_H__
+#define __CARD_DUMP_H__
+
+#include <Arduino.h>
+
+#define CARD_DUMP_MAX_PAGES 256    // MIFARE Classic 4K blocks, the biggest card we read
+#define CARD_DUMP_MAX_PAGE_SIZE 16 // Classic and FeliCa blocks, Ultralight pages are 4
+#define CARD_DUMP_MAX_SECTORS 40
+
+/**
+ * @brief Pages are stored in one flat buffer as they are read, with a bitmap of the ones that were
+ *        read and the MIFARE Classic keys that opened each sector. The .rfid text
+ *        ("Page N: XX XX ...") is only produced by print() when saving and parsed back one line at
+ *        a time by parseLine() when loading.
+ */
+class CardDump {
+public:
+    CardDump() {}
+    CardDump(const CardDump &other) { *this = other; }
+    ~CardDump() { free(data); }
+
+    CardDump &operator=(const CardDump &other);
+    bool operator==(const CardDump &other) const;
+    bool operator!=(const CardDump &other) const { return !(*this == other); }
+
+    // Drops the pages and keys, a FeliCa dump is written as "Block N:" lines
+    void clear(bool felica = false);
+
+    bool setPage(uint16_t index, const uint8_t *bytes, uint8_t pageSize);
+    bool append(const uint8_t *bytes, uint8_t pageSize) { return setPage(count, bytes, pageSize); }
+    const uint8_t *page(uint16_t index) const { return data + index * size; }
+    bool isRead(uint16_t index) const { return index < count && (readMap[index / 8] & (1 << (index % 8))); }
+    uint16_t pages() const { return count; } // highest page + 1, not all of them may be read
+    uint16_t readPages() const;
+    uint8_t pageSize() const { return size; }
+
+    // MIFARE Classic keys, slot 0 = key A, 1 = key B
+    void setKey(uint8_t sector, bool keyB, const uint8_t *key);
+    const uint8_t *key(uint8_t sector, bool keyB) const;
+    static uint8_t sectorOf(uint16_t block) { return block < 128 ? block / 4 : 32 + (block - 128) / 16; }
+
+    // .rfid text, only the page lines, the header is written by each backend
+    void print(Print &out) const;
+    bool parseLine(const String &line);
+    String hex() const; // all the read pages as one hex string, no spaces
+
+private:
+    uint8_t *data = nullptr;
+    uint8_t size = 0;
+    uint16_t count = 0;
+    bool blocks = false;
+    uint8_t readMap[CARD_DUMP_MAX_PAGES / 8] = {};
+    uint8_t keyMap[CARD_DUMP_MAX_SECTORS * 2 / 8] = {};
+    uint8_t keys[CARD_DUMP_MAX_SECTORS][2][6] = {};
+
+    bool alloc(uint8_t pageSize);
+};
+
+#endif
@@ -617,27 +617,7 @@ void Chameleon::emulateHF() {
         return setMode(BATTERY_INFO_MODE);
     }
 
-    String strDump = "";
-    String strData = "";
-    String line = "";
-    int startIndex = 0;
-    int finalIndex;
-
-    while (true) {
-        finalIndex = strAllPages.indexOf("\n", startIndex);
-        if (finalIndex == -1) finalIndex = strAllPages.length();
-
-        line = strAllPages.substring(startIndex, finalIndex);
-        if (line.length() < 5) break;
-
-        strData = line.substring(line.indexOf(":") + 1);
-        strData.trim();
-        strDump += strData;
-
-        startIndex = finalIndex + 1;
-    }
-    strDump.trim();
-    strDump.replace(" ", "");
+    String strDump = dump.hex();
 
     uint8_t slot = selectSlot();
 
@@ -710,7 +690,7 @@ bool Chameleon::readFileHF() {
 
     String line;
     String strData;
-    strAllPages = "";
+    dump.clear();
     pageReadSuccess = true;
 
     while (file.available()) {
@@ -723,7 +703,7 @@ bool Chameleon::readFileHF() {
         if (line.startsWith("ATQA:")) printableHFUID.atqa = strData;
         if (line.startsWith("Pages total:")) dataPages = strData.toInt();
         if (line.startsWith("Pages read:")) pageReadSuccess = false;
-        if (line.startsWith("Page ")) strAllPages += line + "\n";
+        dump.parseLine(line);
     }
 
     file.close();
@@ -758,7 +738,7 @@ bool Chameleon::writeFileHF(String filename) {
     file.println("# Memory dump");
     file.println("Pages total: " + String(dataPages));
     if (!pageReadSuccess) file.println("Pages read: " + String(dataPages));
-    file.print(strAllPages);
+    dump.print(file);
 
     file.close();
     delay(100);
@@ -769,7 +749,7 @@ bool Chameleon::readHFDataBlocks() {
     dataPages = 0;
     totalPages = 0;
     bool readSuccess = false;
-    strAllPages = "";
+    dump.clear();
 
     switch (chmUltra.hfTagData.sak) {
         case 0x08:
@@ -811,20 +791,10 @@ bool Chameleon::readMifareClassicDataBlocks(uint8_t *key) {
             break;
     }
 
-    String strPage;
-
     for (byte i = 0; i < totalPages; i++) {
         if (!chmUltra.cmdMfReadBlock(i, key)) return false;
 
-        strPage = "";
-        for (byte index = 0; index < chmUltra.cmdResponse.dataSize; index++) {
-            strPage += chmUltra.cmdResponse.data[index] < 0x10 ? F(" 0") : F(" ");
-            strPage += String(chmUltra.cmdResponse.data[index], HEX);
-        }
-        strPage.trim();
-        strPage.toUpperCase();
-
-        strAllPages += "Page " + String(dataPages) + ": " + strPage + "\n";
+        dump.setPage(dataPages, chmUltra.cmdResponse.data, chmUltra.cmdResponse.dataSize);
         dataPages++;
     }
 
@@ -832,8 +802,6 @@ bool Chameleon::readMifareClassicDataBlocks(uint8_t *key) {
 }
 
 bool Chameleon::readMifareUltralightDataBlocks() {
-    String strPage;
-
     ChameleonUltra::TagType tagType = chmUltra.getTagType(chmUltra.hfTagData.sak);
 
     switch (tagType) {
@@ -851,15 +819,7 @@ bool Chameleon::readMifareUltralightDataBlocks() {
         if (!chmUltra.cmdMfuReadPage(i)) return false;
         if (chmUltra.cmdResponse.dataSize == 0) break;
 
-        strPage = "";
-        for (byte index = 0; index < chmUltra.cmdResponse.dataSize; index++) {
-            strPage += chmUltra.cmdResponse.data[index] < 0x10 ? F(" 0") : F(" ");
-            strPage += String(chmUltra.cmdResponse.data[index], HEX);
-        }
-        strPage.trim();
-        strPage.toUpperCase();
-
-        strAllPages += "Page " + String(dataPages) + ": " + strPage + "\n";
+        dump.setPage(dataPages, chmUltra.cmdResponse.data, chmUltra.cmdResponse.dataSize);
         dataPages++;
     }
 
@@ -867,34 +827,19 @@ bool Chameleon::readMifareUltralightDataBlocks() {
 }
 
 bool Chameleon::writeHFDataBlocks() {
-    String pageLine = "";
-    String strBytes = "";
-    int lineBreakIndex;
-    int pageIndex;
     bool blockWriteSuccess;
-    int totalSize = strAllPages.length();
-
-    while (strAllPages.length() > 0) {
-        lineBreakIndex = strAllPages.indexOf("\n");
-        pageLine = strAllPages.substring(0, lineBreakIndex);
-        strAllPages = strAllPages.substring(lineBreakIndex + 1);
+    int totalSize = dump.pages();
 
-        pageIndex = pageLine.substring(5, pageLine.indexOf(":")).toInt();
-        strBytes = pageLine.substring(pageLine.indexOf(":") + 1);
-        strBytes.trim();
-        strBytes.replace(" ", "");
+    for (int pageIndex = 1; pageIndex < totalSize; pageIndex++) {
+        if (!dump.isRead(pageIndex)) continue;
 
-        if (pageIndex == 0) continue;
-
-        byte size = strBytes.length() / 2;
-        byte buffer[size];
-        for (size_t i = 0; i < strBytes.length(); i += 2) {
-            buffer[i / 2] = strtoul(strBytes.substring(i, i + 2).c_str(), NULL, 16);
-        }
+        byte size = dump.pageSize();
+        byte buffer[CARD_DUMP_MAX_PAGE_SIZE];
+        memcpy(buffer, dump.page(pageIndex), size);
 
         blockWriteSuccess = false;
         if (isMifareClassic(chmUltra.hfTagData.sak)) {
-            if (pageIndex == 0 || (pageIndex + 1) % 4 == 0) continue; // Data blocks for MIFARE Classic
+            if ((pageIndex + 1) % 4 == 0) continue; // Data blocks for MIFARE Classic
             blockWriteSuccess = chmUltra.cmdMfWriteBlock(pageIndex, {}, buffer, size);
         } else if (chmUltra.hfTagData.sak == 0x00) {
             if (pageIndex < 4 || pageIndex >= dataPages - 5) continue; // Data blocks for NTAG21X
@@ -903,7 +848,7 @@ bool Chameleon::writeHFDataBlocks() {
 
         if (!blockWriteSuccess) return false;
 
-        progressHandler(totalSize - strAllPages.length(), totalSize, "Writing data blocks...");
+        progressHandler(pageIndex + 1, totalSize, "Writing data blocks...");
     }
 
     return true;
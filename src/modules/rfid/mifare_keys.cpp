@@ -0,0 +1,102 @@
+/**
+ * @file mifare_keys.cpp
+ * @brief MIFARE Classic key dictionary with the keys that worked on each card tried first
+ * @version 0.1
+ */
+
+#include "mifare_keys.h"
+#include <globals.h>
+
+void MifareKeyCache::begin(const uint8_t (*builtin)[6], size_t count) {
+    // Any change of the keys in the settings rebuilds it
+    if (built && configVersion == bruceConfig.mifareKeysVersion) return;
+
+    table.clear();
+    table.reserve((count + bruceConfig.mifareKeys.size()) * 6);
+
+    auto add = [this](const uint8_t *key) {
+        for (size_t i = 0; i < table.size(); i += 6) {
+            if (memcmp(table.data() + i, key, 6) == 0) return;
+        }
+        table.insert(table.end(), key, key + 6);
+    };
+
+    for (size_t i = 0; i < count; i++) add(builtin[i]);
+
+    uint8_t key[6];
+    for (const auto &mifKey : bruceConfig.mifareKeys) {
+        if (mifKey.length() != 12) continue;
+        const char *hex = mifKey.c_str();
+        for (int i = 0; i < 6; i++) {
+            char byte[3] = {hex[i * 2], hex[i * 2 + 1], '\0'};
+            key[i] = strtoul(byte, NULL, 16);
+        }
+        add(key);
+    }
+    configVersion = bruceConfig.mifareKeysVersion;
+    built = true;
+
+    // Indexes changed, forget the cards
+    memset(cards, 0, sizeof(cards));
+    card = nullptr;
+    sortOrder(false);
+    sortOrder(true);
+}
+
+void MifareKeyCache::selectCard(const uint8_t *uid, uint8_t uidSize) {
+    if (card && card->uidSize == uidSize && memcmp(card->uid, uid, uidSize) == 0) return;
+
+    // Known card, or take the slot used longest ago
+    Card *oldest = &cards[0];
+    card = nullptr;
+    for (auto &c : cards) {
+        if (c.uidSize == uidSize && memcmp(c.uid, uid, uidSize) == 0) {
+            card = &c;
+            break;
+        }
+        if (c.lastUse < oldest->lastUse) oldest = &c;
+    }
+    if (!card) {
+        card = oldest;
+        memset(card, 0, sizeof(Card));
+        card->uidSize = uidSize < sizeof(card->uid) ? uidSize : sizeof(card->uid);
+        memcpy(card->uid, uid, card->uidSize);
+    }
+    card->lastUse = millis();
+    sortOrder(false);
+    sortOrder(true);
+}
+
+void MifareKeyCache::hit(bool keyB, uint16_t n) {
+    if (!card) return;
+
+    uint16_t index = order[keyB][n];
+    uint16_t *hits = card->hits[keyB];
+    uint8_t &hitCount = card->hitCount[keyB];
+    if (hitCount > 0 && hits[0] == index) return;
+
+    uint8_t pos = 0;
+    while (pos < hitCount && hits[pos] != index) pos++;
+    if (pos == hitCount && hitCount < MIFARE_KEY_CACHE_HITS) hitCount++;
+    if (pos == MIFARE_KEY_CACHE_HITS) pos--;
+
+    memmove(hits + 1, hits, pos * sizeof(uint16_t));
+    hits[0] = index;
+    sortOrder(keyB);
+}
+
+void MifareKeyCache::sortOrder(bool keyB) {
+    uint16_t keys = size();
+    std::vector<uint16_t> &o = order[keyB];
+    o.clear();
+    o.reserve(keys);
+
+    uint8_t hitCount = card ? card->hitCount[keyB] : 0;
+    const uint16_t *hits = card ? card->hits[keyB] : nullptr;
+    for (uint8_t i = 0; i < hitCount; i++) o.push_back(hits[i]);
+    for (uint16_t i = 0; i < keys; i++) {
+        bool cached = false;
+        for (uint8_t j = 0; j < hitCount && !cached; j++) cached = hits[j] == i;
+        if (!cached) o.push_back(i);
+    }
+}
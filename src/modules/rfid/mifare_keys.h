@@ -0,0 +1,55 @@
+/**
+ * @file mifare_keys.h
+ * @brief MIFARE Classic key dictionary with the keys that worked on each card tried first
+ * @version 0.1
+ */
+
+#ifndef __MIFARE_KEYS_H__
+#define __MIFARE_KEYS_H__
+
+#include <Arduino.h>
+#include <vector>
+
+#define MIFARE_KEY_CACHE_CARDS 4 // cards remembered
+#define MIFARE_KEY_CACHE_HITS 8  // keys remembered per card
+
+/**
+ * @brief The built in keys and the ones from the config are parsed once into a binary table.
+ *        key(keyB, n) walks it in try order: the keys of that type that opened other sectors of
+ *        the selected card come first, most recent first, so a card using one or two keys
+ *        authenticates every sector after the first on the first try.
+ */
+class MifareKeyCache {
+public:
+    void begin(const uint8_t (*builtin)[6], size_t count);
+    void selectCard(const uint8_t *uid, uint8_t uidSize);
+
+    uint16_t size() const { return table.size() / 6; }
+    const uint8_t *key(bool keyB, uint16_t n) const { return table.data() + order[keyB][n] * 6; }
+    void hit(bool keyB, uint16_t n); // key(keyB, n) opened a sector
+
+    // Stats of the current dump
+    uint32_t attempts = 0;
+    uint32_t reselects = 0;
+    void resetStats() { attempts = reselects = 0; }
+
+private:
+    struct Card {
+        uint8_t uid[10];
+        uint8_t uidSize;
+        uint8_t hitCount[2];
+        uint16_t hits[2][MIFARE_KEY_CACHE_HITS]; // table indexes per key type, most recent first
+        uint32_t lastUse;
+    };
+
+    std::vector<uint8_t> table; // 6 bytes per key
+    std::vector<uint16_t> order[2];
+    bool built = false;
+    uint32_t configVersion = 0; // bruceConfig.mifareKeysVersion the table was built with
+    Card cards[MIFARE_KEY_CACHE_CARDS] = {};
+    Card *card = nullptr;
+
+    void sortOrder(bool keyB);
+};
+
+#endif
@@ -116,7 +116,7 @@ void TagOMatic::set_state(RFID_State state) {
         _scanned_tags.clear();
     }
     _sourceUID = "";
-    _sourcePages = "";
+    _sourceDump.clear();
 
     switch (state) {
         case READ_MODE:
@@ -127,7 +127,7 @@ void TagOMatic::set_state(RFID_State state) {
             break;
         case CHECK_MODE:
             _sourceUID = _rfid->printableUID.uid;
-            _sourcePages = _rfid->strAllPages;
+            _sourceDump = _rfid->dump;
             padprintln("Source UID: " + _sourceUID);
             padprintln("");
             break;
@@ -193,7 +193,7 @@ void TagOMatic::dump_check_details() {
     padprintln("");
 
     padprintln("UID: " + String(_sourceUID == _rfid->printableUID.uid ? "OK" : "NOT OK"));
-    padprintln("Data: " + String(_sourcePages == _rfid->strAllPages ? "OK" : "NOT OK"));
+    padprintln("Data: " + String(_sourceDump == _rfid->dump ? "OK" : "NOT OK"));
     padprintln("");
 
     if (_rfid->pageReadStatus != RFIDInterface::SUCCESS)
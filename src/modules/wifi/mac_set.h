@@ -0,0 +1,99 @@
+#pragma once
+#include <Arduino.h>
+
+struct BeaconList {
+    char MAC[6];
+    uint8_t channel;
+};
+
+/**
+ * @brief Fixed size open addressing hash set of MAC addresses (+ channel tag).
+ *        Never allocates, so it is safe to use from the promiscuous callback.
+ *        Inserts are refused once 3/4 of the slots are used, refused() counts them so the
+ *        caller can show that the set is full.
+ *
+ * @tparam N number of slots, must be a power of two
+ */
+template <size_t N> class MacSet {
+    static_assert((N & (N - 1)) == 0, "MacSet size must be a power of two");
+
+    struct Slot {
+        BeaconList entry;
+        uint8_t used;
+    };
+
+    Slot slots[N] = {};
+    size_t count = 0;
+    uint32_t refusedCount = 0;
+
+    static uint32_t hash(const uint8_t *mac, uint8_t tag) {
+        // FNV-1a, the last bytes of a MAC carry most of the entropy
+        uint32_t h = 2166136261u;
+        for (int i = 0; i < 6; i++) h = (h ^ mac[i]) * 16777619u;
+        return (h ^ tag) * 16777619u;
+    }
+
+    // Returns the slot holding the key, or the empty slot where it would be inserted
+    Slot *find(const uint8_t *mac, uint8_t tag) {
+        size_t i = hash(mac, tag) & (N - 1);
+        for (size_t probe = 0; probe < N; probe++, i = (i + 1) & (N - 1)) {
+            Slot &s = slots[i];
+            if (!s.used) return &s;
+            if (s.entry.channel == tag && memcmp(s.entry.MAC, mac, 6) == 0) return &s;
+        }
+        return nullptr;
+    }
+
+public:
+    class iterator {
+        const Slot *cur, *end;
+        void skip() {
+            while (cur != end && !cur->used) cur++;
+        }
+
+    public:
+        iterator(const Slot *c, const Slot *e) : cur(c), end(e) { skip(); }
+        const BeaconList &operator*() const { return cur->entry; }
+        iterator &operator++() {
+            cur++;
+            skip();
+            return *this;
+        }
+        bool operator!=(const iterator &other) const { return cur != other.cur; }
+    };
+
+    iterator begin() const { return iterator(slots, slots + N); }
+    iterator end() const { return iterator(slots + N, slots + N); }
+
+    bool contains(const uint8_t *mac, uint8_t tag = 0) {
+        Slot *s = find(mac, tag);
+        return s && s->used;
+    }
+
+    // Returns true only when the MAC was not in the set and was added
+    bool insert(const uint8_t *mac, uint8_t tag = 0) {
+        Slot *s = find(mac, tag);
+        if (s && s->used) return false;
+        if (!s || count >= N * 3 / 4) {
+            refusedCount++;
+            return false;
+        }
+        memcpy(s->entry.MAC, mac, 6);
+        s->entry.channel = tag;
+        s->used = 1;
+        count++;
+        return true;
+    }
+    bool insert(const BeaconList &b) { return insert((const uint8_t *)b.MAC, b.channel); }
+
+    size_t size() const { return count; }
+    bool full() const { return count >= N * 3 / 4; }
+    static constexpr size_t capacity() { return N * 3 / 4; }
+    uint32_t refused() const { return refusedCount; } // new MACs not added since the last clear()
+
+    void clear() {
+        for (size_t i = 0; i < N; i++) slots[i].used = 0;
+        count = 0;
+        refusedCount = 0;
+    }
+};
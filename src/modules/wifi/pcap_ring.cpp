@@ -0,0 +1,130 @@
+#include "pcap_ring.h"
+
+static inline uint32_t alignedSize(uint32_t len) { return (sizeof(PcapRingRecord) + len + 3) & ~3u; }
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Ring
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool PcapRing::begin(uint32_t size) {
+    if (buffer) return true;
+    buffer = (uint8_t *)(psramFound() ? ps_malloc(size) : malloc(size));
+    if (!buffer) return false;
+    ringSize = size;
+    head = 0;
+    tail = 0;
+    return true;
+}
+
+void PcapRing::end() {
+    free(buffer);
+    buffer = nullptr;
+    ringSize = 0;
+}
+
+bool PcapRing::push(
+    uint8_t kind, uint32_t ts_sec, uint32_t ts_usec, const uint8_t *payload, uint32_t len,
+    uint8_t channel, uint32_t *used
+) {
+    if (len > PCAP_MAX_FRAME) len = PCAP_MAX_FRAME;
+
+    uint32_t need = alignedSize(len);
+    uint32_t h = head;
+    uint32_t t = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    uint32_t pos = h & (ringSize - 1);
+    uint32_t contiguous = ringSize - pos;
+    uint32_t total = contiguous < need ? contiguous + need : need;
+
+    *used = h - t;
+    if (ringSize - (h - t) < total) return false;
+
+    if (contiguous < need) { // record doesn't fit at the end, skip to the beginning
+        ((PcapRingRecord *)(buffer + pos))->len = PCAP_RING_WRAP;
+        h += contiguous;
+        pos = 0;
+    }
+
+    PcapRingRecord *rec = (PcapRingRecord *)(buffer + pos);
+    rec->len = len;
+    rec->kind = kind;
+    rec->channel = channel;
+    rec->ts_sec = ts_sec;
+    rec->ts_usec = ts_usec;
+    memcpy(buffer + pos + sizeof(PcapRingRecord), payload, len);
+
+    h += need;
+    __atomic_store_n(&head, h, __ATOMIC_RELEASE);
+    *used = h - t;
+    return true;
+}
+
+const PcapRingRecord *PcapRing::front() {
+    uint32_t t = tail;
+    for (;;) {
+        if (t == __atomic_load_n(&head, __ATOMIC_ACQUIRE)) return nullptr;
+        uint32_t pos = t & (ringSize - 1);
+        PcapRingRecord *rec = (PcapRingRecord *)(buffer + pos);
+        if (rec->len != PCAP_RING_WRAP) return rec;
+        t += ringSize - pos;
+        __atomic_store_n(&tail, t, __ATOMIC_RELEASE);
+    }
+}
+
+void PcapRing::pop() {
+    const PcapRingRecord *rec = front();
+    if (rec) __atomic_store_n(&tail, tail + alignedSize(rec->len), __ATOMIC_RELEASE);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Batches
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool PcapBatchWriter::begin() {
+    if (!batch) batch = (uint8_t *)malloc(PCAP_BATCH_SIZE);
+    return batch != nullptr;
+}
+
+void PcapBatchWriter::end() {
+    free(batch);
+    batch = nullptr;
+    file = nullptr;
+}
+
+void PcapBatchWriter::start(File *_file) {
+    file = _file;
+    filePos = (file && *file) ? file->size() : 0;
+    fill = 0;
+    limit = PCAP_BATCH_SIZE - (filePos % PCAP_BATCH_SIZE);
+}
+
+void PcapBatchWriter::writeBatch() {
+    if (fill == 0) return;
+    if (file && *file) file->write(batch, fill);
+    filePos += fill;
+    fill = 0;
+    limit = PCAP_BATCH_SIZE - (filePos % PCAP_BATCH_SIZE);
+}
+
+void PcapBatchWriter::appendBytes(const uint8_t *data, uint32_t len) {
+    while (len > 0) {
+        uint32_t take = limit - fill;
+        if (take > len) take = len;
+        memcpy(batch + fill, data, take);
+        fill += take;
+        data += take;
+        len -= take;
+        if (fill == limit) writeBatch();
+    }
+}
+
+void PcapBatchWriter::append(const PcapRingRecord *rec) {
+    if (!file || !*file) return;
+    uint32_t hdr[4] = {rec->ts_sec, rec->ts_usec, rec->len, rec->len};
+    appendBytes((uint8_t *)hdr, sizeof(hdr));
+    appendBytes((const uint8_t *)(rec + 1), rec->len);
+}
+
+void PcapBatchWriter::flush() {
+    writeBatch();
+    if (file && *file) file->flush();
+}
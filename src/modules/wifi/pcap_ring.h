@@ -0,0 +1,75 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+
+// Ring and batching of the pcap writer, without FreeRTOS or WiFi, so it also builds on a host
+// ([env:native], the replay benchmark)
+
+#define PCAP_BATCH_SIZE 4096  // SD sector multiple, size of each write to the raw file
+#define PCAP_MAX_FRAME 2500   // same as the snaplen written in the pcap header
+#define PCAP_RING_WRAP 0xFFFF // marks the unused tail of the ring, reader jumps to 0
+
+// Record header stored in the ring, payload follows it. Records are 4 bytes aligned.
+struct __attribute__((packed)) PcapRingRecord {
+    uint16_t len;
+    uint8_t kind;
+    uint8_t channel;
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+};
+
+/**
+ * @brief Single producer / single consumer ring of variable size frames.
+ *        push() from the producer (the promiscuous callback) only, front() and pop() from the
+ *        consumer only. Never blocks and never allocates after begin().
+ */
+class PcapRing {
+public:
+    ~PcapRing() { end(); }
+    bool begin(uint32_t size); // size must be a power of two, PSRAM when available
+    void end();
+    bool ready() const { return buffer != nullptr; }
+
+    // Copies the frame, cut at PCAP_MAX_FRAME. false when it doesn't fit, *used gets the bytes in use
+    bool push(
+        uint8_t kind, uint32_t ts_sec, uint32_t ts_usec, const uint8_t *payload, uint32_t len,
+        uint8_t channel, uint32_t *used
+    );
+    // Oldest record, its payload follows the header. nullptr when empty
+    const PcapRingRecord *front();
+    void pop();
+
+    uint32_t size() const { return ringSize; }
+
+private:
+    uint8_t *buffer = nullptr;
+    uint32_t ringSize = 0;
+    uint32_t head = 0; // free running, written by the producer only
+    uint32_t tail = 0; // free running, written by the consumer only
+};
+
+/**
+ * @brief Gathers pcap records into PCAP_BATCH_SIZE writes aligned to the file offset, so the SD card
+ *        sees whole sectors instead of one small write per frame.
+ */
+class PcapBatchWriter {
+public:
+    ~PcapBatchWriter() { end(); }
+    bool begin(); // the batch buffer, internal RAM so SD can DMA from it
+    void end();
+
+    void start(File *file); // nullptr drops the raw frames
+    void append(const PcapRingRecord *rec);
+    void flush(); // writes the partial batch and flushes the file
+    uint32_t position() const { return filePos + fill; }
+
+private:
+    uint8_t *batch = nullptr;
+    uint32_t fill = 0;
+    uint32_t limit = PCAP_BATCH_SIZE;
+    uint32_t filePos = 0;
+    File *file = nullptr;
+
+    void appendBytes(const uint8_t *data, uint32_t len);
+    void writeBatch();
+};
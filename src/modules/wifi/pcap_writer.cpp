@@ -0,0 +1,163 @@
+/*
+  Single producer / single consumer ring between the promiscuous callback and a writer task.
+  The callback only copies frames into the ring, all the filesystem work happens in the task,
+  which batches the raw capture into sector aligned writes.
+*/
+#include "pcap_writer.h"
+#include "core/sd_functions.h"
+#include "esp_wifi.h"
+#include "pcap_ring.h"
+#include "sniffer.h"
+#include <LittleFS.h>
+#include <globals.h>
+
+#define PCAP_RING_SIZE_PSRAM (128 * 1024) // must be a power of two
+#define PCAP_RING_SIZE_RAM (16 * 1024)    // must be a power of two
+#define PCAP_FLUSH_INTERVAL 1000          // ms between forced flushes of the open files
+
+static PcapRing ring;
+static PcapBatchWriter batch;
+
+static FS *writerFs = nullptr;
+static TaskHandle_t writerTask = NULL;
+static volatile bool writerStop = false;
+static volatile bool writerDone = true;
+
+static volatile uint32_t statQueued = 0;
+static volatile uint32_t statWritten = 0;
+static volatile uint32_t statDropped = 0;
+static volatile uint32_t statHighWater = 0;
+// The counters only grow, a reset keeps a baseline to subtract instead of clearing counters the
+// callback and the writer task are updating. The high water mark is restarted by the callback itself
+static uint32_t baseQueued = 0;
+static uint32_t baseWritten = 0;
+static uint32_t baseDropped = 0;
+static volatile bool highWaterReset = false;
+
+bool pcapWriterPush(
+    PcapRecordKind kind, uint32_t ts_sec, uint32_t ts_usec, const uint8_t *payload, uint32_t len,
+    uint8_t channel
+) {
+    if (!ring.ready()) return false;
+
+    uint32_t used;
+    if (!ring.push(kind, ts_sec, ts_usec, payload, len, channel, &used)) {
+        statDropped++;
+        return false;
+    }
+    if (highWaterReset || used > statHighWater) {
+        statHighWater = used;
+        highWaterReset = false;
+    }
+    statQueued++;
+
+    // wake the writer earlier when the ring is getting full, otherwise it polls
+    if (used > ring.size() / 2 && writerTask) xTaskNotifyGive(writerTask);
+    return true;
+}
+
+static void drainRing() {
+    while (const PcapRingRecord *rec = ring.front()) {
+        if (rec->kind == PCAP_REC_RAW) {
+            batch.append(rec);
+        } else if (writerFs) {
+            saveHandshake(
+                (const uint8_t *)(rec + 1),
+                rec->len,
+                rec->ts_sec,
+                rec->ts_usec,
+                rec->channel,
+                rec->kind == PCAP_REC_BEACON,
+                *writerFs
+            );
+        }
+        statWritten++;
+        ring.pop();
+    }
+}
+
+static void flushFiles() {
+    batch.flush();
+    flushHandshakeFiles();
+
+    // If using LittleFS to save .pcaps and there's no room for data, stop sniffing
+    if (isLittleFS && !checkLittleFsSizeNM()) {
+        returnToMenu = true;
+        esp_wifi_set_promiscuous(false);
+    }
+}
+
+static void pcapWriterTask(void *pvParameters) {
+    uint32_t lastFlush = millis();
+    for (;;) {
+        bool stop = writerStop; // read before draining, so the last pass catches everything queued
+        drainRing();
+        if (stop || millis() - lastFlush > PCAP_FLUSH_INTERVAL) {
+            flushFiles();
+            lastFlush = millis();
+        }
+        if (stop) {
+            closeHandshakeFiles();
+            break;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+    }
+    writerDone = true;
+    vTaskDelete(NULL);
+}
+
+bool pcapWriterBegin(FS *fs, File *rawFile) {
+    if (writerTask) pcapWriterEnd(false);
+
+    if (!ring.begin(psramFound() ? PCAP_RING_SIZE_PSRAM : PCAP_RING_SIZE_RAM)) {
+        Serial.println("Fail allocating the pcap ring buffer");
+        return false;
+    }
+    if (!batch.begin()) {
+        Serial.println("Fail allocating the pcap write buffer");
+        return false;
+    }
+
+    writerFs = fs;
+    batch.start(rawFile);
+
+    writerStop = false;
+    writerDone = false;
+    if (xTaskCreate(pcapWriterTask, "PcapWriter", 4096, NULL, 2, &writerTask) != pdPASS) {
+        writerTask = NULL;
+        writerDone = true;
+        Serial.println("Fail starting the pcap writer task");
+        return false;
+    }
+    return true;
+}
+
+void pcapWriterEnd(bool release) {
+    if (writerTask) {
+        TaskHandle_t task = writerTask;
+        writerTask = NULL; // the callback must not notify a task that is about to be deleted
+        writerStop = true;
+        xTaskNotifyGive(task);
+        while (!writerDone) vTaskDelay(5 / portTICK_PERIOD_MS);
+    }
+    batch.start(nullptr);
+
+    if (release) {
+        ring.end();
+        batch.end();
+    }
+}
+
+PcapWriterStats pcapWriterStats() {
+    uint32_t highWater = highWaterReset ? 0 : statHighWater;
+    return {
+        statQueued - baseQueued, statWritten - baseWritten, statDropped - baseDropped, highWater, ring.size()
+    };
+}
+
+void pcapWriterResetStats() {
+    baseQueued = statQueued;
+    baseWritten = statWritten;
+    baseDropped = statDropped;
+    highWaterReset = true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+
+// Kind of frame queued by the promiscuous callback
+enum PcapRecordKind : uint8_t {
+    PCAP_REC_RAW = 0,    // goes to the session raw_N.pcap file
+    PCAP_REC_EAPOL = 1,  // goes to /BrucePCAP/handshakes/HS_<mac>.pcap
+    PCAP_REC_BEACON = 2, // appended to the handshake file of its AP, if one exists
+};
+
+struct PcapWriterStats {
+    uint32_t queued;    // frames accepted by the ring
+    uint32_t written;   // frames written to the filesystem
+    uint32_t dropped;   // frames lost because the ring was full
+    uint32_t highWater; // max bytes used in the ring
+    uint32_t capacity;  // ring size in bytes
+};
+
+/**
+ * @brief Allocates the ring (PSRAM when available) and starts the writer task.
+ *        The ring is kept across pcapWriterEnd(false) calls, so frames queued while the
+ *        writer is stopped (ex: changing files) are written once it is started again.
+ *
+ * @param fs filesystem where handshake files are written
+ * @param rawFile already opened session pcap, or nullptr when only handshakes are saved
+ */
+bool pcapWriterBegin(FS *fs, File *rawFile);
+
+/**
+ * @brief Drains the ring, flushes pending batches and stops the writer task.
+ *
+ * @param release frees the ring too. Only pass true after the promiscuous callback was removed.
+ */
+void pcapWriterEnd(bool release);
+
+/**
+ * @brief Copies a frame into the ring. Safe to call from the WiFi driver callback,
+ *        never touches the filesystem and never blocks.
+ */
+bool pcapWriterPush(
+    PcapRecordKind kind, uint32_t ts_sec, uint32_t ts_usec, const uint8_t *payload, uint32_t len,
+    uint8_t channel
+);
+
+// Both from the same task (the sniffer UI), the callback and the writer keep running meanwhile
+PcapWriterStats pcapWriterStats();
+
+void pcapWriterResetStats();
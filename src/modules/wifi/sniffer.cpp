@@ -15,7 +15,6 @@
 // #include "esp_event_loop.h"
 #include "driver/gpio.h"
 #include "nvs_flash.h"
-#include <set>
 
 #include "FS.h"
 #include "core/display.h"
@@ -32,6 +31,7 @@
 #include <SPI.h>
 #include <SdFat.h>
 #endif
+#include "modules/wifi/pcap_writer.h"
 #include "modules/wifi/wifi_atks.h" // to use deauth frames and cmds
 
 //===== SETTINGS =====//
@@ -61,12 +61,38 @@ uint32_t start_time     = 0;
 long     deauth_tmp = 0;
 
 File _pcap_file;
-std::set<BeaconList> registeredBeacons;
-std::set<String> SavedHS; // Saves the MAC of beacon HS detected in the session
+BeaconSet registeredBeacons;
+static portMUX_TYPE beaconLock = portMUX_INITIALIZER_UNLOCKED;
+HandshakeSet SavedHS;        // Saves the MAC of beacon HS detected in the session
+HandshakeSet SavedHSBeacons; // Beacons already appended to a HS file, owned by the pcap writer task
 String filename = "/BrucePCAP/" + (String)FILENAME + ".pcap";
 
 //===== FUNCTIONS =====//
 
+void registerBeacon(const uint8_t *mac, uint8_t channel) {
+    portENTER_CRITICAL(&beaconLock);
+    registeredBeacons.insert(mac, channel);
+    portEXIT_CRITICAL(&beaconLock);
+}
+
+void clearRegisteredBeacons() {
+    portENTER_CRITICAL(&beaconLock);
+    registeredBeacons.clear();
+    portEXIT_CRITICAL(&beaconLock);
+}
+
+size_t registeredBeaconsOn(uint8_t channel, const BeaconList *&list) {
+    static BeaconList targets[BeaconSet::capacity()];
+    size_t count = 0;
+    portENTER_CRITICAL(&beaconLock);
+    for (const BeaconList &b : registeredBeacons) {
+        if (b.channel == channel && count < BeaconSet::capacity()) targets[count++] = b;
+    }
+    portEXIT_CRITICAL(&beaconLock);
+    list = targets;
+    return count;
+}
+
 // Thank you 7h30th3r0n3 for helping me solve this issue! and for sharing your EAPOL/Handshake sniffer
 // please, give stars to his project: https://github.com/7h30th3r0n3/Evil-M5Core2/
 
@@ -107,22 +133,39 @@ typedef struct pcaprec_hdr_s {
     uint32_t orig_len; /* longueur réelle du paquet */
 } pcaprec_hdr_t;
 
-void saveHandshake(const wifi_promiscuous_pkt_t *packet, bool beacon, FS &Fs) {
-    // Construire le nom du fichier en utilisant les adresses MAC de l'AP et du client
-    const uint8_t *addr1 = packet->payload + 4;  // Adresse du destinataire (Adresse 1)
-    const uint8_t *addr2 = packet->payload + 10; // Adresse de l'expéditeur (Adresse 2)
-    const uint8_t *bssid = packet->payload + 16; // Adresse BSSID (Adresse 3)
-    const uint8_t *apAddr;
-
-    if (memcmp(addr1, bssid, 6) == 0) {
-        apAddr = addr1;
-    } else {
-        apAddr = addr2;
+// Handshake files stay open between frames, the least recently used one is closed when a new AP shows up.
+// SD is mounted with 5 max open files and the raw pcap already uses one.
+#define HS_FILE_CACHE 3
+
+struct HSFileSlot {
+    uint8_t mac[6];
+    File file;
+    uint32_t lastUse;
+    bool dirty;
+};
+static HSFileSlot hsFiles[HS_FILE_CACHE];
+static uint32_t hsUseCounter = 0;
+
+static HSFileSlot *getHandshakeFile(const uint8_t *apAddr, bool create, FS &Fs) {
+    HSFileSlot *slot = &hsFiles[0];
+    for (int i = 0; i < HS_FILE_CACHE; i++) {
+        if (hsFiles[i].file && memcmp(hsFiles[i].mac, apAddr, 6) == 0) {
+            if (!create) {
+                hsFiles[i].lastUse = ++hsUseCounter;
+                return &hsFiles[i];
+            }
+            slot = &hsFiles[i]; // file is being recreated, reuse its slot
+            break;
+        }
+        if (!hsFiles[i].file) slot = &hsFiles[i];
+        else if (slot->file && hsFiles[i].lastUse < slot->lastUse) slot = &hsFiles[i];
     }
+    if (slot->file) slot->file.close(); // evict, close() flushes it
 
     char nomFichier[50];
-    sprintf(
+    snprintf(
         nomFichier,
+        sizeof(nomFichier),
         "/BrucePCAP/handshakes/HS_%02X%02X%02X%02X%02X%02X.pcap",
         apAddr[0],
         apAddr[1],
@@ -131,50 +174,83 @@ void saveHandshake(const wifi_promiscuous_pkt_t *packet, bool beacon, FS &Fs) {
         apAddr[4],
         apAddr[5]
     );
+    // if the file already exists in the new session, will overwrite it
+    slot->file = Fs.open(nomFichier, create ? FILE_WRITE : FILE_APPEND);
+    if (!slot->file) return nullptr;
+    memcpy(slot->mac, apAddr, 6);
+    slot->lastUse = ++hsUseCounter;
+    slot->dirty = false;
+    return slot;
+}
+
+void flushHandshakeFiles() {
+    for (int i = 0; i < HS_FILE_CACHE; i++) {
+        if (hsFiles[i].file && hsFiles[i].dirty) {
+            hsFiles[i].file.flush();
+            hsFiles[i].dirty = false;
+        }
+    }
+}
 
-    // Vérifier si le fichier existe déjà
-    bool fichierExiste = false;
+void closeHandshakeFiles() {
+    for (int i = 0; i < HS_FILE_CACHE; i++) {
+        if (hsFiles[i].file) hsFiles[i].file.close();
+        hsFiles[i].dirty = false;
+    }
+}
+
+// Runs on the pcap writer task, never from the promiscuous callback
+void saveHandshake(
+    const uint8_t *payload, uint32_t len, uint32_t ts_sec, uint32_t ts_usec, uint8_t channel, bool beacon,
+    FS &Fs
+) {
+    // Construire le nom du fichier en utilisant les adresses MAC de l'AP et du client
+    const uint8_t *addr1 = payload + 4;  // Adresse du destinataire (Adresse 1)
+    const uint8_t *addr2 = payload + 10; // Adresse de l'expéditeur (Adresse 2)
+    const uint8_t *bssid = payload + 16; // Adresse BSSID (Adresse 3)
+    const uint8_t *apAddr;
+
+    if (memcmp(addr1, bssid, 6) == 0) {
+        apAddr = addr1;
+    } else {
+        apAddr = addr2;
+    }
 
     // Check if the MAC Address was registered in the list
-    if (SavedHS.find(String((char *)apAddr, 6)) != SavedHS.end()) { fichierExiste = true; }
+    bool fichierExiste = SavedHS.contains(apAddr);
 
     // Si probe est true et que le fichier n'existe pas, ignorer l'enregistrement
     if (beacon && !fichierExiste) { return; }
 
+    // No room to remember a new AP, skip it instead of overwriting its file on every EAPOL
+    if (!fichierExiste && SavedHS.full()) { return; }
+
+    // Beacon déjà enregistré pour ce BSSID
+    if (beacon && !SavedHSBeacons.insert(apAddr, channel)) { return; }
+
     // Ouvrir le fichier en mode ajout si existant sinon en mode écriture
-    File fichierPcap = Fs.open(
-        nomFichier, fichierExiste ? FILE_APPEND : FILE_WRITE
-    ); // if the file already exists in the new session, will overwrite it
+    HSFileSlot *fichierPcap = getHandshakeFile(apAddr, !fichierExiste, Fs);
     if (!fichierPcap) {
         Serial.println("Fail creating the EAPOL/Handshake PCAP file");
         return;
     }
 
-    if (!beacon && !fichierExiste) {
+    if (!fichierExiste) {
         // Serial.println("New EAPOL/Handshake PCAP file, writing header");
-        SavedHS.insert(String((char *)apAddr, 6));
+        SavedHS.insert(apAddr);
         num_HS++;
-        writeHeader(fichierPcap);
-    }
-    if (beacon && fichierExiste) {
-        BeaconList ThisBeacon;
-        memcpy(ThisBeacon.MAC, (char *)apAddr, 6);
-        ThisBeacon.channel = ch;
-        if (registeredBeacons.find(ThisBeacon) != registeredBeacons.end()) {
-            return; // Beacon déjà enregistré pour ce BSSID
-        }
-        registeredBeacons.insert(ThisBeacon); // Ajouter le BSSID à l'ensemble
+        writeHeader(fichierPcap->file);
     }
 
     // Écrire l'en-tête du paquet et le paquet lui-même dans le fichier
     pcaprec_hdr_t pcap_packet_header;
-    pcap_packet_header.ts_sec = packet->rx_ctrl.timestamp / 1000000;
-    pcap_packet_header.ts_usec = packet->rx_ctrl.timestamp % 1000000;
-    pcap_packet_header.incl_len = packet->rx_ctrl.sig_len;
-    pcap_packet_header.orig_len = packet->rx_ctrl.sig_len;
-    fichierPcap.write((const byte *)&pcap_packet_header, sizeof(pcaprec_hdr_t));
-    fichierPcap.write(packet->payload, packet->rx_ctrl.sig_len);
-    fichierPcap.close();
+    pcap_packet_header.ts_sec = ts_sec;
+    pcap_packet_header.ts_usec = ts_usec;
+    pcap_packet_header.incl_len = len;
+    pcap_packet_header.orig_len = len;
+    fichierPcap->file.write((const byte *)&pcap_packet_header, sizeof(pcaprec_hdr_t));
+    fichierPcap->file.write(payload, len);
+    fichierPcap->dirty = true;
 }
 
 void printAddress(const uint8_t *addr) {
@@ -228,15 +304,9 @@ bool writeHeader(File file) {
 }
 
 /* will be executed on every packet the ESP32 gets while beeing in promiscuous mode */
-// Sniffer callback
+// Sniffer callback: only copies frames into the pcap writer ring, files are handled by its task
+// (if using LittleFS and there's no room for data, the writer task stops promiscuous mode)
 void sniffer(void *buf, wifi_promiscuous_pkt_type_t type) {
-    // If using LittleFS to save .pcaps and there's no room for data, don't do anything whith new packets
-  
-    if (isLittleFS && !checkLittleFsSizeNM()) {
-        returnToMenu = true;
-        esp_wifi_set_promiscuous(false);
-        return;
-    }
     wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)buf;
     wifi_pkt_rx_ctrl_t ctrl = (wifi_pkt_rx_ctrl_t)pkt->rx_ctrl;
 
@@ -246,57 +316,51 @@ void sniffer(void *buf, wifi_promiscuous_pkt_type_t type) {
     const uint8_t frameSubType = (frameControl & 0xF0) >> 4;
 
     packet_counter++;
-    
+
     if (isItEAPOL(pkt)) {
-        // if(_only_HS) newPacketSD(timestamp, microseconds, len, pkt->payload, _pcap_file);
         num_EAPOL++;
-        // Serial.println("EAPOL detected.");
-        const uint8_t *receiverAddr = frame + 4;
-        const uint8_t *senderAddr = frame + 10;
-        // Serial.print("Address MAC destination: ");
-        // printAddress(receiverAddr);
-        // Serial.print("Address MAC expedition: ");
-        // printAddress(senderAddr);
-        if (isLittleFS) saveHandshake(pkt, false, LittleFS);
-        else saveHandshake(pkt, false, SD);
+        pcapWriterPush(
+            PCAP_REC_EAPOL,
+            ctrl.timestamp / 1000000,
+            ctrl.timestamp % 1000000,
+            pkt->payload,
+            ctrl.sig_len,
+            ch
+        );
     }
 
     // Beacon frame
     if (frameType == 0x00 && frameSubType == 0x08) {
         const uint8_t *senderAddr = frame + 10; // Beacon source address
-	beacon_frames++;
-        
-        pkt->rx_ctrl.sig_len -= 4; // cut off last 4 b
-        // save the packet
-        if(isLittleFS) saveHandshake(pkt, true, LittleFS);
-	else           saveHandshake(pkt, true, SD);
-
-	//Save beacon to the list
-	BeaconList ThisBeacon;
-        memcpy(ThisBeacon.MAC, (char *)senderAddr, 6);
-        ThisBeacon.channel = ch;
-	//Check if already registered
-        if (registeredBeacons.find(ThisBeacon) != registeredBeacons.end()) {
-	  return;
-        }
-        registeredBeacons.insert(ThisBeacon); // add to the list
+        beacon_frames++;
+
+        // save the packet, cutting off the last 4 bytes
+        pcapWriterPush(
+            PCAP_REC_BEACON,
+            ctrl.timestamp / 1000000,
+            ctrl.timestamp % 1000000,
+            pkt->payload,
+            ctrl.sig_len - 4,
+            ch
+        );
+
+        // Save beacon to the list, MacSet ignores it if already registered
+        registerBeacon(senderAddr, ch);
     }
-    
+
     // If we just want handshakes, quit now
-    if(_only_HS) return;
-    
+    if (_only_HS) return;
+
     if (fileOpen) {
         uint32_t timestamp = now();                                         // current timestamp
         uint32_t microseconds = (unsigned int)(micros() - millis() * 1000); // microseconds offset (0 - 999)
 
         uint32_t len = ctrl.sig_len;
         if (type == WIFI_PKT_MGMT) {
-            len -= 4; // Remove last 4 bytes (for checksum) or packet gets malformed 
+            len -= 4; // Remove last 4 bytes (for checksum) or packet gets malformed
                       // https://github.com/espressif/esp-idf/issues/886
         }
-        newPacketSD(
-            timestamp, microseconds, len, pkt->payload, _pcap_file
-		    ); // write packet to sd
+        pcapWriterPush(PCAP_REC_RAW, timestamp, microseconds, pkt->payload, len, ch); // queue packet to sd
     }
 }
 
@@ -364,7 +428,15 @@ void sniffer_setup() {
     tft.setCursor(80, 100);
 
     SavedHS.clear(); // Need to clear to restart HS count
-    registeredBeacons.clear();
+    SavedHSBeacons.clear();
+    clearRegisteredBeacons();
+    pcapWriterResetStats();
+    if (!pcapWriterBegin(Fs, &_pcap_file)) {
+        displayError("Not enough memory", true);
+        _pcap_file.close();
+        fileOpen = false;
+        return;
+    }
     /* setup wifi */
     nvs_flash_init();
     ESP_ERROR_CHECK(esp_netif_init()); // novo
@@ -445,7 +517,6 @@ void sniffer_setup() {
             }
             if (millis() - _tmp > 700) { // longpress detected to exit
                 returnToMenu = true;
-                _pcap_file.close();
                 break;
             }
 #endif
@@ -469,7 +540,6 @@ void sniffer_setup() {
     ) // T-Embed has a different btn for Escape, different from StickCs that uses Previous btn
         if (check(EscPress)) { // Apertar o botão power ou Esc
             returnToMenu = true;
-            _pcap_file.close();
             break;
         }
 #endif
@@ -480,14 +550,15 @@ void sniffer_setup() {
                      [=]() {
                          if (_pcap_file) { // for the first run, only draws the screen, after that, changes
                                            // files
-                             _pcap_file.flush(); // save file
+                             fileOpen = false;      // update flag, new frames stay in the ring meanwhile
+                             pcapWriterEnd(false);  // writes what was queued and flushes the file
                              // Serial.println("==================");
                              // Serial.println(filename + " saved!");
                              // Serial.println("==================");
-                             fileOpen = false; // update flag
                              _pcap_file.close();
                              c++;           // add to filename
                              openFile(*Fs); // open new file
+                             pcapWriterBegin(Fs, &_pcap_file);
                          }
                      }                                                                          },
                     {deauth ? "Disable deauth" : "Enable deauth",      [&]() { deauth = !deauth; }    },
@@ -499,8 +570,9 @@ void sniffer_setup() {
                          num_HS = 0;
 			 start_time = millis();
 			 beacon_frames = 0;
-			 registeredBeacons.clear();
+			 clearRegisteredBeacons();
 			 deauth_tmp = millis();
+			 pcapWriterResetStats();
 			 
                      }                                                                          },
                     {"Exit Sniffer",                             [=]() { returnToMenu = true; } },
@@ -534,6 +606,21 @@ void sniffer_setup() {
 	  padprintln("Run time " + String(runtime/60) + ":" + String(runtime%60));
 	  //padprintln("millis=" + String(millis()));
 	  padprintln("Beacons " + String(beacon_frames) + " tot. /" + String(registeredBeacons.size()) + " in mem.");
+	  if (registeredBeacons.full()) {
+	    // new APs are not remembered (nor deauthed) until the list is cleared
+	    tft.setTextColor(bruceConfig.bgColor, bruceConfig.priColor);
+	    padprintln(
+		       "AP list full (" + String(registeredBeacons.capacity()) + "), " +
+		       String(registeredBeacons.refused()) + " not stored"
+		       );
+	    tft.setTextColor(bruceConfig.priColor, bruceConfig.bgColor);
+	  }
+	  PcapWriterStats ringStats = pcapWriterStats();
+	  padprintln(
+		     "Buffer: " + String(ringStats.dropped) + " dropped, peak " +
+		     String(ringStats.capacity ? ringStats.highWater * 100 / ringStats.capacity : 0) + "% of " +
+		     String(ringStats.capacity / 1024) + "kB"
+		     );
 
 	  // make a nice reverse video bar
 	  tft.setTextColor(bruceConfig.bgColor, bruceConfig.priColor);
@@ -545,30 +632,23 @@ void sniffer_setup() {
 
 	}
 
-	if (currentTime - lastTime > 100) tft.drawPixel(0, 0, 0);
-
-        if (fileOpen && currentTime - lastTime > 1000) {
-	  _pcap_file.flush();     // save file
-            lastTime = currentTime; // update time
-            
-        }
+	if (currentTime - lastTime > 100) {
+	  tft.drawPixel(0, 0, 0);
+	  lastTime = currentTime; // update time
+	}
 
         if (deauth && (millis() - deauth_tmp) > DEAUTH_INTERVAL) {
 	  bool deauth_sent = false;
-            if (registeredBeacons.size() > 40)
-                registeredBeacons.clear(); // Clear registered beacons to restart search and avoid restarts
             Serial.println("<<---- Starting Deauthentication Process ---->>");
-            for (auto registeredBeacon : registeredBeacons) {
-                if (registeredBeacon.channel == ch) {
-                    memcpy(&ap_record.bssid, registeredBeacon.MAC, 6);
-                    wsl_bypasser_send_raw_frame(
-                        &ap_record, registeredBeacon.channel
-                    ); // writes the buffer with the information
-		    //XXX: ap_record reused between this and wifi_atks.h
-                    send_raw_frame(deauth_frame, 26);
-		    deauth_sent = true; deauth_counter++;
-                    vTaskDelay(2 / portTICK_RATE_MS);
-                }
+            const BeaconList *targets;
+            size_t count = registeredBeaconsOn(ch, targets);
+            for (size_t i = 0; i < count; i++) {
+                memcpy(&ap_record.bssid, targets[i].MAC, 6);
+                wsl_bypasser_send_raw_frame(&ap_record, ch); // writes the buffer with the information
+		//XXX: ap_record reused between this and wifi_atks.h
+                send_raw_frame(deauth_frame, 26);
+		deauth_sent = true; deauth_counter++;
+                vTaskDelay(2 / portTICK_RATE_MS);
             }
 	    if(deauth_sent) tft.drawString("Deauth sent.", 10, tftHeight - 14);
 
@@ -588,6 +668,9 @@ Exit:
     esp_wifi_set_promiscuous(false);
     esp_wifi_stop();
     esp_wifi_set_promiscuous_rx_cb(NULL);
+    pcapWriterEnd(true); // writes everything left in the ring before closing
+    fileOpen = false;
+    _pcap_file.close();
     esp_wifi_deinit();
     wifiDisconnect();
     vTaskDelay(1 / portTICK_RATE_MS);
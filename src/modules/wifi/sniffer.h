@@ -3,21 +3,7 @@
 #include <FS.h>
 #include <SD.h>
 #include <WiFi.h>
-#include <set>
-
-struct BeaconList {
-    char MAC[6];
-    uint8_t channel;
-    // Define comparison operator to use <set>
-    bool operator<(const BeaconList &other) const {
-        // Compare MACs (using memcmp)
-        int cmp = memcmp(MAC, other.MAC, sizeof(MAC));
-        if (cmp != 0) {
-            return cmp < 0; // if MACs are diferent, compares lexicografically
-        }
-        return channel < other.channel; // If MACs are equal, compare by channel
-    }
-};
+#include "mac_set.h"
 
 extern bool _only_HS;
 
@@ -27,8 +13,27 @@ extern uint8_t ch;
 
 void setHandshakeSniffer();
 
-extern std::set<BeaconList> registeredBeacons;
-extern std::set<String> SavedHS;
+typedef MacSet<512> BeaconSet;    // MAC + channel of the APs seen (up to 384, 4KB), used to deauth
+typedef MacSet<256> HandshakeSet; // MAC of the APs with a handshake file in this session
+
+extern BeaconSet registeredBeacons; // filled from the promiscuous callback, use the functions below
+extern HandshakeSet SavedHS;
+extern HandshakeSet SavedHSBeacons;
+
+void registerBeacon(const uint8_t *mac, uint8_t channel);
+void clearRegisteredBeacons();
+// Copies the APs seen on channel under the lock, for the deauth loops of the UI task.
+// list stays valid until the next call
+size_t registeredBeaconsOn(uint8_t channel, const BeaconList *&list);
+
+void saveHandshake(
+    const uint8_t *payload, uint32_t len, uint32_t ts_sec, uint32_t ts_usec, uint8_t channel, bool beacon,
+    FS &Fs
+);
+
+void flushHandshakeFiles();
+
+void closeHandshakeFiles();
 
 void newPacketSD(uint32_t ts_sec, uint32_t ts_usec, uint32_t len, uint8_t *buf, File pcap_file);
 
@@ -7,6 +7,7 @@
 #include "core/display.h"
 #include "core/main_menu.h"
 #include "core/mykeyboard.h"
+#include "core/net_utils.h"
 #include "core/utils.h"
 #include "core/wifi/wifi_common.h"
 #include "esp_system.h"
@@ -83,6 +84,8 @@ void wifi_atk_info(String tssid, String mac, uint8_t channel) {
     tft.drawString("AP: " + tssid, 10, 48);
     tft.drawString("Channel: " + String(channel), 10, 66);
     tft.drawString(mac, 10, 84);
+    String vendor = getVendor(mac);
+    if (!vendor.isEmpty()) tft.drawString(vendor, 10, 102);
     tft.drawString("Press " + String(BTN_ALIAS) + " to act", 10, tftHeight - 20);
     vTaskDelay(200 / portTICK_RATE_MS);
     SelPress = false;
@@ -0,0 +1,362 @@
+// Benchmarks of the hardware independent code, on the host:
+//   pio run -e native && .pio/build/native/program [name filter]
+// Every case runs until it has taken BENCH_MIN_NS, then prints the time and the heap allocations
+// (operator new and ps_malloc, see shim/Arduino.h) per operation. Files live in the in-memory FS of
+// the shim, so the numbers are parsing and bookkeeping, not SD or flash reads.
+#ifndef PIO_UNIT_TESTING
+
+#include "core/connect/espnow_transfer.h"
+#include "core/oui_db.h"
+#include "modules/ir/ir_file.h"
+#include "modules/rf/rf_pulses.h"
+#include "modules/rf/sub_file.h"
+#include "modules/rfid/card_dump.h"
+#include "modules/others/spectrum.h"
+#include "modules/wifi/pcap_ring.h"
+#include <chrono>
+#include <functional>
+#include <map>
+#include <random>
+
+#define BENCH_MIN_NS 300e6
+
+struct BenchCase {
+    const char *name;
+    std::function<void()> op;
+    uint32_t items = 0; // items handled per op, adds a per second rate to the line
+};
+
+static volatile uint64_t sink; // keeps the results alive
+
+static void fail(const char *name, const char *what) {
+    fprintf(stderr, "%s: %s\n", name, what);
+    exit(1);
+}
+
+static void runCase(const BenchCase &c) {
+    c.op(); // warm up, first allocations and tables
+    for (uint64_t iters = 1;; iters *= 2) {
+        uint64_t allocs = nativeAllocs;
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iters; i++) c.op();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        double ns = elapsed.count();
+        if (ns >= BENCH_MIN_NS || iters >= (1ull << 32)) {
+            printf(
+                "%-44s %14.1f ns/op %10.2f allocs/op %10llu ops",
+                c.name,
+                ns / iters,
+                (double)(nativeAllocs - allocs) / iters,
+                (unsigned long long)iters
+            );
+            if (c.items) printf(" %12.0f /s", c.items * iters * 1e9 / ns);
+            printf("\n");
+            return;
+        }
+    }
+}
+
+static void writeFile(FS &fs, const char *path, const String &content) {
+    File f = fs.open(path, FILE_WRITE);
+    f.write((const uint8_t *)content.c_str(), content.length());
+    f.close();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Fixtures
+/////////////////////////////////////////////////////////////////////////////////////
+
+// 100 signals, parsed and raw ones in turns, as the Flipper IR database files
+static String irFixture() {
+    String s = "Filetype: IR signals file\nVersion: 1\n";
+    char line[96];
+    for (int i = 0; i < 100; i++) {
+        snprintf(line, sizeof(line), "#\nname: Button_%d\n", i);
+        s += line;
+        if (i % 2) {
+            s += "type: raw\nfrequency: 38000\nduty_cycle: 0.330000\ndata:";
+            for (int j = 0; j < 67; j++) s += j % 2 ? " 560" : " 1690";
+            s += "\n";
+        } else {
+            snprintf(line, sizeof(line), "type: parsed\nprotocol: NEC\naddress: %02X 00 00 00\n", i);
+            s += line;
+            snprintf(line, sizeof(line), "command: %02X 00 00 00\n", i * 3 & 0xFF);
+            s += line;
+        }
+    }
+    return s;
+}
+
+// RAW capture of 4000 pulses, 16 RAW_Data lines of 250, with CRLF line ends
+static String subRawFixture() {
+    String s = "Filetype: Flipper SubGhz RAW File\r\nVersion: 1\r\nFrequency: 433920000\r\n"
+               "Preset: FuriHalSubGhzPresetOok650Async\r\nProtocol: RAW\r\n";
+    std::mt19937 rng(1);
+    char value[16];
+    for (int line = 0; line < 16; line++) {
+        s += "RAW_Data:";
+        for (int i = 0; i < 250; i++) {
+            snprintf(value, sizeof(value), " %d", (i % 2 ? -1 : 1) * (int)(200 + rng() % 1800));
+            s += value;
+        }
+        s += "\r\n";
+    }
+    return s;
+}
+
+// A minimal copy of tools/oui_build.py build(), so the runner doesn't need the registry
+static void putLe32(std::vector<uint8_t> &out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(v >> (8 * i));
+}
+
+static void putVarint(std::vector<uint8_t> &out, uint32_t v) {
+    for (; v >= 0x80; v >>= 7) out.push_back((v & 0x7F) | 0x80);
+    out.push_back(v);
+}
+
+static std::vector<uint8_t> buildOuiDb(const std::map<uint32_t, std::string> &entries) {
+    std::map<std::string, int> counts;
+    for (auto &e : entries) counts[e.second]++;
+    std::vector<std::string> names;
+    for (auto &c : counts) names.push_back(c.first);
+    std::stable_sort(names.begin(), names.end(), [&](const std::string &a, const std::string &b) {
+        return counts[a] > counts[b];
+    });
+    std::map<std::string, uint32_t> nameId;
+    for (size_t i = 0; i < names.size(); i++) nameId[names[i]] = i;
+
+    std::vector<uint8_t> blocks, block, entry;
+    std::vector<std::pair<uint32_t, uint32_t>> index;
+    int count = 0;
+    uint32_t prev = 0;
+    for (auto &e : entries) {
+        entry.clear();
+        if (count) putVarint(entry, e.first - prev);
+        putVarint(entry, nameId[e.second]);
+        if (!count || count == 64 || block.size() + entry.size() > OUI_DB_MAX_BLOCK) {
+            blocks.insert(blocks.end(), block.begin(), block.end());
+            index.push_back({e.first, OUI_DB_HEADER + blocks.size()});
+            block.clear();
+            entry.clear();
+            putVarint(entry, nameId[e.second]);
+            count = 0;
+        }
+        block.insert(block.end(), entry.begin(), entry.end());
+        count++;
+        prev = e.first;
+    }
+    blocks.insert(blocks.end(), block.begin(), block.end());
+
+    uint32_t indexOffset = OUI_DB_HEADER + blocks.size();
+    uint32_t namesOffset = indexOffset + index.size() * 8;
+    std::vector<uint8_t> out(OUI_DB_MAGIC, OUI_DB_MAGIC + 4);
+    putLe32(out, entries.size());
+    putLe32(out, index.size());
+    putLe32(out, names.size());
+    putLe32(out, indexOffset);
+    putLe32(out, namesOffset);
+    out.insert(out.end(), blocks.begin(), blocks.end());
+    for (auto &i : index) {
+        putLe32(out, i.first);
+        putLe32(out, i.second);
+    }
+    uint32_t pos = namesOffset + (names.size() + 1) * 4;
+    for (auto &n : names) {
+        putLe32(out, pos);
+        pos += n.size();
+    }
+    putLe32(out, pos);
+    for (auto &n : names) out.insert(out.end(), n.begin(), n.end());
+    return out;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Cases
+/////////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+    const char *filter = argc > 1 ? argv[1] : "";
+    std::vector<BenchCase> cases;
+    std::mt19937 rng(42);
+    FS fs;
+
+    // RF scanner, the CRC of every captured frame
+    static std::vector<int> pulses;
+    for (int i = 0; i < 512; i++) pulses.push_back((i % 2 ? -1 : 1) * (int)(200 + rng() % 1800));
+    cases.push_back({"crc64_ecma, 512 pulses", [] { sink = crc64_ecma(pulses); }});
+
+    // .ir and .sub files, both through KeyValueReader
+    writeFile(fs, "/remote.ir", irFixture());
+    cases.push_back({"IRFileReader, 100 signals", [&fs] {
+                         File f = fs.open("/remote.ir");
+                         IRFileReader reader(f);
+                         IRCode code;
+                         int n = 0;
+                         while (reader.next(code)) n++;
+                         if (n != 100) fail("IRFileReader", "wrong signal count");
+                         sink = n;
+                     }});
+    cases.push_back({"IRFileIndex, build + load 10", [&fs] {
+                         fs.open("/remote.ir", FILE_APPEND).close(); // new last write, the index is stale
+                         IRFileIndex index;
+                         if (!index.begin(&fs, "/remote.ir") || index.count() != 100) {
+                             fail("IRFileIndex", "build");
+                         }
+                         IRCode code;
+                         for (uint32_t i = 0; i < 100; i += 10) sink = index.load(i, code);
+                     }});
+    writeFile(fs, "/raw.sub", subRawFixture());
+    cases.push_back({"SubFile::load, RAW 4000 pulses (CRLF)", [&fs] {
+                         SubFile sub;
+                         if (!sub.load(&fs, "/raw.sub") || sub.pulseCount() != 4000) fail("SubFile", "RAW");
+                         sink = sub.pulseCount();
+                     }});
+
+    // MIFARE Classic 4K dump saved as .rfid text and loaded back
+    static CardDump classic;
+    for (uint16_t i = 0; i < 256; i++) {
+        uint8_t page[16];
+        for (auto &b : page) b = rng();
+        classic.append(page, sizeof(page));
+    }
+    cases.push_back({"CardDump 4K, print + parseLine", [] {
+                         struct LinePrint : Print {
+                             CardDump loaded;
+                             String line;
+                             size_t write(uint8_t c) override {
+                                 if (c != '\n') return line += (char)c, 1;
+                                 loaded.parseLine(line);
+                                 line = "";
+                                 return 1;
+                             }
+                         } out;
+                         classic.print(out);
+                         if (out.loaded != classic) fail("CardDump", "round trip differs");
+                     }});
+
+    // OUI lookup, 30000 registrations of 3000 vendors
+    static std::map<uint32_t, std::string> ouis;
+    while (ouis.size() < 30000) ouis[rng() & 0xFFFFFF] = "Vendor " + std::to_string(rng() % 3000);
+    static std::vector<uint8_t> ouiFile = buildOuiDb(ouis);
+    static OuiDatabase oui([](uint32_t offset, uint8_t *buf, size_t len) -> size_t {
+        if (offset >= ouiFile.size()) return 0;
+        len = std::min(len, ouiFile.size() - offset);
+        memcpy(buf, ouiFile.data() + offset, len);
+        return len;
+    });
+    if (!oui.open()) fail("OuiDatabase", "open");
+    static std::vector<uint32_t> keys;
+    for (auto &e : ouis) keys.push_back(e.first);
+    std::shuffle(keys.begin(), keys.end(), rng);
+    cases.push_back({"OuiDatabase::lookup, distinct OUIs", [] {
+                         static size_t i = 0;
+                         static std::string vendor;
+                         uint32_t key = keys[i++ % keys.size()];
+                         if (!oui.lookup(key, vendor) || vendor != ouis[key]) {
+                             fail("OuiDatabase", "wrong vendor");
+                         }
+                     }});
+    cases.push_back({"OuiDatabase::lookup, 8 OUIs (cached)", [] {
+                         static size_t i = 0;
+                         static std::string vendor;
+                         sink = oui.lookup(keys[i++ % 8], vendor);
+                     }});
+
+    // Sniffer capture replayed through the pcap ring and the 4KB batches, as the promiscuous callback
+    // and the writer task do: the writer drains once the ring is half full, as when the callback wakes it
+    static std::vector<std::vector<uint8_t>> frames;
+    static size_t captureBytes = 0;
+    for (int i = 0; i < 1000; i++) {
+        uint32_t kind = rng() % 10; // 40% beacons, 30% control, 30% data
+        size_t len = kind < 4 ? 180 + rng() % 140 : kind < 7 ? 24 + rng() % 40 : 60 + rng() % 1440;
+        frames.emplace_back(len);
+        for (auto &b : frames.back()) b = rng();
+        captureBytes += 16 + len;
+    }
+    static PcapRing pcapRing;
+    static PcapBatchWriter pcapBatch;
+    if (!pcapRing.begin(128 * 1024) || !pcapBatch.begin()) fail("PcapRing", "begin");
+    cases.push_back(
+        {"pcap replay, 1000 frames into a file",
+         [&fs] {
+             File f = fs.open("/replay.pcap", FILE_WRITE);
+             pcapBatch.start(&f);
+             uint32_t ts = 0, used;
+             for (const auto &frame : frames) {
+                 if (!pcapRing.push(0, ts / 1000000, ts % 1000000, frame.data(), frame.size(), 1, &used)) {
+                     fail("PcapRing", "frame dropped");
+                 }
+                 ts += 150;
+                 if (used > pcapRing.size() / 2) {
+                     while (const PcapRingRecord *rec = pcapRing.front()) {
+                         pcapBatch.append(rec);
+                         pcapRing.pop();
+                     }
+                 }
+             }
+             while (const PcapRingRecord *rec = pcapRing.front()) {
+                 pcapBatch.append(rec);
+                 pcapRing.pop();
+             }
+             pcapBatch.flush();
+             if (f.size() != captureBytes) fail("PcapBatchWriter", "wrong file size");
+         },
+         (uint32_t)frames.size()}
+    );
+
+    // Mic screen: one spectrogram column per hop, window + FFT + palette lookup on a noisy tone
+    static uint8_t paletteRgb[256 * 3];
+    static int16_t micSamples[SPECTRUM_FFT_SIZE];
+    for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+        float wave = 4000 * sinf(2 * PI * 100 * i / SPECTRUM_FFT_SIZE);
+        micSamples[i] = (int16_t)wave + (int16_t)(rng() % 512) - 256;
+    }
+    static Spectrum spectrum;
+    if (!spectrum.begin(paletteRgb)) fail("Spectrum", "begin");
+    cases.push_back(
+        {"Spectrum column, 1024 FFT",
+         [] {
+             static uint16_t column[SPECTRUM_HEIGHT];
+             spectrum.column(micSamples, column);
+             sink = column[SPECTRUM_HEIGHT - 100];
+         },
+         1}
+    );
+
+    // ESP-NOW file transfer, both ends over LoopbackTransport, 1ms of fake clock per poll
+    static std::vector<uint8_t> payload(64 * 1024);
+    for (auto &b : payload) b = rng();
+    auto transfer = [](unsigned dropEvery) {
+        LoopbackTransport a, b;
+        a.connect(b);
+        b.connect(a);
+        a.dropEvery = dropEvery;
+        b.dropEvery = dropEvery;
+        std::vector<uint8_t> received;
+        received.reserve(payload.size());
+        EspNowFileSender sender(a, [](uint32_t offset, uint8_t *buf, size_t len) -> size_t {
+            memcpy(buf, payload.data() + offset, len);
+            return len;
+        });
+        EspNowFileReceiver receiver(
+            b,
+            [](const std::string &, const std::string &, uint32_t) { return true; },
+            [&](const uint8_t *buf, size_t len) {
+                received.insert(received.end(), buf, buf + len);
+                return true;
+            }
+        );
+        uint32_t now = 0;
+        sender.begin("/bench", "payload.bin", payload.size(), now);
+        while (sender.poll(now) | receiver.poll(now)) now++;
+        if (!sender.done() || received != payload) fail("EspNowFileSender", "transfer failed");
+    };
+    cases.push_back({"ESP-NOW loopback, 64KB", [=] { transfer(0); }});
+    cases.push_back({"ESP-NOW loopback, 64KB, 1 in 13 lost", [=] { transfer(13); }});
+
+    for (const BenchCase &c : cases) {
+        if (strstr(c.name, filter)) runCase(c);
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef __NATIVE_ARDUINO_H__
+#define __NATIVE_ARDUINO_H__
+
+// Just enough of the Arduino core for the hardware independent units to build on a host
+// ([env:native] in platformio.ini). Not a port: only what those units use is here.
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Allocations made by the code under test: operator new and the ps_* calls (psramFound() is true,
+// so the "psramFound() ? ps_malloc : malloc" idiom goes through them). Read by the benchmarks
+extern uint64_t nativeAllocs;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+inline void yield() {}
+
+inline bool psramFound() { return true; }
+void *ps_malloc(size_t size);
+void *ps_calloc(size_t n, size_t size);
+void *ps_realloc(void *ptr, size_t size);
+
+#define PI 3.1415926535897932384626433832795
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+class String {
+public:
+    String(const char *cstr = "") : s(cstr ? cstr : "") {}
+    String(const String &other) = default;
+    String(String &&other) = default;
+    explicit String(char c) : s(1, c) {}
+    explicit String(unsigned char value, unsigned char base = DEC) : s(toBase(value, base)) {}
+    explicit String(int value, unsigned char base = DEC)
+        : s(base == DEC ? std::to_string(value) : toBase((unsigned)value, base)) {}
+    explicit String(unsigned value, unsigned char base = DEC) : s(toBase(value, base)) {}
+    explicit String(long value, unsigned char base = DEC)
+        : s(base == DEC ? std::to_string(value) : toBase((unsigned long)value, base)) {}
+    explicit String(unsigned long value, unsigned char base = DEC) : s(toBase(value, base)) {}
+
+    String &operator=(const String &other) = default;
+    String &operator=(String &&other) = default;
+    String &operator=(const char *cstr) {
+        s.assign(cstr ? cstr : "");
+        return *this;
+    }
+
+    const char *c_str() const { return s.c_str(); }
+    unsigned length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    bool reserve(unsigned size) {
+        s.reserve(size);
+        return true;
+    }
+
+    bool concat(const char *cstr, unsigned len) {
+        s.append(cstr, len);
+        return true;
+    }
+    bool concat(const char *cstr) { return concat(cstr, strlen(cstr)); }
+    bool concat(const String &str) { return concat(str.c_str(), str.length()); }
+    bool concat(char c) {
+        s.push_back(c);
+        return true;
+    }
+    String &operator+=(const String &str) { return concat(str), *this; }
+    String &operator+=(const char *cstr) { return concat(cstr), *this; }
+    String &operator+=(char c) { return concat(c), *this; }
+    friend String operator+(String lhs, const String &rhs) { return lhs += rhs; }
+    friend String operator+(String lhs, const char *rhs) { return lhs += rhs; }
+
+    bool operator==(const String &other) const { return s == other.s; }
+    bool operator==(const char *cstr) const { return s == cstr; }
+    bool operator!=(const String &other) const { return s != other.s; }
+    bool operator!=(const char *cstr) const { return s != cstr; }
+    char operator[](unsigned index) const { return index < s.size() ? s[index] : 0; }
+    char charAt(unsigned index) const { return (*this)[index]; }
+
+    bool equalsIgnoreCase(const String &other) const {
+        return s.size() == other.s.size() && strncasecmp(s.c_str(), other.c_str(), s.size()) == 0;
+    }
+    bool startsWith(const String &prefix) const { return s.compare(0, prefix.s.size(), prefix.s) == 0; }
+    bool endsWith(const String &suffix) const {
+        size_t n = suffix.s.size();
+        return s.size() >= n && s.compare(s.size() - n, n, suffix.s) == 0;
+    }
+    int indexOf(char c, unsigned from = 0) const {
+        size_t i = s.find(c, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    int lastIndexOf(char c) const {
+        size_t i = s.rfind(c);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    String substring(unsigned from, unsigned to = ~0u) const {
+        if (from > s.size()) return String();
+        return String(s.substr(from, std::min<size_t>(to, s.size()) - from).c_str());
+    }
+    long toInt() const { return atol(s.c_str()); }
+    void remove(unsigned index, unsigned count = ~0u) {
+        if (index < s.size()) s.erase(index, count);
+    }
+    void toUpperCase() {
+        for (char &c : s) c = toupper((uint8_t)c);
+    }
+    void toLowerCase() {
+        for (char &c : s) c = tolower((uint8_t)c);
+    }
+    void trim() {
+        size_t end = s.size();
+        while (end > 0 && isspace((uint8_t)s[end - 1])) end--;
+        size_t start = 0;
+        while (start < end && isspace((uint8_t)s[start])) start++;
+        s.erase(end);
+        s.erase(0, start); // in place, as the Arduino String keeps its buffer
+    }
+
+private:
+    std::string s;
+
+    static std::string toBase(unsigned long value, unsigned char base) {
+        std::string out;
+        do out.insert(out.begin(), "0123456789abcdefghijklmnopqrstuvwxyz"[value % base]);
+        while (value /= base);
+        return out;
+    }
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t print(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+    size_t print(const String &str) { return write((const uint8_t *)str.c_str(), str.length()); }
+    size_t println(const char *str = "") { return print(str) + print("\n"); }
+    size_t println(const String &str) { return print(str) + print("\n"); }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+// Serial output of the units is dropped, the runner and the tests print their own
+class HardwareSerial : public Print {
+public:
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t *, size_t size) override { return size; }
+};
+extern HardwareSerial Serial;
+
+#endif
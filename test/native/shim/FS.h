@@ -0,0 +1,71 @@
+#ifndef __NATIVE_FS_H__
+#define __NATIVE_FS_H__
+
+// Arduino FS API over files kept in memory, see Arduino.h
+
+#include "Arduino.h"
+#include <map>
+#include <memory>
+#include <vector>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct MemFile {
+    std::vector<uint8_t> data;
+    uint32_t lastWrite = 0;
+};
+
+class File : public Print {
+public:
+    File() {}
+    File(std::shared_ptr<MemFile> file, const String &path, size_t pos)
+        : file(file), filePath(path), pos(pos) {}
+
+    operator bool() const { return file != nullptr; }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t size) override;
+    int read();
+    size_t read(uint8_t *buf, size_t size);
+    int peek();
+    int available() { return file ? file->data.size() - pos : 0; }
+    bool seek(uint32_t offset, SeekMode mode = SeekSet);
+    size_t position() const { return pos; }
+    size_t size() const { return file ? file->data.size() : 0; }
+    void flush() {}
+    void close() { file.reset(); }
+    bool isDirectory() const { return false; }
+    time_t getLastWrite() { return file ? file->lastWrite : 0; }
+    const char *path() const { return filePath.c_str(); }
+
+private:
+    std::shared_ptr<MemFile> file;
+    String filePath;
+    size_t pos = 0;
+};
+
+// One flat namespace of paths, no directories. Every open for writing counts as a new last write
+class FS {
+public:
+    File open(const String &path, const char *mode = FILE_READ, bool create = false);
+    bool exists(const String &path) const { return files.count(path.c_str()) > 0; }
+    bool remove(const String &path) { return files.erase(path.c_str()) > 0; }
+    bool mkdir(const String &) { return true; }
+
+private:
+    std::map<std::string, std::shared_ptr<MemFile>> files;
+    uint32_t writes = 0;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekMode;
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef __NATIVE_ESP_HEAP_CAPS_H__
+#define __NATIVE_ESP_HEAP_CAPS_H__
+
+// heap_caps_* of ESP-IDF, the capabilities don't mean anything on a host
+
+#include <cstdlib>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+inline void *heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+inline void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t) {
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+inline void heap_caps_free(void *ptr) { free(ptr); }
+
+#endif
@@ -0,0 +1,108 @@
+#include "Arduino.h"
+#include "FS.h"
+#include <chrono>
+#include <new>
+#include <thread>
+
+uint64_t nativeAllocs = 0;
+HardwareSerial Serial;
+
+static const auto bootTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+    auto elapsed = std::chrono::steady_clock::now() - bootTime;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+unsigned long micros() {
+    auto elapsed = std::chrono::steady_clock::now() - bootTime;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+void *ps_malloc(size_t size) {
+    nativeAllocs++;
+    return malloc(size);
+}
+
+void *ps_calloc(size_t n, size_t size) {
+    nativeAllocs++;
+    return calloc(n, size);
+}
+
+void *ps_realloc(void *ptr, size_t size) {
+    nativeAllocs++;
+    return realloc(ptr, size);
+}
+
+void *operator new(size_t size) {
+    nativeAllocs++;
+    void *p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+size_t Print::printf(const char *format, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (n < 0) return 0;
+    return write((const uint8_t *)buf, std::min<size_t>(n, sizeof(buf) - 1));
+}
+
+namespace fs {
+
+size_t File::write(const uint8_t *buf, size_t size) {
+    if (!file) return 0;
+    if (pos + size > file->data.size()) file->data.resize(pos + size);
+    memcpy(file->data.data() + pos, buf, size);
+    pos += size;
+    return size;
+}
+
+int File::read() {
+    uint8_t c;
+    return read(&c, 1) ? c : -1;
+}
+
+size_t File::read(uint8_t *buf, size_t size) {
+    if (!file || pos >= file->data.size()) return 0;
+    size = std::min(size, file->data.size() - pos);
+    memcpy(buf, file->data.data() + pos, size);
+    pos += size;
+    return size;
+}
+
+int File::peek() {
+    if (!file || pos >= file->data.size()) return -1;
+    return file->data[pos];
+}
+
+bool File::seek(uint32_t offset, SeekMode mode) {
+    if (!file) return false;
+    size_t base = mode == SeekSet ? 0 : mode == SeekCur ? pos : file->data.size();
+    if (base + offset > file->data.size()) return false;
+    pos = base + offset;
+    return true;
+}
+
+File FS::open(const String &path, const char *mode, bool /*create*/) {
+    auto it = files.find(path.c_str());
+    if (mode[0] == 'r') return it == files.end() ? File() : File(it->second, path, 0);
+
+    if (it == files.end()) it = files.emplace(path.c_str(), std::make_shared<MemFile>()).first;
+    std::shared_ptr<MemFile> file = it->second;
+    if (mode[0] == 'w') file->data.clear();
+    file->lastWrite = ++writes;
+    return File(file, path, mode[0] == 'a' ? file->data.size() : 0);
+}
+
+} // namespace fs
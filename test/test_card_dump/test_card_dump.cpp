@@ -0,0 +1,147 @@
+// CardDump pages, keys and the .rfid text round trip, run with "pio test -e native"
+#include "modules/rfid/card_dump.h"
+#include <unity.h>
+
+// What print() writes, as one String
+struct TextPrint : Print {
+    String text;
+    size_t write(uint8_t c) override { return text += (char)c, 1; }
+};
+
+// Feeds text to parseLine() one line at a time, as the backends do when loading a file
+static int parseText(CardDump &dump, const String &text) {
+    int pages = 0;
+    String line;
+    for (unsigned i = 0; i < text.length(); i++) {
+        if (text[i] != '\n') {
+            line += text[i];
+            continue;
+        }
+        pages += dump.parseLine(line);
+        line = "";
+    }
+    return pages + (line.length() ? dump.parseLine(line) : 0);
+}
+
+static void fillPages(CardDump &dump, uint16_t pages, uint8_t pageSize) {
+    uint8_t bytes[CARD_DUMP_MAX_PAGE_SIZE];
+    for (uint16_t i = 0; i < pages; i++) {
+        for (uint8_t b = 0; b < pageSize; b++) bytes[b] = i * 7 + b;
+        TEST_ASSERT_TRUE(dump.append(bytes, pageSize));
+    }
+}
+
+void test_classic_4k_round_trip() {
+    CardDump dump;
+    fillPages(dump, 256, 16);
+    TEST_ASSERT_EQUAL(256, dump.pages());
+    TEST_ASSERT_EQUAL(256, dump.readPages());
+
+    TextPrint out;
+    dump.print(out);
+    const char *first = "Page 0: 00 01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F\n";
+    TEST_ASSERT_EQUAL(0, strncmp(out.text.c_str(), first, strlen(first)));
+
+    CardDump loaded;
+    TEST_ASSERT_EQUAL(256, parseText(loaded, out.text));
+    TEST_ASSERT_TRUE(loaded == dump);
+    TEST_ASSERT_EQUAL(16, loaded.pageSize());
+}
+
+void test_ultralight_pages() {
+    CardDump dump;
+    fillPages(dump, 45, 4); // NTAG215 user memory would be 135, the page size is what matters
+    TextPrint out;
+    dump.print(out);
+
+    CardDump loaded;
+    parseText(loaded, out.text);
+    TEST_ASSERT_EQUAL(4, loaded.pageSize());
+    TEST_ASSERT_TRUE(loaded == dump);
+    TEST_ASSERT_EQUAL_STRING("00010203", loaded.hex().substring(0, 8).c_str());
+    TEST_ASSERT_EQUAL(45 * 8, loaded.hex().length());
+}
+
+void test_felica_blocks() {
+    CardDump dump;
+    dump.clear(true);
+    fillPages(dump, 2, 16);
+    TextPrint out;
+    dump.print(out);
+    TEST_ASSERT_EQUAL(0, strncmp(out.text.c_str(), "Block 0:", 8));
+
+    CardDump loaded;
+    TEST_ASSERT_EQUAL(2, parseText(loaded, out.text));
+    TEST_ASSERT_TRUE(loaded == dump);
+    out.text = "";
+    loaded.print(out);
+    TEST_ASSERT_EQUAL(0, strncmp(out.text.c_str(), "Block 0:", 8)); // saved again as blocks
+}
+
+void test_unread_pages() {
+    // pages that failed to read are not written, and stay missing after loading
+    CardDump dump;
+    uint8_t bytes[16] = {0xAB};
+    TEST_ASSERT_TRUE(dump.setPage(0, bytes, 16));
+    TEST_ASSERT_TRUE(dump.setPage(5, bytes, 16));
+    TEST_ASSERT_EQUAL(6, dump.pages());
+    TEST_ASSERT_EQUAL(2, dump.readPages());
+    TEST_ASSERT_FALSE(dump.isRead(3));
+
+    TextPrint out;
+    dump.print(out);
+    CardDump loaded;
+    TEST_ASSERT_EQUAL(2, parseText(loaded, out.text));
+    TEST_ASSERT_TRUE(loaded == dump);
+    TEST_ASSERT_FALSE(loaded.isRead(3));
+}
+
+void test_parse_line() {
+    CardDump dump;
+    TEST_ASSERT_FALSE(dump.parseLine("Device type: MIFARE Classic 1K"));
+    TEST_ASSERT_FALSE(dump.parseLine("Page x: 00 11"));
+    TEST_ASSERT_FALSE(dump.parseLine("Page 1 00 11 22 33"));
+    TEST_ASSERT_TRUE(dump.parseLine("Page 1: 00 11 22 33\r")); // saved on Windows
+    TEST_ASSERT_EQUAL(4, dump.pageSize());
+    TEST_ASSERT_EQUAL_HEX8(0x33, dump.page(1)[3]);
+    TEST_ASSERT_FALSE(dump.parseLine("Page 2: 00 11 22 33 44 55 66 77")); // another page size
+    TEST_ASSERT_FALSE(dump.parseLine("Page 256: 00 11 22 33"));
+}
+
+void test_keys_and_copy() {
+    CardDump dump;
+    fillPages(dump, 4, 16);
+    const uint8_t keyA[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    const uint8_t keyB[6] = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5};
+    dump.setKey(0, false, keyA);
+    dump.setKey(39, true, keyB);
+    TEST_ASSERT_NULL(dump.key(0, true));
+    TEST_ASSERT_NULL(dump.key(40, false));
+    TEST_ASSERT_EQUAL(0, CardDump::sectorOf(3));
+    TEST_ASSERT_EQUAL(32, CardDump::sectorOf(128));
+    TEST_ASSERT_EQUAL(39, CardDump::sectorOf(255));
+
+    CardDump copy = dump;
+    TEST_ASSERT_TRUE(copy == dump);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(keyA, copy.key(0, false), 6);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(keyB, copy.key(39, true), 6);
+
+    copy.clear();
+    TEST_ASSERT_EQUAL(0, copy.pages());
+    TEST_ASSERT_NULL(copy.key(0, false));
+    TEST_ASSERT_TRUE(copy != dump);
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_classic_4k_round_trip);
+    RUN_TEST(test_ultralight_pages);
+    RUN_TEST(test_felica_blocks);
+    RUN_TEST(test_unread_pages);
+    RUN_TEST(test_parse_line);
+    RUN_TEST(test_keys_and_copy);
+    return UNITY_END();
+}
@@ -0,0 +1,177 @@
+// ESP-NOW file transfer between a sender and a receiver over LoopbackTransport, run with
+// "pio test -e native". Time is a counter advanced by 1ms per poll
+#include "core/connect/espnow_transfer.h"
+#include <cstring>
+#include <unity.h>
+#include <vector>
+
+// Flips a byte in the nth DATA packet it sends, the receiver must NACK it and get it again
+class CorruptingTransport : public LoopbackTransport {
+public:
+    unsigned corruptData = 0;
+    bool send(const uint8_t *data, size_t len) override {
+        if (len > ESPNOW_FT_HEADER + 4 && data[1] == 2 && ++dataSent == corruptData) { // DATA
+            uint8_t copy[ESPNOW_FT_MTU];
+            memcpy(copy, data, len);
+            copy[len - 1] ^= 0x55;
+            return LoopbackTransport::send(copy, len);
+        }
+        return LoopbackTransport::send(data, len);
+    }
+
+private:
+    unsigned dataSent = 0;
+};
+
+struct Transfer {
+    CorruptingTransport a, b;
+    std::vector<uint8_t> payload, received;
+    std::string path, name;
+    bool accept = true;
+    EspNowFileSender sender{a, [this](uint32_t offset, uint8_t *buf, size_t len) -> size_t {
+                                memcpy(buf, payload.data() + offset, len);
+                                return len;
+                            }};
+    EspNowFileReceiver receiver{
+        b,
+        [this](const std::string &p, const std::string &n, uint32_t) {
+            path = p;
+            name = n;
+            return accept;
+        },
+        [this](const uint8_t *buf, size_t len) {
+            received.insert(received.end(), buf, buf + len);
+            return true;
+        }
+    };
+    uint32_t now = 0;
+
+    explicit Transfer(size_t size, unsigned dropEvery = 0) {
+        a.connect(b);
+        b.connect(a);
+        a.dropEvery = dropEvery;
+        b.dropEvery = dropEvery;
+        for (size_t i = 0; i < size; i++) payload.push_back(i * 31 + (i >> 8));
+    }
+
+    void run(bool pollReceiver = true) {
+        sender.begin("/BruceRF", "capture.sub", payload.size(), now);
+        while (now < 60000 && (sender.poll(now) | (pollReceiver && receiver.poll(now)))) now++;
+    }
+};
+
+void test_transfer() {
+    Transfer t(10000);
+    t.run();
+    TEST_ASSERT_TRUE(t.sender.done());
+    TEST_ASSERT_TRUE(t.receiver.done());
+    TEST_ASSERT_EQUAL_STRING("/BruceRF", t.path.c_str());
+    TEST_ASSERT_EQUAL_STRING("capture.sub", t.name.c_str());
+    TEST_ASSERT_EQUAL(10000, t.receiver.size());
+    TEST_ASSERT_TRUE(t.received == t.payload);
+    TEST_ASSERT_EQUAL(10000, t.sender.bytesAcked());
+    TEST_ASSERT_EQUAL(0, t.sender.retransmits);
+}
+
+void test_sizes() {
+    // empty, one byte, exactly one chunk, one chunk + 1, more than a window
+    const size_t sizes[] = {
+        0, 1, ESPNOW_FT_CHUNK, ESPNOW_FT_CHUNK + 1, ESPNOW_FT_CHUNK * ESPNOW_FT_WINDOW * 3 + 7
+    };
+    for (size_t size : sizes) {
+        Transfer t(size);
+        t.run();
+        TEST_ASSERT_TRUE(t.sender.done());
+        TEST_ASSERT_TRUE(t.receiver.done());
+        TEST_ASSERT_EQUAL(size, t.received.size());
+        TEST_ASSERT_TRUE(t.received == t.payload);
+    }
+}
+
+void test_lossy_link() {
+    const unsigned drops[] = {3, 7, 13};
+    for (unsigned dropEvery : drops) {
+        Transfer t(64 * 1024, dropEvery);
+        t.run();
+        TEST_ASSERT_TRUE(t.sender.done());
+        TEST_ASSERT_TRUE(t.received == t.payload);
+        TEST_ASSERT_TRUE(t.sender.retransmits > 0);
+    }
+}
+
+void test_corrupted_chunk() {
+    Transfer t(20 * ESPNOW_FT_CHUNK);
+    t.a.corruptData = 3;
+    t.run();
+    TEST_ASSERT_TRUE(t.sender.done());
+    TEST_ASSERT_TRUE(t.received == t.payload);
+}
+
+void test_refused() {
+    Transfer t(1000);
+    t.accept = false;
+    t.run();
+    TEST_ASSERT_TRUE(t.sender.failed());
+    TEST_ASSERT_TRUE(t.receiver.failed());
+    TEST_ASSERT_EQUAL(0, t.received.size());
+}
+
+void test_no_receiver() {
+    Transfer t(1000);
+    t.run(false);
+    TEST_ASSERT_TRUE(t.sender.failed());
+    TEST_ASSERT_TRUE(t.now >= ESPNOW_FT_TIMEOUT_MS);
+    TEST_ASSERT_TRUE(t.now < ESPNOW_FT_TIMEOUT_MS + 100);
+}
+
+void test_abort() {
+    Transfer t(64 * 1024);
+    t.sender.begin("/", "big.bin", t.payload.size(), t.now);
+    for (int i = 0; i < 5; i++, t.now++) { // 16 chunks a poll, ~80 of the 276 sent
+        t.sender.poll(t.now);
+        t.receiver.poll(t.now);
+    }
+    TEST_ASSERT_TRUE(t.receiver.started());
+    t.sender.abort();
+    t.receiver.poll(t.now);
+    TEST_ASSERT_TRUE(t.sender.failed());
+    TEST_ASSERT_TRUE(t.receiver.failed());
+    TEST_ASSERT_TRUE(t.received.size() < t.payload.size());
+}
+
+void test_spsc_ring() {
+    SpscRing<int> ring(5); // rounded up to 8
+    for (int i = 0; i < 8; i++) TEST_ASSERT_TRUE(ring.push(i));
+    TEST_ASSERT_FALSE(ring.push(8));
+    int v;
+    for (int round = 0; round < 20; round++) { // wraps the indexes many times
+        TEST_ASSERT_TRUE(ring.pop(v));
+        TEST_ASSERT_EQUAL(round, v);
+        TEST_ASSERT_TRUE(ring.push(round + 8));
+    }
+    ring.clear();
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_FALSE(ring.pop(v));
+}
+
+void test_crc32() {
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, espnow_crc32((const uint8_t *)"123456789", 9)); // zlib check value
+    TEST_ASSERT_EQUAL_HEX32(0, espnow_crc32(nullptr, 0));
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_transfer);
+    RUN_TEST(test_sizes);
+    RUN_TEST(test_lossy_link);
+    RUN_TEST(test_corrupted_chunk);
+    RUN_TEST(test_refused);
+    RUN_TEST(test_no_receiver);
+    RUN_TEST(test_abort);
+    RUN_TEST(test_spsc_ring);
+    RUN_TEST(test_crc32);
+    return UNITY_END();
+}
@@ -0,0 +1,185 @@
+// OuiDatabase on test/corpus/oui: oui.csv is a made-up registry in the IEEE format, oui.bin its build by
+//   tools/oui_build.py build test/corpus/oui/oui.csv test/corpus/oui/oui.bin
+#include "core/oui_db.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <unity.h>
+
+static std::string corpusDir() {
+    std::string dir = __FILE__;
+    return dir.substr(0, dir.find_last_of("/\\") + 1) + "../corpus/oui/";
+}
+
+static std::string readCorpus(const char *name) {
+    FILE *f = fopen((corpusDir() + name).c_str(), "rb");
+    TEST_ASSERT_NOT_NULL_MESSAGE(f, name);
+    std::string data;
+    char buf[512];
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;) data.append(buf, n);
+    fclose(f);
+    return data;
+}
+
+// The file as the SD card would give it, cut at limit bytes
+struct MemFile {
+    std::string data;
+    size_t limit = SIZE_MAX;
+    uint32_t reads = 0;
+
+    OuiDatabase::Reader reader() {
+        return [this](uint32_t offset, uint8_t *buf, size_t len) -> size_t {
+            reads++;
+            size_t size = std::min(limit, data.size());
+            if (offset >= size) return 0;
+            len = std::min(len, size - offset);
+            memcpy(buf, data.data() + offset, len);
+            return len;
+        };
+    }
+};
+
+// Assignments of oui.csv, every row after the header is "MA-L,XXXXXX,..."
+static std::vector<uint32_t> registered() {
+    std::vector<uint32_t> ouis;
+    std::string csv = readCorpus("oui.csv");
+    for (size_t pos = csv.find('\n'); pos != std::string::npos && pos + 12 < csv.size();
+         pos = csv.find('\n', pos + 1)) {
+        TEST_ASSERT_EQUAL(0, csv.compare(pos + 1, 5, "MA-L,"));
+        ouis.push_back(strtoul(csv.substr(pos + 6, 6).c_str(), nullptr, 16));
+    }
+    return ouis;
+}
+
+static std::string vendorOf(OuiDatabase &db, uint32_t oui) {
+    std::string vendor;
+    TEST_ASSERT_TRUE_MESSAGE(db.lookup(oui, vendor), "not found");
+    return vendor;
+}
+
+void test_every_entry() {
+    MemFile file{readCorpus("oui.bin")};
+    OuiDatabase db(file.reader());
+    TEST_ASSERT_TRUE(db.open());
+    std::vector<uint32_t> ouis = registered();
+    TEST_ASSERT_EQUAL(300, ouis.size());
+    TEST_ASSERT_EQUAL(ouis.size(), db.entries());
+
+    std::string vendor;
+    for (uint32_t oui : ouis) {
+        char msg[16];
+        snprintf(msg, sizeof(msg), "%06X", oui);
+        TEST_ASSERT_TRUE_MESSAGE(db.lookup(oui, vendor), msg);
+        TEST_ASSERT_FALSE_MESSAGE(vendor.empty(), msg);
+    }
+    TEST_ASSERT_TRUE(db.ok());
+}
+
+void test_vendor_names() {
+    MemFile file{readCorpus("oui.bin")};
+    OuiDatabase db(file.reader());
+    TEST_ASSERT_TRUE(db.open());
+    TEST_ASSERT_EQUAL_STRING("First Block Corp", vendorOf(db, 0x001049).c_str());
+    TEST_ASSERT_EQUAL_STRING("Vendor 7 Inc.", vendorOf(db, 0x010D47).c_str());
+    TEST_ASSERT_EQUAL_STRING("Last Entry LLC", vendorOf(db, 0xFE3CFA).c_str());
+    // last entry of the first block, first one of the second
+    TEST_ASSERT_EQUAL_STRING("Vendor 0 Inc.", vendorOf(db, 0x2A3BF4).c_str());
+    TEST_ASSERT_EQUAL_STRING("Vendor 8 Inc.", vendorOf(db, 0x2A97FB).c_str());
+    // quoted csv field, whitespace collapsed, UTF-8 and a name cut at OUI_DB_MAX_NAME
+    TEST_ASSERT_EQUAL_STRING("Comma, Quote \"Labs\" Ltd", vendorOf(db, 0x4F436D).c_str());
+    TEST_ASSERT_EQUAL_STRING("Spaced Out Name", vendorOf(db, 0x74CADF).c_str());
+    TEST_ASSERT_EQUAL_STRING("M\xC3\xBCller \xC3\x89lectronique GmbH", vendorOf(db, 0x95E70A).c_str());
+    TEST_ASSERT_EQUAL(OUI_DB_MAX_NAME, vendorOf(db, 0xC7AD14).size());
+    TEST_ASSERT_EQUAL_STRING(std::string(OUI_DB_MAX_NAME, 'X').c_str(), vendorOf(db, 0xC7AD14).c_str());
+}
+
+void test_not_registered() {
+    MemFile file{readCorpus("oui.bin")};
+    OuiDatabase db(file.reader());
+    TEST_ASSERT_TRUE(db.open());
+    std::vector<uint32_t> ouis = registered();
+    std::set<uint32_t> known(ouis.begin(), ouis.end());
+
+    std::string vendor = "unchanged";
+    TEST_ASSERT_FALSE(db.lookup(0x000000, vendor)); // before the first block
+    TEST_ASSERT_FALSE(db.lookup(0xFFFFFF, vendor)); // after the last entry
+    for (uint32_t oui : ouis) {
+        if (!known.count(oui - 1)) TEST_ASSERT_FALSE(db.lookup(oui - 1, vendor));
+        if (!known.count(oui + 1)) TEST_ASSERT_FALSE(db.lookup(oui + 1, vendor));
+    }
+    TEST_ASSERT_EQUAL_STRING("unchanged", vendor.c_str());
+    TEST_ASSERT_TRUE(db.ok());
+}
+
+void test_cache() {
+    MemFile file{readCorpus("oui.bin")};
+    OuiDatabase db(file.reader());
+    TEST_ASSERT_TRUE(db.open());
+    std::vector<uint32_t> ouis = registered();
+
+    vendorOf(db, ouis[10]);
+    uint32_t reads = file.reads;
+    TEST_ASSERT_EQUAL_STRING(vendorOf(db, ouis[10]).c_str(), vendorOf(db, ouis[10]).c_str());
+    std::string vendor;
+    TEST_ASSERT_EQUAL(reads, file.reads);
+    TEST_ASSERT_FALSE(db.lookup(ouis[10] + 1, vendor)); // one block read
+    TEST_ASSERT_FALSE(db.lookup(ouis[10] + 1, vendor)); // misses are remembered too
+    TEST_ASSERT_EQUAL(3, db.cacheHits);
+    TEST_ASSERT_EQUAL(reads + 1, file.reads);
+
+    // OUI_DB_CACHE other vendors push it out, the least recently used first
+    for (int i = 0; i < OUI_DB_CACHE; i++) vendorOf(db, ouis[20 + i]);
+    uint32_t hits = db.cacheHits;
+    vendorOf(db, ouis[10]);
+    TEST_ASSERT_EQUAL(hits, db.cacheHits);
+    vendorOf(db, ouis[20 + OUI_DB_CACHE - 1]);
+    TEST_ASSERT_EQUAL(hits + 1, db.cacheHits);
+}
+
+void test_bad_magic() {
+    MemFile file{readCorpus("oui.bin")};
+    file.data[0] = 'X';
+    OuiDatabase db(file.reader());
+    TEST_ASSERT_FALSE(db.open());
+    TEST_ASSERT_FALSE(db.ok());
+    std::string vendor;
+    TEST_ASSERT_FALSE(db.lookup(0x001049, vendor));
+}
+
+void test_truncated() {
+    MemFile file{readCorpus("oui.bin")};
+    OuiDatabase db(file.reader());
+
+    file.limit = OUI_DB_HEADER - 1;
+    TEST_ASSERT_FALSE(db.open());
+    TEST_ASSERT_FALSE(db.ok());
+
+    // the index fits, the last names don't: the read error isn't cached and the file is marked broken
+    file.limit = file.data.size() - 4;
+    TEST_ASSERT_TRUE(db.open());
+    std::string vendor;
+    TEST_ASSERT_FALSE(db.lookup(0xC7AD14, vendor));
+    TEST_ASSERT_FALSE(db.ok());
+    TEST_ASSERT_FALSE(db.lookup(0x001049, vendor));
+
+    // open() again once the whole file is there
+    file.limit = SIZE_MAX;
+    TEST_ASSERT_TRUE(db.open());
+    TEST_ASSERT_TRUE(db.ok());
+    TEST_ASSERT_EQUAL(OUI_DB_MAX_NAME, vendorOf(db, 0xC7AD14).size());
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_entry);
+    RUN_TEST(test_vendor_names);
+    RUN_TEST(test_not_registered);
+    RUN_TEST(test_cache);
+    RUN_TEST(test_bad_magic);
+    RUN_TEST(test_truncated);
+    return UNITY_END();
+}
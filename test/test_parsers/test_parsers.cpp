@@ -0,0 +1,259 @@
+// .ir and .sub parsing on the files of test/corpus, run with "pio test -e native"
+#include "modules/ir/ir_file.h"
+#include "modules/rf/sub_file.h"
+#include <string>
+#include <unity.h>
+#include <vector>
+
+static FS memFs;
+
+// Copies test/corpus/<name> into the in-memory FS, as /<name>. crlf != 0 rewrites the line ends:
+// 1 to "\r\n", -1 to "\n"
+static String loadCorpus(const char *name, int crlf = 0) {
+    std::string dir = __FILE__;
+    dir = dir.substr(0, dir.find_last_of("/\\") + 1) + "../corpus/";
+    FILE *f = fopen((dir + name).c_str(), "rb");
+    TEST_ASSERT_NOT_NULL_MESSAGE(f, name);
+    std::string text;
+    char buf[512];
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0;) text.append(buf, n);
+    fclose(f);
+
+    if (crlf) {
+        std::string out;
+        for (char c : text) {
+            if (c == '\r') continue;
+            if (c == '\n' && crlf > 0) out += '\r';
+            out += c;
+        }
+        text = out;
+    }
+
+    String path = String("/") + name;
+    File file = memFs.open(path, FILE_WRITE);
+    file.write((const uint8_t *)text.data(), text.size());
+    file.close();
+    return path;
+}
+
+static std::vector<IRCode> readIr(const String &path) {
+    std::vector<IRCode> codes;
+    File file = memFs.open(path);
+    IRFileReader reader(file);
+    IRCode code;
+    while (reader.next(code)) codes.push_back(code);
+    return codes;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// .ir
+/////////////////////////////////////////////////////////////////////////////////////
+void test_ir_parsed() {
+    std::vector<IRCode> codes = readIr(loadCorpus("ir/tv_nec.ir"));
+    TEST_ASSERT_EQUAL(3, codes.size());
+    TEST_ASSERT_EQUAL_STRING("Power", codes[0].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("parsed", codes[0].type.c_str());
+    TEST_ASSERT_EQUAL_STRING("NEC", codes[0].protocol.c_str());
+    TEST_ASSERT_EQUAL_STRING("04 00 00 00", codes[0].address.c_str());
+    TEST_ASSERT_EQUAL_STRING("08 00 00 00", codes[0].command.c_str());
+    TEST_ASSERT_EQUAL_STRING("Vol_up", codes[1].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("NECext", codes[1].protocol.c_str());
+    TEST_ASSERT_EQUAL_STRING("15 EA 00 00", codes[1].command.c_str());
+    TEST_ASSERT_EQUAL_STRING("Mute", codes[2].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("Samsung32", codes[2].protocol.c_str());
+}
+
+void test_ir_raw_crlf() {
+    std::vector<IRCode> codes = readIr(loadCorpus("ir/ac_raw_crlf.ir"));
+    TEST_ASSERT_EQUAL(2, codes.size());
+    TEST_ASSERT_EQUAL_STRING("Off", codes[0].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("raw", codes[0].type.c_str());
+    TEST_ASSERT_EQUAL(38000, codes[0].frequency);
+    TEST_ASSERT_EQUAL_STRING("9024 4512 579 552 579 1683", codes[0].data.c_str());
+    TEST_ASSERT_EQUAL_STRING("Cool_22", codes[1].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("3506 1750 436 1312", codes[1].data.c_str());
+}
+
+void test_ir_edge_cases() {
+    // no '#' between signals, "name:" without a space, a line without ':', no newline at the end
+    std::vector<IRCode> codes = readIr(loadCorpus("ir/edge.ir"));
+    TEST_ASSERT_EQUAL(2, codes.size());
+    TEST_ASSERT_EQUAL_STRING("Power", codes[0].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("02 00 00 00", codes[0].command.c_str());
+    TEST_ASSERT_EQUAL(32, codes[0].bits);
+    TEST_ASSERT_EQUAL_STRING("Next", codes[1].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("RC5", codes[1].protocol.c_str());
+    TEST_ASSERT_EQUAL(13, codes[1].bits);
+    TEST_ASSERT_EQUAL_STRING("0C 00 00 00", codes[1].command.c_str());
+}
+
+void test_ir_seek_to_offset() {
+    File file = memFs.open(loadCorpus("ir/tv_nec.ir"));
+    IRFileReader reader(file);
+    IRCode code;
+    uint32_t offsets[3];
+    for (uint32_t &offset : offsets) TEST_ASSERT_TRUE(reader.next(code, &offset));
+
+    TEST_ASSERT_TRUE(reader.seek(offsets[1]));
+    TEST_ASSERT_TRUE(reader.next(code));
+    TEST_ASSERT_EQUAL_STRING("Vol_up", code.name.c_str());
+    TEST_ASSERT_TRUE(reader.seek(offsets[0]));
+    TEST_ASSERT_TRUE(reader.next(code));
+    TEST_ASSERT_EQUAL_STRING("Power", code.name.c_str());
+}
+
+void test_ir_index() {
+    String path = loadCorpus("ir/tv_nec.ir");
+    IRFileIndex index;
+    TEST_ASSERT_TRUE(index.begin(&memFs, path));
+    TEST_ASSERT_EQUAL(3, index.count());
+    IRIndexEntry e;
+    TEST_ASSERT_TRUE(index.entry(1, e));
+    TEST_ASSERT_EQUAL_STRING("Vol_up", e.name);
+    TEST_ASSERT_EQUAL_STRING("NECext", e.protocol);
+    TEST_ASSERT_EQUAL(0, e.raw);
+    IRCode code;
+    TEST_ASSERT_TRUE(index.load(2, code));
+    TEST_ASSERT_EQUAL_STRING("Mute", code.name.c_str());
+    index.end();
+
+    // a new signal changes the last write, the sidecar is rebuilt
+    File file = memFs.open(path, FILE_APPEND);
+    file.print("# \nname: Input\ntype: raw\nfrequency: 38000\ndata: 100 200\n");
+    file.close();
+    TEST_ASSERT_TRUE(index.begin(&memFs, path));
+    TEST_ASSERT_EQUAL(4, index.count());
+    TEST_ASSERT_TRUE(index.entry(3, e));
+    TEST_ASSERT_EQUAL_STRING("Input", e.name);
+    TEST_ASSERT_EQUAL(1, e.raw);
+}
+
+void test_ir_line_ends() {
+    const char *files[] = {"ir/tv_nec.ir", "ir/ac_raw_crlf.ir", "ir/edge.ir"};
+    for (const char *name : files) {
+        std::vector<IRCode> lf = readIr(loadCorpus(name, -1));
+        std::vector<IRCode> crlf = readIr(loadCorpus(name, 1));
+        TEST_ASSERT_EQUAL_MESSAGE(lf.size(), crlf.size(), name);
+        for (size_t i = 0; i < lf.size(); i++) {
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(lf[i].name.c_str(), crlf[i].name.c_str(), name);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(lf[i].type.c_str(), crlf[i].type.c_str(), name);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(lf[i].protocol.c_str(), crlf[i].protocol.c_str(), name);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(lf[i].address.c_str(), crlf[i].address.c_str(), name);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(lf[i].command.c_str(), crlf[i].command.c_str(), name);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(lf[i].data.c_str(), crlf[i].data.c_str(), name);
+            TEST_ASSERT_EQUAL_MESSAGE(lf[i].frequency, crlf[i].frequency, name);
+            TEST_ASSERT_EQUAL_MESSAGE(lf[i].bits, crlf[i].bits, name);
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// .sub
+/////////////////////////////////////////////////////////////////////////////////////
+void test_sub_key() {
+    SubFile sub;
+    TEST_ASSERT_TRUE(sub.load(&memFs, loadCorpus("sub/key_princeton.sub")));
+    TEST_ASSERT_EQUAL(433920000, sub.frequency);
+    TEST_ASSERT_EQUAL_STRING("FuriHalSubGhzPresetOok650Async", sub.preset.c_str());
+    TEST_ASSERT_EQUAL_STRING("Princeton", sub.protocol.c_str());
+    TEST_ASSERT_EQUAL(400, sub.te);
+    TEST_ASSERT_EQUAL(1, sub.signals.size());
+    TEST_ASSERT_EQUAL(SUB_SIGNAL_KEY, sub.signals[0].type);
+    TEST_ASSERT_EQUAL(24, sub.signals[0].bits);
+    TEST_ASSERT_EQUAL_HEX64(0x95D5D4, sub.signals[0].key);
+}
+
+void test_sub_key_before_bit_crlf() {
+    SubFile sub;
+    TEST_ASSERT_TRUE(sub.load(&memFs, loadCorpus("sub/key_before_bit_crlf.sub")));
+    TEST_ASSERT_EQUAL(315000000, sub.frequency);
+    TEST_ASSERT_EQUAL_STRING("CAME", sub.protocol.c_str());
+    TEST_ASSERT_EQUAL(1, sub.signals.size());
+    TEST_ASSERT_EQUAL(12, sub.signals[0].bits);
+    TEST_ASSERT_EQUAL_HEX64(0xA5F, sub.signals[0].key);
+}
+
+void test_sub_raw_lines() {
+    // 0, garbage and '+' inside RAW_Data, one CRLF line, no newline at the end
+    SubFile sub;
+    TEST_ASSERT_TRUE(sub.load(&memFs, loadCorpus("sub/raw_multiline.sub")));
+    TEST_ASSERT_EQUAL_STRING("RAW", sub.protocol.c_str());
+    TEST_ASSERT_EQUAL(1, sub.signals.size());
+    TEST_ASSERT_EQUAL(SUB_SIGNAL_RAW, sub.signals[0].type);
+    const int expected[] = {500, -1000, 500, -1000, 1500, -500, 250, -250, 300};
+    TEST_ASSERT_EQUAL(9, sub.signals[0].count);
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected, sub.pulses(sub.signals[0]), 9);
+}
+
+void test_sub_binraw() {
+    SubFile sub;
+    TEST_ASSERT_TRUE(sub.load(&memFs, loadCorpus("sub/binraw.sub")));
+    TEST_ASSERT_EQUAL(250, sub.te);
+    TEST_ASSERT_EQUAL(2, sub.signals.size());
+    TEST_ASSERT_EQUAL(SUB_SIGNAL_BINRAW, sub.signals[0].type);
+    TEST_ASSERT_EQUAL(16, sub.signals[0].bits);
+    const int first[] = {0xAA, 0x55};
+    TEST_ASSERT_EQUAL(2, sub.signals[0].count);
+    TEST_ASSERT_EQUAL_INT_ARRAY(first, sub.pulses(sub.signals[0]), 2);
+    const int second[] = {0x01, 0x02, 0x03};
+    TEST_ASSERT_EQUAL(24, sub.signals[1].bits);
+    TEST_ASSERT_EQUAL(3, sub.signals[1].count);
+    TEST_ASSERT_EQUAL_INT_ARRAY(second, sub.pulses(sub.signals[1]), 3);
+}
+
+void test_sub_line_ends() {
+    const char *files[] = {
+        "sub/key_princeton.sub", "sub/key_before_bit_crlf.sub", "sub/raw_multiline.sub", "sub/binraw.sub"
+    };
+    for (const char *name : files) {
+        SubFile lf, crlf;
+        TEST_ASSERT_TRUE(lf.load(&memFs, loadCorpus(name, -1)));
+        TEST_ASSERT_TRUE(crlf.load(&memFs, loadCorpus(name, 1)));
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(lf.protocol.c_str(), crlf.protocol.c_str(), name);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(lf.preset.c_str(), crlf.preset.c_str(), name);
+        TEST_ASSERT_EQUAL_MESSAGE(lf.frequency, crlf.frequency, name);
+        TEST_ASSERT_EQUAL_MESSAGE(lf.te, crlf.te, name);
+        TEST_ASSERT_EQUAL_MESSAGE(lf.signals.size(), crlf.signals.size(), name);
+        TEST_ASSERT_EQUAL_MESSAGE(lf.pulseCount(), crlf.pulseCount(), name);
+        for (size_t i = 0; i < lf.signals.size(); i++) {
+            TEST_ASSERT_EQUAL_MESSAGE(lf.signals[i].bits, crlf.signals[i].bits, name);
+            TEST_ASSERT_EQUAL_HEX64_MESSAGE(lf.signals[i].key, crlf.signals[i].key, name);
+            TEST_ASSERT_EQUAL_MESSAGE(lf.signals[i].count, crlf.signals[i].count, name);
+        }
+        if (lf.pulseCount()) {
+            TEST_ASSERT_EQUAL_INT_ARRAY_MESSAGE(
+                lf.pulses(lf.signals[0]), crlf.pulses(crlf.signals[0]), lf.pulseCount(), name
+            );
+        }
+    }
+}
+
+void test_sub_reload() {
+    // the same SubFile loading another file starts from a clean reader
+    SubFile sub;
+    TEST_ASSERT_TRUE(sub.load(&memFs, loadCorpus("sub/raw_multiline.sub")));
+    TEST_ASSERT_TRUE(sub.load(&memFs, loadCorpus("sub/key_princeton.sub")));
+    TEST_ASSERT_EQUAL_STRING("Princeton", sub.protocol.c_str());
+    TEST_ASSERT_EQUAL(1, sub.signals.size());
+    TEST_ASSERT_EQUAL(0, sub.pulseCount());
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ir_parsed);
+    RUN_TEST(test_ir_raw_crlf);
+    RUN_TEST(test_ir_edge_cases);
+    RUN_TEST(test_ir_seek_to_offset);
+    RUN_TEST(test_ir_index);
+    RUN_TEST(test_ir_line_ends);
+    RUN_TEST(test_sub_key);
+    RUN_TEST(test_sub_key_before_bit_crlf);
+    RUN_TEST(test_sub_raw_lines);
+    RUN_TEST(test_sub_binraw);
+    RUN_TEST(test_sub_line_ends);
+    RUN_TEST(test_sub_reload);
+    return UNITY_END();
+}
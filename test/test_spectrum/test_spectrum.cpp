@@ -0,0 +1,106 @@
+// Spectrum: the windowed FFT against a plain double precision DFT, and the columns drawn from it
+#include "modules/others/spectrum.h"
+#include <cmath>
+#include <random>
+#include <unity.h>
+#include <vector>
+
+#define N SPECTRUM_FFT_SIZE
+
+static uint8_t paletteRgb[256 * 3];
+static Spectrum spectrum;
+
+// amplitude * cos at exactly bin k, plus noise of the given amplitude
+static std::vector<int16_t> tone(int k, double amplitude, int noise = 0) {
+    std::mt19937 rng(k);
+    std::vector<int16_t> samples(N);
+    for (int n = 0; n < N; n++) {
+        double v = amplitude * cos(2 * M_PI * k * n / N);
+        if (noise) v += (int)(rng() % (2 * noise + 1)) - noise;
+        samples[n] = (int16_t)lround(v);
+    }
+    return samples;
+}
+
+void test_matches_reference_dft() {
+    std::vector<int16_t> samples = tone(37, 9000, 4000);
+    for (int n = 0; n < N; n++) samples[n] += (int16_t)lround(3000 * sin(2 * M_PI * 211.5 * n / N));
+    const float *out = spectrum.transform(samples.data());
+
+    std::vector<double> re(N / 2), im(N / 2);
+    double peak = 0;
+    for (int k = 1; k < N / 2; k++) {
+        for (int n = 0; n < N; n++) {
+            double x = samples[n] * (double)spectrum.window(n);
+            re[k] += x * cos(2 * M_PI * k * n / N);
+            im[k] -= x * sin(2 * M_PI * k * n / N);
+        }
+        peak = std::max(peak, std::hypot(re[k], im[k]));
+    }
+    for (int k = 1; k < N / 2; k++) {
+        char msg[16];
+        snprintf(msg, sizeof(msg), "bin %d", k);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1e-4 * peak, re[k], out[2 * k], msg);
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1e-4 * peak, im[k], out[2 * k + 1], msg);
+    }
+}
+
+void test_tone_peak() {
+    std::vector<int16_t> samples = tone(100, 1000);
+    const float *out = spectrum.transform(samples.data());
+    int best = 1;
+    for (int k = 1; k < N / 2; k++) {
+        if (std::hypot(out[2 * k], out[2 * k + 1]) > std::hypot(out[2 * best], out[2 * best + 1])) best = k;
+    }
+    TEST_ASSERT_EQUAL(100, best);
+    // the window's x2 gives back the tone's amplitude: N / 2 * 1000 / 32768
+    TEST_ASSERT_FLOAT_WITHIN(0.5, N / 2 * 1000 / 32768.0, std::hypot(out[200], out[201]));
+}
+
+void test_column_silence() {
+    std::vector<int16_t> samples(N, 0);
+    uint16_t column[SPECTRUM_HEIGHT];
+    spectrum.column(samples.data(), column);
+    for (int y = 0; y < SPECTRUM_HEIGHT; y++) TEST_ASSERT_EQUAL_HEX16(spectrum.color(0), column[y]);
+}
+
+void test_column_tone() {
+    std::vector<int16_t> samples = tone(100, 8000);
+    uint16_t column[SPECTRUM_HEIGHT];
+    spectrum.column(samples.data(), column);
+    // low frequencies at the bottom: bin 100 is row SPECTRUM_HEIGHT - 100
+    TEST_ASSERT_EQUAL_HEX16(spectrum.color(255), column[SPECTRUM_HEIGHT - 100]);
+    TEST_ASSERT_EQUAL_HEX16(spectrum.color(0), column[SPECTRUM_HEIGHT - 10]);
+    TEST_ASSERT_EQUAL_HEX16(spectrum.color(0), column[0]);
+}
+
+void test_begin_again() {
+    std::vector<int16_t> samples = tone(100, 1000);
+    const float *out = spectrum.transform(samples.data());
+    std::vector<float> first(out, out + N);
+    spectrum.end();
+    TEST_ASSERT_TRUE(spectrum.begin(paletteRgb));
+    TEST_ASSERT_TRUE(spectrum.begin(paletteRgb)); // releases the previous plan
+    out = spectrum.transform(samples.data());
+    for (int i = 2; i < N; i++) TEST_ASSERT_FLOAT_WITHIN(1e-6, first[i], out[i]);
+}
+
+void setUp() {}
+void tearDown() {}
+
+int main() {
+    for (int i = 0; i < 256; i++) { // 5/6/5 bits components, a gradient
+        paletteRgb[i * 3] = i >> 3;
+        paletteRgb[i * 3 + 1] = i >> 2;
+        paletteRgb[i * 3 + 2] = 31 - (i >> 3);
+    }
+    UNITY_BEGIN();
+    if (!spectrum.begin(paletteRgb)) return 1;
+    RUN_TEST(test_matches_reference_dft);
+    RUN_TEST(test_tone_peak);
+    RUN_TEST(test_column_silence);
+    RUN_TEST(test_column_tone);
+    RUN_TEST(test_begin_again);
+    spectrum.end();
+    return UNITY_END();
+}
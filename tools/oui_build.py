@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""Builds oui.bin, the offline MAC vendor database, from the IEEE MA-L registry.
+
+Copy oui.bin to the root of the SD card (or LittleFS) and Bruce shows vendor names without internet.
+The format is described in src/core/oui_db.h.
+
+    oui_build.py build oui.csv oui.bin          # https://standards-oui.ieee.org/oui/oui.csv
+    oui_build.py build --download oui.bin
+    oui_build.py lookup oui.bin 2C:33:58:12:34:56
+"""
+
+import argparse
+import csv
+import io
+import re
+import struct
+import sys
+import urllib.request
+from collections import Counter
+
+URL = "https://standards-oui.ieee.org/oui/oui.csv"
+MAGIC = b"OUI1"
+HEADER = struct.Struct("<4s5I")
+BLOCK_ENTRIES = 64
+MAX_BLOCK = 512  # OUI_DB_MAX_BLOCK
+MAX_NAME = 96    # OUI_DB_MAX_NAME
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        b = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return value, pos
+        shift += 7
+
+
+def clean_name(name):
+    name = " ".join(name.split())
+    return name.encode("utf-8")[:MAX_NAME].decode("utf-8", "ignore")
+
+
+def parse_registry(text):
+    """{oui: vendor} from oui.csv, or from oui.txt ("2C-33-58   (hex)\\t\\tIntel Corporate")."""
+    entries = {}
+    if text.startswith("Registry,"):
+        for row in csv.DictReader(io.StringIO(text)):
+            assignment = row.get("Assignment", "")
+            if len(assignment) == 6:
+                entries[int(assignment, 16)] = clean_name(row.get("Organization Name", ""))
+    else:
+        for m in re.finditer(r"^([0-9A-Fa-f]{2})-([0-9A-Fa-f]{2})-([0-9A-Fa-f]{2})\s+\(hex\)\s+(.*)$", text, re.M):
+            entries[int("".join(m.groups()[:3]), 16)] = clean_name(m.group(4))
+    return {oui: name for oui, name in entries.items() if name}
+
+
+def build(entries):
+    # most used names first, so they get one byte ids
+    counts = Counter(entries.values())
+    names = sorted(counts, key=lambda n: (-counts[n], n))
+    name_id = {n: i for i, n in enumerate(names)}
+
+    blocks = bytearray()
+    index = []  # (first OUI, offset)
+    block, count, prev = bytearray(), 0, None
+    for oui in sorted(entries):
+        name = varint(name_id[entries[oui]])
+        entry = varint(oui - prev) + name if count else name
+        if not count or count == BLOCK_ENTRIES or len(block) + len(entry) > MAX_BLOCK:
+            blocks += block
+            index.append((oui, HEADER.size + len(blocks)))
+            block, count, entry = bytearray(), 0, name
+        block += entry
+        count += 1
+        prev = oui
+    blocks += block
+
+    index_offset = HEADER.size + len(blocks)
+    names_offset = index_offset + len(index) * 8
+    pool = [n.encode("utf-8") for n in names]
+    offsets, pos = [], names_offset + (len(names) + 1) * 4
+    for n in pool:
+        offsets.append(pos)
+        pos += len(n)
+    offsets.append(pos)
+
+    out = bytearray(HEADER.pack(MAGIC, len(entries), len(index), len(names), index_offset, names_offset))
+    out += blocks
+    for oui, offset in index:
+        out += struct.pack("<II", oui, offset)
+    out += struct.pack(f"<{len(offsets)}I", *offsets)
+    out += b"".join(pool)
+    return bytes(out)
+
+
+def lookup(data, oui):
+    """Same steps as OuiDatabase::lookup, to check a file."""
+    magic, _, blocks, names, index_offset, names_offset = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise ValueError("not an OUI database")
+    index = [struct.unpack_from("<II", data, index_offset + i * 8) for i in range(blocks)]
+    block = max((i for i in range(blocks) if index[i][0] <= oui), default=None)
+    if block is None:
+        return None
+    start = index[block][1]
+    end = index[block + 1][1] if block + 1 < blocks else index_offset
+    current, (name, pos) = index[block][0], read_varint(data, start)
+    while current < oui and pos < end:
+        delta, pos = read_varint(data, pos)
+        name, pos = read_varint(data, pos)
+        current += delta
+    if current != oui or name >= names:
+        return None
+    a, b = struct.unpack_from("<II", data, names_offset + name * 4)
+    return data[a:b].decode("utf-8")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="action", required=True)
+    p = sub.add_parser("build", help="registry (oui.csv or oui.txt) to oui.bin")
+    p.add_argument("registry", nargs="?", help="local copy of the registry")
+    p.add_argument("output")
+    p.add_argument("--download", action="store_true", help="fetch " + URL)
+    p = sub.add_parser("lookup", help="vendor of a MAC in an oui.bin")
+    p.add_argument("database")
+    p.add_argument("mac")
+    args = parser.parse_args()
+
+    if args.action == "lookup":
+        with open(args.database, "rb") as f:
+            data = f.read()
+        digits = re.sub(r"[^0-9A-Fa-f]", "", args.mac)
+        vendor = lookup(data, int(digits[:6], 16)) if len(digits) >= 6 else None
+        print(vendor or "not found")
+        return 0 if vendor else 1
+
+    if args.download:
+        with urllib.request.urlopen(URL) as r:
+            text = r.read().decode("utf-8", "replace")
+    elif args.registry:
+        with open(args.registry, encoding="utf-8", errors="replace") as f:
+            text = f.read()
+    else:
+        parser.error("give the registry file or --download")
+    entries = parse_registry(text)
+    if not entries:
+        print("error: no MA-L entries found", file=sys.stderr)
+        return 1
+    data = build(entries)
+    for oui in list(entries)[:: max(1, len(entries) // 500)]:
+        assert lookup(data, oui) == entries[oui], f"{oui:06X}"
+    with open(args.output, "wb") as f:
+        f.write(data)
+    print(f"{len(entries)} OUIs, {len(set(entries.values()))} vendors, {len(data)} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+"""Binary file transfer with Bruce over the serial CLI ("storage get" / "storage put").
+
+Frames and flow control are described in src/core/serial_commands/file_transfer.h.
+
+    serial_transfer.py /dev/ttyACM0 get /pcaps/capture.pcap
+    serial_transfer.py /dev/ttyACM0 put dump.bin /dumps/dump.bin --resume
+    serial_transfer.py /dev/ttyACM0 bench --size 1048576
+
+Needs pyserial (pip install pyserial).
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+MAGIC = 0xBF
+HEADER = struct.Struct("<BBHI")  # magic, type, length, offset
+READY, DATA, ACK, NAK, END, ABORT, ERROR = b"R", b"D", b"A", b"N", b"E", b"X", b"!"
+TIMEOUT = 1.0      # seconds without a frame before resending / NAKing
+RETRIES = 10
+READY_TIMEOUT = 5  # the CLI task checks for commands every 500ms
+MAX_PAYLOAD = 8192
+
+
+class TransferError(Exception):
+    pass
+
+
+class Link:
+    def __init__(self, port):
+        self.port = port
+        self.buf = bytearray()
+
+    def command(self, line):
+        self.port.reset_input_buffer()
+        self.port.write(line.encode() + b"\n")
+
+    def send(self, ftype, offset, payload=b""):
+        head = HEADER.pack(MAGIC, ftype[0], len(payload), offset)
+        crc = zlib.crc32(payload, zlib.crc32(head[1:]))
+        self.port.write(head + payload + struct.pack("<I", crc))
+
+    def recv(self, timeout=TIMEOUT):
+        """Next valid frame as (type, offset, payload), None on timeout. Skips text and bad frames."""
+        deadline = time.monotonic() + timeout
+        while True:
+            frame = self._parse()
+            if frame:
+                return frame
+            if time.monotonic() > deadline:
+                return None
+            self.buf += self.port.read(max(1, self.port.in_waiting))
+
+    def _parse(self):
+        while True:
+            start = self.buf.find(MAGIC)
+            if start < 0:
+                self.buf.clear()
+                return None
+            del self.buf[:start]
+            if len(self.buf) < HEADER.size:
+                return None
+            _, ftype, length, offset = HEADER.unpack_from(self.buf)
+            if length > MAX_PAYLOAD:
+                del self.buf[0]
+                continue
+            end = HEADER.size + length + 4
+            if len(self.buf) < end:
+                return None
+            payload = bytes(self.buf[HEADER.size:end - 4])
+            (crc,) = struct.unpack_from("<I", self.buf, end - 4)
+            if zlib.crc32(self.buf[HEADER.size:end - 4], zlib.crc32(self.buf[1:HEADER.size])) != crc:
+                del self.buf[0]  # the magic byte was data, look for the next one
+                continue
+            del self.buf[:end]
+            return bytes([ftype]), offset, payload
+
+    def ready(self):
+        deadline = time.monotonic() + READY_TIMEOUT
+        while time.monotonic() < deadline:
+            frame = self.recv(deadline - time.monotonic())
+            if not frame:
+                break
+            ftype, offset, payload = frame
+            if ftype == ERROR:
+                raise TransferError(payload.decode(errors="replace"))
+            if ftype == READY:
+                size, chunk, window = struct.unpack("<IHH", payload)
+                return offset, size, chunk, window
+        raise TransferError("no answer from the device")
+
+
+def progress(done, total, started):
+    rate = done / max(time.monotonic() - started, 1e-6)
+    sys.stderr.write(f"\r{done}/{total} bytes, {rate / 1024:.1f} KiB/s ")
+    sys.stderr.flush()
+
+
+def get(link, remote, local, resume=False, quiet=False):
+    offset = os.path.getsize(local) if resume and os.path.exists(local) else 0
+    link.command(f"storage get {remote} {offset}")
+    start, size, _, _ = link.ready()
+    started = time.monotonic()
+    expected, nak_sent, retries = start, None, 0
+    with open(local, "r+b" if start else "wb") as f:
+        f.seek(start)
+        f.truncate()
+        while True:
+            frame = link.recv()
+            if not frame:
+                retries += 1
+                if retries > RETRIES:
+                    link.send(ABORT, expected)
+                    raise TransferError("device stopped answering")
+                link.send(NAK, expected)
+                nak_sent = expected
+                continue
+            ftype, offset, payload = frame
+            if ftype == END and expected == size:
+                break
+            if ftype == ERROR:
+                raise TransferError(payload.decode(errors="replace"))
+            if ftype != DATA:
+                continue
+            if offset != expected:
+                if offset < expected:
+                    link.send(ACK, expected)
+                elif nak_sent != expected:
+                    link.send(NAK, expected)
+                    nak_sent = expected
+                continue
+            f.write(payload)
+            expected += len(payload)
+            retries = 0
+            link.send(ACK, expected)
+            if not quiet:
+                progress(expected, size, started)
+    if not quiet:
+        sys.stderr.write("\n")
+    return size - start, time.monotonic() - started
+
+
+def put(link, local, remote, resume=False, quiet=False):
+    size = os.path.getsize(local)
+    link.command(f"storage put {remote} {size}" + (" -resume" if resume else ""))
+    start, _, chunk, window = link.ready()
+    started = time.monotonic()
+    acked = sent = start
+    retries = 0
+    with open(local, "rb") as f:
+        while True:
+            while sent < size and sent - acked < chunk * window:
+                f.seek(sent)
+                data = f.read(chunk)
+                link.send(DATA, sent, data)
+                sent += len(data)
+            frame = link.recv()
+            if not frame:
+                retries += 1
+                if retries > RETRIES:
+                    link.send(ABORT, acked)
+                    raise TransferError("device stopped answering")
+                sent = acked  # go back to what the device has
+                continue
+            ftype, offset, payload = frame
+            if ftype == ERROR:
+                raise TransferError(payload.decode(errors="replace"))
+            if ftype == END:
+                break
+            if ftype not in (ACK, NAK) or offset > sent:
+                continue
+            if offset > acked:
+                acked = offset
+                retries = 0
+                if not quiet:
+                    progress(acked, size, started)
+            if ftype == NAK and offset == acked:
+                sent = acked
+    if not quiet:
+        sys.stderr.write("\n")
+    return size - start, time.monotonic() - started
+
+
+def bench(link, remote, size):
+    data = os.urandom(size)
+    up, down = "serial_transfer_up.bin", "serial_transfer_down.bin"
+    try:
+        with open(up, "wb") as f:
+            f.write(data)
+        n, secs = put(link, up, remote, quiet=True)
+        print(f"put: {n} bytes in {secs:.2f}s, {n / secs / 1024:.1f} KiB/s")
+        n, secs = get(link, remote, down, quiet=True)
+        print(f"get: {n} bytes in {secs:.2f}s, {n / secs / 1024:.1f} KiB/s")
+        with open(down, "rb") as f:
+            same = f.read() == data
+        print("round trip: " + ("identical" if same else "MISMATCH"))
+        link.command(f"storage remove {remote}")
+        return same
+    finally:
+        for p in (up, down):
+            if os.path.exists(p):
+                os.remove(p)
+
+
+def open_port(port, baud):
+    import serial  # pyserial
+
+    return serial.Serial(port, baud, timeout=0.05)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port")
+    parser.add_argument("--baud", type=int, default=115200, help="ignored by USB CDC")
+    sub = parser.add_subparsers(dest="action", required=True)
+    p = sub.add_parser("get", help="copy a file from the device")
+    p.add_argument("remote")
+    p.add_argument("local", nargs="?")
+    p.add_argument("--resume", action="store_true", help="continue a partial local file")
+    p = sub.add_parser("put", help="copy a file to the device")
+    p.add_argument("local")
+    p.add_argument("remote")
+    p.add_argument("--resume", action="store_true", help="continue a partial remote file")
+    p = sub.add_parser("bench", help="throughput of put and get with random data")
+    p.add_argument("--size", type=int, default=1 << 20)
+    p.add_argument("--remote", default="/serial_transfer_bench.bin")
+    args = parser.parse_args()
+
+    link = Link(open_port(args.port, args.baud))
+    try:
+        if args.action == "get":
+            n, secs = get(link, args.remote, args.local or os.path.basename(args.remote), args.resume)
+        elif args.action == "put":
+            n, secs = put(link, args.local, args.remote, args.resume)
+        else:
+            return 0 if bench(link, args.remote, args.size) else 1
+        print(f"{n} bytes in {secs:.2f}s, {n / max(secs, 1e-6) / 1024:.1f} KiB/s")
+    except TransferError as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())